@@ -303,6 +303,12 @@ void CPUInfo::Detect()
 	bIDIVt = isVFP4;
 	bFP = false;
 	bASIMD = false;
+#if (PPSSPP_PLATFORM(IOS) || PPSSPP_PLATFORM(MAC)) && PPSSPP_ARCH(ARM64)
+	// All Apple ARM64 chips have the crypto extensions.
+	bAES = true;
+#else
+	bAES = false;
+#endif
 #else // PPSSPP_PLATFORM(LINUX)
 	truncate_cpy(cpu_string, GetCPUString().c_str());
 	truncate_cpy(brand_string, GetCPUBrandString().c_str());
@@ -330,6 +336,7 @@ void CPUInfo::Detect()
 	// These two require ARMv8 or higher
 	bFP = CheckCPUFeature("fp");
 	bASIMD = CheckCPUFeature("asimd");
+	bAES = CheckCPUFeature("aes");
 	num_cores = GetCoreCount();
 #endif
 #if PPSSPP_ARCH(ARM64)
@@ -360,6 +367,7 @@ std::string CPUInfo::Summarize()
 	if (bNEON) sum += ", NEON";
 	if (bIDIVa) sum += ", IDIVa";
 	if (bIDIVt) sum += ", IDIVt";
+	if (bAES) sum += ", AES";
 	if (CPU64bit) sum += ", 64-bit";
 
 	return sum;
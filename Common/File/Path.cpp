@@ -5,6 +5,7 @@
 
 #include "Common/File/Path.h"
 #include "Common/File/FileUtil.h"
+#include "Common/File/PathCaseCache.h"
 #include "Common/StringUtils.h"
 #include "Common/Log.h"
 #include "Common/Data/Encoding/Utf8.h"
@@ -425,7 +426,7 @@ static bool FixFilenameCase(const std::string &path, std::string &filename) {
 	return retValue;
 }
 
-bool FixPathCase(const Path &realBasePath, std::string &path, FixPathCaseBehavior behavior) {
+bool FixPathCase(const Path &realBasePath, std::string &path, FixPathCaseBehavior behavior, PathCaseCache *cache) {
 	if (realBasePath.Type() == PathType::CONTENT_URI) {
 		// Nothing to do. These are already case insensitive, I think.
 		return true;
@@ -462,7 +463,8 @@ bool FixPathCase(const Path &realBasePath, std::string &path, FixPathCaseBehavio
 			std::string component = path.substr(start, i - start);
 
 			// Fix case and stop on nonexistant path component
-			if (FixFilenameCase(fullPath, component) == false) {
+			bool fixed = cache ? cache->FixFilenameCase(fullPath, component) : FixFilenameCase(fullPath, component);
+			if (!fixed) {
 				// Still counts as success if partial matches allowed or if this
 				// is the last component and only the ones before it are required
 				return (behavior == FPC_PARTIAL_ALLOWED || (behavior == FPC_PATH_MUST_EXIST && i >= len));
@@ -143,6 +143,9 @@ enum FixPathCaseBehavior {
 	FPC_PARTIAL_ALLOWED,  // don't care how many exist (mkdir recursive)
 };
 
-bool FixPathCase(const Path &basePath, std::string &path, FixPathCaseBehavior behavior);
+class PathCaseCache;
+
+// If cache is passed, directory listings are remembered between calls (see PathCaseCache.h.)
+bool FixPathCase(const Path &basePath, std::string &path, FixPathCaseBehavior behavior, PathCaseCache *cache = nullptr);
 
 #endif
@@ -0,0 +1,125 @@
+#include "ppsspp_config.h"
+
+#include <cctype>
+#include <ctime>
+
+#include "Common/File/Path.h"
+#include "Common/File/PathCaseCache.h"
+#include "Common/File/FileUtil.h"
+
+#if HOST_IS_CASE_SENSITIVE
+#include <dirent.h>
+#include <sys/stat.h>
+
+static std::string FoldCase(const std::string &name) {
+	std::string folded = name;
+	for (char &c : folded)
+		c = tolower(c);
+	return folded;
+}
+
+bool PathCaseCache::Rescan(const std::string &dirPath, DirIndex &index) {
+	index.names.clear();
+	index.collisions.clear();
+
+	DIR *dirp = opendir(dirPath.c_str());
+	if (!dirp)
+		return false;
+
+	time_t scanTime = time(nullptr);
+	struct dirent *result;
+	while ((result = readdir(dirp))) {
+		std::string real = result->d_name;
+		if (real == "." || real == "..")
+			continue;
+		auto inserted = index.names.emplace(FoldCase(real), real);
+		if (!inserted.second)
+			index.collisions.insert(inserted.first->first);
+	}
+	closedir(dirp);
+
+	// If the directory changed in the same second we listed it, we can't tell later changes apart.
+	index.racy = index.mtime >= (int64_t)scanTime;
+	index.valid = true;
+	stats_.rescans++;
+	return true;
+}
+
+bool PathCaseCache::FixFilenameCase(const std::string &dirPath, std::string &filename) {
+	struct stat st;
+	if (stat(dirPath.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+		return false;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	DirIndex &index = dirs_[dirPath];
+	bool scanned = false;
+	if (!index.valid || index.mtime != (int64_t)st.st_mtime) {
+		index.mtime = (int64_t)st.st_mtime;
+		if (!Rescan(dirPath, index)) {
+			dirs_.erase(dirPath);
+			return false;
+		}
+		scanned = true;
+		stats_.misses++;
+	}
+
+	std::string folded = FoldCase(filename);
+	auto it = index.names.find(folded);
+	if (it == index.names.end() && index.racy && !scanned) {
+		// Might have been created since we listed, without the mtime changing.  Look again.
+		if (!Rescan(dirPath, index)) {
+			dirs_.erase(dirPath);
+			return false;
+		}
+		stats_.misses++;
+		it = index.names.find(folded);
+	} else if (!scanned) {
+		stats_.hits++;
+	}
+	if (it == index.names.end())
+		return false;
+
+	if (index.collisions.count(folded)) {
+		// Ambiguous, so prefer an exact match like the uncached path does.
+		if (File::Exists(Path(dirPath + "/" + filename)))
+			return true;
+	}
+	filename = it->second;
+	return true;
+}
+
+void PathCaseCache::Invalidate(const std::string &path) {
+	std::lock_guard<std::mutex> guard(lock_);
+	size_t slash = path.find_last_of('/');
+	if (slash != path.npos)
+		dirs_.erase(path.substr(0, slash));
+
+	const std::string prefix = path + "/";
+	for (auto it = dirs_.begin(); it != dirs_.end(); ) {
+		if (it->first == path || it->first.compare(0, prefix.size(), prefix) == 0)
+			it = dirs_.erase(it);
+		else
+			++it;
+	}
+}
+
+#else
+
+bool PathCaseCache::FixFilenameCase(const std::string &dirPath, std::string &filename) {
+	return File::Exists(Path(dirPath + "/" + filename));
+}
+
+void PathCaseCache::Invalidate(const std::string &path) {
+}
+
+#endif
+
+void PathCaseCache::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	dirs_.clear();
+}
+
+PathCaseCache::Stats PathCaseCache::GetStats() {
+	std::lock_guard<std::mutex> guard(lock_);
+	return stats_;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Remembers directory listings for FixPathCase, so that resolving the case of a path
+// component becomes a hash lookup instead of a readdir() and compare over the whole
+// directory. Useful for homebrew and mods with thousands of files in a folder.
+//
+// Listings are keyed by the full host path of the directory, exactly as FixPathCase builds it.
+// A listing is revalidated against the directory mtime (one stat) on each use, and the
+// owner should also Invalidate() paths it changes itself, since mtime may be too coarse.
+class PathCaseCache {
+public:
+	// Same contract as the uncached version: on success, filename is replaced by the
+	// real on-disk name. filename must not contain slashes.
+	bool FixFilenameCase(const std::string &dirPath, std::string &filename);
+
+	// Drops the listing of the parent directory of path, and of path itself and below it.
+	void Invalidate(const std::string &path);
+	void Clear();
+
+	struct Stats {
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t rescans;
+	};
+	Stats GetStats();
+
+private:
+	struct DirIndex {
+		bool valid = false;
+		int64_t mtime = 0;
+		// Set if the listing might have missed a change made in the same second as mtime.
+		// Hits are still trusted, but misses rescan.
+		bool racy = false;
+		// Case-folded name -> real name.
+		std::unordered_map<std::string, std::string> names;
+		// Folded names that map to more than one real name (e.g. "a" and "A" both exist.)
+		std::unordered_set<std::string> collisions;
+	};
+
+	bool Rescan(const std::string &dirPath, DirIndex &index);
+
+	std::mutex lock_;
+	std::unordered_map<std::string, DirIndex> dirs_;
+	Stats stats_{};
+};
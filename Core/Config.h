@@ -126,6 +126,7 @@ struct Config {
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
 	bool bCacheFullIsoInRam;
+	bool bDecryptedCache;
 	int iRemoteISOPort;
 	std::string sLastRemoteISOServer;
 	int iLastRemoteISOPort;
@@ -161,6 +162,9 @@ struct Config {
 
 	bool bSoftwareRendering;
 	bool bSoftwareRenderingJit;
+	// Also precompile funcs seen in any game, not just the current one.
+	bool bSoftwareRenderingJitAOT;
+	bool bSoftwareTextureCache;
 	bool bHardwareTransform; // only used in the GLES backend
 	bool bSoftwareSkinning;
 	bool bVendorBugChecksEnabled;
@@ -220,6 +224,7 @@ struct Config {
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexScalingDiskCache;
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iAnalogFpsLimit;
@@ -11,6 +11,7 @@ extern "C"
 #include "Common/Log.h"
 #include "Common/Swap.h"
 #include "Core/ELF/PrxDecrypter.h"
+#include "Core/HW/KirkAES.h"
 
 #define ROUNDUP16(x)  (((x)+15)&~15)
 
@@ -1003,6 +1004,7 @@ static int pspDecryptType6(const u8 *inbuf, u8 *outbuf, u32 size)
 int pspDecryptPRX(const u8 *inbuf, u8 *outbuf, u32 size, const u8 *seed)
 {
 	kirk_init();
+	KirkAES_Init();
 
 	// this would be significantly better if we had a log of the tags
 	// and their appropriate prx types
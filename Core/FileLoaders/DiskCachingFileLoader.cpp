@@ -425,11 +425,15 @@ std::string DiskCachingFileLoaderCache::MakeCacheFilename(const Path &path) {
 	return filename + ".ppdc";
 }
 
-::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename) {
-	Path dir = cacheDir_;
-	if (dir.empty()) {
-		dir = GetSysDirectory(DIRECTORY_CACHE);
+Path DiskCachingFileLoaderCache::GetCacheDir() {
+	if (cacheDir_.empty()) {
+		return GetSysDirectory(DIRECTORY_CACHE);
 	}
+	return cacheDir_;
+}
+
+::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename) {
+	Path dir = GetCacheDir();
 
 	if (!File::Exists(dir)) {
 		File::CreateFullPath(dir);
@@ -79,6 +79,7 @@ class DiskCachingFileLoaderCache {
 	static void SetCacheDir(const Path &path) {
 		cacheDir_ = path;
 	}
+	static Path GetCacheDir();
 
 	size_t ReadFromCache(s64 pos, size_t bytes, void *data);
 	// Guaranteed to read at least one block into the cache.
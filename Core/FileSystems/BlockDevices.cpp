@@ -18,6 +18,7 @@
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <vector>
 
 #include "Common/Data/Text/I18n.h"
 #include "Common/File/FileUtil.h"
@@ -26,6 +27,8 @@
 #include "Core/Loaders.h"
 #include "Core/Host.h"
 #include "Core/FileSystems/BlockDevices.h"
+#include "Core/FileSystems/DecryptedCache.h"
+#include "Core/HW/KirkAES.h"
 
 extern "C"
 {
@@ -398,6 +401,7 @@ NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 	}
 
 	kirk_init();
+	KirkAES_Init();
 
 	// getkey
 	sceDrmBBMacInit(&mkey, 3);
@@ -446,11 +450,17 @@ NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 
 	currentBlock = -1;
 
+	// The header and table carry the MACs of every block, so together they identify the content.
+	std::vector<u8> cacheKey(np_header, np_header + sizeof(np_header));
+	cacheKey.insert(cacheKey.end(), (const u8 *)table, (const u8 *)table + tableSize);
+	decryptedCache_ = DecryptedBlockCache::Open(cacheKey.data(), cacheKey.size(), blockSize, numBlocks);
+
 }
 
 NPDRMDemoBlockDevice::~NPDRMDemoBlockDevice()
 {
 	std::lock_guard<std::mutex> guard(mutex_);
+	delete decryptedCache_;
 	delete [] table;
 	delete [] tempBuf;
 	delete [] blockBuf;
@@ -484,6 +494,11 @@ bool NPDRMDemoBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 			return false;
 	}
 
+	if (decryptedCache_ && decryptedCache_->ReadBlock(block, blockBuf)) {
+		memcpy(outPtr, blockBuf+lba*2048, 2048);
+		return true;
+	}
+
 	if(table[block].size<blockSize)
 		readBuf = tempBuf;
 	else
@@ -516,6 +531,9 @@ bool NPDRMDemoBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 		}
 	}
 
+	if (decryptedCache_ && !uncached)
+		decryptedCache_->WriteBlock(block, blockBuf);
+
 	memcpy(outPtr, blockBuf+lba*2048, 2048);
 
 	return true;
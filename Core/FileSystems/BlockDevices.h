@@ -29,6 +29,7 @@
 #include "Core/ELF/PBPReader.h"
 
 class FileLoader;
+class DecryptedBlockCache;
 
 class BlockDevice {
 public:
@@ -129,6 +130,8 @@ class NPDRMDemoBlockDevice : public BlockDevice {
 	int currentBlock;
 	u8 *blockBuf;
 	u8 *tempBuf;
+
+	DecryptedBlockCache *decryptedCache_ = nullptr;
 };
 
 
@@ -0,0 +1,294 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "Common/File/DirListing.h"
+#include "Common/File/Path.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Swap.h"
+#include "Core/Config.h"
+#include "Core/ELF/PrxDecrypter.h"
+#include "Core/FileLoaders/DiskCachingFileLoader.h"
+#include "Core/FileSystems/DecryptedCache.h"
+#include "ext/xxhash.h"
+
+static const char *BLOCKFILE_MAGIC = "ppssppDB";
+static const char *PRXFILE_MAGIC = "ppssppDP";
+static const u32 CACHE_VERSION = 1;
+// Decrypted data can be as large as the games themselves, so old files are deleted past this.
+static const u64 MAX_CACHE_BYTES = 2ULL * 1024 * 1024 * 1024;
+
+// Block caches that are open can't be deleted to make room.
+static std::mutex inUseLock;
+static std::set<std::string> inUseFilenames;
+
+// Just so an empty slot can't be confused with a block that happens to hash to zero.
+static u64 HashBlock(const u8 *data, u32 size) {
+	u64 hash = XXH3_64bits(data, size);
+	return hash == 0 ? 1 : hash;
+}
+
+static Path MakeCacheFilePath(XXH128_hash_t hash, const char *extension) {
+	Path dir = DiskCachingFileLoaderCache::GetCacheDir();
+	if (!File::Exists(dir)) {
+		File::CreateFullPath(dir);
+	}
+	return dir / StringFromFormat("%016llx%016llx.%s", (unsigned long long)hash.high64, (unsigned long long)hash.low64, extension);
+}
+
+// Deletes the least recently used cache files until there's room for another reserveBytes.
+static void GarbageCollectCacheFiles(u64 reserveBytes) {
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(DiskCachingFileLoaderCache::GetCacheDir(), &files, "ppdb:ppdp:");
+
+	u64 total = reserveBytes;
+	for (const File::FileInfo &file : files) {
+		total += file.size;
+	}
+	if (total <= MAX_CACHE_BYTES) {
+		return;
+	}
+
+	// Reads don't always update atime, but writes to block caches do update mtime.
+	auto lastUsed = [](const File::FileInfo &file) {
+		return std::max(file.atime, file.mtime);
+	};
+	std::sort(files.begin(), files.end(), [&](const File::FileInfo &a, const File::FileInfo &b) {
+		return lastUsed(a) < lastUsed(b);
+	});
+
+	std::lock_guard<std::mutex> guard(inUseLock);
+	for (const File::FileInfo &file : files) {
+		if (total <= MAX_CACHE_BYTES) {
+			break;
+		}
+		if (file.isDirectory || inUseFilenames.count(file.name)) {
+			continue;
+		}
+		if (File::Delete(file.fullName)) {
+			total -= file.size;
+		}
+	}
+	INFO_LOG(LOADER, "Decrypted cache trimmed to %lld bytes", (long long)(total - reserveBytes));
+}
+
+DecryptedBlockCache *DecryptedBlockCache::Open(const void *key, size_t keySize, u32 blockSize, u32 numBlocks) {
+	if (!g_Config.bDecryptedCache || blockSize == 0 || numBlocks == 0) {
+		return nullptr;
+	}
+
+	// The layout is part of the name too, so a mismatch never reuses the wrong file.
+	XXH128_hash_t hash = XXH3_128bits_withSeed(key, keySize, ((u64)blockSize << 32) | numBlocks);
+	const Path path = MakeCacheFilePath(hash, "ppdb");
+
+	DecryptedBlockCache *cache = new DecryptedBlockCache(blockSize, numBlocks);
+	{
+		std::lock_guard<std::mutex> guard(inUseLock);
+		cache->filename_ = path.GetFilename();
+		inUseFilenames.insert(cache->filename_);
+	}
+	if (cache->file_.Open(path, "rb+") && cache->Load()) {
+		INFO_LOG(LOADER, "Using decrypted block cache %s", path.c_str());
+		return cache;
+	}
+	cache->file_.Close();
+
+	// Blocks are written as they're decrypted, so make room for the whole thing up front.
+	GarbageCollectCacheFiles((u64)cache->GetBlockOffset(numBlocks));
+	if (cache->file_.Open(path, "wb+") && cache->Create()) {
+		INFO_LOG(LOADER, "Created decrypted block cache %s", path.c_str());
+		return cache;
+	}
+
+	ERROR_LOG(LOADER, "Could not create decrypted block cache %s", path.c_str());
+	delete cache;
+	return nullptr;
+}
+
+DecryptedBlockCache::DecryptedBlockCache(u32 blockSize, u32 numBlocks)
+	: blockSize_(blockSize), numBlocks_(numBlocks) {
+}
+
+DecryptedBlockCache::~DecryptedBlockCache() {
+	file_.Close();
+
+	std::lock_guard<std::mutex> guard(inUseLock);
+	inUseFilenames.erase(filename_);
+}
+
+bool DecryptedBlockCache::Load() {
+	FileHeader header;
+	if (!file_.ReadBytes(&header, sizeof(header))) {
+		return false;
+	}
+	if (memcmp(header.magic, BLOCKFILE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION) {
+		return false;
+	}
+	if (header.blockSize != blockSize_ || header.numBlocks != numBlocks_) {
+		return false;
+	}
+
+	index_.resize(numBlocks_);
+	return file_.ReadArray(&index_[0], numBlocks_);
+}
+
+bool DecryptedBlockCache::Create() {
+	FileHeader header{};
+	memcpy(header.magic, BLOCKFILE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.blockSize = blockSize_;
+	header.numBlocks = numBlocks_;
+
+	index_.clear();
+	index_.resize(numBlocks_);
+	return file_.WriteBytes(&header, sizeof(header)) && file_.WriteArray(&index_[0], numBlocks_) && file_.Flush();
+}
+
+s64 DecryptedBlockCache::GetBlockOffset(u32 block) const {
+	return (s64)sizeof(FileHeader) + (s64)numBlocks_ * (s64)sizeof(u64) + (s64)block * (s64)blockSize_;
+}
+
+bool DecryptedBlockCache::ReadBlock(u32 block, u8 *dest) {
+	if (!file_.IsOpen() || block >= numBlocks_ || index_[block] == 0) {
+		return false;
+	}
+
+	// Reads and writes share a stream, so this also takes care of flushing pending writes.
+	if (!file_.Seek(GetBlockOffset(block), SEEK_SET) || !file_.ReadBytes(dest, blockSize_)) {
+		ERROR_LOG(LOADER, "Unable to read decrypted block cache, disabling");
+		file_.Close();
+		return false;
+	}
+
+	if (HashBlock(dest, blockSize_) != index_[block]) {
+		// Probably a write that never finished.  Decrypt it again and overwrite.
+		WARN_LOG(LOADER, "Decrypted block cache entry %d was corrupt", block);
+		index_[block] = 0;
+		return false;
+	}
+	return true;
+}
+
+void DecryptedBlockCache::WriteBlock(u32 block, const u8 *src) {
+	if (!file_.IsOpen() || block >= numBlocks_) {
+		return;
+	}
+
+	// Data first, so the index never points at a block that wasn't written.
+	u64 hash = HashBlock(src, blockSize_);
+	s64 indexOffset = (s64)sizeof(FileHeader) + (s64)block * (s64)sizeof(u64);
+	bool failed = false;
+	if (!file_.Seek(GetBlockOffset(block), SEEK_SET) || !file_.WriteBytes(src, blockSize_)) {
+		failed = true;
+	} else if (!file_.Seek(indexOffset, SEEK_SET) || !file_.WriteArray(&hash, 1)) {
+		failed = true;
+	}
+
+	if (failed) {
+		ERROR_LOG(LOADER, "Unable to write decrypted block cache, disabling");
+		file_.Close();
+		return;
+	}
+	index_[block] = hash;
+}
+
+struct PRXFileHeader {
+	char magic[8];
+	u32_le version;
+	u32_le size;
+	u64_le hash;
+};
+
+static int LoadCachedPRX(const Path &path, u8 *outbuf, u32 outCapacity) {
+	File::IOFile file(path, "rb");
+	if (!file.IsOpen()) {
+		return -1;
+	}
+
+	PRXFileHeader header;
+	if (!file.ReadBytes(&header, sizeof(header))) {
+		return -1;
+	}
+	if (memcmp(header.magic, PRXFILE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION) {
+		return -1;
+	}
+	if (header.size == 0 || header.size > outCapacity || header.size > 0x7FFFFFFF) {
+		return -1;
+	}
+
+	// Read to the side first, since outbuf may still be the input if this turns out to be bad.
+	std::vector<u8> data(header.size);
+	if (!file.ReadBytes(&data[0], header.size) || HashBlock(&data[0], header.size) != header.hash) {
+		return -1;
+	}
+	memcpy(outbuf, &data[0], header.size);
+	return (int)header.size;
+}
+
+static void SaveCachedPRX(const Path &path, const u8 *data, u32 size) {
+	PRXFileHeader header{};
+	memcpy(header.magic, PRXFILE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.size = size;
+	header.hash = HashBlock(data, size);
+
+	// Write to a temporary name so a crash can't leave a truncated file under the real one.
+	Path tempPath = path.WithExtraExtension(".tmp");
+	bool success;
+	{
+		File::IOFile file(tempPath, "wb");
+		success = file.WriteBytes(&header, sizeof(header)) && file.WriteBytes(data, size);
+	}
+	if (!success || !File::Rename(tempPath, path)) {
+		ERROR_LOG(LOADER, "Unable to save decrypted PRX to %s", path.c_str());
+		File::Delete(tempPath);
+	}
+}
+
+int DecryptPRXCached(const u8 *inbuf, u8 *outbuf, u32 size, u32 outCapacity, const u8 *seed) {
+	if (!g_Config.bDecryptedCache) {
+		return pspDecryptPRX(inbuf, outbuf, size, seed);
+	}
+
+	// Hashing is a few milliseconds even for a large EBOOT, decrypting is far slower.
+	u64 seedHash = seed ? XXH3_64bits(seed, 0x10) : 0;
+	XXH128_hash_t hash = XXH3_128bits_withSeed(inbuf, size, seedHash);
+	const Path path = MakeCacheFilePath(hash, "ppdp");
+
+	if (File::Exists(path)) {
+		int result = LoadCachedPRX(path, outbuf, outCapacity);
+		if (result > 0) {
+			DEBUG_LOG(LOADER, "Loaded decrypted PRX from %s", path.c_str());
+			return result;
+		}
+		WARN_LOG(LOADER, "Discarding unusable decrypted PRX cache file %s", path.c_str());
+		File::Delete(path);
+	}
+
+	int result = pspDecryptPRX(inbuf, outbuf, size, seed);
+	if (result > 0 && (u32)result <= outCapacity) {
+		GarbageCollectCacheFiles(sizeof(PRXFileHeader) + (u64)result);
+		SaveCachedPRX(path, outbuf, (u32)result);
+	}
+	return result;
+}
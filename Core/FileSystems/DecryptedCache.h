@@ -0,0 +1,73 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Common/File/FileUtil.h"
+
+// Optional on-disk cache of decrypted game content (g_Config.bDecryptedCache), stored next
+// to the disk cache files. Entries are named by a hash of the encrypted input and the keys
+// that apply to it, so they never need invalidating: changed content simply misses.
+// The least recently used files are deleted to keep the total size bounded.
+
+// Caches decrypted blocks of a PGD/NPDRM stream. Every block in a file has the same size.
+// Not thread safe, callers already serialize their reads.
+class DecryptedBlockCache {
+public:
+	// key should cover everything that identifies the plaintext, typically the headers and
+	// block tables (which carry the MACs.) Returns nullptr if caching is off or unavailable.
+	static DecryptedBlockCache *Open(const void *key, size_t keySize, u32 blockSize, u32 numBlocks);
+	~DecryptedBlockCache();
+
+	// Returns false on a miss, in which case dest may have been overwritten.
+	bool ReadBlock(u32 block, u8 *dest);
+	void WriteBlock(u32 block, const u8 *src);
+
+private:
+	DecryptedBlockCache(u32 blockSize, u32 numBlocks);
+	bool Load();
+	bool Create();
+	s64 GetBlockOffset(u32 block) const;
+
+	// File format:
+	// FileHeader
+	// u64 hash[numBlocks] <-- XXH3 of the plaintext, 0 if not present.
+	// blocks[numBlocks]
+	struct FileHeader {
+		char magic[8];
+		u32_le version;
+		u32_le blockSize;
+		u32_le numBlocks;
+		u32_le reserved;
+	};
+
+	File::IOFile file_;
+	std::string filename_;
+	u32 blockSize_;
+	u32 numBlocks_;
+	std::vector<u64> index_;
+};
+
+// Same as pspDecryptPRX(), but reuses an earlier result for identical input when the cache
+// is enabled. outCapacity is the size of outbuf, which may alias inbuf.
+int DecryptPRXCached(const u8 *inbuf, u8 *outbuf, u32 size, u32 outCapacity, const u8 *seed = nullptr);
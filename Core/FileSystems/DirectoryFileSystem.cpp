@@ -112,6 +112,12 @@ Path DirectoryFileSystem::GetLocalPath(std::string internalPath) const {
 	return basePath / internalPath;
 }
 
+void DirectoryFileSystem::InvalidateCase(const Path &localPath) {
+#if HOST_IS_CASE_SENSITIVE
+	caseCache_.Invalidate(localPath.ToString());
+#endif
+}
+
 bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &error) {
 	error = 0;
 
@@ -123,7 +129,7 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 #if HOST_IS_CASE_SENSITIVE
 	if (access & (FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_WRITE)) {
 		DEBUG_LOG(FILESYS, "Checking case for path %s", fileName.c_str());
-		if (!FixPathCase(basePath, fileName, FPC_PATH_MUST_EXIST)) {
+		if (!FixPathCase(basePath, fileName, FPC_PATH_MUST_EXIST, caseCache_)) {
 			error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 			return false;  // or go on and attempt (for a better error code than just 0?)
 		}
@@ -256,7 +262,7 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 
 #if HOST_IS_CASE_SENSITIVE
 	if (!success && !(access & FILEACCESS_CREATE)) {
-		if (!FixPathCase(basePath, fileName, FPC_PATH_MUST_EXIST)) {
+		if (!FixPathCase(basePath, fileName, FPC_PATH_MUST_EXIST, caseCache_)) {
 			error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 			return false;
 		}
@@ -303,6 +309,11 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 	if (access & (FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_WRITE)) {
 		MemoryStick_NotifyWrite();
 	}
+#if HOST_IS_CASE_SENSITIVE
+	if (success && (access & FILEACCESS_CREATE) && caseCache_) {
+		caseCache_->Invalidate(fullName.ToString());
+	}
+#endif
 
 	return success;
 }
@@ -453,10 +464,11 @@ bool DirectoryFileSystem::MkDir(const std::string &dirname) {
 	// duplicate (different case) directories
 
 	std::string fixedCase = dirname;
-	if (!FixPathCase(basePath, fixedCase, FPC_PARTIAL_ALLOWED))
+	if (!FixPathCase(basePath, fixedCase, FPC_PARTIAL_ALLOWED, &caseCache_))
 		result = false;
 	else
 		result = File::CreateFullPath(GetLocalPath(fixedCase));
+	InvalidateCase(GetLocalPath(fixedCase));
 #else
 	result = File::CreateFullPath(GetLocalPath(dirname));
 #endif
@@ -470,19 +482,21 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 #if HOST_IS_CASE_SENSITIVE
 	// Maybe we're lucky?
 	if (File::DeleteDirRecursively(fullName)) {
+		InvalidateCase(fullName);
 		MemoryStick_NotifyWrite();
 		return (bool)ReplayApplyDisk(ReplayAction::RMDIR, true, CoreTiming::GetGlobalTimeUs());
 	}
 
 	// Nope, fix case and try again.  Should we try again?
 	std::string fullPath = dirname;
-	if (!FixPathCase(basePath, fullPath, FPC_FILE_MUST_EXIST))
+	if (!FixPathCase(basePath, fullPath, FPC_FILE_MUST_EXIST, &caseCache_))
 		return (bool)ReplayApplyDisk(ReplayAction::RMDIR, false, CoreTiming::GetGlobalTimeUs());
 
 	fullName = GetLocalPath(fullPath);
 #endif
 
 	bool result = File::DeleteDirRecursively(fullName);
+	InvalidateCase(fullName);
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::RMDIR, result, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -508,7 +522,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 
 #if HOST_IS_CASE_SENSITIVE
 	// In case TO should overwrite a file with different case.  Check error code?
-	if (!FixPathCase(basePath, fullTo, FPC_PATH_MUST_EXIST))
+	if (!FixPathCase(basePath, fullTo, FPC_PATH_MUST_EXIST, &caseCache_))
 		return ReplayApplyDisk(ReplayAction::FILE_RENAME, -1, CoreTiming::GetGlobalTimeUs());
 #endif
 
@@ -521,7 +535,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 	{
 		// May have failed due to case sensitivity on FROM, so try again.  Check error code?
 		std::string fullFromPath = from;
-		if (!FixPathCase(basePath, fullFromPath, FPC_FILE_MUST_EXIST))
+		if (!FixPathCase(basePath, fullFromPath, FPC_FILE_MUST_EXIST, &caseCache_))
 			return ReplayApplyDisk(ReplayAction::FILE_RENAME, -1, CoreTiming::GetGlobalTimeUs());
 		fullFrom = GetLocalPath(fullFromPath);
 
@@ -529,6 +543,11 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 	}
 #endif
 
+	if (retValue) {
+		InvalidateCase(fullFrom);
+		InvalidateCase(fullToPath);
+	}
+
 	// TODO: Better error codes.
 	int result = retValue ? 0 : (int)SCE_KERNEL_ERROR_ERRNO_FILE_ALREADY_EXISTS;
 	MemoryStick_NotifyWrite();
@@ -545,7 +564,7 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 	{
 		// May have failed due to case sensitivity, so try again.  Try even if it fails?
 		std::string fullNamePath = filename;
-		if (!FixPathCase(basePath, fullNamePath, FPC_FILE_MUST_EXIST))
+		if (!FixPathCase(basePath, fullNamePath, FPC_FILE_MUST_EXIST, &caseCache_))
 			return (bool)ReplayApplyDisk(ReplayAction::FILE_REMOVE, false, CoreTiming::GetGlobalTimeUs());
 		localPath = GetLocalPath(fullNamePath);
 
@@ -553,6 +572,8 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 	}
 #endif
 
+	if (retValue)
+		InvalidateCase(localPath);
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::FILE_REMOVE, retValue, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -560,6 +581,9 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 int DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const char *devicename) {
 	OpenFileEntry entry;
 	entry.hFile.fileSystemFlags_ = flags;
+#if HOST_IS_CASE_SENSITIVE
+	entry.hFile.caseCache_ = &caseCache_;
+#endif
 	u32 err = 0;
 	bool success = entry.hFile.Open(basePath, filename, access, err);
 	if (err == 0 && !success) {
@@ -680,7 +704,7 @@ PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
 	Path fullName = GetLocalPath(filename);
 	if (!File::GetFileInfo(fullName, &info)) {
 #if HOST_IS_CASE_SENSITIVE
-		if (! FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST))
+		if (! FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST, &caseCache_))
 			return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
 		fullName = GetLocalPath(filename);
 
@@ -805,7 +829,7 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(const std::string &p
 	if (!success) {
 		// TODO: Case sensitivity should be checked on a file system basis, right?
 		std::string fixedPath = path;
-		if (FixPathCase(basePath, fixedPath, FPC_FILE_MUST_EXIST)) {
+		if (FixPathCase(basePath, fixedPath, FPC_FILE_MUST_EXIST, &caseCache_)) {
 			// May have failed due to case sensitivity, try again
 			localPath = GetLocalPath(fixedPath);
 			success = File::GetFilesInDir(localPath, &files, nullptr, flags);
@@ -865,7 +889,7 @@ u64 DirectoryFileSystem::FreeSpace(const std::string &path) {
 
 #if HOST_IS_CASE_SENSITIVE
 	std::string fixedCase = path;
-	if (FixPathCase(basePath, fixedCase, FPC_FILE_MUST_EXIST)) {
+	if (FixPathCase(basePath, fixedCase, FPC_FILE_MUST_EXIST, &caseCache_)) {
 		// May have failed due to case sensitivity, try again.
 		if (free_disk_space(GetLocalPath(fixedCase), result)) {
 			return ReplayApplyDisk64(ReplayAction::FREESPACE, result, CoreTiming::GetGlobalTimeUs());
@@ -899,6 +923,9 @@ void DirectoryFileSystem::DoState(PointerWrap &p) {
 		u32 key;
 		OpenFileEntry entry;
 		entry.hFile.fileSystemFlags_ = flags;
+#if HOST_IS_CASE_SENSITIVE
+		entry.hFile.caseCache_ = &caseCache_;
+#endif
 		for (u32 i = 0; i < num; i++) {
 			Do(p, key);
 			Do(p, entry.guestFilename);
@@ -22,6 +22,7 @@
 #include <map>
 
 #include "Common/File/Path.h"
+#include "Common/File/PathCaseCache.h"
 #include "Core/FileSystems/FileSystem.h"
 
 #ifdef _WIN32
@@ -43,6 +44,8 @@ struct DirectoryFileHandle {
 	bool replay_ = true;
 	bool inGameDir_ = false;
 	FileSystemFlags fileSystemFlags_ = (FileSystemFlags)0;
+	// Optional, owned by the file system that opened this handle.
+	PathCaseCache *caseCache_ = nullptr;
 
 	DirectoryFileHandle() {}
 
@@ -99,8 +102,12 @@ class DirectoryFileSystem : public IFileSystem {
 	Path basePath;
 	IHandleAllocator *hAlloc;
 	FileSystemFlags flags;
+#if HOST_IS_CASE_SENSITIVE
+	PathCaseCache caseCache_;
+#endif
 
 	Path GetLocalPath(std::string internalPath) const;
+	void InvalidateCase(const Path &localPath);
 };
 
 // VFSFileSystem: Ability to map in Android APK paths as well! Does not support all features, only meant for fonts.
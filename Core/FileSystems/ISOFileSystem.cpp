@@ -30,6 +30,19 @@
 
 const int sectorSize = 2048;
 
+// Directories with fewer entries than this are just scanned, comparing hashes first.
+static const size_t CHILD_LOOKUP_MIN_ENTRIES = 16;
+
+static u32 HashEntryName(const char *name, size_t len) {
+	// FNV-1a, names are short.
+	u32 hash = 2166136261U;
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= (u8)name[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
 bool parseLBN(std::string filename, u32 *sectorStart, u32 *readSize) {
 	// The format of this is: "/sce_lbn" "0x"? HEX* ANY* "_size" "0x"? HEX* ANY*
 	// That means that "/sce_lbn/_size1/" is perfectly valid.
@@ -148,7 +161,7 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 	if (!blockDevice->ReadBlock(16, (u8*)&desc))
 		blockDevice->NotifyReadError();
 
-	entireISO.name.clear();
+	entireISO.name = InternName("");
 	entireISO.isDirectory = false;
 	entireISO.startingPosition = 0;
 	entireISO.size = _blockDevice->GetNumBlocks();
@@ -156,6 +169,7 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 	entireISO.parent = NULL;
 
 	treeroot = new TreeEntry();
+	treeroot->name = InternName("");
 	treeroot->isDirectory = true;
 	treeroot->startingPosition = 0;
 	treeroot->size = 0;
@@ -177,13 +191,28 @@ ISOFileSystem::~ISOFileSystem() {
 	delete treeroot;
 }
 
+const std::string *ISOFileSystem::InternName(std::string &&name) {
+	// Set elements never move, so the pointer stays valid until we're destroyed.
+	return &*names_.insert(std::move(name)).first;
+}
+
 void ISOFileSystem::ReadDirectory(TreeEntry *root) {
+	// Built up separately and moved in at the end, so the entries stay in one array that's
+	// never reallocated after anything can point into it.
+	std::vector<TreeEntry> children;
+	auto finish = [&] {
+		root->children = std::move(children);
+		BuildChildLookup(root);
+		// Also on errors, to avoid re-reading and replacing children that may be in use.
+		root->valid = true;
+	};
+
 	for (u32 secnum = root->startsector, endsector = root->startsector + (root->dirsize + 2047) / 2048; secnum < endsector; ++secnum) {
 		u8 theSector[2048];
 		if (!blockDevice->ReadBlock(secnum, theSector)) {
 			blockDevice->NotifyReadError();
-			ERROR_LOG(FILESYS, "Error reading block for directory '%s' in sector %d - skipping", root->name.c_str(), secnum);
-			root->valid = true;  // Prevents re-reading
+			ERROR_LOG(FILESYS, "Error reading block for directory '%s' in sector %d - skipping", root->name->c_str(), secnum);
+			finish();
 			return;
 		}
 		lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
@@ -200,6 +229,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			if (offset + IDENTIFIER_OFFSET + dir.identifierLength > 2048) {
 				blockDevice->NotifyReadError();
 				ERROR_LOG(FILESYS, "Directory entry crosses sectors, corrupt iso?");
+				finish();
 				return;
 			}
 
@@ -208,17 +238,19 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			bool isFile = (dir.flags & 2) ? false : true;
 			bool relative;
 
-			TreeEntry *entry = new TreeEntry();
+			children.emplace_back();
+			TreeEntry *entry = &children.back();
 			if (dir.identifierLength == 1 && (dir.firstIdChar == '\x00' || dir.firstIdChar == '.')) {
-				entry->name = ".";
+				entry->name = InternName(".");
 				relative = true;
 			} else if (dir.identifierLength == 1 && dir.firstIdChar == '\x01') {
-				entry->name = "..";
+				entry->name = InternName("..");
 				relative = true;
 			} else {
-				entry->name = std::string((const char *)&dir.firstIdChar, dir.identifierLength);
+				entry->name = InternName(std::string((const char *)&dir.firstIdChar, dir.identifierLength));
 				relative = false;
 			}
+			entry->nameHash = HashEntryName(entry->name->data(), entry->name->size());
 
 			entry->size = dir.dataLength;
 			entry->startingPosition = dir.firstDataSector * 2048;
@@ -228,12 +260,12 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			entry->startsector = dir.firstDataSector;
 			entry->dirsize = dir.dataLength;
 			entry->valid = isFile;  // Can pre-mark as valid if file, as we don't recurse into those.
-			VERBOSE_LOG(FILESYS, "%s: %s %08x %08x %i", entry->isDirectory ? "D" : "F", entry->name.c_str(), (u32)dir.firstDataSector, entry->startingPosition, entry->startingPosition);
+			VERBOSE_LOG(FILESYS, "%s: %s %08x %08x %i", entry->isDirectory ? "D" : "F", entry->name->c_str(), (u32)dir.firstDataSector, entry->startingPosition, entry->startingPosition);
 
 			// Round down to avoid any false reports.
 			if (isFile && dir.firstDataSector + (dir.dataLength / 2048) > blockDevice->GetNumBlocks()) {
 				blockDevice->NotifyReadError();
-				ERROR_LOG(FILESYS, "File '%s' starts or ends outside ISO", entry->name.c_str());
+				ERROR_LOG(FILESYS, "File '%s' starts or ends outside ISO", entry->name->c_str());
 			}
 
 			if (entry->isDirectory && !relative) {
@@ -242,10 +274,58 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 					ERROR_LOG(FILESYS, "WARNING: Appear to have a recursive file system, breaking recursion. Probably corrupt ISO.");
 				}
 			}
-			root->children.push_back(entry);
 		}
 	}
-	root->valid = true;
+	finish();
+}
+
+void ISOFileSystem::BuildChildLookup(TreeEntry *root) {
+	root->childLookup.clear();
+	if (root->children.size() < CHILD_LOOKUP_MIN_ENTRIES)
+		return;
+
+	// Keep the load factor at or below 50%.
+	size_t tableSize = 1;
+	while (tableSize < root->children.size() * 2)
+		tableSize <<= 1;
+	const u32 mask = (u32)tableSize - 1;
+
+	root->childLookup.resize(tableSize, 0);
+	for (size_t i = 0; i < root->children.size(); ++i) {
+		u32 slot = root->children[i].nameHash & mask;
+		while (root->childLookup[slot] != 0)
+			slot = (slot + 1) & mask;
+		root->childLookup[slot] = (u32)i + 1;
+	}
+}
+
+ISOFileSystem::TreeEntry *ISOFileSystem::FindChild(TreeEntry *root, const char *name, size_t len) {
+	const u32 hash = HashEntryName(name, len);
+	auto matches = [&](const TreeEntry *e) {
+		return e->nameHash == hash && e->name->size() == len && memcmp(e->name->data(), name, len) == 0;
+	};
+
+	if (root->childLookup.empty()) {
+		for (TreeEntry &e : root->children) {
+			if (matches(&e))
+				return &e;
+		}
+		return nullptr;
+	}
+
+	// Duplicate names resolve to the first child, same as a linear scan would.
+	const u32 mask = (u32)root->childLookup.size() - 1;
+	TreeEntry *found = nullptr;
+	size_t foundIndex = 0;
+	for (u32 slot = hash & mask; root->childLookup[slot] != 0; slot = (slot + 1) & mask) {
+		size_t index = root->childLookup[slot] - 1;
+		TreeEntry *e = &root->children[index];
+		if (matches(e) && (!found || index < foundIndex)) {
+			found = e;
+			foundIndex = index;
+		}
+	}
+	return found;
 }
 
 ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bool catchError) {
@@ -275,29 +355,19 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 			ReadDirectory(entry);
 		}
 		TreeEntry *nextEntry = nullptr;
-		std::string name = "";
 		if (pathLength > pathIndex) {
 			size_t nextSlashIndex = path.find_first_of('/', pathIndex);
 			if (nextSlashIndex == std::string::npos)
 				nextSlashIndex = pathLength;
 
-			const std::string firstPathComponent = path.substr(pathIndex, nextSlashIndex - pathIndex);
-			for (size_t i = 0; i < entry->children.size(); i++) {
-				const std::string &n = entry->children[i]->name;
-				if (firstPathComponent == n) {
-					//yay we got it
-					nextEntry = entry->children[i];
-					name = n;
-					break;
-				}
-			}
+			nextEntry = FindChild(entry, path.data() + pathIndex, nextSlashIndex - pathIndex);
 		}
-		
+
 		if (nextEntry) {
 			entry = nextEntry;
 			if (!entry->valid)
 				ReadDirectory(entry);
-			pathIndex += name.length();
+			pathIndex += entry->name->length();
 			if (pathIndex < pathLength && path[pathIndex] == '/')
 				++pathIndex;
 
@@ -471,7 +541,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		OpenFileEntry &e = iter->second;
 
 		if (size < 0) {
-			ERROR_LOG_REPORT(FILESYS, "Invalid read for %lld bytes from umd %s", size, e.file ? e.file->name.c_str() : "device");
+			ERROR_LOG_REPORT(FILESYS, "Invalid read for %lld bytes from umd %s", size, e.file ? e.file->name->c_str() : "device");
 			return 0;
 		}
 		
@@ -619,7 +689,7 @@ PSPFileInfo ISOFileSystem::GetFileInfo(std::string filename) {
 	TreeEntry *entry = GetFromPath(filename, false);
 	PSPFileInfo x; 
 	if (entry) {
-		x.name = entry->name;
+		x.name = *entry->name;
 		// Strangely, it seems to be executable even for files.
 		x.access = 0555;
 		x.size = entry->size;
@@ -644,14 +714,14 @@ std::vector<PSPFileInfo> ISOFileSystem::GetDirListing(const std::string &path, b
 	const std::string dotdot("..");
 
 	for (size_t i = 0; i < entry->children.size(); i++) {
-		TreeEntry *e = entry->children[i];
+		const TreeEntry *e = &entry->children[i];
 
 		// do not include the relative entries in the list
-		if (e->name == dot || e->name == dotdot)
+		if (*e->name == dot || *e->name == dotdot)
 			continue;
 
 		PSPFileInfo x;
-		x.name = e->name;
+		x.name = *e->name;
 		// Strangely, it seems to be executable even for files.
 		x.access = 0555;
 		x.exists = true;
@@ -676,7 +746,7 @@ std::string ISOFileSystem::EntryFullPath(TreeEntry *e) {
 	TreeEntry *cur = e;
 	while (cur != NULL && cur != treeroot) {
 		// For the "/".
-		fullLen += 1 + cur->name.size();
+		fullLen += 1 + cur->name->size();
 		cur = cur->parent;
 	}
 
@@ -685,21 +755,15 @@ std::string ISOFileSystem::EntryFullPath(TreeEntry *e) {
 
 	cur = e;
 	while (cur != NULL && cur != treeroot) {
-		path.replace(fullLen - cur->name.size(), cur->name.size(), cur->name);
-		path.replace(fullLen - cur->name.size() - 1, 1, "/");
-		fullLen -= 1 + cur->name.size();
+		path.replace(fullLen - cur->name->size(), cur->name->size(), *cur->name);
+		path.replace(fullLen - cur->name->size() - 1, 1, "/");
+		fullLen -= 1 + cur->name->size();
 		cur = cur->parent;
 	}
 
 	return path;
 }
 
-ISOFileSystem::TreeEntry::~TreeEntry() {
-	for (size_t i = 0; i < children.size(); ++i)
-		delete children[i];
-	children.clear();
-}
-
 void ISOFileSystem::DoState(PointerWrap &p) {
 	auto s = p.Section("ISOFileSystem", 1, 2);
 	if (!s)
@@ -20,6 +20,7 @@
 #include <map>
 #include <list>
 #include <memory>
+#include <unordered_set>
 
 #include "FileSystem.h"
 
@@ -58,9 +59,9 @@ class ISOFileSystem : public IFileSystem {
 
 private:
 	struct TreeEntry {
-		~TreeEntry();
-
-		std::string name;
+		// Interned in names_, many directories repeat the same names.
+		const std::string *name = nullptr;
+		u32 nameHash = 0;
 		u32 flags = 0;
 		u32 startingPosition = 0;
 		s64 size = 0;
@@ -72,7 +73,11 @@ class ISOFileSystem : public IFileSystem {
 		TreeEntry *parent = nullptr;
 
 		bool valid = false;
-		std::vector<TreeEntry *> children;
+		// Filled in once by ReadDirectory() and never resized after that, since open files
+		// and the children's parent pointers point into it.
+		std::vector<TreeEntry> children;
+		// Open addressed hash table of (index + 1) into children, only for large directories.
+		std::vector<u32> childLookup;
 	};
 
 	struct OpenFileEntry {
@@ -92,8 +97,12 @@ class ISOFileSystem : public IFileSystem {
 	u32 lastReadBlock_;
 
 	TreeEntry entireISO;
+	std::unordered_set<std::string> names_;
 
+	const std::string *InternName(std::string &&name);
 	void ReadDirectory(TreeEntry *root);
+	void BuildChildLookup(TreeEntry *root);
+	TreeEntry *FindChild(TreeEntry *root, const char *name, size_t len);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
 	std::string EntryFullPath(TreeEntry *e);
 };
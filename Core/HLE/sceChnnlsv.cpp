@@ -21,6 +21,7 @@
 
 #include "Core/HLE/sceChnnlsv.h"
 #include "Core/HLE/sceKernel.h"
+#include "Core/HW/KirkAES.h"
 extern "C"
 {
 #include "ext/libkirk/kirk_engine.h"
@@ -527,4 +528,5 @@ void Register_sceChnnlsv()
 {
 	RegisterModule("sceChnnlsv", ARRAY_SIZE(sceChnnlsv), sceChnnlsv);
 	kirk_init();
+	KirkAES_Init();
 }
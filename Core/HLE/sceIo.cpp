@@ -55,6 +55,7 @@
 #include "Core/FileSystems/MetaFileSystem.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/FileSystems/DirectoryFileSystem.h"
+#include "Core/FileSystems/DecryptedCache.h"
 
 extern "C" {
 #include "ext/libkirk/amctrl.h"
@@ -217,6 +218,7 @@ class FileNode : public KernelObject {
 		if (handle != -1)
 			pspFileSystem.CloseFile(handle);
 		pgd_close(pgdInfo);
+		delete pgdCache;
 	}
 	const char *GetName() override { return fullpath.c_str(); }
 	const char *GetTypeName() override { return GetStaticTypeName(); }
@@ -309,6 +311,8 @@ class FileNode : public KernelObject {
 	u32 npdrm = 0;
 	u32 pgd_offset = 0;
 	PGD_DESC *pgdInfo = nullptr;
+	// Not saved in states, we just decrypt directly after loading one.
+	DecryptedBlockCache *pgdCache = nullptr;
 
 	std::vector<SceUID> waitingThreads;
 	std::vector<SceUID> waitingSyncThreads;
@@ -1006,10 +1010,14 @@ static u32 npdrmRead(FileNode *f, u8 *data, int size) {
 	while(remain_size){
 	
 		if(pgd->current_block!=block){
-			blockPos = block*pgd->block_size;
-			pspFileSystem.SeekFile(f->handle, (s32)pgd->data_offset+blockPos, FILEMOVE_BEGIN);
-			pspFileSystem.ReadFile(f->handle, pgd->block_buf, pgd->block_size);
-			pgd_decrypt_block(pgd, block);
+			if (!f->pgdCache || !f->pgdCache->ReadBlock(block, pgd->block_buf)) {
+				blockPos = block*pgd->block_size;
+				pspFileSystem.SeekFile(f->handle, (s32)pgd->data_offset+blockPos, FILEMOVE_BEGIN);
+				pspFileSystem.ReadFile(f->handle, pgd->block_buf, pgd->block_size);
+				pgd_decrypt_block(pgd, block);
+				if (f->pgdCache)
+					f->pgdCache->WriteBlock(block, pgd->block_buf);
+			}
 			pgd->current_block = block;
 		}
 
@@ -2571,6 +2579,9 @@ static int __IoIoctl(u32 id, u32 cmd, u32 indataPtr, u32 inlen, u32 outdataPtr,
 		DEBUG_LOG(SCEIO, "Decrypting PGD DRM files");
 		pspFileSystem.SeekFile(f->handle, (s32)f->pgd_offset, FILEMOVE_BEGIN);
 		pspFileSystem.ReadFile(f->handle, pgd_header, 0x90);
+		// The header is everything that identifies the content (it has the MACs), grab it before it's decrypted.
+		u8 cacheKey[0x90 + 16];
+		memcpy(cacheKey, pgd_header, 0x90);
 		f->pgdInfo = pgd_open(pgd_header, 2, key_ptr);
 		if(f->pgdInfo==NULL){
 			ERROR_LOG(SCEIO, "Not a valid PGD file. Open as normal file.");
@@ -2587,6 +2598,9 @@ static int __IoIoctl(u32 id, u32 cmd, u32 indataPtr, u32 inlen, u32 outdataPtr,
 			// Everthing OK.
 			f->npdrm = true;
 			f->pgdInfo->data_offset += f->pgd_offset;
+			memcpy(cacheKey + 0x90, f->pgdInfo->dkey, 16);
+			delete f->pgdCache;
+			f->pgdCache = DecryptedBlockCache::Open(cacheKey, sizeof(cacheKey), f->pgdInfo->block_size, f->pgdInfo->block_nr);
 			return 0;
 		}
 		break;
@@ -0,0 +1,217 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <mutex>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Core/HW/KirkAES.h"
+
+extern "C" {
+#include "ext/libkirk/AES.h"
+}
+
+// The rest of the build doesn't assume hardware AES, so only the functions below may use it,
+// and only after checking cpu_info.
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#define KIRK_AES_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#define KIRK_AES_TARGET __attribute__((target("aes,sse2")))
+#else
+#define KIRK_AES_TARGET
+#endif
+#elif PPSSPP_ARCH(ARM64)
+#if defined(_MSC_VER)
+#include <arm64_neon.h>
+#define KIRK_AES_ARM64 1
+#define KIRK_AES_TARGET
+#else
+#include <arm_neon.h>
+// Older clang only declares the crypto intrinsics when the whole file is built with them,
+// so there's no backend there unless the build already targets the crypto extensions.
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+#define KIRK_AES_ARM64 1
+#define KIRK_AES_TARGET
+#elif defined(__clang__) && __clang_major__ >= 16
+#define KIRK_AES_ARM64 1
+#define KIRK_AES_TARGET __attribute__((target("aes")))
+#elif defined(__GNUC__) && !defined(__clang__)
+#define KIRK_AES_ARM64 1
+#define KIRK_AES_TARGET __attribute__((target("+crypto")))
+#endif
+#endif
+#endif
+
+// How many blocks to decrypt in parallel.  CBC encryption is inherently serial.
+static const int PARALLEL_BLOCKS = 4;
+
+#if defined(KIRK_AES_X86)
+
+// libkirk's decryption schedule is already the "equivalent inverse cipher" one that AESDEC
+// and AESD/AESIMC expect, so the byte order copies in the ctx can be used as is.
+KIRK_AES_TARGET static void LoadKeysAESNI(const u8 *bytes, int rounds, __m128i *keys) {
+	for (int i = 0; i <= rounds; ++i)
+		keys[i] = _mm_loadu_si128((const __m128i *)(bytes + i * 16));
+}
+
+KIRK_AES_TARGET static void CBCEncryptAESNI(const AES_ctx *ctx, const u8 *src, u8 *dst, int size) {
+	const int rounds = ctx->Nr;
+	__m128i keys[AES_MAXROUNDS + 1];
+	LoadKeysAESNI(ctx->ek_bytes, rounds, keys);
+
+	__m128i prev = _mm_setzero_si128();
+	for (int i = 0; i < size; i += 16) {
+		__m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + i)), prev);
+		b = _mm_xor_si128(b, keys[0]);
+		for (int r = 1; r < rounds; ++r)
+			b = _mm_aesenc_si128(b, keys[r]);
+		prev = _mm_aesenclast_si128(b, keys[rounds]);
+		_mm_storeu_si128((__m128i *)(dst + i), prev);
+	}
+}
+
+KIRK_AES_TARGET static void CBCDecryptAESNI(const AES_ctx *ctx, const u8 *src, u8 *dst, int size) {
+	const int rounds = ctx->Nr;
+	__m128i keys[AES_MAXROUNDS + 1];
+	LoadKeysAESNI(ctx->dk_bytes, rounds, keys);
+
+	__m128i prev = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 16 * PARALLEL_BLOCKS <= size; i += 16 * PARALLEL_BLOCKS) {
+		// Load everything first, src may be the same as dst.
+		__m128i c[PARALLEL_BLOCKS], b[PARALLEL_BLOCKS];
+		for (int j = 0; j < PARALLEL_BLOCKS; ++j) {
+			c[j] = _mm_loadu_si128((const __m128i *)(src + i + j * 16));
+			b[j] = _mm_xor_si128(c[j], keys[0]);
+		}
+		for (int r = 1; r < rounds; ++r) {
+			for (int j = 0; j < PARALLEL_BLOCKS; ++j)
+				b[j] = _mm_aesdec_si128(b[j], keys[r]);
+		}
+		for (int j = 0; j < PARALLEL_BLOCKS; ++j) {
+			b[j] = _mm_aesdeclast_si128(b[j], keys[rounds]);
+			b[j] = _mm_xor_si128(b[j], j == 0 ? prev : c[j - 1]);
+			_mm_storeu_si128((__m128i *)(dst + i + j * 16), b[j]);
+		}
+		prev = c[PARALLEL_BLOCKS - 1];
+	}
+
+	for (; i < size; i += 16) {
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i b = _mm_xor_si128(c, keys[0]);
+		for (int r = 1; r < rounds; ++r)
+			b = _mm_aesdec_si128(b, keys[r]);
+		b = _mm_aesdeclast_si128(b, keys[rounds]);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(b, prev));
+		prev = c;
+	}
+}
+
+#elif defined(KIRK_AES_ARM64)
+
+KIRK_AES_TARGET static void LoadKeysARMv8(const u8 *bytes, int rounds, uint8x16_t *keys) {
+	for (int i = 0; i <= rounds; ++i)
+		keys[i] = vld1q_u8(bytes + i * 16);
+}
+
+KIRK_AES_TARGET static void CBCEncryptARMv8(const AES_ctx *ctx, const u8 *src, u8 *dst, int size) {
+	const int rounds = ctx->Nr;
+	uint8x16_t keys[AES_MAXROUNDS + 1];
+	LoadKeysARMv8(ctx->ek_bytes, rounds, keys);
+
+	uint8x16_t prev = vdupq_n_u8(0);
+	for (int i = 0; i < size; i += 16) {
+		uint8x16_t b = veorq_u8(vld1q_u8(src + i), prev);
+		for (int r = 0; r < rounds - 1; ++r)
+			b = vaesmcq_u8(vaeseq_u8(b, keys[r]));
+		b = vaeseq_u8(b, keys[rounds - 1]);
+		prev = veorq_u8(b, keys[rounds]);
+		vst1q_u8(dst + i, prev);
+	}
+}
+
+KIRK_AES_TARGET static void CBCDecryptARMv8(const AES_ctx *ctx, const u8 *src, u8 *dst, int size) {
+	const int rounds = ctx->Nr;
+	uint8x16_t keys[AES_MAXROUNDS + 1];
+	LoadKeysARMv8(ctx->dk_bytes, rounds, keys);
+
+	uint8x16_t prev = vdupq_n_u8(0);
+	int i = 0;
+	for (; i + 16 * PARALLEL_BLOCKS <= size; i += 16 * PARALLEL_BLOCKS) {
+		// Load everything first, src may be the same as dst.
+		uint8x16_t c[PARALLEL_BLOCKS], b[PARALLEL_BLOCKS];
+		for (int j = 0; j < PARALLEL_BLOCKS; ++j) {
+			c[j] = vld1q_u8(src + i + j * 16);
+			b[j] = c[j];
+		}
+		for (int r = 0; r < rounds - 1; ++r) {
+			for (int j = 0; j < PARALLEL_BLOCKS; ++j)
+				b[j] = vaesimcq_u8(vaesdq_u8(b[j], keys[r]));
+		}
+		for (int j = 0; j < PARALLEL_BLOCKS; ++j) {
+			b[j] = veorq_u8(vaesdq_u8(b[j], keys[rounds - 1]), keys[rounds]);
+			b[j] = veorq_u8(b[j], j == 0 ? prev : c[j - 1]);
+			vst1q_u8(dst + i + j * 16, b[j]);
+		}
+		prev = c[PARALLEL_BLOCKS - 1];
+	}
+
+	for (; i < size; i += 16) {
+		uint8x16_t c = vld1q_u8(src + i);
+		uint8x16_t b = c;
+		for (int r = 0; r < rounds - 1; ++r)
+			b = vaesimcq_u8(vaesdq_u8(b, keys[r]));
+		b = veorq_u8(vaesdq_u8(b, keys[rounds - 1]), keys[rounds]);
+		vst1q_u8(dst + i, veorq_u8(b, prev));
+		prev = c;
+	}
+}
+
+#endif
+
+static std::once_flag initOnce;
+static bool hardwareInUse = false;
+
+bool KirkAES_SetHardware(bool enable) {
+	AES_cbc_func encrypt = nullptr;
+	AES_cbc_func decrypt = nullptr;
+#if defined(KIRK_AES_X86)
+	if (enable && cpu_info.bAES && cpu_info.bSSE2) {
+		encrypt = &CBCEncryptAESNI;
+		decrypt = &CBCDecryptAESNI;
+	}
+#elif defined(KIRK_AES_ARM64)
+	if (enable && cpu_info.bAES) {
+		encrypt = &CBCEncryptARMv8;
+		decrypt = &CBCDecryptARMv8;
+	}
+#endif
+	AES_set_cbc_backend(encrypt, decrypt);
+	hardwareInUse = encrypt != nullptr;
+	return hardwareInUse;
+}
+
+bool KirkAES_Init() {
+	std::call_once(initOnce, [] {
+		KirkAES_SetHardware(true);
+	});
+	return hardwareInUse;
+}
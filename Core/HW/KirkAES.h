@@ -0,0 +1,29 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+// Hardware accelerated AES (AES-NI or ARMv8 crypto extensions) for libkirk, which is behind
+// PRX decryption, PGD/NPDRM reads and savedata crypto.
+
+// Installs the backend into libkirk if the CPU supports it. Only does anything the first time,
+// so it's fine to call from every path that's about to use libkirk.
+// Returns true if hardware AES is in use.
+bool KirkAES_Init();
+// Switches between the hardware backend and libkirk's table based implementation, for testing.
+// Returns true if hardware AES is now in use.
+bool KirkAES_SetHardware(bool enable);
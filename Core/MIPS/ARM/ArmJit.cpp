@@ -113,6 +113,7 @@ ArmJit::ArmJit(MIPSState *mipsState) : blocks(mipsState, this), gpr(mipsState, &
 	fpr.SetEmitter(this);
 	AllocCodeSpace(1024 * 1024 * 16);  // 32MB is the absolute max because that's what an ARM branch instruction can reach, backwards and forwards.
 	GenerateFixedCode();
+	blocks.InitCodeSegments(GetCodePtr(), region + region_size);
 
 	INFO_LOG(JIT, "ARM JIT initialized: %lld MB of code space", (long long)(GetSpaceLeft() / (1024 * 1024)));
 
@@ -181,6 +182,7 @@ void ArmJit::ClearCache()
 	blocks.Clear();
 	ClearCodeSpace(0);
 	GenerateFixedCode();
+	blocks.InitCodeSegments(GetCodePtr(), region + region_size);
 }
 
 void ArmJit::InvalidateCacheAt(u32 em_address, int length) {
@@ -230,8 +232,11 @@ void ArmJit::Compile(u32 em_address) {
 
 	// INFO_LOG(JIT, "Compiling at %08x", em_address);
 
-	if (GetSpaceLeft() < 0x10000 || blocks.IsFull()) {
+	const u8 *blockStart = blocks.ReserveCodeSpace(GetCodePtr(), 0x10000);
+	if (!blockStart) {
 		ClearCache();
+	} else if (blockStart != GetCodePtr()) {
+		SetCodePtr((u8 *)blockStart);
 	}
 
 	BeginWrite(JitBlockCache::MAX_BLOCK_INSTRUCTIONS * 16);
@@ -361,7 +366,7 @@ const u8 *ArmJit::DoJit(u32 em_address, JitBlock *b)
 		}
 
 		// Safety check, in case we get a bunch of really large jit ops without a lot of branching.
-		if (GetSpaceLeft() < 0x800 || js.numInstructions >= JitBlockCache::MAX_BLOCK_INSTRUCTIONS)
+		if (blocks.GetCodeSpaceLeft(GetCodePtr()) < 0x800 || js.numInstructions >= JitBlockCache::MAX_BLOCK_INSTRUCTIONS)
 		{
 			FlushAll();
 			WriteExit(GetCompilerPC(), js.nextExit++);
@@ -112,6 +112,7 @@ Arm64Jit::Arm64Jit(MIPSState *mipsState) : blocks(mipsState, this), gpr(mipsStat
 	fpr.SetEmitter(this, &fp);
 	AllocCodeSpace(1024 * 1024 * 16);  // 32MB is the absolute max because that's what an ARM branch instruction can reach, backwards and forwards.
 	GenerateFixedCode(jo);
+	blocks.InitCodeSegments(GetCodePtr(), region + region_size);
 	js.startDefaultPrefix = mips_->HasDefaultPrefix();
 	js.currentRoundingFunc = convertS0ToSCRATCH1[mips_->fcr31 & 3];
 
@@ -178,6 +179,7 @@ void Arm64Jit::ClearCache() {
 	blocks.Clear();
 	ClearCodeSpace(jitStartOffset);
 	FlushIcacheSection(region + jitStartOffset, region + region_size - jitStartOffset);
+	blocks.InitCodeSegments(GetCodePtr(), region + region_size);
 }
 
 void Arm64Jit::InvalidateCacheAt(u32 em_address, int length) {
@@ -225,9 +227,12 @@ void Arm64Jit::CompileDelaySlot(int flags) {
 
 void Arm64Jit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
-	if (GetSpaceLeft() < 0x10000 || blocks.IsFull()) {
-		INFO_LOG(JIT, "Space left: %d", (int)GetSpaceLeft());
+	const u8 *blockStart = blocks.ReserveCodeSpace(GetCodePtr(), 0x10000);
+	if (!blockStart) {
+		INFO_LOG(JIT, "Space left: %d", (int)blocks.GetCodeSpaceLeft(GetCodePtr()));
 		ClearCache();
+	} else if (blockStart != GetCodePtr()) {
+		SetCodePtr((u8 *)blockStart);
 	}
 
 	BeginWrite(JitBlockCache::MAX_BLOCK_INSTRUCTIONS * 16);
@@ -353,7 +358,7 @@ const u8 *Arm64Jit::DoJit(u32 em_address, JitBlock *b) {
 		}
 
 		// Safety check, in case we get a bunch of really large jit ops without a lot of branching.
-		if (GetSpaceLeft() < 0x800 || js.numInstructions >= JitBlockCache::MAX_BLOCK_INSTRUCTIONS) {
+		if (blocks.GetCodeSpaceLeft(GetCodePtr()) < 0x800 || js.numInstructions >= JitBlockCache::MAX_BLOCK_INSTRUCTIONS) {
 			FlushAll();
 			WriteExit(GetCompilerPC(), js.nextExit++);
 			js.compiling = false;
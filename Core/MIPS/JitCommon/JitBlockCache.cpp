@@ -93,12 +93,131 @@ bool JitBlockCache::IsFull() const {
 	return num_blocks_ >= MAX_NUM_BLOCKS - 1;
 }
 
+void JitBlockCache::InitCodeSegments(const u8 *start, const u8 *end) {
+	_dbg_assert_msg_(num_blocks_ == 0, "Code segments should be set up on an empty cache");
+	segmentsStart_ = start;
+	// Keep segment starts reasonably aligned.
+	segmentSize_ = ((end - start) / NUM_CODE_SEGMENTS) & ~15;
+	oldestSegment_ = 0;
+	currentSegment_ = 0;
+}
+
+size_t JitBlockCache::GetCodeSpaceLeft(const u8 *codePtr) const {
+	const u8 *segmentEnd = GetSegmentStart(currentSegment_ + 1);
+	return codePtr < segmentEnd ? segmentEnd - codePtr : 0;
+}
+
+const u8 *JitBlockCache::ReserveCodeSpace(const u8 *codePtr, size_t needed) {
+	if (!segmentsStart_) {
+		if (!IsFull())
+			return codePtr;
+		RecordFlush();
+		return nullptr;
+	}
+
+	while (IsFull()) {
+		// Can't evict the segment we're writing to, at that point we might as well clear.
+		if (oldestSegment_ == currentSegment_) {
+			RecordFlush();
+			return nullptr;
+		}
+		EvictOldestSegment();
+	}
+
+	if (GetCodeSpaceLeft(codePtr) >= needed)
+		return codePtr;
+
+	int next = (currentSegment_ + 1) % NUM_CODE_SEGMENTS;
+	if (next == oldestSegment_) {
+		EvictOldestSegment();
+	}
+	currentSegment_ = next;
+	return GetSegmentStart(next);
+}
+
+// The caller is about to clear everything because it ran out of space.
+// Clears for other reasons, like loading a savestate, aren't counted.
+void JitBlockCache::RecordFlush() {
+	numFlushes_++;
+	for (int i = 0; i < num_blocks_; i++) {
+		if (!blocks_[i].invalid && !blocks_[i].IsPureProxy())
+			evictedAddresses_.insert(blocks_[i].originalAddress);
+	}
+}
+
+void JitBlockCache::EvictOldestSegment() {
+	const u8 *start = GetSegmentStart(oldestSegment_);
+	const u8 *end = GetSegmentStart(oldestSegment_ + 1);
+	oldestSegment_ = (oldestSegment_ + 1) % NUM_CODE_SEGMENTS;
+
+	// The oldest blocks come first, so everything in the segment is at the start.
+	int count = 0;
+	while (count < num_blocks_ && blocks_[count].normalEntry >= start && blocks_[count].normalEntry < end)
+		count++;
+	if (count == 0)
+		return;
+
+	// Other blocks might jump directly into the code we're about to overwrite.  Exits can't
+	// always be rewritten in place, so those blocks go too.  Their own entries are stubbed out,
+	// so anything linked to them in turn just goes back to the dispatcher.
+	std::vector<int> linkedFrom;
+	for (int i = 0; i < count; i++) {
+		const JitBlock &b = blocks_[i];
+		if (!b.invalid && !b.IsPureProxy())
+			evictedAddresses_.insert(b.originalAddress);
+		auto range = links_to_.equal_range(b.originalAddress);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second >= count)
+				linkedFrom.push_back(it->second);
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		DestroyBlock(i, DestroyType::EVICT);
+	for (int i : linkedFrom) {
+		if (!blocks_[i].invalid) {
+			evictedAddresses_.insert(blocks_[i].originalAddress);
+			DestroyBlock(i, DestroyType::INVALIDATE);
+		}
+	}
+
+	// Now drop them from the table and renumber the rest.
+	std::copy(blocks_ + count, blocks_ + num_blocks_, blocks_);
+	num_blocks_ -= count;
+	for (int i = 0; i < num_blocks_; i++)
+		blocks_[i].blockNum = i;
+
+	auto renumber = [count](auto &map) {
+		for (auto it = map.begin(); it != map.end(); ) {
+			if ((int)it->second < count) {
+				it = map.erase(it);
+			} else {
+				it->second -= count;
+				++it;
+			}
+		}
+	};
+	renumber(block_map_);
+	renumber(proxyBlockMap_);
+	renumber(links_to_);
+
+	numEvictions_++;
+	numBlocksEvicted_ += count;
+	DEBUG_LOG(JIT, "Evicted %d jit blocks to reuse code space, %d left", count, num_blocks_);
+}
+
 void JitBlockCache::Init() {
 #if defined USE_OPROFILE && USE_OPROFILE
 	agent = op_open_agent();
 #endif
 	blocks_ = new JitBlock[MAX_NUM_BLOCKS];
 	Clear();
+
+	evictedAddresses_.clear();
+	numFlushes_ = 0;
+	numEvictions_ = 0;
+	numBlocksEvicted_ = 0;
+	numRecompiles_ = 0;
 }
 
 void JitBlockCache::Shutdown() {
@@ -124,6 +243,8 @@ void JitBlockCache::Clear() {
 		DestroyBlock(i, DestroyType::CLEAR);
 	links_to_.clear();
 	num_blocks_ = 0;
+	oldestSegment_ = 0;
+	currentSegment_ = 0;
 
 	blockMemRanges_[JITBLOCK_RANGE_SCRATCH] = std::make_pair(0xFFFFFFFF, 0x00000000);
 	blockMemRanges_[JITBLOCK_RANGE_RAMBOTTOM] = std::make_pair(0xFFFFFFFF, 0x00000000);
@@ -146,6 +267,9 @@ const JitBlock *JitBlockCache::GetBlock(int no) const {
 int JitBlockCache::AllocateBlock(u32 startAddress) {
 	JitBlock &b = blocks_[num_blocks_];
 
+	if (!evictedAddresses_.empty() && evictedAddresses_.erase(startAddress) != 0)
+		numRecompiles_++;
+
 	b.proxyFor = 0;
 	// If there's an existing pure proxy block at the address, we need to ditch it and create a new one,
 	// taking over the proxied blocks.
@@ -309,10 +433,21 @@ bool JitBlockCache::RangeMayHaveEmuHacks(u32 start, u32 end) const {
 	return false;
 }
 
-static int binary_search(const JitBlock blocks_[], const u8 *baseoff, int imin, int imax) {
+int JitBlockCache::FindBlockByEntry(const u8 *baseoff) const {
+	// Blocks are sorted by entry, but once the segments wrap around, the newest blocks are
+	// at lower addresses.  Measuring from the first (oldest) block takes care of that.
+	const u8 *first = blocks_[0].normalEntry;
+	const size_t wrap = segmentSize_ * NUM_CODE_SEGMENTS;
+	auto distance = [&](const u8 *p) -> size_t {
+		return p >= first ? (size_t)(p - first) : (size_t)(p - first) + wrap;
+	};
+
+	const size_t target = distance(baseoff);
+	int imin = 0;
+	int imax = num_blocks_ - 1;
 	while (imin < imax) {
 		int imid = (imin + imax) / 2;
-		if (blocks_[imid].normalEntry < baseoff)
+		if (distance(blocks_[imid].normalEntry) < target)
 			imin = imid + 1;
 		else
 			imax = imid;
@@ -329,14 +464,16 @@ int JitBlockCache::GetBlockNumberFromEmuHackOp(MIPSOpcode inst, bool ignoreBad)
 	int off = (inst & MIPS_EMUHACK_VALUE_MASK);
 
 	const u8 *baseoff = codeBlock_->GetBasePtr() + off;
-	if (baseoff < codeBlock_->GetBasePtr() || baseoff >= codeBlock_->GetCodePtr()) {
+	// With segments, valid blocks may be past the current code pointer.
+	const u8 *codeEnd = segmentsStart_ ? GetSegmentStart(NUM_CODE_SEGMENTS) : codeBlock_->GetCodePtr();
+	if (baseoff < codeBlock_->GetBasePtr() || baseoff >= codeEnd) {
 		if (!ignoreBad) {
 			ERROR_LOG(JIT, "JitBlockCache: Invalid Emuhack Op %08x", inst.encoding);
 		}
 		return -1;
 	}
 
-	int bl = binary_search(blocks_, baseoff, 0, num_blocks_ - 1);
+	int bl = FindBlockByEntry(baseoff);
 	if (bl >= 0 && blocks_[bl].invalid) {
 		return -1;
 	} else {
@@ -525,7 +662,8 @@ void JitBlockCache::DestroyBlock(int block_num, DestroyType type) {
 			int proxied_blocknum = GetBlockNumberFromStartAddress((*b->proxyFor)[i], false);
 			// If it was already cleared, we don't know which to destroy.
 			if (proxied_blocknum != -1) {
-				DestroyBlock(proxied_blocknum, type);
+				// The root's code is fine, but it can't be tracked anymore, so it has to go properly.
+				DestroyBlock(proxied_blocknum, type == DestroyType::EVICT ? DestroyType::INVALIDATE : type);
 			}
 		}
 		b->proxyFor->clear();
@@ -568,7 +706,7 @@ void JitBlockCache::DestroyBlock(int block_num, DestroyType type) {
 
 	if (b->checkedEntry) {
 		// We can skip this if we're clearing anyway, which cuts down on protect back and forth on WX exclusive.
-		if (type != DestroyType::CLEAR) {
+		if (type != DestroyType::CLEAR && type != DestroyType::EVICT) {
 			u8 *writableEntry = codeBlock_->GetWritablePtrFromCodePtr(b->checkedEntry);
 			MIPSComp::jit->UnlinkBlock(writableEntry, b->originalAddress);
 		}
@@ -679,6 +817,10 @@ void JitBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 	bcStats.minBloat = (float)minBloat;
 	bcStats.maxBloat = (float)maxBloat;
 	bcStats.avgBloat = (float)(totalBloat / (double)num_blocks_);
+	bcStats.numFlushes = numFlushes_;
+	bcStats.numEvictions = numEvictions_;
+	bcStats.numBlocksEvicted = numBlocksEvicted_;
+	bcStats.numRecompiles = numRecompiles_;
 }
 
 JitBlockDebugInfo JitBlockCache::GetBlockDebugInfo(int blockNum) const {
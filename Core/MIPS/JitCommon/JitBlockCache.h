@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 
@@ -43,6 +44,12 @@ struct BlockCacheStats {
 	float maxBloat;
 	u32 maxBloatBlock;
 	std::map<float, u32> bloatMap;
+
+	// Since the last reset.
+	int numFlushes = 0;
+	int numEvictions = 0;
+	int numBlocksEvicted = 0;
+	int numRecompiles = 0;
 };
 
 enum class DestroyType {
@@ -50,6 +57,8 @@ enum class DestroyType {
 	INVALIDATE,
 	// Skips jit unlink, since it'll be poisoned anyway.
 	CLEAR,
+	// Like CLEAR, but only for this block (its code space is about to be reused.)
+	EVICT,
 };
 
 // Define this in order to get VTune profile support for the Jit generated code.
@@ -131,6 +140,17 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	bool IsFull() const;
 	void ComputeStats(BlockCacheStats &bcStats) const override;
 
+	// The code space after the fixed code is split into segments that are filled in turn.
+	// Once they're all used, the oldest segment is evicted and reused, rather than clearing
+	// the whole cache.  Call this after (re)generating the fixed code.
+	void InitCodeSegments(const u8 *start, const u8 *end);
+	// Makes sure there's room for a new block of up to needed bytes, and space in the block table.
+	// Returns where to emit it: codePtr, or the start of a recycled segment.
+	// Returns nullptr if that's not possible, and the caller should clear the cache instead.
+	const u8 *ReserveCodeSpace(const u8 *codePtr, size_t needed);
+	// Space left for code in the segment being written.
+	size_t GetCodeSpaceLeft(const u8 *codePtr) const;
+
 	// Code Cache
 	JitBlock *GetBlock(int block_num);
 	const JitBlock *GetBlock(int block_num) const;
@@ -182,6 +202,13 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	void RemoveBlockMap(int block_num);
 
 	MIPSOpcode GetEmuHackOpForBlock(int block_num) const;
+	int FindBlockByEntry(const u8 *normalEntry) const;
+
+	const u8 *GetSegmentStart(int segment) const {
+		return segmentsStart_ + segment * segmentSize_;
+	}
+	void EvictOldestSegment();
+	void RecordFlush();
 
 	CodeBlockCommon *codeBlock_;
 	JitBlock *blocks_;
@@ -200,7 +227,22 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	std::pair<u32, u32> blockMemRanges_[3];
 
 	enum {
-		MAX_NUM_BLOCKS = 65536*2
+		MAX_NUM_BLOCKS = 65536*2,
+		NUM_CODE_SEGMENTS = 8,
 	};
+
+	// Blocks are always in emission order, which matches address order except for at most one
+	// wrap around from the last segment to the first.
+	const u8 *segmentsStart_ = nullptr;
+	size_t segmentSize_ = 0;
+	int oldestSegment_ = 0;
+	int currentSegment_ = 0;
+
+	// For stats, addresses that were dropped only to make space and may be compiled again.
+	std::unordered_set<u32> evictedAddresses_;
+	int numFlushes_ = 0;
+	int numEvictions_ = 0;
+	int numBlocksEvicted_ = 0;
+	int numRecompiles_ = 0;
 };
 
@@ -114,6 +114,7 @@ Jit::Jit(MIPSState *mipsState)
 	fpr.SetEmitter(this);
 	AllocCodeSpace(1024 * 1024 * 16);
 	GenerateFixedCode(jo);
+	blocks.InitCodeSegments(GetCodePtr(), region + region_size);
 
 	safeMemFuncs.Init(&thunks);
 
@@ -214,6 +215,7 @@ void Jit::ClearCache()
 	blocks.Clear();
 	ClearCodeSpace(0);
 	GenerateFixedCode(jo);
+	blocks.InitCodeSegments(GetCodePtr(), region + region_size);
 }
 
 void Jit::SaveFlags() {
@@ -272,8 +274,11 @@ void Jit::EatInstruction(MIPSOpcode op) {
 
 void Jit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
-	if (GetSpaceLeft() < 0x10000 || blocks.IsFull()) {
+	const u8 *blockStart = blocks.ReserveCodeSpace(GetCodePtr(), 0x10000);
+	if (!blockStart) {
 		ClearCache();
+	} else if (blockStart != GetCodePtr()) {
+		SetCodePtr((u8 *)blockStart);
 	}
 
 	if (!Memory::IsValidAddress(em_address) || (em_address & 3) != 0) {
@@ -407,7 +412,7 @@ const u8 *Jit::DoJit(u32 em_address, JitBlock *b) {
 		}
 
 		// Safety check, in case we get a bunch of really large jit ops without a lot of branching.
-		if (GetSpaceLeft() < 0x800 || js.numInstructions >= JitBlockCache::MAX_BLOCK_INSTRUCTIONS) {
+		if (blocks.GetCodeSpaceLeft(GetCodePtr()) < 0x800 || js.numInstructions >= JitBlockCache::MAX_BLOCK_INSTRUCTIONS) {
 			FlushAll();
 			WriteExit(GetCompilerPC(), js.nextExit++);
 			js.compiling = false;
@@ -0,0 +1,300 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <zstd.h>
+
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ext/xxhash.h"
+
+#include "Common/Log.h"
+#include "Core/ReplacementPack.h"
+
+static const char *PACK_MAGIC = "ppssppTP";
+static const u32 PACK_VERSION = 1;
+// Only done once per pack, so might as well compress well.  Doesn't affect decompression speed.
+static const int COMPRESSION_LEVEL = 9;
+
+static_assert(sizeof(ReplacementPack::Header) == 40, "Pack header should not have padding");
+static_assert(sizeof(ReplacementPack::Entry) == 40, "Pack entries should not have padding");
+
+ReplacementPack::~ReplacementPack() {
+	Close();
+}
+
+bool ReplacementPack::Open(const Path &filename) {
+	Close();
+	if (!Map(filename))
+		return false;
+
+	if (!Validate()) {
+		ERROR_LOG(G3D, "Invalid or corrupt texture pack: %s", filename.c_str());
+		Close();
+		return false;
+	}
+
+	INFO_LOG(G3D, "Opened texture pack with %d files: %s", entryCount_, filename.c_str());
+	return true;
+}
+
+void ReplacementPack::Close() {
+	Unmap();
+	entries_ = nullptr;
+	entryCount_ = 0;
+	names_ = nullptr;
+	namesSize_ = 0;
+}
+
+bool ReplacementPack::Map(const Path &filename) {
+#if PPSSPP_PLATFORM(UWP)
+	// No plain file access to map, textures.zip or loose files still work.
+	return false;
+#elif PPSSPP_PLATFORM(WINDOWS)
+	HANDLE file = CreateFileW(filename.ToWString().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size{};
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart >= (LONGLONG)sizeof(Header) && (u64)size.QuadPart <= (u64)SIZE_MAX)
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	// The view keeps the mapping and file alive.
+	base_ = (const u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!base_) {
+		ERROR_LOG(G3D, "Unable to map texture pack: %s", filename.c_str());
+		return false;
+	}
+	size_ = (size_t)size.QuadPart;
+	return true;
+#else
+	int fd;
+	if (filename.Type() == PathType::CONTENT_URI)
+		fd = File::OpenFD(filename, File::OPEN_READ);
+	else
+		fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st{};
+	void *base = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header) && (u64)st.st_size <= (u64)SIZE_MAX)
+		base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		// Too large for the address space on 32-bit, most likely.
+		ERROR_LOG(G3D, "Unable to map texture pack: %s", filename.c_str());
+		return false;
+	}
+	base_ = (const u8 *)base;
+	size_ = (size_t)st.st_size;
+	return true;
+#endif
+}
+
+void ReplacementPack::Unmap() {
+	if (!base_)
+		return;
+#if PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
+	UnmapViewOfFile(base_);
+#elif !PPSSPP_PLATFORM(WINDOWS)
+	munmap((void *)base_, size_);
+#endif
+	base_ = nullptr;
+	size_ = 0;
+}
+
+bool ReplacementPack::Validate() {
+	const Header *header = (const Header *)base_;
+	if (memcmp(header->magic, PACK_MAGIC, sizeof(header->magic)) != 0 || header->version != PACK_VERSION)
+		return false;
+
+	const u64 indexOffset = header->indexOffset;
+	const u64 namesOffset = header->namesOffset;
+	const u64 indexSize = (u64)header->entryCount * sizeof(Entry);
+	if ((indexOffset & 7) != 0 || indexOffset > size_ || indexSize > size_ - indexOffset)
+		return false;
+	if (namesOffset > size_ || header->namesSize > size_ - namesOffset)
+		return false;
+
+	entries_ = (const Entry *)(base_ + indexOffset);
+	entryCount_ = header->entryCount;
+	names_ = (const char *)(base_ + namesOffset);
+	namesSize_ = header->namesSize;
+
+	// Check everything once up front, so lookups and reads can trust the index.
+	for (u32 i = 0; i < entryCount_; ++i) {
+		const Entry &entry = entries_[i];
+		if (i > 0 && entries_[i - 1].nameHash > entry.nameHash)
+			return false;
+		if (entry.offset > size_ || entry.compressedSize > size_ - entry.offset)
+			return false;
+		if (entry.nameOffset > namesSize_ || entry.nameSize > namesSize_ - entry.nameOffset)
+			return false;
+		if (entry.type == ReplacementPackType::RGBA8888 && (u64)entry.w * entry.h * 4 != entry.size)
+			return false;
+	}
+	return true;
+}
+
+std::string ReplacementPack::NormalizeName(const std::string &name) {
+	std::string normalized = name;
+	for (char &c : normalized) {
+		if (c == '\\')
+			c = '/';
+		else if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+	}
+	return normalized;
+}
+
+u64 ReplacementPack::HashName(const std::string &normalizedName) {
+	return XXH3_64bits(normalizedName.data(), normalizedName.size());
+}
+
+int ReplacementPack::Find(const std::string &name) const {
+	if (!base_)
+		return -1;
+
+	const std::string normalized = NormalizeName(name);
+	const u64 hash = HashName(normalized);
+	const Entry *end = entries_ + entryCount_;
+	const Entry *it = std::lower_bound(entries_, end, hash, [](const Entry &entry, u64 hash) {
+		return entry.nameHash < hash;
+	});
+	for (; it != end && it->nameHash == hash; ++it) {
+		if (it->nameSize == normalized.size() && memcmp(names_ + it->nameOffset, normalized.data(), normalized.size()) == 0)
+			return (int)(it - entries_);
+	}
+	return -1;
+}
+
+bool ReplacementPack::Read(const Entry *entry, void *dest) const {
+	size_t result = ZSTD_decompress(dest, entry->size, base_ + entry->offset, entry->compressedSize);
+	if (ZSTD_isError(result) || result != entry->size) {
+		ERROR_LOG(G3D, "Corrupt data in texture pack: %.*s", (int)entry->nameSize, names_ + entry->nameOffset);
+		return false;
+	}
+	return true;
+}
+
+bool ReplacementPack::ReadString(const std::string &name, std::string *data) const {
+	const Entry *entry = GetEntry(Find(name));
+	if (!entry || entry->type != ReplacementPackType::RAW)
+		return false;
+
+	data->resize(entry->size);
+	if (entry->size == 0)
+		return true;
+	return Read(entry, &(*data)[0]);
+}
+
+bool ReplacementPackWriter::Begin(const Path &filename) {
+	entries_.clear();
+	names_.clear();
+	failed_ = false;
+
+	if (!file_.Open(filename, "wb"))
+		return false;
+
+	// Rewritten by Finish(), the magic only goes in once everything else is there.
+	ReplacementPack::Header header{};
+	offset_ = sizeof(header);
+	return file_.WriteBytes(&header, sizeof(header));
+}
+
+bool ReplacementPackWriter::AddRaw(const std::string &name, const void *data, size_t size) {
+	return Add(name, ReplacementPackType::RAW, data, size, 0, 0, 0);
+}
+
+bool ReplacementPackWriter::AddImage(const std::string &name, const u32 *pixels, int w, int h, u8 alphaResult) {
+	return Add(name, ReplacementPackType::RGBA8888, pixels, (size_t)w * h * 4, w, h, alphaResult);
+}
+
+bool ReplacementPackWriter::Add(const std::string &name, ReplacementPackType type, const void *data, size_t size, int w, int h, u8 alphaResult) {
+	const std::string normalized = ReplacementPack::NormalizeName(name);
+	if (failed_ || size > 0xFFFFFFFF || normalized.size() > 0xFFFF)
+		return false;
+
+	compressed_.resize(ZSTD_compressBound(size));
+	size_t compressedSize = ZSTD_compress(&compressed_[0], compressed_.size(), data, size, COMPRESSION_LEVEL);
+	if (ZSTD_isError(compressedSize) || !file_.WriteBytes(&compressed_[0], compressedSize)) {
+		failed_ = true;
+		return false;
+	}
+
+	ReplacementPack::Entry entry{};
+	entry.nameHash = ReplacementPack::HashName(normalized);
+	entry.offset = offset_;
+	entry.compressedSize = (u32)compressedSize;
+	entry.size = (u32)size;
+	entry.w = w;
+	entry.h = h;
+	entry.nameOffset = (u32)names_.size();
+	entry.nameSize = (u16)normalized.size();
+	entry.type = type;
+	entry.alphaResult = alphaResult;
+	entries_.push_back(entry);
+
+	names_ += normalized;
+	offset_ += compressedSize;
+	return true;
+}
+
+bool ReplacementPackWriter::Finish() {
+	std::sort(entries_.begin(), entries_.end(), [](const ReplacementPack::Entry &a, const ReplacementPack::Entry &b) {
+		return a.nameHash < b.nameHash;
+	});
+
+	// Keep the index aligned, it's used in place.
+	static const u8 padding[8]{};
+	const size_t padSize = (size_t)((8 - (offset_ & 7)) & 7);
+
+	ReplacementPack::Header header{};
+	memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+	header.version = PACK_VERSION;
+	header.entryCount = (u32)entries_.size();
+	header.indexOffset = offset_ + padSize;
+	header.namesOffset = header.indexOffset + entries_.size() * sizeof(ReplacementPack::Entry);
+	header.namesSize = (u32)names_.size();
+
+	bool success = !failed_ && file_.WriteBytes(padding, padSize);
+	success = success && file_.WriteArray(entries_.data(), entries_.size());
+	success = success && file_.WriteBytes(names_.data(), names_.size());
+	success = success && file_.Seek(0, SEEK_SET) && file_.WriteBytes(&header, sizeof(header));
+	success = file_.Close() && success;
+
+	entries_.clear();
+	names_.clear();
+	compressed_.clear();
+	return success;
+}
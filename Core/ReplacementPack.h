@@ -0,0 +1,121 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+
+// textures.pack holds a whole texture replacement folder, with the images already decoded to
+// RGBA8888 and zstd compressed, behind a sorted index of filename hashes.  The file is memory
+// mapped, so lookups and loads never take a lock and never touch libpng or libzip.
+//
+// File format:
+// Header
+// { zstd frame } repeated, one per file.
+// Entry index, sorted by nameHash.
+// Names (lowercase, / separated, not null terminated.)
+enum class ReplacementPackType : u8 {
+	// Any other file, currently only the ini files.
+	RAW = 0,
+	RGBA8888 = 1,
+};
+
+class ReplacementPack {
+public:
+	struct Header {
+		char magic[8];
+		u32_le version;
+		u32_le entryCount;
+		u64_le indexOffset;
+		u64_le namesOffset;
+		u32_le namesSize;
+		u32_le reserved;
+	};
+
+	struct Entry {
+		u64_le nameHash;
+		u64_le offset;
+		u32_le compressedSize;
+		// Decompressed size in bytes.
+		u32_le size;
+		u32_le w;
+		u32_le h;
+		u32_le nameOffset;
+		u16_le nameSize;
+		ReplacementPackType type;
+		// A CheckAlphaResult, only for images.
+		u8 alphaResult;
+	};
+
+	~ReplacementPack();
+
+	bool Open(const Path &filename);
+	void Close();
+	bool IsOpen() const { return base_ != nullptr; }
+
+	// Names are looked up case insensitively, like in textures.zip.  Returns -1 if not found.
+	int Find(const std::string &name) const;
+	const Entry *GetEntry(int index) const {
+		if (index < 0 || (u32)index >= entryCount_)
+			return nullptr;
+		return &entries_[index];
+	}
+	// Decompresses the whole entry, dest must have room for entry->size bytes.
+	bool Read(const Entry *entry, void *dest) const;
+	bool ReadString(const std::string &name, std::string *data) const;
+
+	static std::string NormalizeName(const std::string &name);
+	static u64 HashName(const std::string &normalizedName);
+
+private:
+	bool Map(const Path &filename);
+	void Unmap();
+	bool Validate();
+
+	const u8 *base_ = nullptr;
+	size_t size_ = 0;
+	const Entry *entries_ = nullptr;
+	u32 entryCount_ = 0;
+	const char *names_ = nullptr;
+	u32 namesSize_ = 0;
+};
+
+// Builds a textures.pack, payloads are written as they're added.
+class ReplacementPackWriter {
+public:
+	bool Begin(const Path &filename);
+	bool AddRaw(const std::string &name, const void *data, size_t size);
+	bool AddImage(const std::string &name, const u32 *pixels, int w, int h, u8 alphaResult);
+	// Writes the index, returns false if anything went wrong along the way.
+	bool Finish();
+
+private:
+	bool Add(const std::string &name, ReplacementPackType type, const void *data, size_t size, int w, int h, u8 alphaResult);
+
+	File::IOFile file_;
+	u64 offset_ = 0;
+	std::vector<ReplacementPack::Entry> entries_;
+	std::string names_;
+	std::vector<u8> compressed_;
+	bool failed_ = false;
+};
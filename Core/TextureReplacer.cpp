@@ -34,6 +34,7 @@
 #include "Common/Data/Format/ZIMLoad.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Text/Parsers.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/LogReporting.h"
 #include "Common/StringUtils.h"
@@ -51,6 +52,9 @@
 
 static const std::string INI_FILENAME = "textures.ini";
 static const std::string ZIP_FILENAME = "textures.zip";
+static const std::string PACK_FILENAME = "textures.pack";
+// A pack built while the old one was in use, swapped in the next time the pack is opened.
+static const std::string NEW_PACK_FILENAME = "textures.pack.new";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
 static const int MAX_MIP_LEVELS = 12;  // 12 should be plenty, 8 is the max mip levels supported by the PSP.
@@ -97,6 +101,7 @@ void TextureReplacer::NotifyConfigChanged() {
 		enabled_ = File::IsDirectory(basePath_);
 	} else if (wasEnabled) {
 		zip_.Close();
+		ClosePack();
 		Decimate(ReplacerDecimateMode::ALL);
 	}
 
@@ -143,6 +148,15 @@ static bool LoadIniZip(IniFile &ini, zip *z, const std::string &filename) {
 	return ini.Load(sstream);
 }
 
+static bool LoadIniPack(IniFile &ini, const ReplacementPack &pack, const std::string &filename) {
+	std::string inistr;
+	if (!pack.ReadString(filename, &inistr))
+		return false;
+
+	std::stringstream sstream(inistr);
+	return ini.Load(sstream);
+}
+
 bool TextureReplacer::LoadIni() {
 	// TODO: Use crc32c?
 	hash_ = ReplacedTextureHash::QUICK;
@@ -163,8 +177,15 @@ bool TextureReplacer::LoadIni() {
 	IniFile ini;
 	bool iniLoaded = false;
 
-	// First, check for textures.zip, which is used to reduce IO.
-	zip *z = ZipOpenPath(basePath_ / ZIP_FILENAME);
+	// First, check for textures.pack, which has everything decoded and indexed already.
+	// Like the zip, it replaces the loose files entirely.
+	zip *z = nullptr;
+	if (OpenPack()) {
+		iniLoaded = LoadIniPack(ini, *pack_, INI_FILENAME);
+	} else {
+		// Then for textures.zip, which is used to reduce IO.
+		z = ZipOpenPath(basePath_ / ZIP_FILENAME);
+	}
 	if (z) {
 		iniLoaded = LoadIniZip(ini, z, INI_FILENAME);
 		// Require the zip have textures.ini to use it.
@@ -178,7 +199,7 @@ bool TextureReplacer::LoadIni() {
 		}
 	}
 
-	if (!iniLoaded) {
+	if (!iniLoaded && !pack_) {
 		iniLoaded = ini.LoadFromVFS((basePath_ / INI_FILENAME).ToString());
 	}
 
@@ -192,7 +213,9 @@ bool TextureReplacer::LoadIni() {
 		if (ini.GetOrCreateSection("games")->Get(gameID_.c_str(), &overrideFilename, "")) {
 			if (!overrideFilename.empty() && overrideFilename != INI_FILENAME) {
 				IniFile overrideIni;
-				if (zip_.z) {
+				if (pack_) {
+					iniLoaded = LoadIniPack(overrideIni, *pack_, overrideFilename);
+				} else if (zip_.z) {
 					std::lock_guard<std::mutex> guard(zip_.lock);
 					iniLoaded = LoadIniZip(overrideIni, zip_.z, overrideFilename);
 				} else {
@@ -215,6 +238,58 @@ bool TextureReplacer::LoadIni() {
 	return true;
 }
 
+bool TextureReplacer::OpenPack() {
+	const Path packFilename = basePath_ / PACK_FILENAME;
+	const Path newFilename = basePath_ / NEW_PACK_FILENAME;
+	if (File::Exists(newFilename)) {
+		// Nothing can still be reading the old one once it's closed.
+		ClosePack();
+		if (!File::Exists(packFilename) || File::Delete(packFilename))
+			File::Rename(newFilename, packFilename);
+	}
+
+	File::FileInfo info;
+	if (!File::GetFileInfo(packFilename, &info)) {
+		ClosePack();
+		return false;
+	}
+
+	// Reloading the ini doesn't need a new mapping, unless the pack was rebuilt.
+	if (pack_ && packInfo_.fullName == info.fullName && packInfo_.size == info.size && packInfo_.mtime == info.mtime)
+		return true;
+
+	ClosePack();
+	std::shared_ptr<ReplacementPack> pack = std::make_shared<ReplacementPack>();
+	if (!pack->Open(packFilename))
+		return false;
+
+	// Anything already found came from the zip or loose files.
+	ClearReplacements();
+	pack_ = pack;
+	packInfo_ = info;
+	return true;
+}
+
+void TextureReplacer::ClosePack() {
+	if (!pack_)
+		return;
+
+	// Levels keep their own reference, so the mapping goes away once they're gone too.
+	ClearReplacements();
+	pack_.reset();
+	packInfo_ = File::FileInfo();
+}
+
+void TextureReplacer::ClearReplacements() {
+	// Let loads already running on threads finish first, they may be reading from the pack.
+	for (auto &item : cache_) {
+		if (item.second.threadWaitable_)
+			item.second.threadWaitable_->Wait();
+	}
+	cache_.clear();
+	levelCache_.clear();
+}
+
 bool TextureReplacer::LoadIniValues(IniFile &ini, bool isOverride) {
 	auto options = ini.GetOrCreateSection("options");
 	std::string hash;
@@ -508,7 +583,9 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 
 		bool good;
 		bool logError = hashfile != HashName(cachekey, hash, i) + ".png";
-		if (zip_.z) {
+		if (pack_) {
+			good = PopulateLevelFromPack(level, hashfile, !logError);
+		} else if (zip_.z) {
 			level.zinfo = &zip_;
 
 			std::lock_guard<std::mutex> guard(zip_.lock);
@@ -673,6 +750,27 @@ bool TextureReplacer::PopulateLevelFromZip(ReplacedTextureLevel &level, bool ign
 	return good;
 }
 
+bool TextureReplacer::PopulateLevelFromPack(ReplacedTextureLevel &level, const std::string &hashfile, bool ignoreError) {
+	level.pack = pack_;
+	level.packIndex = pack_->Find(hashfile);
+
+	const ReplacementPack::Entry *entry = pack_->GetEntry(level.packIndex);
+	if (!entry) {
+		if (!ignoreError)
+			ERROR_LOG(G3D, "Error opening replacement texture file '%s' in textures.pack", level.file.c_str());
+		return false;
+	}
+	if (entry->type != ReplacementPackType::RGBA8888) {
+		ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported format (pack)", level.file.ToVisualString().c_str());
+		return false;
+	}
+
+	// No need to look at the image at all, the size is in the index.
+	level.w = entry->w;
+	level.h = entry->h;
+	return true;
+}
+
 static bool WriteTextureToPNG(png_imagep image, const Path &filename, int convert_to_8bit, const void *buffer, png_int_32 row_stride, const void *colormap) {
 	FILE *fp = File::OpenCFile(filename, "wb");
 	if (!fp) {
@@ -1075,6 +1173,38 @@ void ReplacedTexture::PrepareData(int level) {
 	if (!out.empty())
 		return;
 
+	if (info.pack) {
+		// Already decoded, and the level keeps the mapping alive, so no lock is needed to read it.
+		const ReplacementPack::Entry *entry = info.pack->GetEntry(info.packIndex);
+		if (!entry || entry->type != ReplacementPackType::RGBA8888 || (int)entry->w > info.w || (int)entry->h > info.h) {
+			ERROR_LOG(G3D, "Texture replacement changed since header read: %s", info.file.c_str());
+			return;
+		}
+
+		out.resize(info.w * info.h * 4);
+		bool success;
+		if ((int)entry->w == info.w) {
+			success = info.pack->Read(entry, &out[0]);
+		} else {
+			// Padded because of a hashrange.
+			std::vector<uint8_t> image(entry->size);
+			success = info.pack->Read(entry, &image[0]);
+			for (int y = 0; success && y < (int)entry->h; ++y) {
+				memcpy(&out[info.w * 4 * y], &image[entry->w * 4 * y], entry->w * 4);
+			}
+		}
+		if (!success) {
+			out.resize(0);
+			return;
+		}
+
+		CheckAlphaResult res = (CheckAlphaResult)entry->alphaResult;
+		if (res == CHECKALPHA_ANY || level == 0) {
+			alphaStatus_ = ReplacedTextureAlpha(res);
+		}
+		return;
+	}
+
 	FILE *fp = nullptr;
 	zip_file_t *zf = nullptr;
 	ReplacedImageType imageType;
@@ -1352,3 +1482,193 @@ bool TextureReplacer::GenerateIni(const std::string &gameID, Path &generatedFile
 	}
 	return File::Exists(generatedFilename);
 }
+
+static bool DecodeReplacementImage(const std::string &data, std::vector<u32> &pixels, int *w, int *h) {
+	if (data.size() < 16)
+		return false;
+
+	const uint8_t *p = (const uint8_t *)data.data();
+	ReplacedImageType imageType = Identify(p);
+	if (imageType == ReplacedImageType::ZIM) {
+		int flags;
+		memcpy(&flags, p + 12, 4);
+		if ((flags & ZIM_FORMAT_MASK) != ZIM_RGBA8888)
+			return false;
+
+		uint8_t *image;
+		if (!LoadZIMPtr(p, data.size(), w, h, &flags, &image))
+			return false;
+		pixels.resize(*w * *h);
+		memcpy(&pixels[0], image, *w * *h * 4);
+		free(image);
+		return true;
+	} else if (imageType == ReplacedImageType::PNG) {
+		png_image png = {};
+		png.version = PNG_IMAGE_VERSION;
+		if (!png_image_begin_read_from_memory(&png, p, data.size()))
+			return false;
+
+		png.format = PNG_FORMAT_RGBA;
+		*w = png.width;
+		*h = png.height;
+		pixels.resize(*w * *h);
+		bool success = png_image_finish_read(&png, nullptr, &pixels[0], *w * 4, nullptr) != 0;
+		png_image_free(&png);
+		return success;
+	}
+	return false;
+}
+
+static void ListPackFiles(const Path &dir, const std::string &prefix, std::vector<std::pair<std::string, Path>> &files) {
+	std::vector<File::FileInfo> infos;
+	File::GetFilesInDir(dir, &infos);
+	for (const File::FileInfo &info : infos) {
+		if (info.isDirectory) {
+			// Newly saved textures aren't replacements (yet.)
+			if (prefix.empty() && info.name + "/" == NEW_TEXTURE_DIR)
+				continue;
+			ListPackFiles(info.fullName, prefix + info.name + "/", files);
+		} else {
+			files.push_back(std::make_pair(prefix + info.name, info.fullName));
+		}
+	}
+}
+
+bool TextureReplacer::BuildPack(const Path &texturesDirectory) {
+	// Same as when loading: a textures.zip is only used if it has a textures.ini.
+	zip *z = ZipOpenPath(texturesDirectory / ZIP_FILENAME);
+	if (z && zip_name_locate(z, INI_FILENAME.c_str(), ZIP_FL_NOCASE) < 0) {
+		zip_close(z);
+		z = nullptr;
+	}
+
+	// Either a path or an index in the zip.
+	std::vector<std::pair<std::string, Path>> files;
+	std::vector<zip_int64_t> zipIndices;
+	if (z) {
+		zip_int64_t count = zip_get_num_entries(z, 0);
+		for (zip_int64_t i = 0; i < count; ++i) {
+			const char *name = zip_get_name(z, i, 0);
+			if (name && !endsWith(name, "/")) {
+				files.push_back(std::make_pair(std::string(name), Path()));
+				zipIndices.push_back(i);
+			}
+		}
+	} else {
+		ListPackFiles(texturesDirectory, "", files);
+	}
+
+	auto isImage = [](const std::string &name) {
+		return endsWithNoCase(name, ".png") || endsWithNoCase(name, ".zim");
+	};
+
+	const Path packFilename = texturesDirectory / PACK_FILENAME;
+	const Path tempFilename = texturesDirectory / (PACK_FILENAME + ".tmp");
+	const Path newFilename = texturesDirectory / NEW_PACK_FILENAME;
+	ReplacementPackWriter writer;
+	bool success = writer.Begin(tempFilename);
+
+	// Decoding is by far the slowest part, so do that in parallel, a few files at a time.
+	const size_t BATCH_SIZE = 16;
+	std::vector<std::string> data(BATCH_SIZE);
+	std::vector<std::vector<u32>> pixels(BATCH_SIZE);
+	std::vector<int> widths(BATCH_SIZE), heights(BATCH_SIZE);
+	std::vector<uint8_t> decoded(BATCH_SIZE);
+	int images = 0;
+	for (size_t start = 0; success && start < files.size(); start += BATCH_SIZE) {
+		const int count = (int)std::min(BATCH_SIZE, files.size() - start);
+		for (int i = 0; i < count; ++i) {
+			const std::string &name = files[start + i].first;
+			data[i].clear();
+			if (!isImage(name) && !endsWithNoCase(name, ".ini"))
+				continue;
+
+			if (z) {
+				zip_uint64_t sz = ZipFileSize(z, zipIndices[start + i]);
+				zip_file_t *zf = sz == INVALID_ZIP_SIZE ? nullptr : zip_fopen_index(z, zipIndices[start + i], 0);
+				if (zf) {
+					data[i].resize(sz);
+					if (sz != 0)
+						data[i].resize(std::max((zip_int64_t)0, zip_fread(zf, &data[i][0], sz)));
+					zip_fclose(zf);
+				}
+			} else {
+				File::ReadFileToString(false, files[start + i].second, data[i]);
+			}
+		}
+
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			for (int i = l; i < h; ++i) {
+				decoded[i] = isImage(files[start + i].first) && DecodeReplacementImage(data[i], pixels[i], &widths[i], &heights[i]);
+			}
+		}, 0, count, 1);
+
+		for (int i = 0; success && i < count; ++i) {
+			const std::string &name = files[start + i].first;
+			if (endsWithNoCase(name, ".ini")) {
+				success = writer.AddRaw(name, data[i].data(), data[i].size());
+			} else if (decoded[i]) {
+				CheckAlphaResult alpha = CheckAlpha32Rect(&pixels[i][0], widths[i], widths[i], heights[i], 0xFF000000);
+				success = writer.AddImage(name, &pixels[i][0], widths[i], heights[i], (u8)alpha);
+				images++;
+			} else if (isImage(name)) {
+				WARN_LOG(G3D, "Could not decode texture replacement, leaving it out of the pack: %s", name.c_str());
+			}
+		}
+	}
+
+	if (z)
+		zip_close(z);
+
+	success = writer.Finish() && success;
+	if (success) {
+		if (File::Exists(newFilename))
+			File::Delete(newFilename);
+		bool replaced = (!File::Exists(packFilename) || File::Delete(packFilename)) && File::Rename(tempFilename, packFilename);
+		if (!replaced) {
+			// On Windows, a pack that's still mapped can't be deleted or replaced.  Swap it in next time instead.
+			INFO_LOG(G3D, "Texture pack in use, replacing it on the next load: %s", packFilename.c_str());
+			success = File::Rename(tempFilename, newFilename);
+		}
+	} else {
+		File::Delete(tempFilename);
+	}
+
+	if (success)
+		NOTICE_LOG(G3D, "Built texture pack with %d images: %s", images, packFilename.c_str());
+	else
+		ERROR_LOG(G3D, "Failed to build texture pack: %s", packFilename.c_str());
+	return success;
+}
+
+class TexturePackBuildTask : public Task {
+public:
+	TexturePackBuildTask(const Path &dir) : dir_(dir) {}
+
+	// Mostly decoding, but that's split up with a ParallelRangeLoop.
+	TaskType Type() const override { return TaskType::IO_BLOCKING; }
+	void Run() override {
+		bool success = TextureReplacer::BuildPack(dir_);
+		auto dev = GetI18NCategory("Developer");
+		host->NotifyUserMessage(success ? dev->T("Texture pack built, used when the game is restarted") : dev->T("Failed to build texture pack"), 6.0f);
+		building_ = false;
+	}
+
+	static std::atomic<bool> building_;
+
+private:
+	Path dir_;
+};
+
+std::atomic<bool> TexturePackBuildTask::building_;
+
+void TextureReplacer::BuildPackInBackground(const std::string &gameID) {
+	if (gameID.empty())
+		return;
+
+	Path texturesDirectory = GetSysDirectory(DIRECTORY_TEXTURES) / gameID;
+	if (!File::IsDirectory(texturesDirectory) || TexturePackBuildTask::building_.exchange(true))
+		return;
+
+	g_threadManager.EnqueueTask(new TexturePackBuildTask(texturesDirectory));
+}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "ppsspp_config.h"
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -26,9 +27,11 @@
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/Path.h"
 #include "Common/GPU/DataFormat.h"
 
+#include "Core/ReplacementPack.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/ge_constants.h"
 
@@ -68,6 +71,9 @@ struct ReplacedTextureLevel {
 	// To be able to reload, we need to be able to reopen, unfortunate we can't use zip_file_t.
 	ReplacerZipInfo *zinfo = nullptr;
 	int64_t zi = -1;
+	// Or from textures.pack, which takes priority.  Keeps the mapping alive while loading on a thread.
+	std::shared_ptr<const ReplacementPack> pack;
+	int packIndex = -1;
 
 	bool operator ==(const ReplacedTextureLevel &other) const {
 		if (w != other.w || h != other.h || fmt != other.fmt)
@@ -270,9 +276,15 @@ class TextureReplacer {
 
 	static bool GenerateIni(const std::string &gameID, Path &generatedFilename);
 	static bool IniExists(const std::string &gameID);
+	// Converts the textures.zip or loose files and inis of a game to textures.pack, on a thread.
+	static void BuildPackInBackground(const std::string &gameID);
+	static bool BuildPack(const Path &texturesDirectory);
 
 protected:
 	bool LoadIni();
+	bool OpenPack();
+	void ClosePack();
+	void ClearReplacements();
 	bool LoadIniValues(IniFile &ini, bool isOverride = false);
 	void ParseHashRange(const std::string &key, const std::string &value);
 	void ParseFiltering(const std::string &key, const std::string &value);
@@ -284,6 +296,7 @@ class TextureReplacer {
 	void PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h);
 	bool PopulateLevelFromPath(ReplacedTextureLevel &level, bool ignoreError);
 	bool PopulateLevelFromZip(ReplacedTextureLevel &level, bool ignoreError);
+	bool PopulateLevelFromPack(ReplacedTextureLevel &level, const std::string &hashfile, bool ignoreError);
 
 	bool enabled_ = false;
 	bool allowVideo_ = false;
@@ -297,6 +310,9 @@ class TextureReplacer {
 	Path basePath_;
 	ReplacedTextureHash hash_ = ReplacedTextureHash::QUICK;
 	ReplacerZipInfo zip_;
+	std::shared_ptr<ReplacementPack> pack_;
+	// To tell if the pack was rebuilt since it was mapped.
+	File::FileInfo packInfo_;
 
 	typedef std::pair<int, int> WidthHeightPair;
 	std::unordered_map<u64, WidthHeightPair> hashranges_;
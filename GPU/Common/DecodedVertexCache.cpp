@@ -0,0 +1,225 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ext/xxhash.h"
+#include "Core/Config.h"
+#include "GPU/GPU.h"
+#include "GPU/ge_constants.h"
+#include "GPU/Common/DecodedVertexCache.h"
+#include "GPU/Common/DrawEngineCommon.h"
+#include "GPU/Common/VertexDecoderCommon.h"
+
+// Same aging as the vai_ caches in the backends.
+enum {
+	DECIMATION_INTERVAL = 17,
+	KILL_AGE = 120,
+	UNRELIABLE_KILL_AGE = 240,
+	UNRELIABLE_KILL_MAX = 4,
+};
+
+// Decoded vertices are usually around 2-3x the size of the PSP format.
+static constexpr size_t MAX_CACHE_BYTES = 32 * 1024 * 1024;
+// Smaller arrays change more often, and are cheap to hash fully every time.
+static constexpr int ALWAYS_FULL_HASH_VERTS = 64;
+
+bool DecodedVertexCache::Key::operator ==(const Key &other) const {
+	return memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+DecodedVertexCache::~DecodedVertexCache() {
+	Clear();
+}
+
+bool DecodedVertexCache::CanCache(u32 vertTypeID) {
+	if (vertTypeID & (GE_VTYPE_THROUGH_MASK | GE_VTYPE_MORPHCOUNT_MASK))
+		return false;
+	// See GetVertTypeID(), this is skinInDecode.
+	const bool skinInDecode = (vertTypeID & (1 << 26)) != 0;
+	return !skinInDecode || (vertTypeID & GE_VTYPE_WEIGHT_MASK) == 0;
+}
+
+bool DecodedVertexCache::DecodeFresh(VertexDecoder *dec, const void *verts, int lowerBound, int upperBound, u8 *dest) {
+	// The decoder only ever clears this, so start from true to find out about just these verts.
+	const bool prevFullAlpha = gstate_c.vertexFullAlpha;
+	gstate_c.vertexFullAlpha = true;
+	dec->DecodeVerts(dest, verts, lowerBound, upperBound);
+	const bool fullAlpha = gstate_c.vertexFullAlpha;
+	gstate_c.vertexFullAlpha = prevFullAlpha && fullAlpha;
+	return fullAlpha;
+}
+
+const u8 *DecodedVertexCache::Decode(VertexDecoder *dec, const void *verts, int lowerBound, int upperBound, u8 *dest) {
+	if (!g_Config.bVertexCache || !CanCache(dec->VertexType())) {
+		dec->DecodeVerts(dest, verts, lowerBound, upperBound);
+		return dest;
+	}
+
+	if (lastFrame_ != gpuStats.numFlips)
+		BeginFrame();
+
+	Key key{};
+	key.verts = verts;
+	key.vertTypeID = dec->VertexType();
+	key.lowerBound = (u16)lowerBound;
+	key.upperBound = (u16)upperBound;
+	key.uv = gstate_c.uv;
+	const u32 id = (u32)XXH3_64bits(&key, sizeof(key));
+
+	const int count = upperBound - lowerBound + 1;
+	const u8 *src = (const u8 *)verts + lowerBound * dec->VertexSize();
+	const size_t srcBytes = (size_t)count * dec->VertexSize();
+	const bool fullHashOnly = count <= ALWAYS_FULL_HASH_VERTS;
+
+	DecodedVertexArray *vda = arrays_.Get(id);
+	if (vda && !(vda->key == key)) {
+		// Rare, just leave the one we have alone.
+		misses_++;
+		DecodeFresh(dec, verts, lowerBound, upperBound, dest);
+		return dest;
+	}
+
+	if (!vda) {
+		// Haven't seen this one before.  Don't keep the data yet, many are only drawn once.
+		vda = new DecodedVertexArray();
+		vda->key = key;
+		vda->hash = XXH3_64bits(src, srcBytes);
+		vda->minihash = fullHashOnly ? 0 : ComputeMiniHashRange(src, srcBytes);
+		vda->lastFrame = lastFrame_;
+		arrays_.Insert(id, vda);
+
+		misses_++;
+		DecodeFresh(dec, verts, lowerBound, upperBound, dest);
+		return dest;
+	}
+
+	if (vda->lastFrame != lastFrame_) {
+		vda->numFrames++;
+		vda->lastFrame = lastFrame_;
+	}
+
+	if (vda->status == DecodedVertexArray::UNRELIABLE) {
+		misses_++;
+		DecodeFresh(dec, verts, lowerBound, upperBound, dest);
+		return dest;
+	}
+
+	bool changed;
+	if (vda->drawsUntilNextFullHash == 0) {
+		// Let's try to skip the full hash if the mini would fail.
+		changed = !fullHashOnly && ComputeMiniHashRange(src, srcBytes) != vda->minihash;
+		changed = changed || XXH3_64bits(src, srcBytes) != vda->hash;
+		// Exponential backoff up to every 24 draws.
+		vda->drawsUntilNextFullHash = fullHashOnly ? 0 : (u16)std::min(24, vda->numFrames);
+	} else {
+		vda->drawsUntilNextFullHash--;
+		changed = ComputeMiniHashRange(src, srcBytes) != vda->minihash;
+	}
+
+	if (changed) {
+		vda->status = DecodedVertexArray::UNRELIABLE;
+		totalBytes_ -= vda->bytes;
+		vda->data.reset();
+		vda->bytes = 0;
+
+		misses_++;
+		DecodeFresh(dec, verts, lowerBound, upperBound, dest);
+		return dest;
+	}
+
+	if (!vda->data) {
+		// Second time with the same data, now it's worth keeping.
+		misses_++;
+		const bool fullAlpha = DecodeFresh(dec, verts, lowerBound, upperBound, dest);
+		const u32 bytes = (u32)count * dec->GetDecVtxFmt().stride;
+		if (totalBytes_ + bytes <= MAX_CACHE_BYTES) {
+			vda->data.reset(new u8[bytes]);
+			memcpy(vda->data.get(), dest, bytes);
+			vda->bytes = bytes;
+			vda->fullAlpha = fullAlpha;
+			totalBytes_ += bytes;
+		}
+		return dest;
+	}
+
+	hits_++;
+	gstate_c.vertexFullAlpha = gstate_c.vertexFullAlpha && vda->fullAlpha;
+	return vda->data.get();
+}
+
+void DecodedVertexCache::DecodeInto(VertexDecoder *dec, const void *verts, int lowerBound, int upperBound, u8 *dest) {
+	const u8 *decoded = Decode(dec, verts, lowerBound, upperBound, dest);
+	if (decoded != dest)
+		memcpy(dest, decoded, (upperBound - lowerBound + 1) * dec->GetDecVtxFmt().stride);
+}
+
+void DecodedVertexCache::BeginFrame() {
+	lastFrame_ = gpuStats.numFlips;
+	lastHits_ = hits_;
+	lastMisses_ = misses_;
+	hits_ = 0;
+	misses_ = 0;
+
+	if (--decimationCounter_ <= 0) {
+		decimationCounter_ = DECIMATION_INTERVAL;
+		Decimate();
+	}
+}
+
+void DecodedVertexCache::Decimate() {
+	const int threshold = lastFrame_ - KILL_AGE;
+	const int unreliableThreshold = lastFrame_ - UNRELIABLE_KILL_AGE;
+	int unreliableLeft = UNRELIABLE_KILL_MAX;
+	arrays_.Iterate([&](u32 id, DecodedVertexArray *vda) {
+		bool kill;
+		if (vda->status == DecodedVertexArray::UNRELIABLE) {
+			// We limit killing unreliable so we don't rehash too often.
+			kill = vda->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
+		} else {
+			kill = vda->lastFrame < threshold;
+		}
+		if (kill)
+			Remove(id, vda);
+	});
+	arrays_.Maintain();
+}
+
+void DecodedVertexCache::Remove(u32 id, DecodedVertexArray *vda) {
+	totalBytes_ -= vda->bytes;
+	arrays_.Remove(id);
+	delete vda;
+}
+
+void DecodedVertexCache::Clear() {
+	arrays_.Iterate([&](u32 id, DecodedVertexArray *vda) {
+		delete vda;
+	});
+	arrays_.Clear();
+	totalBytes_ = 0;
+}
+
+void DecodedVertexCache::GetStats(char *buffer, size_t bufsize) const {
+	const int total = lastHits_ + lastMisses_;
+	snprintf(buffer, bufsize,
+		"Decoded vertex cache: %d arrays, %d KB\n"
+		"Decoded vertex cache hits: %d, misses %d (%0.1f%% hit)",
+		(int)arrays_.size(), (int)(totalBytes_ / 1024),
+		lastHits_, lastMisses_, total == 0 ? 0.0 : lastHits_ * 100.0 / total);
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Common/CommonTypes.h"
+#include "Common/Data/Collections/Hashmaps.h"
+#include "GPU/GPUState.h"
+
+class VertexDecoder;
+
+// Keeps decoded vertices around for the paths that have nowhere else to keep them: the software
+// renderer, and software transform in the other backends.  Hardware transform has its own
+// vertex buffer caches (vai_) for this.
+//
+// Uses the same policy as those: an array is only kept once it's been seen twice with the same
+// data, it's checked with a minihash on each use and a full hash less and less often, and it's
+// given up on for a while if it keeps changing.  Only used when the vertex cache is enabled.
+class DecodedVertexCache {
+public:
+	DecodedVertexCache() : arrays_(256) {}
+	~DecodedVertexCache();
+
+	// Decodes like VertexDecoder::DecodeVerts(), but may return previously decoded data instead of
+	// writing to dest.  Either way, gstate_c.vertexFullAlpha is updated as if it had decoded.
+	// The result is valid until the next call.
+	const u8 *Decode(VertexDecoder *dec, const void *verts, int lowerBound, int upperBound, u8 *dest);
+	// Same, but always leaves the decoded vertices in dest.
+	void DecodeInto(VertexDecoder *dec, const void *verts, int lowerBound, int upperBound, u8 *dest);
+
+	// Only draws that decode the same way every time can be cached.  Morph and skinning in decode
+	// depend on other state, and throughmode decoding tracks UV bounds.
+	static bool CanCache(u32 vertTypeID);
+
+	void Clear();
+
+	void GetStats(char *buffer, size_t bufsize) const;
+
+private:
+	// Compared and hashed as raw bytes, so keep this free of implicit padding.
+	struct Key {
+		const void *verts;
+		u32 vertTypeID;
+		u16 lowerBound;
+		u16 upperBound;
+		UVScale uv;
+
+		bool operator ==(const Key &other) const;
+	};
+
+	struct DecodedVertexArray {
+		enum Status : u8 {
+			HASHING,
+			// Changed since it was first seen, so just decode until it's forgotten.
+			UNRELIABLE,
+		};
+
+		Key key;
+		uint64_t hash = 0;
+		u32 minihash = 0;
+		std::unique_ptr<u8[]> data;
+		u32 bytes = 0;
+		int numFrames = 0;
+		int lastFrame = 0;
+		u16 drawsUntilNextFullHash = 0;
+		Status status = HASHING;
+		bool fullAlpha = false;
+	};
+
+	void BeginFrame();
+	void Decimate();
+	void Remove(u32 id, DecodedVertexArray *vda);
+	// Decodes into dest, returning whether all vertices had full alpha.
+	static bool DecodeFresh(VertexDecoder *dec, const void *verts, int lowerBound, int upperBound, u8 *dest);
+
+	DenseHashMap<u32, DecodedVertexArray *, nullptr> arrays_;
+	size_t totalBytes_ = 0;
+	int lastFrame_ = -1;
+	int decimationCounter_ = 0;
+
+	int hits_ = 0;
+	int misses_ = 0;
+	int lastHits_ = 0;
+	int lastMisses_ = 0;
+};
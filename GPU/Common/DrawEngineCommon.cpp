@@ -35,7 +35,7 @@ enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
 
-DrawEngineCommon::DrawEngineCommon() : decoderMap_(16) {
+DrawEngineCommon::DrawEngineCommon() : decoderMap_(16), drawCalls(MIN_DEFERRED_DRAW_CALLS) {
 	decJitCache_ = new VertexDecoderJitCache();
 	transformed = (TransformedVertex *)AllocateMemoryPages(TRANSFORMED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
 	transformedExpanded = (TransformedVertex *)AllocateMemoryPages(3 * TRANSFORMED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
@@ -111,6 +111,12 @@ void DrawEngineCommon::DecodeVerts(u8 *dest) {
 	}
 }
 
+void DrawEngineCommon::DecodeVertsCached(u8 *dest) {
+	useDecodedCache_ = true;
+	DecodeVerts(dest);
+	useDecodedCache_ = false;
+}
+
 std::vector<std::string> DrawEngineCommon::DebugGetVertexLoaderIDs() {
 	std::vector<std::string> ids;
 	decoderMap_.Iterate([&](const uint32_t vtype, VertexDecoder *decoder) {
@@ -176,6 +182,7 @@ void DrawEngineCommon::NotifyConfigChanged() {
 		delete decoder;
 	});
 	decoderMap_.Clear();
+	decodedCache_.Clear();
 	ClearTrackedVertexArrays();
 
 	useHWTransform_ = g_Config.bHardwareTransform;
@@ -614,16 +621,40 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 	int indexUpperBound = dc.indexUpperBound;
 
 	if (dc.indexType == GE_VTYPE_IDX_NONE >> GE_VTYPE_IDX_SHIFT) {
+		// The vertex address advances past the verts of each non-indexed draw, so a run of them
+		// often reads one contiguous block.  Decode those all at once, as long as the UV scale
+		// (which the decoder applies) matches.
+		const int vertexSize = dec_->VertexSize();
+		const u8 *nextVerts = (const u8 *)dc.verts + dc.vertexCount * vertexSize;
+		int lastMatch = i;
+		for (int j = i + 1; j < numDrawCalls; ++j) {
+			const DeferredDrawCall &next = drawCalls[j];
+			if (next.verts != nextVerts || next.indexType != dc.indexType || memcmp(&next.uvScale, &dc.uvScale, sizeof(UVScale)) != 0)
+				break;
+			nextVerts += next.vertexCount * vertexSize;
+			lastMatch = j;
+		}
+		indexUpperBound = indexLowerBound + (int)((nextVerts - (const u8 *)dc.verts) / vertexSize) - 1;
+
 		// Decode the verts (and at the same time apply morphing/skinning). Simple.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
-			dc.verts, indexLowerBound, indexUpperBound);
-		decodedVerts += indexUpperBound - indexLowerBound + 1;
-		
-		bool clockwise = true;
-		if (gstate.isCullEnabled() && gstate.getCullMode() != dc.cullMode) {
-			clockwise = false;
+		u8 *stepDest = dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride;
+		if (useDecodedCache_)
+			decodedCache_.DecodeInto(dec_, dc.verts, indexLowerBound, indexUpperBound, stepDest);
+		else
+			dec_->DecodeVerts(stepDest, dc.verts, indexLowerBound, indexUpperBound);
+		gpuStats.numVertexDecodes++;
+		gpuStats.numMergedDrawCalls += lastMatch - i;
+
+		for (int j = i; j <= lastMatch; j++) {
+			bool clockwise = true;
+			if (gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
+				clockwise = false;
+			}
+			indexGen.SetIndex(decodedVerts);
+			indexGen.AddPrim(drawCalls[j].prim, drawCalls[j].vertexCount, clockwise);
+			decodedVerts += drawCalls[j].vertexCount;
 		}
-		indexGen.AddPrim(dc.prim, dc.vertexCount, clockwise);
+		i = lastMatch;
 	} else {
 		// It's fairly common that games issue long sequences of PRIM calls, with differing
 		// inds pointer but the same base vertex pointer. We'd like to reuse vertices between
@@ -682,9 +713,14 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 		}
 
 		// 3. Decode that range of vertex data.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
-			dc.verts, indexLowerBound, indexUpperBound);
+		u8 *stepDest = dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride;
+		if (useDecodedCache_)
+			decodedCache_.DecodeInto(dec_, dc.verts, indexLowerBound, indexUpperBound, stepDest);
+		else
+			dec_->DecodeVerts(stepDest, dc.verts, indexLowerBound, indexUpperBound);
 		decodedVerts += vertexCount;
+		gpuStats.numVertexDecodes++;
+		gpuStats.numMergedDrawCalls += lastMatch - i;
 
 		// 4. Advance indexgen vertex counter.
 		indexGen.Advance(vertexCount);
@@ -692,7 +728,7 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 	}
 }
 
-inline u32 ComputeMiniHashRange(const void *ptr, size_t sz) {
+u32 ComputeMiniHashRange(const void *ptr, size_t sz) {
 	// Switch to u32 units, and round up to avoid unaligned accesses.
 	// Probably doesn't matter if we skip the first few bytes in some cases.
 	const u32 *p = (const u32 *)(((uintptr_t)ptr + 3) & ~3);
@@ -786,7 +822,11 @@ inline uint32_t lowbias32_r(uint32_t x) {
 
 // vertTypeID is the vertex type but with the UVGen mode smashed into the top bits.
 void DrawEngineCommon::SubmitPrim(const void *verts, const void *inds, GEPrimitiveType prim, int vertexCount, u32 vertTypeID, int cullMode, int *bytesRead) {
-	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
+	if (numDrawCalls >= (int)drawCalls.size() && drawCalls.size() < MAX_DEFERRED_DRAW_CALLS) {
+		// Only long runs of compatible draws fill the queue, so they're worth batching further.
+		drawCalls.resize(drawCalls.size() * 2);
+	}
+	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= (int)drawCalls.size() || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
 		DispatchFlush();
 	}
 
@@ -23,6 +23,7 @@
 #include "Common/Data/Collections/Hashmaps.h"
 
 #include "GPU/GPUState.h"
+#include "GPU/Common/DecodedVertexCache.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "GPU/Common/IndexGenerator.h"
@@ -58,6 +59,9 @@ inline uint32_t GetVertTypeID(uint32_t vertType, int uvGenMode, bool skinInDecod
 	return (vertType & 0xFFFFFF) | (uvGenMode << 24) | (skinInDecode << 26);
 }
 
+// Cheap hash of a few samples of the data, for noticing changes between full hashes.
+u32 ComputeMiniHashRange(const void *ptr, size_t sz);
+
 struct SimpleVertex;
 namespace Spline { struct Weight2D; }
 
@@ -123,12 +127,18 @@ class DrawEngineCommon {
 
 	VertexDecoder *GetVertexDecoder(u32 vtype);
 
+	DecodedVertexCache &GetDecodedVertexCache() {
+		return decodedCache_;
+	}
+
 protected:
 	virtual bool UpdateUseHWTessellation(bool enabled) { return enabled; }
 	virtual void ClearTrackedVertexArrays() {}
 
 	int ComputeNumVertsToDecode() const;
 	void DecodeVerts(u8 *dest);
+	// For software transform, where the decoded vertices aren't kept in any GPU buffer.
+	void DecodeVertsCached(u8 *dest);
 
 	// Preprocessing for spline/bezier
 	u32 NormalizeVertices(u8 *outPtr, u8 *bufPtr, const u8 *inPtr, int lowerBound, int upperBound, u32 vertType, int *vertexSize = nullptr);
@@ -189,6 +199,8 @@ class DrawEngineCommon {
 	VertexDecoder *dec_ = nullptr;
 	VertexDecoderJitCache *decJitCache_ = nullptr;
 	VertexDecoderOptions decOptions_{};
+	DecodedVertexCache decodedCache_;
+	bool useDecodedCache_ = false;
 
 	TransformedVertex *transformed = nullptr;
 	TransformedVertex *transformedExpanded = nullptr;
@@ -206,8 +218,9 @@ class DrawEngineCommon {
 		UVScale uvScale;
 	};
 
-	enum { MAX_DEFERRED_DRAW_CALLS = 128 };
-	DeferredDrawCall drawCalls[MAX_DEFERRED_DRAW_CALLS];
+	// Grows when a flush is only forced by running out of room.
+	enum { MIN_DEFERRED_DRAW_CALLS = 128, MAX_DEFERRED_DRAW_CALLS = 1024 };
+	std::vector<DeferredDrawCall> drawCalls;
 	int numDrawCalls = 0;
 	int vertexCountInDrawCalls_ = 0;
 
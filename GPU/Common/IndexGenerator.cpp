@@ -272,13 +272,58 @@ void IndexGenerator::AddRectangles(int numVerts) {
 	seenPrims_ |= 1 << GE_PRIM_RECTANGLES;
 }
 
+// Adds the offset to each index, keeping the order.  Most translations are just this.
+template <class ITypeLE>
+static inline void RebaseIndices(u16 *outInds, const ITypeLE *inds, int numInds, int indexOffset) {
+	for (int i = 0; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+static inline void RebaseIndices(u16 *outInds, const u8 *inds, int numInds, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i offset = _mm_set1_epi16((short)indexOffset);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= numInds; i += 16) {
+		const __m128i values = _mm_loadu_si128((const __m128i *)(inds + i));
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(_mm_unpacklo_epi8(values, zero), offset));
+		_mm_storeu_si128((__m128i *)(outInds + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(values, zero), offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	for (; i + 16 <= numInds; i += 16) {
+		const uint8x16_t values = vld1q_u8(inds + i);
+		vst1q_u16(outInds + i, vaddw_u8(offset, vget_low_u8(values)));
+		vst1q_u16(outInds + i + 8, vaddw_u8(offset, vget_high_u8(values)));
+	}
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+// Only picked when u16_le is plain u16, i.e. on little endian.
+static inline void RebaseIndices(u16 *outInds, const u16 *inds, int numInds, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i offset = _mm_set1_epi16((short)indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		const __m128i values = _mm_loadu_si128((const __m128i *)(inds + i));
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(values, offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	for (; i + 8 <= numInds; i += 8)
+		vst1q_u16(outInds + i, vaddq_u16(vld1q_u16(inds + i), offset));
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
-		*outInds++ = indexOffset + inds[i];
-	inds_ = outInds;
+	RebaseIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_POINTS;
 	seenPrims_ |= (1 << GE_PRIM_POINTS) | flag;
@@ -287,13 +332,9 @@ void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int index
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i + 1];
-	}
-	inds_ = outInds;
+	RebaseIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= (1 << GE_PRIM_LINES) | flag;
@@ -323,16 +364,20 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 		memcpy(inds_, inds, numInds * sizeof(ITypeLE));
 		inds_ += numInds;
 		count_ += numInds;
+	} else if (clockwise) {
+		numInds = (numInds / 3) * 3;  // Round to whole triangles
+		RebaseIndices(inds_, inds, numInds, indexOffset);
+		inds_ += numInds;
+		count_ += numInds;
 	} else {
+		// Counter-clockwise, so swap the last two of each triangle.
 		u16 *outInds = inds_;
 		int numTris = numInds / 3;  // Round to whole triangles
 		numInds = numTris * 3;
-		const int v1 = clockwise ? 1 : 2;
-		const int v2 = clockwise ? 2 : 1;
 		for (int i = 0; i < numInds; i += 3) {
 			*outInds++ = indexOffset + inds[i];
-			*outInds++ = indexOffset + inds[i + v1];
-			*outInds++ = indexOffset + inds[i + v2];
+			*outInds++ = indexOffset + inds[i + 2];
+			*outInds++ = indexOffset + inds[i + 1];
 		}
 		inds_ = outInds;
 		count_ += numInds;
@@ -381,14 +426,10 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 template <class ITypeLE, int flag>
 inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i+1];
-	}
-	inds_ = outInds;
+	RebaseIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_RECTANGLES;
 	seenPrims_ |= (1 << GE_PRIM_RECTANGLES) | flag;
@@ -0,0 +1,383 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+#include <zstd.h>
+
+#include "Common/File/DirListing.h"
+#include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Core/System.h"
+#include "GPU/Common/ScaledTextureCache.h"
+
+static const char *SCALEDTEX_MAGIC = "ppssppST";
+static const u32 SCALEDTEX_VERSION = 1;
+
+// Upscaled textures are big, keep the file and memory use within reason.
+static const s64 MAX_FILE_SIZE = 2048LL * 1024 * 1024;
+// For all games together, the least recently used files of other games are deleted beyond this.
+static const u64 MAX_TOTAL_SIZE = 4096ULL * 1024 * 1024;
+static const size_t MAX_PREFETCH_BYTES = 256 * 1024 * 1024;
+static const size_t MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+// Larger than any texture we'd scale: 512x512 at 5x.
+static const u32 MAX_DIMENSION = 4096;
+static const double MIN_SCALE_SECONDS = 0.0005;
+// Scaled textures compress well even at fast levels, and decompression speed doesn't depend on it.
+static const int COMPRESSION_LEVEL = 3;
+
+ScaledTextureCache::~ScaledTextureCache() {
+	Shutdown();
+}
+
+void ScaledTextureCache::Init(const std::string &gameID) {
+	Shutdown();
+	if (gameID.empty()) {
+		return;
+	}
+
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+	filename_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (gameID + ".scaledtex");
+
+	done_ = false;
+	indexReady_ = false;
+	thread_ = std::thread([this] { Run(); });
+}
+
+void ScaledTextureCache::Shutdown() {
+	if (!thread_.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		done_ = true;
+		cond_.notify_all();
+	}
+	// Pending writes are still flushed, there's no point in scaling them again next time.
+	thread_.join();
+
+	file_.Close();
+	readFile_.Close();
+	entries_.clear();
+	prefetchOrder_.clear();
+	prefetchPos_ = 0;
+	prefetchedBytes_ = 0;
+	decompressed_.clear();
+	indexReady_ = false;
+}
+
+bool ScaledTextureCache::Find(const ScaledTextureKey &key, u8 *dest, int pitch, int w, int h, CheckAlphaResult *alphaResult) {
+	// Only look up the entry under the lock, so reading and decompressing doesn't stall the
+	// background thread, and through it Store().
+	Entry entry;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!indexReady_) {
+			return false;
+		}
+		auto it = entries_.find(key);
+		if (it == entries_.end()) {
+			return false;
+		}
+		entry = it->second;
+	}
+	if (entry.w != w || entry.h != h) {
+		return false;
+	}
+
+	auto forget = [&] {
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = entries_.find(key);
+		if (it != entries_.end() && it->second.offset == entry.offset) {
+			entries_.erase(it);
+		}
+	};
+
+	std::vector<u8> readBuffer;
+	const std::vector<u8> *compressed = entry.compressed.get();
+	if (!compressed) {
+		readBuffer.resize(entry.compressedSize);
+		if (!readFile_.Seek(entry.offset, SEEK_SET) || !readFile_.ReadBytes(&readBuffer[0], entry.compressedSize)) {
+			ERROR_LOG(G3D, "Unable to read scaled texture cache entry");
+			forget();
+			return false;
+		}
+		compressed = &readBuffer;
+	}
+
+	const size_t size = (size_t)w * h * 4;
+	decompressed_.resize(size);
+	size_t result = ZSTD_decompress(&decompressed_[0], size, compressed->data(), compressed->size());
+	if (ZSTD_isError(result) || result != size) {
+		WARN_LOG(G3D, "Scaled texture cache entry was corrupt, ignoring");
+		forget();
+		return false;
+	}
+	*alphaResult = entry.alphaResult;
+
+	for (int y = 0; y < h; ++y) {
+		memcpy(dest + pitch * y, &decompressed_[w * 4 * y], w * 4);
+	}
+	return true;
+}
+
+void ScaledTextureCache::Store(const ScaledTextureKey &key, const u8 *src, int pitch, int w, int h, CheckAlphaResult alphaResult, double scaleSeconds) {
+	// Not worth the disk space and the decompression for the really quick ones.
+	if (scaleSeconds < MIN_SCALE_SECONDS || (u32)w > MAX_DIMENSION || (u32)h > MAX_DIMENSION) {
+		return;
+	}
+
+	const size_t size = (size_t)w * h * 4;
+	std::lock_guard<std::mutex> guard(lock_);
+	// Rather drop it than stall rendering, it'll be scaled and stored again some other time.
+	if (done_ || queuedBytes_ + size > MAX_QUEUED_BYTES || entries_.find(key) != entries_.end()) {
+		return;
+	}
+
+	PendingWrite write{ key, w, h, alphaResult };
+	write.pixels.resize(size);
+	for (int y = 0; y < h; ++y) {
+		memcpy(&write.pixels[w * 4 * y], src + pitch * y, w * 4);
+	}
+	queue_.push_back(std::move(write));
+	queuedBytes_ += size;
+	cond_.notify_all();
+}
+
+void ScaledTextureCache::Run() {
+	SetCurrentThreadName("ScaledTexCache");
+
+	GarbageCollectFiles();
+	if (OpenFile()) {
+		ReadIndex();
+		readFile_.Open(filename_, "rb");
+	}
+
+	std::unique_lock<std::mutex> guard(lock_);
+	indexReady_ = true;
+	while (true) {
+		if (!queue_.empty()) {
+			PendingWrite write = std::move(queue_.front());
+			queue_.pop_front();
+			queuedBytes_ -= write.pixels.size();
+
+			guard.unlock();
+			WriteEntry(write);
+			guard.lock();
+			continue;
+		}
+		if (done_) {
+			break;
+		}
+		if (prefetchPos_ < prefetchOrder_.size() && prefetchedBytes_ < MAX_PREFETCH_BYTES) {
+			guard.unlock();
+			PrefetchNext();
+			guard.lock();
+			continue;
+		}
+		cond_.wait(guard);
+	}
+}
+
+void ScaledTextureCache::GarbageCollectFiles() {
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(GetSysDirectory(DIRECTORY_APP_CACHE), &files, "scaledtex:");
+
+	u64 total = 0;
+	for (const File::FileInfo &file : files) {
+		total += file.size;
+	}
+	if (total <= MAX_TOTAL_SIZE) {
+		return;
+	}
+
+	// Lookups only read, and reads don't always update atime, so also go by the last write.
+	auto lastUsed = [](const File::FileInfo &file) {
+		return std::max(file.atime, file.mtime);
+	};
+	std::sort(files.begin(), files.end(), [&](const File::FileInfo &a, const File::FileInfo &b) {
+		return lastUsed(a) < lastUsed(b);
+	});
+
+	// Our own file is already limited to MAX_FILE_SIZE.
+	for (const File::FileInfo &file : files) {
+		if (total <= MAX_TOTAL_SIZE) {
+			break;
+		}
+		if (file.isDirectory || file.fullName == filename_) {
+			continue;
+		}
+		if (File::Delete(file.fullName)) {
+			total -= file.size;
+		}
+	}
+	INFO_LOG(G3D, "Scaled texture caches trimmed to %lld bytes", (long long)total);
+}
+
+bool ScaledTextureCache::OpenFile() {
+	if (file_.Open(filename_, "rb+")) {
+		FileHeader header;
+		if (file_.ReadBytes(&header, sizeof(header)) && memcmp(header.magic, SCALEDTEX_MAGIC, sizeof(header.magic)) == 0 && header.version == SCALEDTEX_VERSION) {
+			return true;
+		}
+		WARN_LOG(G3D, "Discarding unusable scaled texture cache %s", filename_.c_str());
+		file_.Close();
+	}
+
+	FileHeader header{};
+	memcpy(header.magic, SCALEDTEX_MAGIC, sizeof(header.magic));
+	header.version = SCALEDTEX_VERSION;
+	if (!file_.Open(filename_, "wb+") || !file_.WriteBytes(&header, sizeof(header)) || !file_.Flush()) {
+		ERROR_LOG(G3D, "Could not create scaled texture cache %s", filename_.c_str());
+		file_.Close();
+		return false;
+	}
+	return true;
+}
+
+void ScaledTextureCache::ReadIndex() {
+	const s64 fileSize = (s64)file_.GetSize();
+	s64 offset = sizeof(FileHeader);
+
+	std::unordered_map<ScaledTextureKey, Entry, KeyHash> entries;
+	std::vector<ScaledTextureKey> order;
+	while (offset + (s64)sizeof(EntryHeader) <= fileSize) {
+		EntryHeader header;
+		if (!file_.Seek(offset, SEEK_SET) || !file_.ReadBytes(&header, sizeof(header))) {
+			break;
+		}
+
+		// A write that never finished, or garbage.  Anything after it gets overwritten.
+		const s64 dataOffset = offset + sizeof(EntryHeader);
+		bool valid = header.w != 0 && header.w <= MAX_DIMENSION && header.h != 0 && header.h <= MAX_DIMENSION;
+		valid = valid && header.compressedSize != 0 && dataOffset + header.compressedSize <= fileSize;
+		valid = valid && (header.alphaResult == CHECKALPHA_FULL || header.alphaResult == CHECKALPHA_ANY);
+		if (!valid) {
+			WARN_LOG(G3D, "Scaled texture cache truncated at %lld", (long long)offset);
+			break;
+		}
+
+		ScaledTextureKey key{ header.keyHigh, header.keyLow };
+		Entry &entry = entries[key];
+		entry.offset = dataOffset;
+		entry.compressedSize = header.compressedSize;
+		entry.w = (u16)header.w;
+		entry.h = (u16)header.h;
+		entry.alphaResult = (CheckAlphaResult)(u32)header.alphaResult;
+		order.push_back(key);
+
+		offset = dataOffset + header.compressedSize;
+	}
+	// Writes start at the end of the last good entry, whatever stopped the scan.
+	file_.Clear();
+
+	INFO_LOG(G3D, "Loaded %d entries from scaled texture cache %s", (int)entries.size(), filename_.c_str());
+
+	std::lock_guard<std::mutex> guard(lock_);
+	endOffset_ = offset;
+	prefetchPos_ = 0;
+	prefetchedBytes_ = 0;
+	prefetchOrder_ = std::move(order);
+	// Store() may have raced in duplicates, those are skipped when written.
+	entries_ = std::move(entries);
+}
+
+void ScaledTextureCache::PrefetchNext() {
+	ScaledTextureKey key = prefetchOrder_[prefetchPos_++];
+	s64 offset;
+	u32 size;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = entries_.find(key);
+		if (it == entries_.end() || it->second.compressed) {
+			return;
+		}
+		offset = it->second.offset;
+		size = it->second.compressedSize;
+	}
+
+	std::vector<u8> compressed(size);
+	if (!file_.Seek(offset, SEEK_SET) || !file_.ReadBytes(&compressed[0], size)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = entries_.find(key);
+	if (it != entries_.end() && !it->second.compressed) {
+		it->second.compressed = std::make_shared<const std::vector<u8>>(std::move(compressed));
+		prefetchedBytes_ += size;
+	}
+}
+
+void ScaledTextureCache::WriteEntry(PendingWrite &write) {
+	if (!file_.IsOpen()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (entries_.find(write.key) != entries_.end()) {
+			return;
+		}
+	}
+
+	std::vector<u8> compressed(ZSTD_compressBound(write.pixels.size()));
+	ZSTD_CCtx *ctx = ZSTD_createCCtx();
+	ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, COMPRESSION_LEVEL);
+	// Lets Find() notice damaged entries, which could otherwise decode to garbage silently.
+	ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+	size_t compressedSize = ZSTD_compress2(ctx, &compressed[0], compressed.size(), write.pixels.data(), write.pixels.size());
+	ZSTD_freeCCtx(ctx);
+	if (ZSTD_isError(compressedSize)) {
+		return;
+	}
+	compressed.resize(compressedSize);
+
+	const s64 offset = endOffset_;
+	if (offset + (s64)sizeof(EntryHeader) + (s64)compressedSize > MAX_FILE_SIZE) {
+		return;
+	}
+
+	EntryHeader header{};
+	header.keyHigh = write.key.high;
+	header.keyLow = write.key.low;
+	header.w = write.w;
+	header.h = write.h;
+	header.alphaResult = (u32)write.alphaResult;
+	header.compressedSize = (u32)compressedSize;
+
+	// Flushed before it's added to the index, so Find() can read it through the other handle.
+	if (!file_.Seek(offset, SEEK_SET) || !file_.WriteBytes(&header, sizeof(header)) || !file_.WriteBytes(compressed.data(), compressedSize) || !file_.Flush()) {
+		ERROR_LOG(G3D, "Unable to write scaled texture cache, disabling writes");
+		file_.Close();
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	endOffset_ = offset + sizeof(EntryHeader) + compressedSize;
+
+	Entry &entry = entries_[write.key];
+	entry.offset = offset + sizeof(EntryHeader);
+	entry.compressedSize = (u32)compressedSize;
+	entry.w = (u16)write.w;
+	entry.h = (u16)write.h;
+	entry.alphaResult = write.alphaResult;
+	if (prefetchedBytes_ + compressedSize <= MAX_PREFETCH_BYTES) {
+		entry.compressed = std::make_shared<const std::vector<u8>>(std::move(compressed));
+		prefetchedBytes_ += compressedSize;
+	}
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Common/File/FileUtil.h"
+#include "GPU/Common/TextureDecoder.h"
+
+struct ScaledTextureKey {
+	u64 high;
+	u64 low;
+
+	bool operator ==(const ScaledTextureKey &other) const {
+		return high == other.high && low == other.low;
+	}
+};
+
+// Optional per-game on-disk cache of CPU upscaled textures (g_Config.bTexScalingDiskCache), so
+// that xBRZ and friends only ever run once per texture.  Entries are keyed by a hash of the
+// source data, the CLUT and the scaling settings, so they never need invalidating.
+//
+// All file access except for misses in the prefetched data happens on a background thread,
+// which first reads the index and then loads entries into memory, while writing new ones.
+class ScaledTextureCache {
+public:
+	~ScaledTextureCache();
+
+	void Init(const std::string &gameID);
+	void Shutdown();
+	bool IsOpen() const { return thread_.joinable(); }
+
+	// Copies a scaled texture of exactly w x h 8888 pixels to dest.  Returns false on a miss,
+	// which is also what happens until the index has been read.
+	bool Find(const ScaledTextureKey &key, u8 *dest, int pitch, int w, int h, CheckAlphaResult *alphaResult);
+	// Queues a scaled texture for writing, unless scaling it only took scaleSeconds, or the
+	// writer is too far behind.
+	void Store(const ScaledTextureKey &key, const u8 *src, int pitch, int w, int h, CheckAlphaResult alphaResult, double scaleSeconds);
+
+private:
+	// File format:
+	// FileHeader
+	// { EntryHeader, zstd frame of w * h * 4 bytes } repeated.
+	struct FileHeader {
+		char magic[8];
+		u32_le version;
+		u32_le reserved;
+	};
+
+	struct EntryHeader {
+		u64_le keyHigh;
+		u64_le keyLow;
+		u32_le w;
+		u32_le h;
+		u32_le alphaResult;
+		u32_le compressedSize;
+	};
+
+	struct Entry {
+		s64 offset;
+		u32 compressedSize;
+		u16 w;
+		u16 h;
+		CheckAlphaResult alphaResult;
+		// Filled in by prefetching, otherwise read from the file on demand.  Shared so that
+		// Find() can decompress it without holding lock_.
+		std::shared_ptr<const std::vector<u8>> compressed;
+	};
+
+	struct PendingWrite {
+		ScaledTextureKey key;
+		int w;
+		int h;
+		CheckAlphaResult alphaResult;
+		std::vector<u8> pixels;
+	};
+
+	struct KeyHash {
+		size_t operator()(const ScaledTextureKey &key) const {
+			return (size_t)key.low;
+		}
+	};
+
+	void Run();
+	void GarbageCollectFiles();
+	bool OpenFile();
+	void ReadIndex();
+	void PrefetchNext();
+	void WriteEntry(PendingWrite &write);
+
+	Path filename_;
+	// Only used by the background thread.
+	File::IOFile file_;
+	s64 endOffset_ = 0;
+	size_t prefetchPos_ = 0;
+	size_t prefetchedBytes_ = 0;
+	std::vector<ScaledTextureKey> prefetchOrder_;
+
+	// Used by Find() for entries that weren't prefetched.  Opened by the background thread
+	// before the index is ready, and only touched by the caller of Find() after that.
+	File::IOFile readFile_;
+
+	std::thread thread_;
+	std::mutex lock_;
+	std::condition_variable cond_;
+	std::unordered_map<ScaledTextureKey, Entry, KeyHash> entries_;
+	std::deque<PendingWrite> queue_;
+	size_t queuedBytes_ = 0;
+	bool indexReady_ = false;
+	bool done_ = false;
+
+	// Only touched by the caller of Find().
+	std::vector<u8> decompressed_;
+};
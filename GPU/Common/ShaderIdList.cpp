@@ -0,0 +1,172 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/GPU/Shader.h"
+#include "Common/Log.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Core/System.h"
+#include "GPU/Common/GeometryShaderGenerator.h"
+#include "GPU/Common/ShaderIdList.h"
+
+#define SHADER_ID_LIST_MAGIC 0x4c444953
+// Bump this whenever the meaning of the shader ID bits changes, like the backend cache versions.
+#define SHADER_ID_LIST_VERSION 1
+
+struct ShaderIdListHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t useFlags;
+	int numVertexShaders;
+	int numFragmentShaders;
+	int numGeometryShaders;
+};
+
+static constexpr size_t CODE_BUFFER_SIZE = 32768;
+
+bool ShaderIdList::Load(const Path &filename) {
+	File::IOFile f(filename, "rb");
+	if (!f.IsOpen())
+		return false;
+
+	ShaderIdListHeader header{};
+	if (!f.ReadArray(&header, 1) || header.magic != SHADER_ID_LIST_MAGIC) {
+		WARN_LOG(G3D, "Shader ID list magic mismatch in '%s'", filename.c_str());
+		return false;
+	}
+	if (header.version != SHADER_ID_LIST_VERSION) {
+		WARN_LOG(G3D, "Shader ID list version mismatch, %d, expected %d", header.version, SHADER_ID_LIST_VERSION);
+		return false;
+	}
+	if (header.numVertexShaders < 0 || header.numFragmentShaders < 0 || header.numGeometryShaders < 0) {
+		ERROR_LOG(G3D, "Corrupt shader ID list header, ignoring.");
+		return false;
+	}
+
+	// Make sure the size makes sense before allocating anything, in case there's corruption.
+	u64 expectedSize = sizeof(header);
+	expectedSize += (u64)header.numVertexShaders * sizeof(VShaderID);
+	expectedSize += (u64)header.numFragmentShaders * sizeof(FShaderID);
+	expectedSize += (u64)header.numGeometryShaders * sizeof(GShaderID);
+	if (f.GetSize() != expectedSize) {
+		ERROR_LOG(G3D, "Shader ID list is wrong size: %lld instead of %lld", (long long)f.GetSize(), (long long)expectedSize);
+		return false;
+	}
+
+	useFlags = header.useFlags;
+	vert.resize(header.numVertexShaders);
+	frag.resize(header.numFragmentShaders);
+	geom.resize(header.numGeometryShaders);
+	bool success = vert.empty() || f.ReadArray(&vert[0], vert.size());
+	success = success && (frag.empty() || f.ReadArray(&frag[0], frag.size()));
+	success = success && (geom.empty() || f.ReadArray(&geom[0], geom.size()));
+	if (!success) {
+		ERROR_LOG(G3D, "Shader ID list '%s' truncated", filename.c_str());
+		vert.clear();
+		frag.clear();
+		geom.clear();
+	}
+	return success;
+}
+
+bool ShaderIdList::Save(const Path &filename) const {
+	File::IOFile f(filename, "wb");
+	if (!f.IsOpen())
+		return false;
+
+	ShaderIdListHeader header{};
+	header.magic = SHADER_ID_LIST_MAGIC;
+	header.version = SHADER_ID_LIST_VERSION;
+	header.useFlags = useFlags;
+	header.numVertexShaders = (int)vert.size();
+	header.numFragmentShaders = (int)frag.size();
+	header.numGeometryShaders = (int)geom.size();
+	bool success = f.WriteArray(&header, 1);
+	success = success && (vert.empty() || f.WriteArray(&vert[0], vert.size()));
+	success = success && (frag.empty() || f.WriteArray(&frag[0], frag.size()));
+	success = success && (geom.empty() || f.WriteArray(&geom[0], geom.size()));
+	if (!success) {
+		ERROR_LOG(G3D, "Failed to write shader ID list, disk full?");
+	}
+	return success;
+}
+
+template <typename T>
+static void MergeIds(std::vector<T> &dest, const std::vector<T> &src) {
+	dest.insert(dest.end(), src.begin(), src.end());
+	std::sort(dest.begin(), dest.end());
+	dest.erase(std::unique(dest.begin(), dest.end()), dest.end());
+}
+
+void ShaderIdList::Merge(const ShaderIdList &other) {
+	MergeIds(vert, other.vert);
+	MergeIds(frag, other.frag);
+	MergeIds(geom, other.geom);
+}
+
+Path ShaderIdListPath(const std::string &discID) {
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".shaderids");
+}
+
+void GenerateShaderIdListSources(const ShaderIdList &list, const ShaderLanguageDesc &compat, const Draw::Bugs &bugs, ShaderIdListSources *sources) {
+	const int numVert = (int)list.vert.size();
+	const int numFrag = (int)list.frag.size();
+	const int numGeom = (int)list.geom.size();
+	sources->vert.assign(numVert, std::string());
+	sources->vertFlags.assign(numVert, VertexShaderFlags());
+	sources->frag.assign(numFrag, std::string());
+	sources->fragFlags.assign(numFrag, FragmentShaderFlags());
+	sources->geom.assign(numGeom, std::string());
+
+	// Each shader takes a fraction of a millisecond, so hand them out a few at a time.
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		std::unique_ptr<char[]> buffer(new char[CODE_BUFFER_SIZE]);
+		for (int i = lower; i < upper; ++i) {
+			std::string errorString;
+			buffer[0] = '\0';
+			if (i < numVert) {
+				uint32_t attrMask;
+				uint64_t uniformMask;
+				bool success = GenerateVertexShader(list.vert[i], buffer.get(), compat, bugs, &attrMask, &uniformMask, &sources->vertFlags[i], &errorString);
+				if (success)
+					sources->vert[i] = buffer.get();
+			} else if (i < numVert + numFrag) {
+				const int j = i - numVert;
+				uint64_t uniformMask;
+				bool success = GenerateFragmentShader(list.frag[j], buffer.get(), compat, bugs, &uniformMask, &sources->fragFlags[j], &errorString);
+				if (success)
+					sources->frag[j] = buffer.get();
+			} else {
+				const int j = i - numVert - numFrag;
+				bool success = GenerateGeometryShader(list.geom[j], buffer.get(), compat, bugs, &errorString);
+				if (success)
+					sources->geom[j] = buffer.get();
+			}
+			_assert_msg_(strlen(buffer.get()) < CODE_BUFFER_SIZE, "Shader length error: %d", (int)strlen(buffer.get()));
+		}
+	}, 0, numVert + numFrag + numGeom, 16);
+
+	auto countEmpty = [](const std::vector<std::string> &codes) {
+		return (int)std::count_if(codes.begin(), codes.end(), [](const std::string &code) { return code.empty(); });
+	};
+	sources->failed = countEmpty(sources->vert) + countEmpty(sources->frag) + countEmpty(sources->geom);
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Common/GPU/Shader.h"
+#include "Common/GPU/thin3d.h"
+#include "GPU/Common/FragmentShaderGenerator.h"
+#include "GPU/Common/ShaderId.h"
+#include "GPU/Common/VertexShaderGenerator.h"
+
+class Path;
+
+// The shader variants a game has used, in a format that doesn't depend on the backend or device.
+//
+// The backends save one of these next to their own shader cache, and preload from it when they
+// don't have a cache of their own yet.  Lists gathered elsewhere can be merged and checked with
+// PPSSPPShaderTool first, so that a first run doesn't have to compile every shader on first draw.
+struct ShaderIdList {
+	uint32_t useFlags = 0;
+	std::vector<VShaderID> vert;
+	std::vector<FShaderID> frag;
+	std::vector<GShaderID> geom;
+
+	bool Load(const Path &filename);
+	bool Save(const Path &filename) const;
+
+	// Adds the IDs that aren't already in the list, keeping it sorted.
+	void Merge(const ShaderIdList &other);
+
+	bool empty() const {
+		return vert.empty() && frag.empty() && geom.empty();
+	}
+};
+
+// Where a game's list lives, next to the backend caches.
+Path ShaderIdListPath(const std::string &discID);
+
+// Source for each ID of a ShaderIdList, in the same order.  Left empty where generation failed.
+struct ShaderIdListSources {
+	std::vector<std::string> vert;
+	std::vector<VertexShaderFlags> vertFlags;
+	std::vector<std::string> frag;
+	std::vector<FragmentShaderFlags> fragFlags;
+	std::vector<std::string> geom;
+
+	int failed = 0;
+};
+
+// Generates the source of every shader in the list, spread over the worker threads.
+void GenerateShaderIdListSources(const ShaderIdList &list, const ShaderLanguageDesc &compat, const Draw::Bugs &bugs, ShaderIdListSources *sources);
@@ -17,15 +17,20 @@
 
 #include <string.h>
 #include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"  // only needed for UVScale stuff
+#include "ext/xxhash.h"
 
 class SimpleBufferManager {
 private:
@@ -277,6 +282,45 @@ class Spline3DWeight {
 WeightCache<Bezier3DWeight> Bezier3DWeight::weightsCache;
 WeightCache<Spline3DWeight> Spline3DWeight::weightsCache;
 
+// Linear combination
+template<typename T>
+inline T SampleWeighted(const T p[4], const float w[4]) {
+	return p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+}
+
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM64_NEON)
+// Loads the four weights once and broadcasts from a register, instead of per scalar multiply.
+// Summation order is kept the same as the generic version.
+template<typename T>
+inline T SampleWeightedSIMD(const T p[4], const float w[4]) {
+#if defined(_M_SSE)
+	const __m128 wv = _mm_loadu_ps(w);
+	__m128 sum = _mm_mul_ps(p[0].vec, _mm_shuffle_ps(wv, wv, _MM_SHUFFLE(0, 0, 0, 0)));
+	sum = _mm_add_ps(sum, _mm_mul_ps(p[1].vec, _mm_shuffle_ps(wv, wv, _MM_SHUFFLE(1, 1, 1, 1))));
+	sum = _mm_add_ps(sum, _mm_mul_ps(p[2].vec, _mm_shuffle_ps(wv, wv, _MM_SHUFFLE(2, 2, 2, 2))));
+	sum = _mm_add_ps(sum, _mm_mul_ps(p[3].vec, _mm_shuffle_ps(wv, wv, _MM_SHUFFLE(3, 3, 3, 3))));
+	return T(sum);
+#else
+	const float32x4_t wv = vld1q_f32(w);
+	float32x4_t sum = vmulq_laneq_f32(p[0].vec, wv, 0);
+	sum = vaddq_f32(sum, vmulq_laneq_f32(p[1].vec, wv, 1));
+	sum = vaddq_f32(sum, vmulq_laneq_f32(p[2].vec, wv, 2));
+	sum = vaddq_f32(sum, vmulq_laneq_f32(p[3].vec, wv, 3));
+	return T(sum);
+#endif
+}
+
+template<>
+inline Vec3f SampleWeighted(const Vec3f p[4], const float w[4]) {
+	return SampleWeightedSIMD(p, w);
+}
+
+template<>
+inline Vec4f SampleWeighted(const Vec4f p[4], const float w[4]) {
+	return SampleWeightedSIMD(p, w);
+}
+#endif
+
 // Tessellate single patch (4x4 control points)
 template<typename T>
 class Tessellator {
@@ -286,9 +330,8 @@ class Tessellator {
 public:
 	Tessellator(const T *p, const int idx[4]) : p{ p + idx[0], p + idx[1], p + idx[2], p + idx[3] } {}
 
-	// Linear combination
 	T Sample(const T p[4], const float w[4]) {
-		return p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+		return SampleWeighted(p, w);
 	}
 
 	void SampleEdgeU(int idx) {
@@ -333,16 +376,25 @@ void ControlPoints::Convert(const SimpleVertex *const *points, int size) {
 	defcolor = points[0]->color_32;
 }
 
+// Below this many output vertices, it's not worth waking up other threads.
+static const int MIN_TESS_VERTICES_PER_THREAD = 1024;
+
 template<class Surface>
 class SubdivisionSurface {
 public:
+	// Tessellates the output columns [lower, upper), see Surface::GetColumn().
+	// Columns never share output vertices, so ranges can run on separate threads.
 	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
-	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, int lower, int upper) {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
-			const int start_u = surface.GetTessStart(patch_u);
+		for (int column = lower; column < upper; ++column) {
+			int patch_u, tile_u;
+			surface.GetColumn(column, patch_u, tile_u);
+			const int index_u = surface.GetIndexU(patch_u, tile_u);
+			const Weight &wu = weights.u[index_u];
+
 			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
 				const int start_v = surface.GetTessStart(patch_v);
 
@@ -354,76 +406,152 @@ class SubdivisionSurface {
 				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
 				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
 
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
-
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
-
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
-
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
-
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
-						if (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
-						} else {
-							vert.color_32 = points.defcolor;
-						}
-						if (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
-						} else {
-							// Generate texcoord
-							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
-						}
-						if (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if (patchFacing)
-								vert.nrm *= -1.0f;
-						} else {
-							vert.nrm.SetZero();
-							vert.nrm.z = 1.0f;
-						}
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
+
+				for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const Weight &wv = weights.v[index_v];
+
+					SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+
+					// Tessellate
+					vert.pos = tess_pos.SampleV(wv.basis);
+					if (sampleCol) {
+						vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+					} else {
+						vert.color_32 = points.defcolor;
+					}
+					if (sampleTex) {
+						tess_tex.SampleV(wv.basis).Write(vert.uv);
+					} else {
+						// Generate texcoord
+						vert.uv[0] = patch_u + tile_u * inv_u;
+						vert.uv[1] = patch_v + tile_v * inv_v;
+					}
+					if (sampleNrm) {
+						const Vec3f derivU = tess_nrm.SampleV(wv.basis);
+						const Vec3f derivV = tess_pos.SampleV(wv.deriv);
+
+						vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
+						if (patchFacing)
+							vert.nrm *= -1.0f;
+					} else {
+						vert.nrm.SetZero();
+						vert.nrm.z = 1.0f;
 					}
 				}
 			}
 		}
-
-		surface.BuildIndex(output.indices, output.count);
 	}
 
-	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &);
+	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &, int, int);
 	TEMPLATE_PARAMETER_DISPATCHER_FUNCTION(Tess, SubdivisionSurface::Tessellate, TessFunc);
 
-	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, u32 origVertType) {
-		const bool params[] = {
-			(origVertType & GE_VTYPE_NRM_MASK) != 0 || gstate.isLightingEnabled(),
-			(origVertType & GE_VTYPE_COL_MASK) != 0,
-			(origVertType & GE_VTYPE_TC_MASK) != 0,
-			cpu_info.bSSE4_1,
-			surface.patchFacing,
-		};
-		static TemplateParameterDispatcher<TessFunc, ARRAY_SIZE(params), Tess> dispatcher; // Initialize only once
+	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, const bool params[5]) {
+		static TemplateParameterDispatcher<TessFunc, 5, Tess> dispatcher; // Initialize only once
 
 		TessFunc func = dispatcher.GetFunc(params);
-		func(output, surface, points, weights);
+		const int numColumns = surface.GetNumColumns();
+		const int numVertices = surface.GetNumVertices();
+		if (numVertices >= MIN_TESS_VERTICES_PER_THREAD * 2) {
+			const int verticesPerColumn = numVertices / numColumns;
+			const int minColumns = std::max(1, MIN_TESS_VERTICES_PER_THREAD / verticesPerColumn);
+			ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+				func(output, surface, points, weights, lower, upper);
+			}, 0, numColumns, minColumns);
+		} else {
+			func(output, surface, points, weights, 0, numColumns);
+		}
+
+		surface.BuildIndex(output.indices, output.count);
 	}
 };
 
+// Keeps recent software tessellation results, so that static curved geometry drawn every
+// frame is only tessellated once. Results depend on the control point values, the
+// surface parameters and the weights, which stay valid until the weight caches are cleared.
+class TessellationCache {
+public:
+	template<class Surface>
+	static u64 ComputeKey(const Surface &surface, const ControlPoints &points, const Weight2D &weights, const bool params[5]) {
+		const int num_points = surface.num_points_u * surface.num_points_v;
+		u64 hash = XXH3_64bits(points.tex, sizeof(Vec2f) * num_points);
+		hash = XXH3_64bits_withSeed(points.col, sizeof(Vec4f) * num_points, hash);
+		// Vec3f has a fourth lane that isn't part of the value, so skip it.
+		for (int i = 0; i < num_points; ++i)
+			hash = XXH3_64bits_withSeed(points.pos[i].AsArray(), sizeof(float) * 3, hash);
+
+		// Hash arrays rather than a struct, so there's no padding with undefined contents.
+		const uintptr_t weightTables[2] = { (uintptr_t)weights.u, (uintptr_t)weights.v };
+		hash = XXH3_64bits_withSeed(weightTables, sizeof(weightTables), hash);
+		u32 paramBits = std::is_same<Surface, SplineSurface>::value ? 1 << 5 : 0;
+		for (int i = 0; i < 5; ++i)
+			paramBits |= params[i] ? 1 << i : 0;
+		const u32 desc[] = {
+			(u32)surface.tess_u, (u32)surface.tess_v,
+			(u32)surface.num_points_u, (u32)surface.num_points_v,
+			(u32)surface.type_u, (u32)surface.type_v,
+			(u32)surface.primType,
+			points.defcolor,
+			paramBits,
+		};
+		return XXH3_64bits_withSeed(desc, sizeof(desc), hash);
+	}
+
+	bool Lookup(u64 key, OutputBuffers &output) {
+		auto it = entries_.find(key);
+		if (it == entries_.end())
+			return false;
+		const Entry &entry = it->second;
+		memcpy(output.vertices, entry.vertices.data(), entry.vertices.size() * sizeof(SimpleVertex));
+		memcpy(output.indices, entry.indices.data(), entry.indices.size() * sizeof(u16));
+		output.count = (int)entry.indices.size();
+		return true;
+	}
+
+	void Store(u64 key, const OutputBuffers &output, int numVertices) {
+		size_t bytes = numVertices * sizeof(SimpleVertex) + output.count * sizeof(u16);
+		if (bytes > MAX_BYTES / 4)
+			return;
+		// Simple policy: once full, start over. Games with static curves refill it right away.
+		if (totalBytes_ + bytes > MAX_BYTES || entries_.size() >= MAX_ENTRIES)
+			Clear();
+
+		Entry &entry = entries_[key];
+		entry.vertices.assign(output.vertices, output.vertices + numVertices);
+		entry.indices.assign(output.indices, output.indices + output.count);
+		totalBytes_ += bytes;
+	}
+
+	void Clear() {
+		entries_.clear();
+		totalBytes_ = 0;
+	}
+
+private:
+	enum {
+		MAX_ENTRIES = 64,
+		MAX_BYTES = 8 * 1024 * 1024,
+	};
+
+	struct Entry {
+		std::vector<SimpleVertex> vertices;
+		std::vector<u16> indices;
+	};
+
+	std::unordered_map<u64, Entry> entries_;
+	size_t totalBytes_ = 0;
+};
+
+static TessellationCache tessCache;
+
 template<class Surface>
 void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType, const ControlPoints &points) {
 	using WeightType = typename Surface::WeightType;
@@ -431,7 +559,20 @@ void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 ori
 	u32 key_v = WeightType::ToKey(surface.tess_v, surface.num_points_v, surface.type_v);
 	Weight2D weights(WeightType::weightsCache, key_u, key_v);
 
-	SubdivisionSurface<Surface>::Tessellate(output, surface, points, weights, origVertType);
+	const bool params[] = {
+		(origVertType & GE_VTYPE_NRM_MASK) != 0 || gstate.isLightingEnabled(),
+		(origVertType & GE_VTYPE_COL_MASK) != 0,
+		(origVertType & GE_VTYPE_TC_MASK) != 0,
+		cpu_info.bSSE4_1,
+		surface.patchFacing,
+	};
+
+	const u64 cacheKey = TessellationCache::ComputeKey(surface, points, weights, params);
+	if (tessCache.Lookup(cacheKey, output))
+		return;
+
+	SubdivisionSurface<Surface>::Tessellate(output, surface, points, weights, params);
+	tessCache.Store(cacheKey, output, surface.GetNumVertices());
 }
 
 template void SoftwareTessellation<BezierSurface>(OutputBuffers &output, const BezierSurface &surface, u32 origVertType, const ControlPoints &points);
@@ -483,6 +624,7 @@ using namespace Spline;
 void DrawEngineCommon::ClearSplineBezierWeights() {
 	Bezier3DWeight::weightsCache.Clear();
 	Spline3DWeight::weightsCache.Clear();
+	tessCache.Clear();
 }
 
 // Specialize to make instance (to avoid link error).
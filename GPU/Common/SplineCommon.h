@@ -109,6 +109,15 @@ struct BezierSurface : public SurfaceInfo {
 		return index_v * (tess_u + 1) + index_u + num_verts_per_patch * patch_index;
 	}
 
+	// Columns of output vertices across all patches, used to split up the work.
+	int GetNumColumns() const { return num_patches_u * (tess_u + 1); }
+	void GetColumn(int column, int &patch_u, int &tile_u) const {
+		patch_u = column / (tess_u + 1);
+		tile_u = column % (tess_u + 1);
+	}
+
+	int GetNumVertices() const { return num_verts_per_patch * num_patches_u * num_patches_v; }
+
 	void BuildIndex(u16 *indices, int &count) const {
 		for (int patch_u = 0; patch_u < num_patches_u; ++patch_u) {
 			for (int patch_v = 0; patch_v < num_patches_v; ++patch_v) {
@@ -146,6 +155,15 @@ struct SplineSurface : public SurfaceInfo {
 		return index_v * num_vertices_u + index_u;
 	}
 
+	int GetNumColumns() const { return num_vertices_u; }
+	void GetColumn(int column, int &patch_u, int &tile_u) const {
+		// Patches after the first start at tile 1, since they share an edge with the previous one.
+		patch_u = column == 0 ? 0 : (column - 1) / tess_u;
+		tile_u = column - patch_u * tess_u;
+	}
+
+	int GetNumVertices() const { return num_vertices_u * (num_patches_v * tess_v + 1); }
+
 	void BuildIndex(u16 *indices, int &count) const {
 		Spline::BuildIndex(indices, count, num_patches_u * tess_u, num_patches_v * tess_v, primType);
 	}
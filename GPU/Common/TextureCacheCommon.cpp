@@ -18,6 +18,7 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
@@ -28,8 +29,10 @@
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Common/Math/math_util.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/System.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
@@ -42,6 +45,7 @@
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 #include "Core/Util/PPGeDraw.h"
+#include "ext/xxhash.h"
 
 #if defined(_M_SSE)
 #include <emmintrin.h>
@@ -73,6 +77,11 @@
 #define TEXCACHE_MIN_PRESSURE 16 * 1024 * 1024  // Total in VRAM
 #define TEXCACHE_SECOND_MIN_PRESSURE 4 * 1024 * 1024
 
+// Texture levels at least this large are decoded on multiple threads, in bands of rows.
+static constexpr int MIN_PARALLEL_DECODE_PIXELS = 256 * 256;
+static constexpr int DECODE_BAND_ROWS = 8;
+static constexpr int MIN_DECODE_BANDS_PER_TASK = 4;
+
 // Just for reference
 
 // PSP Color formats:
@@ -125,6 +134,9 @@ TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw, Draw2D *draw2D)
 	tmpTexBufRearrange_.resize(512 * 512);   // 1MB
 
 	replacer_.Init();
+	if (g_Config.bTexScalingDiskCache) {
+		scaledCache_.Init(g_paramSFO.GetDiscID());
+	}
 
 	textureShaderCache_ = new TextureShaderCache(draw, draw2D_);
 }
@@ -533,6 +545,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 				entry->sizeInRAM = (textureBitsPerPixel[texFormat] * bufw * h / 2) / 8;
 				entry->bufw = bufw;
 				entry->cluthash = cluthash;
+				cacheAddrIndex_.Update(entry);
 			}
 
 			nextTexture_ = entry;
@@ -627,6 +640,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 	// to avoid excessive clearing caused by cache invalidations.
 	entry->sizeInRAM = (textureBitsPerPixel[texFormat] * bufw * h / 2) / 8;
 	entry->bufw = bufw;
+	cacheAddrIndex_.Update(entry);
 
 	entry->cluthash = cluthash;
 
@@ -1220,6 +1234,12 @@ void TextureCacheCommon::NotifyConfigChanged() {
 	standardScaleFactor_ = scaleFactor;
 
 	replacer_.NotifyConfigChanged();
+
+	if (g_Config.bTexScalingDiskCache && !scaledCache_.IsOpen()) {
+		scaledCache_.Init(g_paramSFO.GetDiscID());
+	} else if (!g_Config.bTexScalingDiskCache && scaledCache_.IsOpen()) {
+		scaledCache_.Shutdown();
+	}
 }
 
 void TextureCacheCommon::NotifyWriteFormattedFromMemory(u32 addr, int size, int width, GEBufferFormat fmt) {
@@ -1558,7 +1578,25 @@ static CheckAlphaResult DecodeDXTBlocks(uint8_t *out, int outPitch, uint32_t tex
 	for (int y = 0; y < h; y += 4) {
 		u32 blockIndex = (y / 4) * (bufw / 4);
 		int blockHeight = std::min(h - y, 4);
-		for (int x = 0; x < minw; x += 4) {
+		int x = 0;
+		if (blockHeight == 4) {
+			// Whole blocks can be decoded several at a time.
+			int fullBlocks = minw / 4;
+			switch (n) {
+			case 1:
+				DecodeDXT1Blocks(dst + outPitch32 * y, (const DXT1Block *)src + blockIndex, fullBlocks, outPitch32, &alphaSum);
+				break;
+			case 3:
+				DecodeDXT3Blocks(dst + outPitch32 * y, (const DXT3Block *)src + blockIndex, fullBlocks, outPitch32);
+				break;
+			case 5:
+				DecodeDXT5Blocks(dst + outPitch32 * y, (const DXT5Block *)src + blockIndex, fullBlocks, outPitch32);
+				break;
+			}
+			x = fullBlocks * 4;
+			blockIndex += fullBlocks;
+		}
+		for (; x < minw; x += 4) {
 			int blockWidth = std::min(minw - x, 4);
 			switch (n) {
 			case 1:
@@ -1607,18 +1645,35 @@ inline u32 TfmtRawToFullAlpha(GETextureFormat fmt) {
 	}
 }
 
-// Used for converting CLUT4 to CLUT8.
-// Could SIMD or whatever, though will hardly be a bottleneck.
-static void Expand4To8Bits(u8 *dest, const u8 *src, int srcWidth) {
-	for (int i = 0; i < (srcWidth + 1) / 2; i++) {
-		u8 lower = src[i] & 0xF;
-		u8 upper = src[i] >> 4;
-		dest[i * 2] = lower;
-		dest[i * 2 + 1] = upper;
-	}
+CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags) {
+	int w = gstate.getTextureWidth(level);
+	int h = gstate.getTextureHeight(level);
+	const uint32_t byteSize = (textureBitsPerPixel[format] * bufw * h) / 8;
+
+	char buf[128];
+	size_t len = snprintf(buf, sizeof(buf), "Tex_%08x_%dx%d_%s", texaddr, w, h, GeTextureFormatToString(format, clutformat));
+	NotifyMemInfo(MemBlockFlags::TEXTURE, texaddr, byteSize, buf, len);
+
+	if (w * h < MIN_PARALLEL_DECODE_PIXELS || h < DECODE_BAND_ROWS * 2 || g_threadManager.GetNumLooperThreads() <= 1)
+		return DecodeTextureRows(out, outPitch, format, clutformat, texaddr, level, bufw, flags, 0, h, tmpTexBuf32_);
+
+	// Large textures are decoded in bands of rows on worker threads.  Bands are a multiple of 8 rows,
+	// so they line up with swizzle and DXT blocks.  The first band sets up the CLUT, so runs first.
+	std::atomic<int> alphaResult((int)DecodeTextureRows(out, outPitch, format, clutformat, texaddr, level, bufw, flags, 0, DECODE_BAND_ROWS, tmpTexBuf32_));
+	const int bands = (h + DECODE_BAND_ROWS - 1) / DECODE_BAND_ROWS;
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		SimpleBuf<u32> tmpBuf;
+		const int startRow = lower * DECODE_BAND_ROWS;
+		const int rows = std::min(upper * DECODE_BAND_ROWS, h) - startRow;
+		CheckAlphaResult result = DecodeTextureRows(out + outPitch * startRow, outPitch, format, clutformat, texaddr, level, bufw, flags, startRow, rows, tmpBuf);
+		// CHECKALPHA_FULL is 0, so this leaves CHECKALPHA_ANY if any band had it.
+		alphaResult.fetch_or((int)result);
+	}, 1, bands, MIN_DECODE_BANDS_PER_TASK);
+
+	return (CheckAlphaResult)alphaResult.load();
 }
 
-CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags) {
+CheckAlphaResult TextureCacheCommon::DecodeTextureRows(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags, int startRow, int h, SimpleBuf<u32> &tmpBuf) {
 	u32 alphaSum = 0xFFFFFFFF;
 	u32 fullAlphaMask = 0x0;
 
@@ -1643,13 +1698,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 	}
 
 	int w = gstate.getTextureWidth(level);
-	int h = gstate.getTextureHeight(level);
-	const u8 *texptr = Memory::GetPointer(texaddr);
-	const uint32_t byteSize = (textureBitsPerPixel[format] * bufw * h) / 8;
-
-	char buf[128];
-	size_t len = snprintf(buf, sizeof(buf), "Tex_%08x_%dx%d_%s", texaddr, w, h, GeTextureFormatToString(format, clutformat));
-	NotifyMemInfo(MemBlockFlags::TEXTURE, texaddr, byteSize, buf, len);
+	// Rows are always a multiple of 8 apart, so this is the same whether swizzled or not.
+	const uint32_t rowsAddr = texaddr + (textureBitsPerPixel[format] * bufw * startRow) / 8;
+	const u8 *texptr = Memory::GetPointer(rowsAddr);
 
 	switch (format) {
 	case GE_TFMT_CLUT4:
@@ -1658,9 +1709,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 		const int clutSharingOffset = mipmapShareClut ? 0 : level * 16;
 
 		if (swizzled) {
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw / 2, texptr, bufw, h, 0);
-			texptr = (u8 *)tmpTexBuf32_.data();
+			tmpBuf.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpBuf.data(), bufw / 2, texptr, bufw, h, 0);
+			texptr = (u8 *)tmpBuf.data();
 		}
 
 		if (toClut8) {
@@ -1697,7 +1748,10 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 					// We simply expand the CLUT to 32-bit, then we deindex as usual. Probably the fastest way.
 					const u16 *clut = GetCurrentRawClut<u16>() + clutSharingOffset;
 					const int clutStart = gstate.getClutIndexStartPos();
-					if (gstate.getClutIndexShift() == 0 || gstate.getClutIndexMask() <= 16) {
+					// The first rows are always decoded before any others, so only expand it then.
+					if (startRow != 0) {
+						// Already expanded.
+					} else if (gstate.getClutIndexShift() == 0 || gstate.getClutIndexMask() <= 16) {
 						ConvertFormatToRGBA8888(clutformat, expandClut_ + clutStart, clut + clutStart, 16);
 					} else {
 						// To be safe for shifts and wrap around, convert the entire CLUT.
@@ -1744,9 +1798,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 	case GE_TFMT_CLUT8:
 		if (toClut8) {
 			if (gstate.isTextureSwizzled()) {
-				tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-				UnswizzleFromMem(tmpTexBuf32_.data(), bufw, texptr, bufw, h, 1);
-				texptr = (u8 *)tmpTexBuf32_.data();
+				tmpBuf.resize(bufw * ((h + 7) & ~7));
+				UnswizzleFromMem(tmpBuf.data(), bufw, texptr, bufw, h, 1);
+				texptr = (u8 *)tmpBuf.data();
 			}
 			// After deswizzling, we are in the correct format and can just copy.
 			for (int y = 0; y < h; ++y) {
@@ -1755,13 +1809,13 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 			// We can't know anything about alpha.
 			return CHECKALPHA_ANY;
 		}
-		return ReadIndexedTex(out, outPitch, level, texptr, 1, bufw, reverseColors, expandTo32bit);
+		return ReadIndexedTex(out, outPitch, level, texptr, 1, bufw, reverseColors, expandTo32bit, startRow, h, tmpBuf);
 
 	case GE_TFMT_CLUT16:
-		return ReadIndexedTex(out, outPitch, level, texptr, 2, bufw, reverseColors, expandTo32bit);
+		return ReadIndexedTex(out, outPitch, level, texptr, 2, bufw, reverseColors, expandTo32bit, startRow, h, tmpBuf);
 
 	case GE_TFMT_CLUT32:
-		return ReadIndexedTex(out, outPitch, level, texptr, 4, bufw, reverseColors, expandTo32bit);
+		return ReadIndexedTex(out, outPitch, level, texptr, 4, bufw, reverseColors, expandTo32bit, startRow, h, tmpBuf);
 
 	case GE_TFMT_4444:
 	case GE_TFMT_5551:
@@ -1795,9 +1849,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 			}
 		}*/ else {
 			// We don't have enough space for all rows in out, so use a temp buffer.
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 2, texptr, bufw, h, 2);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
+			tmpBuf.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpBuf.data(), bufw * 2, texptr, bufw, h, 2);
+			const u8 *unswizzled = (u8 *)tmpBuf.data();
 
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (expandTo32bit) {
@@ -1844,9 +1898,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 				ReverseColors(out, out, format, h * outPitch / 4, useBGRA);
 			}
 		}*/ else {
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 4, texptr, bufw, h, 4);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
+			tmpBuf.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpBuf.data(), bufw * 4, texptr, bufw, h, 4);
+			const u8 *unswizzled = (u8 *)tmpBuf.data();
 
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (reverseColors) {
@@ -1863,13 +1917,13 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 		break;
 
 	case GE_TFMT_DXT1:
-		return DecodeDXTBlocks<DXT1Block, 1>(out, outPitch, texaddr, texptr, w, h, bufw, reverseColors);
+		return DecodeDXTBlocks<DXT1Block, 1>(out, outPitch, rowsAddr, texptr, w, h, bufw, reverseColors);
 
 	case GE_TFMT_DXT3:
-		return DecodeDXTBlocks<DXT3Block, 3>(out, outPitch, texaddr, texptr, w, h, bufw, reverseColors);
+		return DecodeDXTBlocks<DXT3Block, 3>(out, outPitch, rowsAddr, texptr, w, h, bufw, reverseColors);
 
 	case GE_TFMT_DXT5:
-		return DecodeDXTBlocks<DXT5Block, 5>(out, outPitch, texaddr, texptr, w, h, bufw, reverseColors);
+		return DecodeDXTBlocks<DXT5Block, 5>(out, outPitch, rowsAddr, texptr, w, h, bufw, reverseColors);
 
 	default:
 		ERROR_LOG_REPORT(G3D, "Unknown Texture Format %d!!!", format);
@@ -1879,14 +1933,13 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 	return AlphaSumIsFull(alphaSum, fullAlphaMask) ? CHECKALPHA_FULL : CHECKALPHA_ANY;
 }
 
-CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit) {
+CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit, int startRow, int h, SimpleBuf<u32> &tmpBuf) {
 	int w = gstate.getTextureWidth(level);
-	int h = gstate.getTextureHeight(level);
 
 	if (gstate.isTextureSwizzled()) {
-		tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-		UnswizzleFromMem(tmpTexBuf32_.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
-		texptr = (u8 *)tmpTexBuf32_.data();
+		tmpBuf.resize(bufw * ((h + 7) & ~7));
+		UnswizzleFromMem(tmpBuf.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
+		texptr = (u8 *)tmpBuf.data();
 	}
 
 	// Misshitsu no Sacrifice has separate CLUT data, this is a hack to allow it.
@@ -1903,7 +1956,10 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 		const u16 *clut16raw = (const u16 *)clutBufRaw_ + clutSharingOffset;
 		// It's possible to access the latter half of the CLUT using the start pos.
 		const int clutStart = gstate.getClutIndexStartPos();
-		if (clutStart > 256) {
+		// The first rows are always decoded before any others, so only expand it then.
+		if (startRow != 0) {
+			// Already expanded.
+		} else if (clutStart > 256) {
 			// Access wraps around when start + index goes over.
 			ConvertFormatToRGBA8888(GEPaletteFormat(palFormat), expandClut_, clut16raw, 512);
 		} else {
@@ -2398,6 +2454,7 @@ void TextureCacheCommon::Clear(bool delete_them) {
 	if (cache_.size() + secondCache_.size()) {
 		INFO_LOG(G3D, "Texture cached cleared from %i textures", (int)(cache_.size() + secondCache_.size()));
 		cache_.clear();
+		cacheAddrIndex_.Clear();
 		secondCache_.clear();
 		cacheSizeEstimate_ = 0;
 		secondCacheSizeEstimate_ = 0;
@@ -2417,9 +2474,56 @@ void TextureCacheCommon::Clear(bool delete_them) {
 void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
 	ReleaseTexture(it->second.get(), true);
 	cacheSizeEstimate_ -= EstimateTexMemoryUsage(it->second.get());
+	cacheAddrIndex_.Remove(it->second.get());
 	cache_.erase(it);
 }
 
+void TexCacheAddrIndex::Update(TexCacheEntry *entry) {
+	const u32 start = entry->addr & 0x3FFFFFFF;
+	PageRange range;
+	range.firstPage = start >> PAGE_SHIFT;
+	range.lastPage = (start + std::max(entry->sizeInRAM, 1U) - 1) >> PAGE_SHIFT;
+
+	auto existing = ranges_.find(entry);
+	if (existing != ranges_.end()) {
+		if (existing->second.firstPage == range.firstPage && existing->second.lastPage == range.lastPage)
+			return;
+		Remove(entry);
+	}
+
+	ranges_[entry] = range;
+	for (u32 page = range.firstPage; page <= range.lastPage; ++page)
+		pages_[page].push_back(Item{ entry, range.firstPage });
+}
+
+void TexCacheAddrIndex::Remove(const TexCacheEntry *entry) {
+	auto existing = ranges_.find(entry);
+	if (existing == ranges_.end())
+		return;
+
+	for (u32 page = existing->second.firstPage; page <= existing->second.lastPage; ++page) {
+		auto it = pages_.find(page);
+		if (it == pages_.end())
+			continue;
+		std::vector<Item> &items = it->second;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (items[i].entry == entry) {
+				items[i] = items.back();
+				items.pop_back();
+				break;
+			}
+		}
+		if (items.empty())
+			pages_.erase(it);
+	}
+	ranges_.erase(existing);
+}
+
+void TexCacheAddrIndex::Clear() {
+	pages_.clear();
+	ranges_.clear();
+}
+
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
@@ -2505,10 +2609,8 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 }
 
 void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type) {
-	// They could invalidate inside the texture, let's just give a bit of leeway.
-	// TODO: Keep track of the largest texture size in bytes, and use that instead of this
-	// humongous unrealistic value.
-
+	// Used only to decide if the current texture might be affected.
+	// TODO: This can be made tighter.
 	const int LARGEST_TEXTURE_SIZE = 512 * 512 * 4;
 
 	addr &= 0x3FFFFFFF;
@@ -2520,7 +2622,6 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 	} else {
 		// Do a quick check to see if the current texture could potentially be in range.
 		const u32 currentAddr = gstate.getTextureAddress(0);
-		// TODO: This can be made tighter.
 		if (addr_end >= currentAddr && addr < currentAddr + LARGEST_TEXTURE_SIZE) {
 			gstate_c.Dirty(DIRTY_TEXTURE_IMAGE);
 		}
@@ -2531,16 +2632,9 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 		return;
 	}
 
-	const u64 startKey = (u64)(addr - LARGEST_TEXTURE_SIZE) << 32;
-	u64 endKey = (u64)(addr + size + LARGEST_TEXTURE_SIZE) << 32;
-	if (endKey < startKey) {
-		endKey = (u64)-1;
-	}
-
-	for (TexCache::iterator iter = cache_.lower_bound(startKey), end = cache_.upper_bound(endKey); iter != end; ++iter) {
-		auto &entry = iter->second;
-		u32 texAddr = entry->addr;
-		u32 texEnd = entry->addr + entry->sizeInRAM;
+	gpuStats.numTextureInvalidationChecks += cacheAddrIndex_.ForEachNear(addr, addr_end, [&](TexCacheEntry *entry) {
+		u32 texAddr = entry->addr & 0x3FFFFFFF;
+		u32 texEnd = texAddr + entry->sizeInRAM;
 
 		// Quick check for overlap. Yes the check is right.
 		if (addr < texEnd && addr_end > texAddr) {
@@ -2568,7 +2662,7 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 				entry->invalidHint++;
 			}
 		}
-	}
+	});
 }
 
 void TextureCacheCommon::InvalidateAll(GPUInvalidationType /*unused*/) {
@@ -2608,7 +2702,9 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 	gpuStats.numTexturesDecoded++;
 
 	// For the estimate, we assume cluts always point to 8888 for simplicity.
-	cacheSizeEstimate_ += EstimateTexMemoryUsage(entry);
+	const u32 texMemoryUsage = EstimateTexMemoryUsage(entry);
+	cacheSizeEstimate_ += texMemoryUsage;
+	gpuStats.numTextureDataBytesDecoded += texMemoryUsage;
 
 	plan.badMipSizes = false;
 	// maxLevel here is the max level to upload. Not the count.
@@ -2850,12 +2946,25 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 			texDecFlags |= TexDecodeFlags::TO_CLUT8;
 		}
 
-		CheckAlphaResult alphaResult = DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, srcLevel, bufw, texDecFlags);
+		ScaledTextureKey scaledKey{};
+		const bool useScaledCache = plan.scaleFactor > 1 && scaledCache_.IsOpen() && GetScaledTextureKey(entry, srcLevel, plan.scaleFactor, texDecFlags, &scaledKey);
+		CheckAlphaResult alphaResult;
+		const bool scaledCacheHit = useScaledCache && scaledCache_.Find(scaledKey, data, stride, w * plan.scaleFactor, h * plan.scaleFactor, &alphaResult);
+		if (scaledCacheHit) {
+			w *= plan.scaleFactor;
+			h *= plan.scaleFactor;
+			pixelData = (u32 *)data;
+			decPitch = stride;
+		} else {
+			alphaResult = DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, srcLevel, bufw, texDecFlags);
+		}
 		entry.SetAlphaStatus(alphaResult, srcLevel);
 
-		if (plan.scaleFactor > 1) {
+		if (plan.scaleFactor > 1 && !scaledCacheHit) {
 			// Note that this updates w and h!
+			double scaleStart = time_now_d();
 			scaler_.ScaleAlways((u32 *)data, pixelData, w, h, plan.scaleFactor);
+			double scaleTime = time_now_d() - scaleStart;
 			pixelData = (u32 *)data;
 
 			decPitch = w * 4;
@@ -2869,6 +2978,11 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 				}
 				decPitch = stride;
 			}
+
+			// This reads the mapped memory too, but only the first time a texture is scaled.
+			if (useScaledCache) {
+				scaledCache_.Store(scaledKey, data, stride, w, h, alphaResult, scaleTime);
+			}
 		}
 
 		if (replacer_.Enabled() && plan.replaced->IsInvalid()) {
@@ -2887,6 +3001,60 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 	}
 }
 
+bool TextureCacheCommon::GetScaledTextureKey(const TexCacheEntry &entry, int level, int scaleFactor, TexDecodeFlags texDecFlags, ScaledTextureKey *key) {
+	const GETextureFormat format = (GETextureFormat)entry.format;
+	const u32 texaddr = gstate.getTextureAddress(level);
+	const int w = gstate.getTextureWidth(level);
+	const int h = gstate.getTextureHeight(level);
+	const int bufw = GetTextureBufw(level, texaddr, format);
+	const u32 byteSize = (textureBitsPerPixel[format] * bufw * h) / 8;
+	if (!Memory::IsValidRange(texaddr, byteSize)) {
+		return false;
+	}
+
+	// Everything besides the texture data and CLUT that affects the decoded and scaled result.
+	struct {
+		u32 format;
+		u32 clutformat;
+		u32 swizzle;
+		u32 level;
+		u32 clutShared;
+		u32 w;
+		u32 h;
+		u32 bufw;
+		u32 texDecFlags;
+		u32 scaleFactor;
+		u32 scalingType;
+		u32 deposterize;
+	} params{};
+	params.format = format;
+	params.clutformat = gstate.clutformat & 0x00FFFFFF;
+	// VRAM mirrors can flip the swizzle.
+	params.swizzle = (gstate.isTextureSwizzled() ? 1 : 0) | (Memory::IsVRAMAddress(texaddr) ? (texaddr & 0x00600000) : 0);
+	params.level = level;
+	params.clutShared = gstate.isClutSharedForMipmaps() ? 1 : 0;
+	params.w = w;
+	params.h = h;
+	params.bufw = bufw;
+	params.texDecFlags = (u32)texDecFlags;
+	params.scaleFactor = scaleFactor;
+	params.scalingType = g_Config.iTexScalingType;
+	params.deposterize = g_Config.bTexDeposterize ? 1 : 0;
+
+	u64 seed = XXH3_64bits(&params, sizeof(params));
+	if (IsClutFormat(format)) {
+		// Same range as the CLUT hash used for the texture cache key.
+		const u32 clutBaseBytes = gstate.getClutPaletteFormat() == GE_CMODE_32BIT_ABGR8888 ? gstate.getClutIndexStartPos() * 4 : gstate.getClutIndexStartPos() * 2;
+		const u32 clutExtendedBytes = std::min(clutTotalBytes_ + clutBaseBytes, clutMaxBytes_);
+		seed = XXH3_64bits_withSeed(clutBufRaw_, clutExtendedBytes, seed);
+	}
+
+	XXH128_hash_t hash = XXH3_128bits_withSeed(Memory::GetPointerUnchecked(texaddr), byteSize, seed);
+	key->high = hash.high64;
+	key->low = hash.low64;
+	return true;
+}
+
 CheckAlphaResult TextureCacheCommon::CheckCLUTAlpha(const uint8_t *pixelData, GEPaletteFormat clutFormat, int w) {
 	switch (clutFormat) {
 	case GE_CMODE_16BIT_ABGR4444:
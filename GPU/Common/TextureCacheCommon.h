@@ -17,9 +17,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
@@ -27,6 +29,7 @@
 #include "Core/System.h"
 #include "GPU/GPU.h"
 #include "GPU/Common/GPUDebugInterface.h"
+#include "GPU/Common/ScaledTextureCache.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Common/TextureScalerCommon.h"
 #include "GPU/Common/TextureShaderCommon.h"
@@ -213,6 +216,66 @@ struct TexCacheEntry {
 // Would really like to replace this with DenseHashMap but can't as long as we need lower_bound.
 typedef std::map<u64, std::unique_ptr<TexCacheEntry>> TexCache;
 
+// Buckets cache entries by the pages of memory they cover, so invalidation only has to look
+// at entries that might actually overlap, instead of a wide window of cache keys.
+class TexCacheAddrIndex {
+public:
+	// Must be called whenever an entry's addr or sizeInRAM changes.
+	void Update(TexCacheEntry *entry);
+	void Remove(const TexCacheEntry *entry);
+	void Clear();
+
+	// Calls func once for each entry on the pages of [start, end).  Returns how many were visited.
+	template <typename F>
+	int ForEachNear(u32 start, u32 end, F func) const {
+		if (end <= start)
+			return 0;
+		const u32 firstPage = start >> PAGE_SHIFT;
+		const u32 lastPage = (end - 1) >> PAGE_SHIFT;
+
+		int visited = 0;
+		auto visitPage = [&](u32 page, const std::vector<Item> &items) {
+			for (const Item &item : items) {
+				// Entries spanning multiple pages are only visited from the first one in range.
+				if (std::max(item.firstPage, firstPage) != page)
+					continue;
+				visited++;
+				func(item.entry);
+			}
+		};
+
+		if (lastPage - firstPage >= pages_.size()) {
+			// Huge range, cheaper to just look at every page we have.
+			for (const auto &it : pages_) {
+				if (it.first >= firstPage && it.first <= lastPage)
+					visitPage(it.first, it.second);
+			}
+		} else {
+			for (u32 page = firstPage; page <= lastPage; ++page) {
+				auto it = pages_.find(page);
+				if (it != pages_.end())
+					visitPage(page, it->second);
+			}
+		}
+		return visited;
+	}
+
+private:
+	static constexpr int PAGE_SHIFT = 16;
+
+	struct Item {
+		TexCacheEntry *entry;
+		u32 firstPage;
+	};
+	struct PageRange {
+		u32 firstPage;
+		u32 lastPage;
+	};
+
+	std::unordered_map<u32, std::vector<Item>> pages_;
+	std::unordered_map<const TexCacheEntry *, PageRange> ranges_;
+};
+
 // Urgh.
 #ifdef IGNORE
 #undef IGNORE
@@ -372,12 +435,16 @@ class TextureCacheCommon {
 	virtual void BindAsClutTexture(Draw::Texture *tex, bool smooth) {}
 
 	CheckAlphaResult DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags);
+	// Decodes h rows starting at startRow to out.  Rows other than the first must come after startRow == 0.
+	CheckAlphaResult DecodeTextureRows(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags, int startRow, int h, SimpleBuf<u32> &tmpBuf);
 	void UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel);
-	CheckAlphaResult ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit);
+	CheckAlphaResult ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit, int startRow, int h, SimpleBuf<u32> &tmpBuf);
 	ReplacedTexture &FindReplacement(TexCacheEntry *entry, int &w, int &h, int &d);
 
 	// Return value is mapData normally, but could be another buffer allocated with AllocateAlignedMemory.
 	void LoadTextureLevel(TexCacheEntry &entry, uint8_t *mapData, int mapRowPitch, BuildTexturePlan &plan, int srcLevel, Draw::DataFormat dstFmt, TexDecodeFlags texDecFlags);
+	// Identifies the result of decoding and scaling a level, for scaledCache_.  False if it can't be cached.
+	bool GetScaledTextureKey(const TexCacheEntry &entry, int level, int scaleFactor, TexDecodeFlags texDecFlags, ScaledTextureKey *key);
 
 	template <typename T>
 	inline const T *GetCurrentClut() {
@@ -441,6 +508,7 @@ class TextureCacheCommon {
 
 	TextureReplacer replacer_;
 	TextureScalerCommon scaler_;
+	ScaledTextureCache scaledCache_;
 	FramebufferManagerCommon *framebufferManager_;
 	TextureShaderCache *textureShaderCache_;
 	ShaderManagerCommon *shaderManager_;
@@ -456,6 +524,7 @@ class TextureCacheCommon {
 	double replacementFrameBudget_ = 0.5 / 60.0;
 
 	TexCache cache_;
+	TexCacheAddrIndex cacheAddrIndex_;
 	u32 cacheSizeEstimate_ = 0;
 
 	TexCache secondCache_;
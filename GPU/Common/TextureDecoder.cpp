@@ -424,6 +424,7 @@ class DXTDecoder {
 	inline void WriteColorsDXT1(u32 *dst, const DXT1Block *src, int pitch, int width, int height);
 	inline void WriteColorsDXT3(u32 *dst, const DXT3Block *src, int pitch, int width, int height);
 	inline void WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int width, int height);
+	inline void WriteAlphasDXT5(u8 *alphas, const DXT5Block *src);
 
 	bool AnyNonFullAlpha() const { return anyNonFullAlpha_; }
 
@@ -442,7 +443,6 @@ static inline int mix_2_3(int c1, int c2) {
 	return (c1 + c1 + c2) / 3;
 }
 
-// This could probably be done faster by decoding two or four blocks at a time with SSE/NEON.
 void DXTDecoder::DecodeColors(const DXT1Block *src, bool ignore1bitAlpha) {
 	u16 c1 = src->color1;
 	u16 c2 = src->color2;
@@ -555,6 +555,14 @@ void DXTDecoder::WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int
 	}
 }
 
+void DXTDecoder::WriteAlphasDXT5(u8 *alphas, const DXT5Block *src) {
+	u64 alphadata = ((u64)(u16)src->alphadata1 << 32) | (u32)src->alphadata2;
+	for (int i = 0; i < 16; i++) {
+		alphas[i] = alpha_[alphadata & 7];
+		alphadata >>= 3;
+	}
+}
+
 uint32_t GetDXTTexelColor(const DXT1Block *src, int x, int y, int alpha) {
 	_dbg_assert_(x >= 0 && x < 4);
 	_dbg_assert_(y >= 0 && y < 4);
@@ -618,7 +626,7 @@ uint32_t GetDXT5Texel(const DXT5Block *src, int x, int y) {
 	return color | (lerp6(src, alphaIndex - 1) << 24);
 }
 
-// This could probably be done faster by decoding two or four blocks at a time with SSE/NEON.
+// For whole rows of blocks, prefer DecodeDXT1Blocks() etc. below.
 void DecodeDXT1Block(u32 *dst, const DXT1Block *src, int pitch, int width, int height, u32 *alpha) {
 	DXTDecoder dxt;
 	dxt.DecodeColors(src, false);
@@ -664,6 +672,519 @@ inline u32 NEONReduce16And(uint16x8_t value) {
 }
 #endif
 
+// The batched DXT decoders below work on four blocks at a time: the palettes are computed
+// together, and then each row of four pixels is picked with compares instead of a lookup.
+// Results are bit-exact with DecodeDXT*Block().
+#ifdef _M_SSE
+template <typename Block>
+static inline __m128i LoadDXTColors4SSE2(const Block *src) {
+	// Each block starts with [lines, color1 | color2 << 16], and we only want the colors.
+	const u8 *p = (const u8 *)src;
+	__m128i b0 = _mm_loadl_epi64((const __m128i *)(p + sizeof(Block) * 0));
+	__m128i b1 = _mm_loadl_epi64((const __m128i *)(p + sizeof(Block) * 1));
+	__m128i b2 = _mm_loadl_epi64((const __m128i *)(p + sizeof(Block) * 2));
+	__m128i b3 = _mm_loadl_epi64((const __m128i *)(p + sizeof(Block) * 3));
+	return _mm_unpackhi_epi64(_mm_unpacklo_epi32(b0, b1), _mm_unpacklo_epi32(b2, b3));
+}
+
+static inline __m128i Expand565SSE2(__m128i c, __m128i alpha) {
+	__m128i r = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF8));
+	__m128i g = _mm_and_si128(_mm_slli_epi32(c, 5), _mm_set1_epi32(0xFC00));
+	__m128i b = _mm_and_si128(_mm_slli_epi32(c, 19), _mm_set1_epi32(0xF80000));
+	return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, alpha));
+}
+
+// Same as mix_2_3() per byte.  x * 0xAAAB >> 17 is exactly x / 3 for anything this small.
+static inline __m128i Mix23SSE2(__m128i c1, __m128i c2) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i third = _mm_set1_epi16((short)0xAAAB);
+	__m128i lo = _mm_unpacklo_epi8(c1, zero);
+	__m128i hi = _mm_unpackhi_epi8(c1, zero);
+	lo = _mm_add_epi16(_mm_add_epi16(lo, lo), _mm_unpacklo_epi8(c2, zero));
+	hi = _mm_add_epi16(_mm_add_epi16(hi, hi), _mm_unpackhi_epi8(c2, zero));
+	lo = _mm_srli_epi16(_mm_mulhi_epu16(lo, third), 1);
+	hi = _mm_srli_epi16(_mm_mulhi_epu16(hi, third), 1);
+	return _mm_packus_epi16(lo, hi);
+}
+
+// Produces a [c0, c1, c2, c3] palette for each of the four blocks.
+static inline void DecodeDXTPalettes4SSE2(__m128i colors, u32 alpha, __m128i pal[4]) {
+	__m128i c1 = _mm_and_si128(colors, _mm_set1_epi32(0xFFFF));
+	__m128i c2 = _mm_srli_epi32(colors, 16);
+	__m128i alphaBits = _mm_set1_epi32(alpha);
+
+	__m128i col0 = Expand565SSE2(c1, alphaBits);
+	__m128i col1 = Expand565SSE2(c2, alphaBits);
+	// The colors were left shifted, so the rounding average is the same as the truncating one.
+	__m128i avg = _mm_avg_epu8(col0, col1);
+	__m128i mode4 = _mm_cmpgt_epi32(c1, c2);
+	__m128i col2 = _mm_or_si128(_mm_and_si128(mode4, Mix23SSE2(col0, col1)), _mm_andnot_si128(mode4, avg));
+	__m128i col3 = _mm_and_si128(mode4, Mix23SSE2(col1, col0));
+
+	__m128i t0 = _mm_unpacklo_epi32(col0, col1);
+	__m128i t1 = _mm_unpacklo_epi32(col2, col3);
+	__m128i t2 = _mm_unpackhi_epi32(col0, col1);
+	__m128i t3 = _mm_unpackhi_epi32(col2, col3);
+	pal[0] = _mm_unpacklo_epi64(t0, t1);
+	pal[1] = _mm_unpackhi_epi64(t0, t1);
+	pal[2] = _mm_unpacklo_epi64(t2, t3);
+	pal[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+struct DXTRowSelectorSSE2 {
+	explicit DXTRowSelectorSSE2(__m128i pal) {
+		c0 = _mm_shuffle_epi32(pal, _MM_SHUFFLE(0, 0, 0, 0));
+		d1 = _mm_xor_si128(c0, _mm_shuffle_epi32(pal, _MM_SHUFFLE(1, 1, 1, 1)));
+		d2 = _mm_xor_si128(c0, _mm_shuffle_epi32(pal, _MM_SHUFFLE(2, 2, 2, 2)));
+		d3 = _mm_xor_si128(c0, _mm_shuffle_epi32(pal, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+
+	__m128i Row(u8 line) const {
+		const __m128i mask = _mm_setr_epi32(3, 3 << 2, 3 << 4, 3 << 6);
+		__m128i index = _mm_and_si128(_mm_set1_epi32(line), mask);
+		__m128i is1 = _mm_cmpeq_epi32(index, _mm_setr_epi32(1, 1 << 2, 1 << 4, 1 << 6));
+		__m128i is2 = _mm_cmpeq_epi32(index, _mm_setr_epi32(2, 2 << 2, 2 << 4, 2 << 6));
+		__m128i is3 = _mm_cmpeq_epi32(index, mask);
+		// At most one matches, so toggling in the difference from c0 selects the color.
+		__m128i c = _mm_xor_si128(c0, _mm_and_si128(is1, d1));
+		c = _mm_xor_si128(c, _mm_and_si128(is2, d2));
+		return _mm_xor_si128(c, _mm_and_si128(is3, d3));
+	}
+
+	__m128i c0, d1, d2, d3;
+};
+
+// Moves 16 alpha values (in pixel order) to the top byte of each pixel, one vector per row.
+static inline void SpreadDXTAlphasSSE2(__m128i alphas, __m128i rows[4]) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_unpacklo_epi8(zero, alphas);
+	__m128i hi = _mm_unpackhi_epi8(zero, alphas);
+	rows[0] = _mm_unpacklo_epi16(zero, lo);
+	rows[1] = _mm_unpackhi_epi16(zero, lo);
+	rows[2] = _mm_unpacklo_epi16(zero, hi);
+	rows[3] = _mm_unpackhi_epi16(zero, hi);
+}
+#elif PPSSPP_ARCH(ARM_NEON)
+static inline uint32x4_t LoadDXTColors4NEON(const DXT1Block *src) {
+	return vld2q_u32((const u32 *)src).val[1];
+}
+
+static inline uint32x4_t LoadDXTColors4NEON(const DXT3Block *src) {
+	return vld4q_u32((const u32 *)src).val[1];
+}
+
+static inline uint32x4_t LoadDXTColors4NEON(const DXT5Block *src) {
+	return vld4q_u32((const u32 *)src).val[1];
+}
+
+static inline uint32x4_t Expand565NEON(uint32x4_t c, uint32x4_t alpha) {
+	uint32x4_t r = vandq_u32(vshrq_n_u32(c, 8), vdupq_n_u32(0xF8));
+	uint32x4_t g = vandq_u32(vshlq_n_u32(c, 5), vdupq_n_u32(0xFC00));
+	uint32x4_t b = vandq_u32(vshlq_n_u32(c, 19), vdupq_n_u32(0xF80000));
+	return vorrq_u32(vorrq_u32(r, g), vorrq_u32(b, alpha));
+}
+
+static inline uint8x8_t Mix23NEON(uint8x8_t c1, uint8x8_t c2) {
+	uint16x8_t sum = vaddw_u8(vshll_n_u8(c1, 1), c2);
+	uint32x4_t lo = vmull_u16(vget_low_u16(sum), vdup_n_u16(0xAAAB));
+	uint32x4_t hi = vmull_u16(vget_high_u16(sum), vdup_n_u16(0xAAAB));
+	return vmovn_u16(vshrq_n_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)), 1));
+}
+
+static inline uint32x4_t Mix23NEON(uint32x4_t c1, uint32x4_t c2) {
+	uint8x16_t b1 = vreinterpretq_u8_u32(c1);
+	uint8x16_t b2 = vreinterpretq_u8_u32(c2);
+	uint8x8_t lo = Mix23NEON(vget_low_u8(b1), vget_low_u8(b2));
+	uint8x8_t hi = Mix23NEON(vget_high_u8(b1), vget_high_u8(b2));
+	return vreinterpretq_u32_u8(vcombine_u8(lo, hi));
+}
+
+static inline void DecodeDXTPalettes4NEON(uint32x4_t colors, u32 alpha, uint32x4_t pal[4]) {
+	uint32x4_t c1 = vandq_u32(colors, vdupq_n_u32(0xFFFF));
+	uint32x4_t c2 = vshrq_n_u32(colors, 16);
+	uint32x4_t alphaBits = vdupq_n_u32(alpha);
+
+	uint32x4_t col0 = Expand565NEON(c1, alphaBits);
+	uint32x4_t col1 = Expand565NEON(c2, alphaBits);
+	uint32x4_t avg = vreinterpretq_u32_u8(vhaddq_u8(vreinterpretq_u8_u32(col0), vreinterpretq_u8_u32(col1)));
+	uint32x4_t mode4 = vcgtq_u32(c1, c2);
+	uint32x4_t col2 = vbslq_u32(mode4, Mix23NEON(col0, col1), avg);
+	uint32x4_t col3 = vandq_u32(mode4, Mix23NEON(col1, col0));
+
+	uint32x4x2_t t01 = vtrnq_u32(col0, col1);
+	uint32x4x2_t t23 = vtrnq_u32(col2, col3);
+	pal[0] = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+	pal[1] = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+	pal[2] = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+	pal[3] = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+}
+
+struct DXTRowSelectorNEON {
+	explicit DXTRowSelectorNEON(uint32x4_t pal) {
+		static const int32_t shiftValues[4] = { 0, -2, -4, -6 };
+		c0 = vdupq_lane_u32(vget_low_u32(pal), 0);
+		c1 = vdupq_lane_u32(vget_low_u32(pal), 1);
+		c2 = vdupq_lane_u32(vget_high_u32(pal), 0);
+		c3 = vdupq_lane_u32(vget_high_u32(pal), 1);
+		shifts = vld1q_s32(shiftValues);
+	}
+
+	uint32x4_t Row(u8 line) const {
+		uint32x4_t index = vandq_u32(vshlq_u32(vdupq_n_u32(line), shifts), vdupq_n_u32(3));
+		uint32x4_t c = vbslq_u32(vceqq_u32(index, vdupq_n_u32(1)), c1, c0);
+		c = vbslq_u32(vceqq_u32(index, vdupq_n_u32(2)), c2, c);
+		return vbslq_u32(vceqq_u32(index, vdupq_n_u32(3)), c3, c);
+	}
+
+	uint32x4_t c0, c1, c2, c3;
+	int32x4_t shifts;
+};
+
+static inline void SpreadDXTAlphasNEON(uint8x16_t alphas, uint32x4_t rows[4]) {
+	uint16x8_t lo = vmovl_u8(vget_low_u8(alphas));
+	uint16x8_t hi = vmovl_u8(vget_high_u8(alphas));
+	rows[0] = vshlq_n_u32(vmovl_u16(vget_low_u16(lo)), 24);
+	rows[1] = vshlq_n_u32(vmovl_u16(vget_high_u16(lo)), 24);
+	rows[2] = vshlq_n_u32(vmovl_u16(vget_low_u16(hi)), 24);
+	rows[3] = vshlq_n_u32(vmovl_u16(vget_high_u16(hi)), 24);
+}
+#endif
+
+void DecodeDXT1Blocks(u32 *dst, const DXT1Block *src, int count, int pitch, u32 *alpha) {
+	int i = 0;
+#ifdef _M_SSE
+	__m128i alphaMask = _mm_set1_epi32(-1);
+	for (; i + 4 <= count; i += 4) {
+		__m128i pal[4];
+		DecodeDXTPalettes4SSE2(LoadDXTColors4SSE2(src + i), 0xFF000000, pal);
+		for (int j = 0; j < 4; j++) {
+			const DXTRowSelectorSSE2 colors(pal[j]);
+			u32 *blockDst = dst + (i + j) * 4;
+			for (int y = 0; y < 4; y++) {
+				__m128i c = colors.Row(src[i + j].lines[y]);
+				alphaMask = _mm_and_si128(alphaMask, c);
+				_mm_storeu_si128((__m128i *)(blockDst + pitch * y), c);
+			}
+		}
+	}
+	// Only color 3 in the 1-bit alpha mode lacks full alpha.
+	if ((SSEReduce32And(alphaMask) >> 24) != 0xFF)
+		*alpha = 0;
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint32x4_t alphaMask = vdupq_n_u32(0xFFFFFFFF);
+	for (; i + 4 <= count; i += 4) {
+		uint32x4_t pal[4];
+		DecodeDXTPalettes4NEON(LoadDXTColors4NEON(src + i), 0xFF000000, pal);
+		for (int j = 0; j < 4; j++) {
+			const DXTRowSelectorNEON colors(pal[j]);
+			u32 *blockDst = dst + (i + j) * 4;
+			for (int y = 0; y < 4; y++) {
+				uint32x4_t c = colors.Row(src[i + j].lines[y]);
+				alphaMask = vandq_u32(alphaMask, c);
+				vst1q_u32(blockDst + pitch * y, c);
+			}
+		}
+	}
+	if ((NEONReduce32And(alphaMask) >> 24) != 0xFF)
+		*alpha = 0;
+#endif
+
+	for (; i < count; i++)
+		DecodeDXT1Block(dst + i * 4, src + i, pitch, 4, 4, alpha);
+}
+
+void DecodeDXT3Blocks(u32 *dst, const DXT3Block *src, int count, int pitch) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i highNibbles = _mm_set1_epi8((char)0xF0);
+	for (; i + 4 <= count; i += 4) {
+		__m128i pal[4];
+		DecodeDXTPalettes4SSE2(LoadDXTColors4SSE2(src + i), 0, pal);
+		for (int j = 0; j < 4; j++) {
+			const DXT3Block &block = src[i + j];
+			// Each alpha nibble becomes the high nibble of a byte, in pixel order.
+			__m128i alphaData = _mm_loadl_epi64((const __m128i *)block.alphaLines);
+			__m128i even = _mm_and_si128(_mm_slli_epi16(alphaData, 4), highNibbles);
+			__m128i odd = _mm_and_si128(alphaData, highNibbles);
+			__m128i alphaRows[4];
+			SpreadDXTAlphasSSE2(_mm_unpacklo_epi8(even, odd), alphaRows);
+
+			const DXTRowSelectorSSE2 colors(pal[j]);
+			u32 *blockDst = dst + (i + j) * 4;
+			for (int y = 0; y < 4; y++) {
+				__m128i c = _mm_or_si128(colors.Row(block.color.lines[y]), alphaRows[y]);
+				_mm_storeu_si128((__m128i *)(blockDst + pitch * y), c);
+			}
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		uint32x4_t pal[4];
+		DecodeDXTPalettes4NEON(LoadDXTColors4NEON(src + i), 0, pal);
+		for (int j = 0; j < 4; j++) {
+			const DXT3Block &block = src[i + j];
+			uint8x8_t alphaData = vld1_u8((const u8 *)block.alphaLines);
+			uint8x8x2_t nibbles = vzip_u8(vshl_n_u8(alphaData, 4), vand_u8(alphaData, vdup_n_u8(0xF0)));
+			uint32x4_t alphaRows[4];
+			SpreadDXTAlphasNEON(vcombine_u8(nibbles.val[0], nibbles.val[1]), alphaRows);
+
+			const DXTRowSelectorNEON colors(pal[j]);
+			u32 *blockDst = dst + (i + j) * 4;
+			for (int y = 0; y < 4; y++) {
+				vst1q_u32(blockDst + pitch * y, vorrq_u32(colors.Row(block.color.lines[y]), alphaRows[y]));
+			}
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		DecodeDXT3Block(dst + i * 4, src + i, pitch, 4, 4);
+}
+
+void DecodeDXT5Blocks(u32 *dst, const DXT5Block *src, int count, int pitch) {
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	alignas(16) u8 alphas[16];
+	for (; i + 4 <= count; i += 4) {
+#ifdef _M_SSE
+		__m128i pal[4];
+		DecodeDXTPalettes4SSE2(LoadDXTColors4SSE2(src + i), 0, pal);
+#else
+		uint32x4_t pal[4];
+		DecodeDXTPalettes4NEON(LoadDXTColors4NEON(src + i), 0, pal);
+#endif
+		for (int j = 0; j < 4; j++) {
+			const DXT5Block &block = src[i + j];
+			// The alpha indices are 3 bits each and spread across rows, so they're looked up normally.
+			DXTDecoder dxt;
+			dxt.DecodeAlphaDXT5(&block);
+			dxt.WriteAlphasDXT5(alphas, &block);
+
+			u32 *blockDst = dst + (i + j) * 4;
+#ifdef _M_SSE
+			__m128i alphaRows[4];
+			SpreadDXTAlphasSSE2(_mm_load_si128((const __m128i *)alphas), alphaRows);
+			const DXTRowSelectorSSE2 colors(pal[j]);
+			for (int y = 0; y < 4; y++) {
+				__m128i c = _mm_or_si128(colors.Row(block.color.lines[y]), alphaRows[y]);
+				_mm_storeu_si128((__m128i *)(blockDst + pitch * y), c);
+			}
+#else
+			uint32x4_t alphaRows[4];
+			SpreadDXTAlphasNEON(vld1q_u8(alphas), alphaRows);
+			const DXTRowSelectorNEON colors(pal[j]);
+			for (int y = 0; y < 4; y++) {
+				vst1q_u32(blockDst + pitch * y, vorrq_u32(colors.Row(block.color.lines[y]), alphaRows[y]));
+			}
+#endif
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		DecodeDXT5Block(dst + i * 4, src + i, pitch, 4, 4);
+}
+
+#ifdef _M_SSE
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("ssse3")]]
+#endif
+static int DeIndexTexture4SSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	// Split the 16 colors into a table of low bytes and one of high bytes, for pshufb.
+	const __m128i byteSplit = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+	__m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 0), byteSplit);
+	__m128i c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 1), byteSplit);
+	const __m128i tableLo = _mm_unpacklo_epi64(c0, c1);
+	const __m128i tableHi = _mm_unpackhi_epi64(c0, c1);
+
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+	__m128i alphaSum = _mm_set1_epi32(-1);
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m128i index = _mm_loadu_si128((const __m128i *)(indexed + i / 2));
+		__m128i lo = _mm_and_si128(index, nibbleMask);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(index, 4), nibbleMask);
+		__m128i pixelIndex[2] = { _mm_unpacklo_epi8(lo, hi), _mm_unpackhi_epi8(lo, hi) };
+		for (int j = 0; j < 2; j++) {
+			__m128i colorLo = _mm_shuffle_epi8(tableLo, pixelIndex[j]);
+			__m128i colorHi = _mm_shuffle_epi8(tableHi, pixelIndex[j]);
+			__m128i p0 = _mm_unpacklo_epi8(colorLo, colorHi);
+			__m128i p1 = _mm_unpackhi_epi8(colorLo, colorHi);
+			alphaSum = _mm_and_si128(alphaSum, _mm_and_si128(p0, p1));
+			_mm_storeu_si128((__m128i *)(dest + i + j * 16), p0);
+			_mm_storeu_si128((__m128i *)(dest + i + j * 16 + 8), p1);
+		}
+	}
+
+	*outAlphaSum &= SSEReduce16And(alphaSum);
+	return i;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("ssse3")]]
+#endif
+static int DeIndexTexture4SSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	// Transpose the 16 colors into four tables, one per byte.
+	const __m128i byteSplit = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	__m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 0), byteSplit);
+	__m128i c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 1), byteSplit);
+	__m128i c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 2), byteSplit);
+	__m128i c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 3), byteSplit);
+	__m128i t0 = _mm_unpacklo_epi32(c0, c1);
+	__m128i t1 = _mm_unpacklo_epi32(c2, c3);
+	__m128i t2 = _mm_unpackhi_epi32(c0, c1);
+	__m128i t3 = _mm_unpackhi_epi32(c2, c3);
+	const __m128i table0 = _mm_unpacklo_epi64(t0, t1);
+	const __m128i table1 = _mm_unpackhi_epi64(t0, t1);
+	const __m128i table2 = _mm_unpacklo_epi64(t2, t3);
+	const __m128i table3 = _mm_unpackhi_epi64(t2, t3);
+
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+	__m128i alphaSum = _mm_set1_epi32(-1);
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m128i index = _mm_loadu_si128((const __m128i *)(indexed + i / 2));
+		__m128i lo = _mm_and_si128(index, nibbleMask);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(index, 4), nibbleMask);
+		__m128i pixelIndex[2] = { _mm_unpacklo_epi8(lo, hi), _mm_unpackhi_epi8(lo, hi) };
+		for (int j = 0; j < 2; j++) {
+			__m128i b0 = _mm_shuffle_epi8(table0, pixelIndex[j]);
+			__m128i b1 = _mm_shuffle_epi8(table1, pixelIndex[j]);
+			__m128i b2 = _mm_shuffle_epi8(table2, pixelIndex[j]);
+			__m128i b3 = _mm_shuffle_epi8(table3, pixelIndex[j]);
+			__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+			__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+			__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+			__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+			__m128i p0 = _mm_unpacklo_epi16(lo01, lo23);
+			__m128i p1 = _mm_unpackhi_epi16(lo01, lo23);
+			__m128i p2 = _mm_unpacklo_epi16(hi01, hi23);
+			__m128i p3 = _mm_unpackhi_epi16(hi01, hi23);
+			alphaSum = _mm_and_si128(alphaSum, _mm_and_si128(_mm_and_si128(p0, p1), _mm_and_si128(p2, p3)));
+			u32 *d = dest + i + j * 16;
+			_mm_storeu_si128((__m128i *)(d + 0), p0);
+			_mm_storeu_si128((__m128i *)(d + 4), p1);
+			_mm_storeu_si128((__m128i *)(d + 8), p2);
+			_mm_storeu_si128((__m128i *)(d + 12), p3);
+		}
+	}
+
+	*outAlphaSum &= SSEReduce32And(alphaSum);
+	return i;
+}
+#elif PPSSPP_ARCH(ARM64)
+inline u32 NEONReduce8And(uint8x16_t value) {
+	uint64x2_t value64 = vreinterpretq_u64_u8(value);
+	u64 mask = vgetq_lane_u64(value64, 0) & vgetq_lane_u64(value64, 1);
+	mask &= mask >> 32;
+	mask &= mask >> 16;
+	mask &= mask >> 8;
+	return (u32)(mask & 0xFF);
+}
+
+// These use tbl, which is only available on ARM64.
+static int DeIndexTexture4NEON(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	// Deinterleaving gives a table of low bytes and one of high bytes.
+	const uint8x16x2_t table = vld2q_u8((const u8 *)clut);
+	uint8x16_t alphaLo = vdupq_n_u8(0xFF);
+	uint8x16_t alphaHi = vdupq_n_u8(0xFF);
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		uint8x16_t index = vld1q_u8(indexed + i / 2);
+		uint8x16x2_t pixelIndex = vzipq_u8(vandq_u8(index, vdupq_n_u8(0x0F)), vshrq_n_u8(index, 4));
+		for (int j = 0; j < 2; j++) {
+			uint8x16x2_t colors;
+			colors.val[0] = vqtbl1q_u8(table.val[0], pixelIndex.val[j]);
+			colors.val[1] = vqtbl1q_u8(table.val[1], pixelIndex.val[j]);
+			alphaLo = vandq_u8(alphaLo, colors.val[0]);
+			alphaHi = vandq_u8(alphaHi, colors.val[1]);
+			vst2q_u8((u8 *)(dest + i + j * 16), colors);
+		}
+	}
+
+	*outAlphaSum &= NEONReduce8And(alphaLo) | (NEONReduce8And(alphaHi) << 8);
+	return i;
+}
+
+static int DeIndexTexture4NEON(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	const uint8x16x4_t table = vld4q_u8((const u8 *)clut);
+	uint8x16_t alpha[4] = { vdupq_n_u8(0xFF), vdupq_n_u8(0xFF), vdupq_n_u8(0xFF), vdupq_n_u8(0xFF) };
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		uint8x16_t index = vld1q_u8(indexed + i / 2);
+		uint8x16x2_t pixelIndex = vzipq_u8(vandq_u8(index, vdupq_n_u8(0x0F)), vshrq_n_u8(index, 4));
+		for (int j = 0; j < 2; j++) {
+			uint8x16x4_t colors;
+			for (int k = 0; k < 4; k++) {
+				colors.val[k] = vqtbl1q_u8(table.val[k], pixelIndex.val[j]);
+				alpha[k] = vandq_u8(alpha[k], colors.val[k]);
+			}
+			vst4q_u8((u8 *)(dest + i + j * 16), colors);
+		}
+	}
+
+	u32 alphaSum = 0;
+	for (int k = 0; k < 4; k++)
+		alphaSum |= NEONReduce8And(alpha[k]) << (k * 8);
+	*outAlphaSum &= alphaSum;
+	return i;
+}
+#endif
+
+int DeIndexTexture4SIMD(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	if (length < 32)
+		return 0;
+#ifdef _M_SSE
+	if (cpu_info.bSSSE3)
+		return DeIndexTexture4SSSE3(dest, indexed, length, clut, outAlphaSum);
+#elif PPSSPP_ARCH(ARM64)
+	return DeIndexTexture4NEON(dest, indexed, length, clut, outAlphaSum);
+#endif
+	return 0;
+}
+
+int DeIndexTexture4SIMD(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	if (length < 32)
+		return 0;
+#ifdef _M_SSE
+	if (cpu_info.bSSSE3)
+		return DeIndexTexture4SSSE3(dest, indexed, length, clut, outAlphaSum);
+#elif PPSSPP_ARCH(ARM64)
+	return DeIndexTexture4NEON(dest, indexed, length, clut, outAlphaSum);
+#endif
+	return 0;
+}
+
+void Expand4To8Bits(u8 *dest, const u8 *src, int srcWidth) {
+	const int srcBytes = (srcWidth + 1) / 2;
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+	for (; i + 16 <= srcBytes; i += 16) {
+		__m128i value = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lower = _mm_and_si128(value, nibbleMask);
+		__m128i upper = _mm_and_si128(_mm_srli_epi16(value, 4), nibbleMask);
+		_mm_storeu_si128((__m128i *)(dest + i * 2), _mm_unpacklo_epi8(lower, upper));
+		_mm_storeu_si128((__m128i *)(dest + i * 2 + 16), _mm_unpackhi_epi8(lower, upper));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 16 <= srcBytes; i += 16) {
+		uint8x16_t value = vld1q_u8(src + i);
+		uint8x16x2_t expanded;
+		expanded.val[0] = vandq_u8(value, vdupq_n_u8(0x0F));
+		expanded.val[1] = vshrq_n_u8(value, 4);
+		vst2q_u8(dest + i * 2, expanded);
+	}
+#endif
+
+	for (; i < srcBytes; i++) {
+		u8 lower = src[i] & 0xF;
+		u8 upper = src[i] >> 4;
+		dest[i * 2] = lower;
+		dest[i * 2 + 1] = upper;
+	}
+}
+
 // TODO: SSE/SIMD
 // At least on x86, compiler actually SIMDs these pretty well.
 void CopyAndSumMask16(u16 *dst, const u16 *src, int width, u32 *outMask) {
@@ -69,6 +69,11 @@ void DecodeDXT1Block(u32 *dst, const DXT1Block *src, int pitch, int width, int h
 void DecodeDXT3Block(u32 *dst, const DXT3Block *src, int pitch, int width, int height);
 void DecodeDXT5Block(u32 *dst, const DXT5Block *src, int pitch, int width, int height);
 
+// Decode count full 4x4 blocks which are next to each other horizontally, using SIMD where available.
+void DecodeDXT1Blocks(u32 *dst, const DXT1Block *src, int count, int pitch, u32 *alpha);
+void DecodeDXT3Blocks(u32 *dst, const DXT3Block *src, int count, int pitch);
+void DecodeDXT5Blocks(u32 *dst, const DXT5Block *src, int count, int pitch);
+
 uint32_t GetDXT1Texel(const DXT1Block *src, int x, int y);
 uint32_t GetDXT3Texel(const DXT3Block *src, int x, int y);
 uint32_t GetDXT5Texel(const DXT5Block *src, int x, int y);
@@ -156,6 +161,14 @@ inline void DeIndexTexture(/*WRITEONLY*/ ClutT *dest, const u32 texaddr, int len
 	DeIndexTexture(dest, indexed, length, clut, outAlphaSum);
 }
 
+// Looks up as many pixels of a CLUT4 texture as possible with SIMD (using only the first 16
+// CLUT entries), and returns how many were done.  Always an even number.
+int DeIndexTexture4SIMD(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+int DeIndexTexture4SIMD(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+
+// Used for converting CLUT4 to CLUT8.
+void Expand4To8Bits(u8 *dest, const u8 *src, int srcWidth);
+
 template <typename ClutT>
 inline void DeIndexTexture4(/*WRITEONLY*/ ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
 	// Usually, there is no special offset, mask, or shift.
@@ -163,6 +176,11 @@ inline void DeIndexTexture4(/*WRITEONLY*/ ClutT *dest, const u8 *indexed, int le
 
 	ClutT alphaSum = (ClutT)(-1);
 	if (nakedIndex) {
+		int done = DeIndexTexture4SIMD(dest, indexed, length, clut, outAlphaSum);
+		dest += done;
+		indexed += done / 2;
+		length -= done;
+
 		while (length >= 2) {
 			u8 index = *indexed++;
 			ClutT color0 = clut[index & 0xf];
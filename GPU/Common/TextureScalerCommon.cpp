@@ -15,11 +15,14 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/. 
 
+#include "ppsspp_config.h"
+
 #include <cstddef>
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <vector>
 
 #include "GPU/Common/TextureScalerCommon.h"
 
@@ -37,6 +40,14 @@
 #include <smmintrin.h>
 #endif
 
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 // Report the time and throughput for each larger scaling operation in the log
 //#define SCALING_MEASURE_TIME
 
@@ -68,26 +79,97 @@ namespace {
 
 #define BLOCK_SIZE 32
 
-// 3x3 convolution with Neumann boundary conditions, parallelizable
-// quite slow, could be sped up a lot
-// especially handling of separable kernels
-void convolve3x3(const u32 *data, u32 *out, const int kernel[3][3], int width, int height, int l, int u) {
-	for (int yb = 0; yb < (u - l) / BLOCK_SIZE + 1; ++yb) {
-		for (int xb = 0; xb < width / BLOCK_SIZE + 1; ++xb) {
-			for (int y = l + yb*BLOCK_SIZE; y < l + (yb + 1)*BLOCK_SIZE && y < u; ++y) {
-				for (int x = xb*BLOCK_SIZE; x < (xb + 1)*BLOCK_SIZE && x < width; ++x) {
-					int val = 0;
-					for (int yoff = -1; yoff <= 1; ++yoff) {
-						int yy = std::max(std::min(y + yoff, height - 1), 0);
-						for (int xoff = -1; xoff <= 1; ++xoff) {
-							int xx = std::max(std::min(x + xoff, width - 1), 0);
-							val += data[yy*width + xx] * kernel[yoff + 1][xoff + 1];
-						}
-					}
-					out[y*width + x] = abs(val);
-				}
-			}
-		}
+// The hybrid scaler's mask saturates at this value.  Found through practical testing on a variety of textures.
+static const u32 HYBRID_MASK_MAX = 8192;
+
+#if defined(_M_SSE)
+// Same as MIX_PIXELS for four pixels, with the factors spread out to 16-bit lanes for pixels 0-1 and 2-3.
+inline __m128i MixPixelsSSE2(__m128i p0, __m128i p1, __m128i f0lo, __m128i f0hi, __m128i f1lo, __m128i f1hi) {
+	const __m128i zero = _mm_setzero_si128();
+	// These can't overflow, since f0 + f1 <= 255.
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p0, zero), f0lo), _mm_mullo_epi16(_mm_unpacklo_epi8(p1, zero), f1lo));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p0, zero), f0hi), _mm_mullo_epi16(_mm_unpackhi_epi8(p1, zero), f1hi));
+	// x / 255 == ((x + 1) * 257) >> 16 for all x up to 255 * 255.
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i mul257 = _mm_set1_epi16(257);
+	lo = _mm_mulhi_epu16(_mm_add_epi16(lo, one), mul257);
+	hi = _mm_mulhi_epu16(_mm_add_epi16(hi, one), mul257);
+	return _mm_packus_epi16(lo, hi);
+}
+#elif PPSSPP_ARCH(ARM_NEON)
+// Same as MIX_PIXELS for four pixels, with a factor for each byte.
+inline uint8x16_t MixPixelsNEON(uint8x16_t p0, uint8x16_t p1, uint8x16_t f0, uint8x16_t f1) {
+	uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(p0), vget_low_u8(f0)), vget_low_u8(p1), vget_low_u8(f1));
+	uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(p0), vget_high_u8(f0)), vget_high_u8(p1), vget_high_u8(f1));
+	// x / 255 == (x + 1 + (x >> 8)) >> 8 for all x up to 255 * 255.
+	const uint16x8_t one = vdupq_n_u16(1);
+	lo = vaddq_u16(vsraq_n_u16(lo, lo, 8), one);
+	hi = vaddq_u16(vsraq_n_u16(hi, hi, 8), one);
+	return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+}
+#endif
+
+// out = MIX_PIXELS(p0, p1, factors) for n pixels.
+void mixRow(const u32 *p0, const u32 *p1, const u8 factors[2], u32 *out, int n) {
+	int x = 0;
+#if defined(_M_SSE)
+	const __m128i f0 = _mm_set1_epi16(factors[0]);
+	const __m128i f1 = _mm_set1_epi16(factors[1]);
+	for (; x + 4 <= n; x += 4) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(p0 + x));
+		__m128i b = _mm_loadu_si128((const __m128i *)(p1 + x));
+		_mm_storeu_si128((__m128i *)(out + x), MixPixelsSSE2(a, b, f0, f0, f1, f1));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint8x16_t f0 = vdupq_n_u8(factors[0]);
+	const uint8x16_t f1 = vdupq_n_u8(factors[1]);
+	for (; x + 4 <= n; x += 4) {
+		uint8x16_t a = vreinterpretq_u8_u32(vld1q_u32(p0 + x));
+		uint8x16_t b = vreinterpretq_u8_u32(vld1q_u32(p1 + x));
+		vst1q_u32(out + x, vreinterpretq_u32_u8(MixPixelsNEON(a, b, f0, f1)));
+	}
+#endif
+	for (; x < n; ++x) {
+		out[x] = MIX_PIXELS(p0[x], p1[x], factors);
+	}
+}
+
+// Sum of the 3x3 neighborhood of each pixel (Neumann boundary conditions), given the three rows.
+// sums is scratch space for width values.
+void boxFilterRow(const u32 *above, const u32 *row, const u32 *below, u32 *sums, u32 *out, int width) {
+	int x = 0;
+#if defined(_M_SSE)
+	for (; x + 4 <= width; x += 4) {
+		__m128i sum = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(above + x)), _mm_loadu_si128((const __m128i *)(row + x)));
+		sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)(below + x)));
+		_mm_storeu_si128((__m128i *)(sums + x), sum);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; x + 4 <= width; x += 4) {
+		uint32x4_t sum = vaddq_u32(vaddq_u32(vld1q_u32(above + x), vld1q_u32(row + x)), vld1q_u32(below + x));
+		vst1q_u32(sums + x, sum);
+	}
+#endif
+	for (; x < width; ++x) {
+		sums[x] = above[x] + row[x] + below[x];
+	}
+
+	out[0] = sums[0] + sums[0] + sums[std::min(1, width - 1)];
+	x = 1;
+#if defined(_M_SSE)
+	for (; x + 5 <= width; x += 4) {
+		__m128i sum = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums + x - 1)), _mm_loadu_si128((const __m128i *)(sums + x)));
+		sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)(sums + x + 1)));
+		_mm_storeu_si128((__m128i *)(out + x), sum);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; x + 5 <= width; x += 4) {
+		uint32x4_t sum = vaddq_u32(vaddq_u32(vld1q_u32(sums + x - 1), vld1q_u32(sums + x)), vld1q_u32(sums + x + 1));
+		vst1q_u32(out + x, sum);
+	}
+#endif
+	for (; x < width; ++x) {
+		out[x] = sums[x - 1] + sums[x] + sums[std::min(x + 1, width - 1)];
 	}
 }
 
@@ -150,48 +232,127 @@ void deposterizeV(const u32 *data, u32 *out, int w, int h, int l, int u) {
 	}
 }
 
-// generates a distance mask value for each pixel in data
+// generates a distance mask value for each pixel in row y of data
 // higher values -> larger distance to the surrounding pixels
-void generateDistanceMask(const u32 *data, u32 *out, int width, int height, int l, int u) {
-	for (int yb = 0; yb < (u - l) / BLOCK_SIZE + 1; ++yb) {
-		for (int xb = 0; xb < width / BLOCK_SIZE + 1; ++xb) {
-			for (int y = l + yb*BLOCK_SIZE; y < l + (yb + 1)*BLOCK_SIZE && y < u; ++y) {
-				for (int x = xb*BLOCK_SIZE; x < (xb + 1)*BLOCK_SIZE && x < width; ++x) {
-					const u32 center = data[y*width + x];
-					u32 dist = 0;
-					for (int yoff = -1; yoff <= 1; ++yoff) {
-						int yy = y + yoff;
-						if (yy == height || yy == -1) {
-							dist += 1200; // assume distance at borders, usually makes for better result
-							continue;
-						}
-						for (int xoff = -1; xoff <= 1; ++xoff) {
-							if (yoff == 0 && xoff == 0) continue;
-							int xx = x + xoff;
-							if (xx == width || xx == -1) {
-								dist += 400; // assume distance at borders, usually makes for better result
-								continue;
-							}
-							dist += DISTANCE(data[yy*width + xx], center);
-						}
-					}
-					out[y*width + x] = dist;
+void distanceMaskRow(const u32 *data, u32 *out, int width, int height, int y) {
+	auto pixelDistance = [&](int x) {
+		const u32 center = data[y*width + x];
+		u32 dist = 0;
+		for (int yoff = -1; yoff <= 1; ++yoff) {
+			int yy = y + yoff;
+			if (yy == height || yy == -1) {
+				dist += 1200; // assume distance at borders, usually makes for better result
+				continue;
+			}
+			for (int xoff = -1; xoff <= 1; ++xoff) {
+				if (yoff == 0 && xoff == 0) continue;
+				int xx = x + xoff;
+				if (xx == width || xx == -1) {
+					dist += 400; // assume distance at borders, usually makes for better result
+					continue;
 				}
+				dist += DISTANCE(data[yy*width + xx], center);
 			}
 		}
+		return dist;
+	};
+
+	int x = 0;
+	if (y > 0 && y < height - 1 && width > 1) {
+		// Away from the borders, all eight neighbors count the same way.
+		out[0] = pixelDistance(0);
+		x = 1;
+		const u32 *above = data + (y - 1) * width;
+		const u32 *row = data + y * width;
+		const u32 *below = data + (y + 1) * width;
+#if defined(_M_SSE)
+		const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+		const __m128i lowHalves = _mm_set1_epi32(0x0000FFFF);
+		for (; x + 5 <= width; x += 4) {
+			const __m128i center = _mm_loadu_si128((const __m128i *)(row + x));
+			// Sums of two channels per 16 bits, this can't overflow with 8 neighbors.
+			__m128i sum = _mm_setzero_si128();
+			auto add = [&](const u32 *p) {
+				__m128i v = _mm_loadu_si128((const __m128i *)p);
+				__m128i diff = _mm_or_si128(_mm_subs_epu8(v, center), _mm_subs_epu8(center, v));
+				sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_and_si128(diff, lowBytes), _mm_srli_epi16(diff, 8)));
+			};
+			add(above + x - 1); add(above + x); add(above + x + 1);
+			add(row + x - 1); add(row + x + 1);
+			add(below + x - 1); add(below + x); add(below + x + 1);
+			sum = _mm_add_epi32(_mm_and_si128(sum, lowHalves), _mm_srli_epi32(sum, 16));
+			_mm_storeu_si128((__m128i *)(out + x), sum);
+		}
+#elif PPSSPP_ARCH(ARM_NEON)
+		for (; x + 5 <= width; x += 4) {
+			const uint8x16_t center = vreinterpretq_u8_u32(vld1q_u32(row + x));
+			// Sums of two channels per 16 bits, this can't overflow with 8 neighbors.
+			uint16x8_t sum = vdupq_n_u16(0);
+			auto add = [&](const u32 *p) {
+				sum = vpadalq_u8(sum, vabdq_u8(vreinterpretq_u8_u32(vld1q_u32(p)), center));
+			};
+			add(above + x - 1); add(above + x); add(above + x + 1);
+			add(row + x - 1); add(row + x + 1);
+			add(below + x - 1); add(below + x); add(below + x + 1);
+			vst1q_u32(out + x, vpaddlq_u16(sum));
+		}
+#endif
+	}
+	for (; x < width; ++x) {
+		out[x] = pixelDistance(x);
 	}
 }
 
-// mix two images based on a mask
-void mix(u32 *data, const u32 *source, const u32 *mask, u32 maskmax, int width, int l, int u) {
-	for (int y = l; y < u; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int pos = y*width + x;
-			u8 mixFactors[2] = { 0, static_cast<u8>((std::min(mask[pos], maskmax) * 255) / maskmax) };
-			mixFactors[0] = 255 - mixFactors[1];
-			data[pos] = MIX_PIXELS(data[pos], source[pos], mixFactors);
-			if (A(source[pos]) == 0) data[pos] = data[pos] & 0x00FFFFFF; // xBRZ always does a better job with hard alpha
-		}
+// Mixes the smooth and xBRZ scaled images based on the scaled mask.
+void mixMaskedRow(const u32 *smooth, const u32 *sharp, const u32 *mask, u32 *out, int n) {
+	static_assert(HYBRID_MASK_MAX == 1 << 13, "The SIMD paths divide by shifting");
+	int x = 0;
+#if defined(_M_SSE)
+	const __m128i maskMax = _mm_set1_epi32(HYBRID_MASK_MAX);
+	const __m128i all = _mm_set1_epi16(255);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+	for (; x + 4 <= n; x += 4) {
+		__m128i m = _mm_loadu_si128((const __m128i *)(mask + x));
+		// The mask is well below 2^31, so a signed min works.
+		__m128i over = _mm_cmpgt_epi32(m, maskMax);
+		m = _mm_or_si128(_mm_and_si128(over, maskMax), _mm_andnot_si128(over, m));
+		m = _mm_srli_epi32(_mm_sub_epi32(_mm_slli_epi32(m, 8), m), 13);
+		// Spread each pixel's factor to all four channels.
+		m = _mm_or_si128(m, _mm_slli_epi32(m, 16));
+		__m128i f1lo = _mm_unpacklo_epi32(m, m);
+		__m128i f1hi = _mm_unpackhi_epi32(m, m);
+
+		__m128i sharpPixels = _mm_loadu_si128((const __m128i *)(sharp + x));
+		__m128i smoothPixels = _mm_loadu_si128((const __m128i *)(smooth + x));
+		__m128i result = MixPixelsSSE2(smoothPixels, sharpPixels, _mm_sub_epi16(all, f1lo), _mm_sub_epi16(all, f1hi), f1lo, f1hi);
+		// xBRZ always does a better job with hard alpha
+		__m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(sharpPixels, alphaMask), _mm_setzero_si128());
+		result = _mm_andnot_si128(_mm_and_si128(transparent, alphaMask), result);
+		_mm_storeu_si128((__m128i *)(out + x), result);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint32x4_t alphaMask = vdupq_n_u32(0xFF000000);
+	for (; x + 4 <= n; x += 4) {
+		uint32x4_t m = vminq_u32(vld1q_u32(mask + x), vdupq_n_u32(HYBRID_MASK_MAX));
+		m = vshrq_n_u32(vmulq_n_u32(m, 255), 13);
+		// Spread each pixel's factor to all four channels.
+		uint8x16_t f1 = vreinterpretq_u8_u32(vmulq_n_u32(m, 0x01010101));
+		uint8x16_t f0 = vsubq_u8(vdupq_n_u8(255), f1);
+
+		uint32x4_t sharpPixels = vld1q_u32(sharp + x);
+		uint8x16_t smoothPixels = vreinterpretq_u8_u32(vld1q_u32(smooth + x));
+		uint32x4_t result = vreinterpretq_u32_u8(MixPixelsNEON(smoothPixels, vreinterpretq_u8_u32(sharpPixels), f0, f1));
+		// xBRZ always does a better job with hard alpha
+		uint32x4_t transparent = vceqq_u32(vandq_u32(sharpPixels, alphaMask), vdupq_n_u32(0));
+		vst1q_u32(out + x, vbicq_u32(result, vandq_u32(transparent, alphaMask)));
+	}
+#endif
+	for (; x < n; ++x) {
+		u8 mixFactors[2] = { 0, static_cast<u8>((std::min(mask[x], HYBRID_MASK_MAX) * 255) / HYBRID_MASK_MAX) };
+		mixFactors[0] = 255 - mixFactors[1];
+		u32 result = MIX_PIXELS(smooth[x], sharp[x], mixFactors);
+		if (A(sharp[x]) == 0) result = result & 0x00FFFFFF; // xBRZ always does a better job with hard alpha
+		out[x] = result;
 	}
 }
 
@@ -442,12 +603,14 @@ static void upscale_cubic(
 			upscale_block_c   (width, height, src_stride_in_bytes, (const u8*)src_pixels, wrap_mode, scale, B, C, x, y, pixels);
 #endif
 			for(ptrdiff_t iy = 0, ny = (y1-y < BLOCK ? y1-y : BLOCK), nx = (x1-x < BLOCK ? x1-x : BLOCK); iy < ny; ++iy)
-				memcpy((u8*)dst_pixels + dst_stride_in_bytes*(y+iy) + 4*x, pixels + BLOCK*4*iy, (size_t)(4*nx));
+				memcpy((u8*)dst_pixels + dst_stride_in_bytes*(y-y0+iy) + 4*x, pixels + BLOCK*4*iy, (size_t)(4*nx));
 		}
 }
 
 // End of pasted cubic upscaler.
+// (Modified so that dst_pixels points at row y0, to allow scaling bands into smaller buffers.)
 
+// out points at output row factor*l.
 void scaleBicubicBSpline(int factor, const u32 *data, u32 *out, int w, int h, int l, int u) {
 	const float B = 1.0f, C = 0.0f;
 	const int wrap_mode = 1; // Clamp
@@ -458,6 +621,7 @@ void scaleBicubicBSpline(int factor, const u32 *data, u32 *out, int w, int h, in
 		0, factor*l, factor*w, factor*u);
 }
 
+// out points at output row factor*l.
 void scaleBicubicMitchell(int factor, const u32 *data, u32 *out, int w, int h, int l, int u) {
 	const float B = 0.0f, C = 0.5f; // Actually, Catmull-Rom
 	const int wrap_mode = 1; // Clamp
@@ -476,71 +640,118 @@ const static u8 BILINEAR_FACTORS[4][3][2] = {
 		{ { 77, 178 }, { 26, 229 }, { 0, 0 } }, // x4
 		{ { 102, 153 }, { 51, 204 }, { 0, 255 } }, // x5
 };
-// integral bilinear upscaling by factor f, horizontal part
+// integral bilinear upscaling by factor f, horizontal part, for a single row
 template<int f>
-void bilinearHt(const u32 *data, u32 *out, int w, int l, int u) {
+void bilinearHt(const u32 *data, u32 *out, int w) {
 	static_assert(f > 1 && f <= 5, "Bilinear scaling only implemented for factors 2 to 5");
-	int outw = w*f;
-	for (int y = l; y < u; ++y) {
-		for (int x = 0; x < w; ++x) {
-			int inpos = y*w + x;
-			u32 left = data[inpos - (x == 0 ? 0 : 1)];
-			u32 center = data[inpos];
-			u32 right = data[inpos + (x == w - 1 ? 0 : 1)];
-			int i = 0;
-			for (; i < f / 2 + f % 2; ++i) { // first half of the new pixels + center, hope the compiler unrolls this
-				out[y*outw + x*f + i] = MIX_PIXELS(left, center, BILINEAR_FACTORS[f - 2][i]);
-			}
-			for (; i < f; ++i) { // second half of the new pixels, hope the compiler unrolls this
-				out[y*outw + x*f + i] = MIX_PIXELS(right, center, BILINEAR_FACTORS[f - 2][f - 1 - i]);
-			}
+	for (int x = 0; x < w; ++x) {
+		u32 left = data[x - (x == 0 ? 0 : 1)];
+		u32 center = data[x];
+		u32 right = data[x + (x == w - 1 ? 0 : 1)];
+		int i = 0;
+		for (; i < f / 2 + f % 2; ++i) { // first half of the new pixels + center, hope the compiler unrolls this
+			out[x*f + i] = MIX_PIXELS(left, center, BILINEAR_FACTORS[f - 2][i]);
+		}
+		for (; i < f; ++i) { // second half of the new pixels, hope the compiler unrolls this
+			out[x*f + i] = MIX_PIXELS(right, center, BILINEAR_FACTORS[f - 2][f - 1 - i]);
 		}
 	}
 }
-void bilinearH(int factor, const u32 *data, u32 *out, int w, int l, int u) {
+void bilinearH(int factor, const u32 *data, u32 *out, int w) {
 	switch (factor) {
-	case 2: bilinearHt<2>(data, out, w, l, u); break;
-	case 3: bilinearHt<3>(data, out, w, l, u); break;
-	case 4: bilinearHt<4>(data, out, w, l, u); break;
-	case 5: bilinearHt<5>(data, out, w, l, u); break;
+	case 2: bilinearHt<2>(data, out, w); break;
+	case 3: bilinearHt<3>(data, out, w); break;
+	case 4: bilinearHt<4>(data, out, w); break;
+	case 5: bilinearHt<5>(data, out, w); break;
 	default: ERROR_LOG(G3D, "Bilinear upsampling only implemented for factors 2 to 5");
 	}
 }
 // integral bilinear upscaling by factor f, vertical part
-// gl/gu == global lower and upper bound
-template<int f>
-void bilinearVt(const u32 *data, u32 *out, int w, int gl, int gu, int l, int u) {
-	static_assert(f>1 && f <= 5, "Bilinear scaling only implemented for 2x, 3x, 4x, and 5x");
-	int outw = w*f;
-	for (int xb = 0; xb < outw / BLOCK_SIZE + 1; ++xb) {
-		for (int y = l; y < u; ++y) {
-			u32 uy = y - (y == gl ? 0 : 1);
-			u32 ly = y + (y == gu - 1 ? 0 : 1);
-			for (int x = xb*BLOCK_SIZE; x < (xb + 1)*BLOCK_SIZE && x < outw; ++x) {
-				u32 upper = data[uy * outw + x];
-				u32 center = data[y * outw + x];
-				u32 lower = data[ly * outw + x];
-				int i = 0;
-				for (; i < f / 2 + f % 2; ++i) { // first half of the new pixels + center, hope the compiler unrolls this
-					out[(y*f + i)*outw + x] = MIX_PIXELS(upper, center, BILINEAR_FACTORS[f - 2][i]);
-				}
-				for (; i < f; ++i) { // second half of the new pixels, hope the compiler unrolls this
-					out[(y*f + i)*outw + x] = MIX_PIXELS(lower, center, BILINEAR_FACTORS[f - 2][f - 1 - i]);
-				}
-			}
-		}
+// takes the horizontally scaled rows around y, and writes the f output rows for it
+void bilinearV(int factor, const u32 *upper, const u32 *center, const u32 *lower, u32 *out, int outw) {
+	if (factor < 2 || factor > 5) {
+		ERROR_LOG(G3D, "Bilinear upsampling only implemented for factors 2 to 5");
+		return;
+	}
+	int i = 0;
+	for (; i < factor / 2 + factor % 2; ++i) { // first half of the new pixels + center
+		mixRow(upper, center, BILINEAR_FACTORS[factor - 2][i], out + i * outw, outw);
+	}
+	for (; i < factor; ++i) { // second half of the new pixels
+		mixRow(lower, center, BILINEAR_FACTORS[factor - 2][factor - 1 - i], out + i * outw, outw);
 	}
 }
-void bilinearV(int factor, const u32 *data, u32 *out, int w, int gl, int gu, int l, int u) {
-	switch (factor) {
-	case 2: bilinearVt<2>(data, out, w, gl, gu, l, u); break;
-	case 3: bilinearVt<3>(data, out, w, gl, gu, l, u); break;
-	case 4: bilinearVt<4>(data, out, w, gl, gu, l, u); break;
-	case 5: bilinearVt<5>(data, out, w, gl, gu, l, u); break;
-	default: ERROR_LOG(G3D, "Bilinear upsampling only implemented for factors 2 to 5");
+// vertical part for source rows [l, u) of an image with h rows, where rows holds the horizontally
+// scaled rows starting at rowsTop
+void bilinearVRows(int factor, const u32 *rows, int rowsTop, u32 *out, int outw, int h, int l, int u) {
+	for (int y = l; y < u; ++y) {
+		const u32 *upper = rows + (std::max(y - 1, 0) - rowsTop) * outw;
+		const u32 *center = rows + (y - rowsTop) * outw;
+		const u32 *lower = rows + (std::min(y + 1, h - 1) - rowsTop) * outw;
+		bilinearV(factor, upper, center, lower, out + (y - l) * factor * outw, outw);
 	}
 }
 
+//////////////////////////////////////////////////////////////////// Hybrid scaling
+
+struct HybridScratch {
+	std::vector<u32> mask;
+	std::vector<u32> sums;
+	std::vector<u32> box;
+	std::vector<u32> scaledRows;
+	std::vector<u32> scaledMask;
+	std::vector<u32> smooth;
+};
+
+// Runs all the steps of the hybrid scaler for source rows [l, u), so that each band's temporary
+// data stays in cache rather than going through full size buffers between steps.
+// Output goes straight to the matching rows of out.
+void scaleHybridRows(int factor, const u32 *data, u32 *out, int w, int h, bool bicubic, int l, int u, HybridScratch &s) {
+	const int outw = w * factor;
+	// Bilinear scaling needs a row above and below, and so does the box filter on the mask.
+	const int rowsTop = std::max(l - 1, 0);
+	const int rowsBottom = std::min(u + 1, h);
+	const int maskTop = std::max(l - 2, 0);
+	const int maskBottom = std::min(u + 2, h);
+
+	// 1) determine a feature mask C based on a sobel-ish filter + splatting, and upscale that mask bilinearly
+	s.mask.resize((maskBottom - maskTop) * w);
+	for (int y = maskTop; y < maskBottom; ++y) {
+		distanceMaskRow(data, &s.mask[(y - maskTop) * w], w, h, y);
+	}
+	auto maskRow = [&](int y) {
+		return &s.mask[(std::max(std::min(y, h - 1), 0) - maskTop) * w];
+	};
+
+	s.sums.resize(w);
+	s.box.resize(w);
+	s.scaledRows.resize((rowsBottom - rowsTop) * outw);
+	for (int y = rowsTop; y < rowsBottom; ++y) {
+		boxFilterRow(maskRow(y - 1), maskRow(y), maskRow(y + 1), s.sums.data(), s.box.data(), w);
+		bilinearH(factor, s.box.data(), &s.scaledRows[(y - rowsTop) * outw], w);
+	}
+	s.scaledMask.resize((u - l) * factor * outw);
+	bilinearVRows(factor, s.scaledRows.data(), rowsTop, s.scaledMask.data(), outw, h, l, u);
+
+	// 2) generate 2 scaled images: A - using Bilinear filtering, B - using xBRZ
+	s.smooth.resize((u - l) * factor * outw);
+	if (bicubic) {
+		scaleBicubicBSpline(factor, data, s.smooth.data(), w, h, l, u);
+	} else {
+		for (int y = rowsTop; y < rowsBottom; ++y) {
+			bilinearH(factor, data + y * w, &s.scaledRows[(y - rowsTop) * outw], w);
+		}
+		bilinearVRows(factor, s.scaledRows.data(), rowsTop, s.smooth.data(), outw, h, l, u);
+	}
+
+	xbrz::ScalerCfg cfg;
+	xbrz::scale(factor, data, out, w, h, xbrz::ColorFormat::ARGB, cfg, l, u);
+
+	// 3) output = A*C + B*(1-C)
+	u32 *outRows = out + l * factor * outw;
+	mixMaskedRow(s.smooth.data(), outRows, s.scaledMask.data(), outRows, (u - l) * factor * outw);
+}
+
 #undef BLOCK_SIZE
 #undef MIX_PIXELS
 #undef DISTANCE
@@ -635,10 +846,11 @@ bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, int &width, int &h
 	u32 *inputBuf = src;
 
 	// deposterize
+	std::vector<u32> deposterized;
 	if (g_Config.bTexDeposterize) {
-		bufDeposter.resize(width * height);
-		DePosterize(inputBuf, bufDeposter.data(), width, height);
-		inputBuf = bufDeposter.data();
+		deposterized.resize(width * height);
+		DePosterize(inputBuf, deposterized.data(), width, height);
+		inputBuf = deposterized.data();
 	}
 
 	// scale 
@@ -693,25 +905,22 @@ bool TextureScalerCommon::Scale(u32* &data, int &width, int &height, int factor)
 }
 
 const int MIN_LINES_PER_THREAD = 4;
+// Output pixels per band of the hybrid scaler, small enough for its temporary data to stay in L2.
+const int HYBRID_BAND_PIXELS = 64 * 1024;
+// xBRZ does some extra work at the start of each band, and the mask needs a couple of extra rows.
+const int MIN_HYBRID_BAND_LINES = 8;
 
 void TextureScalerCommon::ScaleXBRZ(int factor, u32* source, u32* dest, int width, int height) {
 	xbrz::ScalerCfg cfg;
-	ParallelRangeLoop(&g_threadManager, std::bind(&xbrz::scale, factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-}
-
-void TextureScalerCommon::ScaleBilinear(int factor, u32* source, u32* dest, int width, int height) {
-	bufTmp1.resize(width * height * factor);
-	u32 *tmpBuf = bufTmp1.data();
-	ParallelRangeLoop(&g_threadManager, std::bind(&bilinearH, factor, source, tmpBuf, width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager, std::bind(&bilinearV, factor, tmpBuf, dest, width, 0, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-}
-
-void TextureScalerCommon::ScaleBicubicBSpline(int factor, u32* source, u32* dest, int width, int height) {
-	ParallelRangeLoop(&g_threadManager,std::bind(&scaleBicubicBSpline, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager, [=](int l, int u) {
+		xbrz::scale(factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, l, u);
+	}, 0, height, MIN_LINES_PER_THREAD);
 }
 
 void TextureScalerCommon::ScaleBicubicMitchell(int factor, u32* source, u32* dest, int width, int height) {
-	ParallelRangeLoop(&g_threadManager,std::bind(&scaleBicubicMitchell, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager, [=](int l, int u) {
+		scaleBicubicMitchell(factor, source, dest + l * factor * width * factor, width, height, l, u);
+	}, 0, height, MIN_LINES_PER_THREAD);
 }
 
 void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int width, int height, bool bicubic) {
@@ -719,36 +928,22 @@ void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int wi
 	// 1) determine a feature mask C based on a sobel-ish filter + splatting, and upscale that mask bilinearly
 	// 2) generate 2 scaled images: A - using Bilinear filtering, B - using xBRZ
 	// 3) output = A*C + B*(1-C)
-
-	const static int KERNEL_SPLAT[3][3] = {
-			{ 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 }
-	};
-
-	bufTmp1.resize(width*height);
-	bufTmp2.resize(width*height*factor*factor);
-	bufTmp3.resize(width*height*factor*factor);
-
-	ParallelRangeLoop(&g_threadManager,std::bind(&generateDistanceMask, source, bufTmp1.data(), width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&convolve3x3, bufTmp1.data(), bufTmp2.data(), KERNEL_SPLAT, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ScaleBilinear(factor, bufTmp2.data(), bufTmp3.data(), width, height);
-	// mask C is now in bufTmp3
-
-	ScaleXBRZ(factor, source, bufTmp2.data(), width, height);
-	// xBRZ upscaled source is in bufTmp2
-
-	if (bicubic) ScaleBicubicBSpline(factor, source, dest, width, height);
-	else ScaleBilinear(factor, source, dest, width, height);
-	// Upscaled source is in dest
-
-	// Now we can mix it all together
-	// The factor 8192 was found through practical testing on a variety of textures
-	ParallelRangeLoop(&g_threadManager,std::bind(&mix, dest, bufTmp2.data(), bufTmp3.data(), 8192, width*factor, std::placeholders::_1, std::placeholders::_2), 0, height*factor, MIN_LINES_PER_THREAD);
+	// All of it is done a band of rows at a time, see scaleHybridRows().
+	const int bandLines = std::max(MIN_HYBRID_BAND_LINES, HYBRID_BAND_PIXELS / (width * factor * factor));
+	const int bands = (height + bandLines - 1) / bandLines;
+	ParallelRangeLoop(&g_threadManager, [=](int firstBand, int lastBand) {
+		HybridScratch scratch;
+		for (int band = firstBand; band < lastBand; ++band) {
+			const int l = band * bandLines;
+			scaleHybridRows(factor, source, dest, width, height, bicubic, l, std::min(l + bandLines, height), scratch);
+		}
+	}, 0, bands, 1);
 }
 
 void TextureScalerCommon::DePosterize(u32* source, u32* dest, int width, int height) {
-	bufTmp3.resize(width*height);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, source, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, dest, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	std::vector<u32> tmp(width * height);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, source, tmp.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, tmp.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, dest, tmp.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, tmp.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
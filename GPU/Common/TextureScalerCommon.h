@@ -25,6 +25,7 @@ static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
 // The texture scaler requires input to be in R8G8B8A8.
 // (It's OK if you flip R and B as they are not treated very differently from each other.
 // They will of course not unflip during the operation so be aware of that).
+// ScaleAlways() and ScaleInto() keep no state, so several textures can be scaled at once.
 class TextureScalerCommon {
 public:
 	TextureScalerCommon();
@@ -38,8 +39,6 @@ class TextureScalerCommon {
 
 protected:
 	void ScaleXBRZ(int factor, u32* source, u32* dest, int width, int height);
-	void ScaleBilinear(int factor, u32* source, u32* dest, int width, int height);
-	void ScaleBicubicBSpline(int factor, u32* source, u32* dest, int width, int height);
 	void ScaleBicubicMitchell(int factor, u32* source, u32* dest, int width, int height);
 	void ScaleHybrid(int factor, u32* source, u32* dest, int width, int height, bool bicubic = false);
 
@@ -47,8 +46,7 @@ class TextureScalerCommon {
 
 	bool IsEmptyOrFlat(const u32 *data, int pixels) const;
 
-	// depending on the factor and texture sizes, these can get pretty large 
-	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
-	// of course, scaling factor 5 is totally silly anyway
-	SimpleBuf<u32> bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+	// depending on the factor and texture sizes, this can get pretty large
+	// (25 MB for a 512 by 512 texture with scaling factor 5)
+	SimpleBuf<u32> bufOutput;
 };
@@ -19,6 +19,16 @@
 #include <cstdio>
 
 #include "ppsspp_config.h"
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
 
 #include "Common/CommonTypes.h"
 #include "Common/CPUDetect.h"
@@ -103,15 +113,93 @@ void DecVtxFormat::InitializeFromID(uint32_t id) {
 	stride = posoff + DecFmtSize(posfmt);
 }
 
+// Each of these handles a multiple of the vector size, returning how many indices were checked.
+static int GetIndexBounds8(const u8 *inds, int count, int *lowerBound, int *upperBound) {
+	const int vectorCount = count & ~15;
+	if (vectorCount == 0)
+		return 0;
+
+	alignas(16) u8 mins[16];
+	alignas(16) u8 maxs[16];
+#ifdef _M_SSE
+	__m128i minValues = _mm_set1_epi8((char)0xFF);
+	__m128i maxValues = _mm_setzero_si128();
+	for (int i = 0; i < vectorCount; i += 16) {
+		const __m128i values = _mm_loadu_si128((const __m128i *)(inds + i));
+		minValues = _mm_min_epu8(minValues, values);
+		maxValues = _mm_max_epu8(maxValues, values);
+	}
+	_mm_store_si128((__m128i *)mins, minValues);
+	_mm_store_si128((__m128i *)maxs, maxValues);
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint8x16_t minValues = vdupq_n_u8(0xFF);
+	uint8x16_t maxValues = vdupq_n_u8(0);
+	for (int i = 0; i < vectorCount; i += 16) {
+		const uint8x16_t values = vld1q_u8(inds + i);
+		minValues = vminq_u8(minValues, values);
+		maxValues = vmaxq_u8(maxValues, values);
+	}
+	vst1q_u8(mins, minValues);
+	vst1q_u8(maxs, maxValues);
+#else
+	return 0;
+#endif
+
+	for (int i = 0; i < 16; i++) {
+		*lowerBound = std::min(*lowerBound, (int)mins[i]);
+		*upperBound = std::max(*upperBound, (int)maxs[i]);
+	}
+	return vectorCount;
+}
+
+static int GetIndexBounds16(const u16_le *inds, int count, int *lowerBound, int *upperBound) {
+	const int vectorCount = count & ~7;
+	if (vectorCount == 0 || !COMMON_LITTLE_ENDIAN)
+		return 0;
+
+	alignas(16) u16 mins[8];
+	alignas(16) u16 maxs[8];
+#ifdef _M_SSE
+	// SSE2 only has signed 16-bit min/max, so flip the sign bit to keep the order.
+	const __m128i signBit = _mm_set1_epi16((short)0x8000);
+	__m128i minValues = _mm_set1_epi16(0x7FFF);
+	__m128i maxValues = _mm_set1_epi16((short)0x8000);
+	for (int i = 0; i < vectorCount; i += 8) {
+		const __m128i values = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(inds + i)), signBit);
+		minValues = _mm_min_epi16(minValues, values);
+		maxValues = _mm_max_epi16(maxValues, values);
+	}
+	_mm_store_si128((__m128i *)mins, _mm_xor_si128(minValues, signBit));
+	_mm_store_si128((__m128i *)maxs, _mm_xor_si128(maxValues, signBit));
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint16x8_t minValues = vdupq_n_u16(0xFFFF);
+	uint16x8_t maxValues = vdupq_n_u16(0);
+	for (int i = 0; i < vectorCount; i += 8) {
+		const uint16x8_t values = vld1q_u16((const u16 *)(inds + i));
+		minValues = vminq_u16(minValues, values);
+		maxValues = vmaxq_u16(maxValues, values);
+	}
+	vst1q_u16(mins, minValues);
+	vst1q_u16(maxs, maxValues);
+#else
+	return 0;
+#endif
+
+	for (int i = 0; i < 8; i++) {
+		*lowerBound = std::min(*lowerBound, (int)mins[i]);
+		*upperBound = std::max(*upperBound, (int)maxs[i]);
+	}
+	return vectorCount;
+}
+
 void GetIndexBounds(const void *inds, int count, u32 vertType, u16 *indexLowerBound, u16 *indexUpperBound) {
 	// Find index bounds. Could cache this in display lists.
-	// Also, this could be greatly sped up with SSE2/NEON, although rarely a bottleneck.
 	int lowerBound = 0x7FFFFFFF;
 	int upperBound = 0;
 	u32 idx = vertType & GE_VTYPE_IDX_MASK;
 	if (idx == GE_VTYPE_IDX_8BIT) {
 		const u8 *ind8 = (const u8 *)inds;
-		for (int i = 0; i < count; i++) {
+		for (int i = GetIndexBounds8(ind8, count, &lowerBound, &upperBound); i < count; i++) {
 			u8 value = ind8[i];
 			if (value > upperBound)
 				upperBound = value;
@@ -120,7 +208,7 @@ void GetIndexBounds(const void *inds, int count, u32 vertType, u16 *indexLowerBo
 		}
 	} else if (idx == GE_VTYPE_IDX_16BIT) {
 		const u16_le *ind16 = (const u16_le *)inds;
-		for (int i = 0; i < count; i++) {
+		for (int i = GetIndexBounds16(ind16, count, &lowerBound, &upperBound); i < count; i++) {
 			u16 value = ind16[i];
 			if (value > upperBound)
 				upperBound = value;
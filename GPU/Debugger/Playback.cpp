@@ -25,6 +25,7 @@
 #include "Common/Profiler/Profiler.h"
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -36,6 +37,7 @@
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/System.h"
+#include "GPU/GPU.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 #include "GPU/ge_constants.h"
@@ -51,6 +53,21 @@ static std::vector<Command> lastExecCommands;
 static std::vector<u8> lastExecPushbuf;
 static std::mutex executeLock;
 
+// Version 7+ dumps, one per frame. Pushbufs are put together from chunks right before running.
+struct ExecSegment {
+	std::vector<Command> commands;
+	std::vector<ChunkRef> chunks;
+	u32 bufSize;
+};
+static std::vector<ExecSegment> lastExecSegments;
+static std::vector<u8> lastExecChunkData;
+static std::vector<size_t> lastExecChunkOffsets;
+static std::vector<u32> lastExecChunkSizes;
+
+static int replayFirstFrame = 0;
+static int replayFrameCount = -1;
+static std::function<void(int, double)> replayFrameCallback;
+
 // This class maps pushbuffer (dump data) sections to PSP memory.
 // Dumps can be larger than available PSP memory, because they include generated data too.
 //
@@ -761,15 +778,112 @@ static bool ReadCompressed(u32 fp, void *dest, size_t sz, uint32_t version) {
 	return real_size == sz;
 }
 
+static bool ReadSegments(u32 fp) {
+	lastExecSegments.clear();
+	lastExecChunkData.clear();
+	lastExecChunkOffsets.clear();
+	lastExecChunkSizes.clear();
+
+	std::vector<u8> newData;
+	SegmentHeader header;
+	while (pspFileSystem.ReadFile(fp, (u8 *)&header, sizeof(header)) == sizeof(header)) {
+		ExecSegment segment;
+		segment.commands.resize(header.numCommands);
+		segment.chunks.resize(header.numChunks);
+		segment.bufSize = header.bufSize;
+		newData.resize(header.newDataSize);
+
+		if (!ReadCompressed(fp, segment.commands.data(), sizeof(Command) * header.numCommands, VERSION))
+			return false;
+		if (!ReadCompressed(fp, segment.chunks.data(), sizeof(ChunkRef) * header.numChunks, VERSION))
+			return false;
+		if (!ReadCompressed(fp, newData.data(), header.newDataSize, VERSION))
+			return false;
+
+		// Collect the new chunks, only the first use of each is stored in the file.
+		size_t newPos = 0;
+		u64 total = 0;
+		for (const ChunkRef &ref : segment.chunks) {
+			total += ref.sz;
+			if (ref.id == lastExecChunkOffsets.size()) {
+				if (newPos + ref.sz > newData.size())
+					return false;
+				lastExecChunkOffsets.push_back(lastExecChunkData.size());
+				lastExecChunkSizes.push_back(ref.sz);
+				lastExecChunkData.insert(lastExecChunkData.end(), newData.begin() + newPos, newData.begin() + newPos + ref.sz);
+				newPos += ref.sz;
+			} else if (ref.id > lastExecChunkOffsets.size()) {
+				return false;
+			} else if (ref.sz != lastExecChunkSizes[ref.id]) {
+				// A reused chunk must be the same size, or we'd copy past it.
+				return false;
+			}
+		}
+		if (total != header.bufSize)
+			return false;
+
+		lastExecSegments.push_back(std::move(segment));
+	}
+
+	return !lastExecSegments.empty();
+}
+
+static bool RunTimed(DumpExecute &executor, int frame) {
+	if (!replayFrameCallback)
+		return executor.Run();
+
+	// Each run ends with a list sync, so drawing has finished by the time it returns.
+	gpuStats.ResetFrame();
+	double st = time_now_d();
+	bool success = executor.Run();
+	replayFrameCallback(frame, time_now_d() - st);
+	return success;
+}
+
+static bool RunSegments(uint32_t version) {
+	int first = std::min(replayFirstFrame, (int)lastExecSegments.size() - 1);
+	int last = (int)lastExecSegments.size();
+	if (replayFrameCount >= 0)
+		last = std::min(last, first + replayFrameCount);
+
+	for (int i = first; i < last; ++i) {
+		const ExecSegment &segment = lastExecSegments[i];
+		lastExecPushbuf.resize(segment.bufSize);
+		u8 *dest = lastExecPushbuf.data();
+		for (const ChunkRef &ref : segment.chunks) {
+			memcpy(dest, lastExecChunkData.data() + lastExecChunkOffsets[ref.id], ref.sz);
+			dest += ref.sz;
+		}
+
+		DumpExecute executor(lastExecPushbuf, segment.commands, version);
+		if (!RunTimed(executor, i))
+			return false;
+	}
+	return true;
+}
+
 static void ReplayStop() {
 	// This can happen from a separate thread.
 	std::lock_guard<std::mutex> guard(executeLock);
 	lastExecFilename.clear();
 	lastExecCommands.clear();
 	lastExecPushbuf.clear();
+	lastExecSegments.clear();
+	lastExecChunkData.clear();
+	lastExecChunkOffsets.clear();
+	lastExecChunkSizes.clear();
 	lastExecVersion = 0;
 }
 
+void SetReplayFrameRange(int first, int count) {
+	replayFirstFrame = std::max(first, 0);
+	replayFrameCount = count;
+}
+
+void SetReplayFrameCallback(const std::function<void(int frame, double seconds)> &callback) {
+	replayFrameCallback = callback;
+}
+
 bool RunMountedReplay(const std::string &filename) {
 	_assert_msg_(!GPURecord::IsActivePending(), "Cannot run replay while recording.");
 
@@ -799,17 +913,21 @@ bool RunMountedReplay(const std::string &filename) {
 			g_paramSFO.SetValue("DISC_ID", std::string(header.gameID, gameIDLength), (int)sizeof(header.gameID));
 		}
 
-		u32 sz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
-		u32 bufsz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
-
-		lastExecCommands.resize(sz);
-		lastExecPushbuf.resize(bufsz);
-
 		bool truncated = false;
-		truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz, header.version);
-		truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz, header.version);
+		if (header.version >= 7) {
+			truncated = !ReadSegments(fp);
+		} else {
+			u32 sz = 0;
+			pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
+			u32 bufsz = 0;
+			pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
+
+			lastExecCommands.resize(sz);
+			lastExecPushbuf.resize(bufsz);
+
+			truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz, header.version);
+			truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz, header.version);
+		}
 
 		pspFileSystem.CloseFile(fp);
 
@@ -822,8 +940,11 @@ bool RunMountedReplay(const std::string &filename) {
 		lastExecVersion = version;
 	}
 
+	if (version >= 7)
+		return RunSegments(version);
+
 	DumpExecute executor(lastExecPushbuf, lastExecCommands, version);
-	return executor.Run();
+	return RunTimed(executor, 0);
 }
 
 };
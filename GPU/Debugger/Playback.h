@@ -17,10 +17,15 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace GPURecord {
 
 bool RunMountedReplay(const std::string &filename);
+// Only affects multi-frame dumps: replays frames [first, first + count), or all after first if count < 0.
+void SetReplayFrameRange(int first, int count);
+// Called after each replayed frame, with gpuStats covering only that frame.
+void SetReplayFrameCallback(const std::function<void(int frame, double seconds)> &callback);
 
 };
@@ -20,13 +20,18 @@
 #include <cstring>
 #include <functional>
 #include <set>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
 #include <zstd.h>
 
 #include "Common/CommonTypes.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
 #include "Common/System/System.h"
@@ -45,6 +50,7 @@
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/Debugger/Record.h"
 #include "GPU/Debugger/RecordFormat.h"
+#include "ext/xxhash.h"
 
 namespace GPURecord {
 
@@ -53,6 +59,7 @@ static bool nextFrame = false;
 static int flipLastAction = -1;
 static int flipFinishAt = -1;
 static uint32_t lastEdramTrans = 0x400;
+static int framesLeft = 0;
 static std::function<void(const Path &)> writeCallback;
 
 static std::vector<u8> pushbuf;
@@ -151,20 +158,192 @@ static void DirtyDrawnVRAM() {
 	DirtyVRAM(gstate.getFrameBufAddress(), bytes, DirtyVRAMFlag::DRAWN);
 }
 
-static void BeginRecording() {
-	active = true;
-	nextFrame = false;
+static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
+	size_t compressed_size = ZSTD_compressBound(sz);
+	u8 *compressed = new u8[compressed_size];
+	compressed_size = ZSTD_compress(compressed, compressed_size, p, sz, 6);
+
+	u32 write_size = (u32)compressed_size;
+	fwrite(&write_size, sizeof(write_size), 1, fp);
+	fwrite(compressed, compressed_size, 1, fp);
+
+	delete [] compressed;
+}
+
+// Writes segments out on a separate thread, after splitting them into chunks and deduping
+// those against all previous frames. Only chunk hashes are kept around, not the data.
+class RecordingWriter {
+public:
+	RecordingWriter(FILE *fp) : fp_(fp) {
+		thread_ = std::thread([this] { Run(); });
+	}
+
+	void Queue(std::vector<Command> &&commands, std::vector<u8> &&pushbuf) {
+		std::unique_lock<std::mutex> guard(lock_);
+		// Keep memory bounded if compression can't keep up, by stalling the recording.
+		while (queue_.size() >= MAX_QUEUED_SEGMENTS)
+			cond_.wait(guard);
+		queue_.push_back({ std::move(commands), std::move(pushbuf) });
+		cond_.notify_all();
+	}
+
+	// Writes out everything queued, and closes the file.
+	void Finish() {
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			done_ = true;
+			cond_.notify_all();
+		}
+		thread_.join();
+		fclose(fp_);
+	}
+
+private:
+	struct Segment {
+		std::vector<Command> commands;
+		std::vector<u8> pushbuf;
+	};
+
+	void Run() {
+		SetCurrentThreadName("GERecordWriter");
+
+		std::unique_lock<std::mutex> guard(lock_);
+		while (true) {
+			if (queue_.empty()) {
+				if (done_)
+					break;
+				cond_.wait(guard);
+				continue;
+			}
+
+			Segment segment = std::move(queue_.front());
+			queue_.pop_front();
+			cond_.notify_all();
+
+			guard.unlock();
+			WriteSegment(segment);
+			guard.lock();
+		}
+	}
+
+	void WriteSegment(const Segment &segment) {
+		std::vector<ChunkRef> refs;
+		std::vector<u8> newData;
+
+		auto addChunk = [&](u32 start, u32 end) {
+			const u8 *p = segment.pushbuf.data() + start;
+			u32 sz = end - start;
+			u64 hash = XXH3_64bits(p, sz);
+			auto it = knownChunks_.find(hash);
+			if (it != knownChunks_.end() && it->second.sz == sz) {
+				refs.push_back(it->second);
+				return;
+			}
+
+			ChunkRef ref{ nextChunkID_++, sz };
+			if (knownChunks_.size() < MAX_KNOWN_CHUNKS)
+				knownChunks_[hash] = ref;
+			refs.push_back(ref);
+			newData.insert(newData.end(), p, p + sz);
+		};
+
+		// Large data like textures and vertices always starts a new chunk, so it matches
+		// regardless of whatever was emitted before it.
+		std::vector<u32> cuts;
+		for (const Command &cmd : segment.commands) {
+			if (cmd.sz >= CHUNK_MIN_SIZE)
+				cuts.push_back(cmd.ptr);
+		}
+		cuts.push_back((u32)segment.pushbuf.size());
+		std::sort(cuts.begin(), cuts.end());
+
+		u32 pos = 0;
+		for (u32 cut : cuts) {
+			while (pos < cut) {
+				u32 end = FindChunkEnd(segment.pushbuf.data(), pos, cut);
+				addChunk(pos, end);
+				pos = end;
+			}
+		}
+
+		SegmentHeader header{};
+		header.frame = frame_++;
+		header.numCommands = (u32)segment.commands.size();
+		header.numChunks = (u32)refs.size();
+		header.bufSize = (u32)segment.pushbuf.size();
+		header.newDataSize = (u32)newData.size();
+		fwrite(&header, sizeof(header), 1, fp_);
+
+		WriteCompressed(fp_, segment.commands.data(), segment.commands.size() * sizeof(Command));
+		WriteCompressed(fp_, refs.data(), refs.size() * sizeof(ChunkRef));
+		WriteCompressed(fp_, newData.data(), newData.size());
+	}
+
+	// Content defined chunking using a gear hash, so that data which moves around between
+	// frames still splits into the same chunks.
+	static u32 FindChunkEnd(const u8 *data, u32 start, u32 end) {
+		if (end - start <= CHUNK_MIN_SIZE)
+			return end;
+
+		const u32 last = std::min(end, start + CHUNK_MAX_SIZE);
+		const u64 *gear = ChunkGear();
+		u64 hash = 0;
+		for (u32 i = start + CHUNK_MIN_SIZE; i < last; ++i) {
+			hash = (hash << 1) + gear[data[i]];
+			// The top bits depend on the last 64 bytes, this gives about 8 KB chunks on average.
+			if ((hash >> 51) == 0)
+				return i + 1;
+		}
+		return last;
+	}
+
+	static const u64 *ChunkGear() {
+		static u64 gear[256];
+		static std::once_flag once;
+		std::call_once(once, [] {
+			// splitmix64, any fixed random values will do.
+			u64 x = 0x5050535050474555ULL;
+			for (int i = 0; i < 256; ++i) {
+				u64 z = (x += 0x9E3779B97F4A7C15ULL);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				gear[i] = z ^ (z >> 31);
+			}
+		});
+		return gear;
+	}
+
+	static constexpr u32 CHUNK_MIN_SIZE = 2048;
+	static constexpr u32 CHUNK_MAX_SIZE = 65536;
+	static constexpr size_t MAX_QUEUED_SEGMENTS = 3;
+	static constexpr size_t MAX_KNOWN_CHUNKS = 1024 * 1024;
+
+	FILE *fp_;
+	std::thread thread_;
+	std::mutex lock_;
+	std::condition_variable cond_;
+	std::deque<Segment> queue_;
+	bool done_ = false;
+
+	std::unordered_map<u64, ChunkRef> knownChunks_;
+	u32 nextChunkID_ = 0;
+	u32 frame_ = 0;
+};
+
+static RecordingWriter *writer;
+static Path writerFilename;
+
+static void BeginSegment() {
 	lastTextures.clear();
 	lastRenderTargets.clear();
-	flipLastAction = gpuStats.numFlips;
-	flipFinishAt = -1;
+	// The segment might be played back on its own, so start it from scratch.
+	lastEdramTrans = 0x400;
 
 	u32 ptr = (u32)pushbuf.size();
 	u32 sz = 512 * 4;
 	pushbuf.resize(pushbuf.size() + sz);
 	gstate.Save((u32_le *)(pushbuf.data() + ptr));
 	commands.push_back({CommandType::INIT, sz, ptr});
-	lastVRAM.resize(2 * 1024 * 1024);
 
 	// Also save the initial CLUT.
 	GPUDebugBuffer clut;
@@ -180,43 +359,39 @@ static void BeginRecording() {
 	DirtyAllVRAM(DirtyVRAMFlag::DIRTY);
 }
 
-static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
-	size_t compressed_size = ZSTD_compressBound(sz);
-	u8 *compressed = new u8[compressed_size];
-	compressed_size = ZSTD_compress(compressed, compressed_size, p, sz, 6);
-
-	u32 write_size = (u32)compressed_size;
-	fwrite(&write_size, sizeof(write_size), 1, fp);
-	fwrite(compressed, compressed_size, 1, fp);
+static void EndSegment() {
+	FlushRegisters();
 
-	delete [] compressed;
+	writer->Queue(std::move(commands), std::move(pushbuf));
+	commands.clear();
+	pushbuf.clear();
 }
 
-static Path WriteRecording() {
-	FlushRegisters();
-
-	const Path filename = GenRecordingFilename();
+static void BeginRecording() {
+	writerFilename = GenRecordingFilename();
+	NOTICE_LOG(G3D, "Recording filename: %s", writerFilename.c_str());
 
-	NOTICE_LOG(G3D, "Recording filename: %s", filename.c_str());
+	FILE *fp = File::OpenCFile(writerFilename, "wb");
+	if (!fp) {
+		ERROR_LOG(G3D, "Unable to create recording file");
+		nextFrame = false;
+		return;
+	}
 
-	FILE *fp = File::OpenCFile(filename, "wb");
 	Header header{};
 	strncpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
 	header.version = VERSION;
 	strncpy(header.gameID, g_paramSFO.GetDiscID().c_str(), sizeof(header.gameID));
 	fwrite(&header, sizeof(header), 1, fp);
+	writer = new RecordingWriter(fp);
 
-	u32 sz = (u32)commands.size();
-	fwrite(&sz, sizeof(sz), 1, fp);
-	u32 bufsz = (u32)pushbuf.size();
-	fwrite(&bufsz, sizeof(bufsz), 1, fp);
-
-	WriteCompressed(fp, commands.data(), commands.size() * sizeof(Command));
-	WriteCompressed(fp, pushbuf.data(), bufsz);
-
-	fclose(fp);
+	active = true;
+	nextFrame = false;
+	flipLastAction = gpuStats.numFlips;
+	flipFinishAt = -1;
+	lastVRAM.resize(2 * 1024 * 1024);
 
-	return filename;
+	BeginSegment();
 }
 
 static void GetVertDataSizes(int vcount, const void *indices, u32 &vbytes, u32 &ibytes) {
@@ -593,6 +768,15 @@ static void EmitBezierSpline(u32 op) {
 	DirtyDrawnVRAM();
 }
 
+static void EmitDisplay(const void *disp, u32 sz) {
+	FlushRegisters();
+	u32 ptr = (u32)pushbuf.size();
+	pushbuf.resize(pushbuf.size() + sz);
+	memcpy(pushbuf.data() + ptr, disp, sz);
+
+	commands.push_back({ CommandType::DISPLAY, sz, ptr });
+}
+
 bool IsActive() {
 	return active;
 }
@@ -601,9 +785,10 @@ bool IsActivePending() {
 	return nextFrame || active;
 }
 
-bool Activate() {
+bool Activate(int frames) {
 	if (!nextFrame) {
 		nextFrame = true;
+		framesLeft = std::max(frames, 1);
 		flipLastAction = gpuStats.numFlips;
 		flipFinishAt = -1;
 		return true;
@@ -617,9 +802,11 @@ void SetCallback(const std::function<void(const Path &)> callback) {
 
 static void FinishRecording() {
 	// We're done - this was just to write the result out.
-	Path filename = WriteRecording();
-	commands.clear();
-	pushbuf.clear();
+	EndSegment();
+	writer->Finish();
+	delete writer;
+	writer = nullptr;
+	Path filename = writerFilename;
 	lastVRAM.clear();
 
 	NOTICE_LOG(SYSTEM, "Recording finished");
@@ -633,6 +820,15 @@ static void FinishRecording() {
 	writeCallback = nullptr;
 }
 
+void Shutdown() {
+	// Stopping mid-recording, so write out what we have and let the writer thread exit.
+	if (active)
+		FinishRecording();
+	nextFrame = false;
+	framesLeft = 0;
+	writeCallback = nullptr;
+}
+
 static void CheckEdramTrans() {
 	if (!gpuDebug)
 		return;
@@ -795,16 +991,13 @@ void NotifyDisplay(u32 framebuf, int stride, int fmt) {
 	};
 
 	DisplayBufData disp{ { framebuf }, stride, fmt };
+	EmitDisplay(&disp, sizeof(disp));
 
-	FlushRegisters();
-	u32 ptr = (u32)pushbuf.size();
-	u32 sz = (u32)sizeof(disp);
-	pushbuf.resize(pushbuf.size() + sz);
-	memcpy(pushbuf.data() + ptr, &disp, sz);
-
-	commands.push_back({ CommandType::DISPLAY, sz, ptr });
-
-	if (writePending) {
+	if (writePending && --framesLeft > 0) {
+		EndSegment();
+		BeginSegment();
+		EmitDisplay(&disp, sizeof(disp));
+	} else if (writePending) {
 		NOTICE_LOG(SYSTEM, "Recording complete on display");
 		FinishRecording();
 	}
@@ -824,16 +1017,16 @@ void NotifyBeginFrame() {
 
 		DisplayBufData disp;
 		__DisplayGetFramebuf(&disp.topaddr, &disp.linesize, &disp.pixelFormat, 0);
+		EmitDisplay(&disp, sizeof(disp));
 
-		FlushRegisters();
-		u32 ptr = (u32)pushbuf.size();
-		u32 sz = (u32)sizeof(disp);
-		pushbuf.resize(pushbuf.size() + sz);
-		memcpy(pushbuf.data() + ptr, &disp, sz);
-
-		commands.push_back({ CommandType::DISPLAY, sz, ptr });
-
-		FinishRecording();
+		if (--framesLeft > 0) {
+			EndSegment();
+			BeginSegment();
+			if (flipFinishAt != -1)
+				flipFinishAt = gpuStats.numFlips + 1;
+		} else {
+			FinishRecording();
+		}
 	}
 	if (!active && nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0 && noDisplayAction) {
 		NOTICE_LOG(SYSTEM, "Recording starting on frame...");
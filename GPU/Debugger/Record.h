@@ -27,9 +27,12 @@ namespace GPURecord {
 
 bool IsActive();
 bool IsActivePending();
-bool Activate();
+// Records the given number of frames, starting on the next one.
+bool Activate(int frames = 1);
 // Call only if Activate() returns true.
 void SetCallback(const std::function<void(const Path &)> callback);
+// Finishes any recording in progress, call before the GPU goes away.
+void Shutdown();
 
 void NotifyCommand(u32 pc);
 void NotifyMemcpy(u32 dest, u32 src, u32 sz);
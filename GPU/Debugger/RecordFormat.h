@@ -35,7 +35,8 @@ static const char *HEADER_MAGIC = "PPSSPPGE";
 // Version 4: Expanded header with game ID
 // Version 5: Uses zstd
 // Version 6: Corrects dirty VRAM flag
-static const int VERSION = 6;
+// Version 7: Streamed as per-frame segments, with data deduplicated across frames
+static const int VERSION = 7;
 static const int MIN_VERSION = 2;
 
 enum class CommandType : u8 {
@@ -79,6 +80,24 @@ struct Command {
 	u32 ptr;
 };
 
+// From version 7, the header is followed by segments until the end of the file, one per frame.
+// Each is a SegmentHeader, then separately compressed commands, chunk refs, and new chunk data.
+// The referenced chunks concatenated make up that segment's pushbuf, which commands point into.
+// Chunk ids count up from 0 across the whole file, so a ref to the next unused id is new data.
+// Every segment starts with an INIT command, so playback can start at any of them.
+struct SegmentHeader {
+	u32 frame;
+	u32 numCommands;
+	u32 numChunks;
+	u32 bufSize;
+	u32 newDataSize;
+};
+
+struct ChunkRef {
+	u32 id;
+	u32 sz;
+};
+
 #pragma pack(pop)
 
 };
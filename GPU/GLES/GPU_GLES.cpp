@@ -37,6 +37,7 @@
 #include "GPU/ge_constants.h"
 #include "GPU/GeDisasm.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Common/ShaderIdList.h"
 #include "GPU/GLES/ShaderManagerGLES.h"
 #include "GPU/GLES/GPU_GLES.h"
 #include "GPU/GLES/FramebufferManagerGLES.h"
@@ -97,6 +98,7 @@ GPU_GLES::GPU_GLES(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 		if (g_Config.bShaderCache) {
 			File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 			shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".glshadercache");
+			shaderIdListPath_ = ShaderIdListPath(discID);
 			// Actually precompiled by IsReady() since we're single-threaded.
 			File::IOFile f(shaderCachePath_, "rb");
 			if (f.IsOpen()) {
@@ -111,6 +113,12 @@ GPU_GLES::GPU_GLES(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 					if (shaderManagerGL_->LoadCache(f))
 						NOTICE_LOG(G3D, "Precompiling the shader cache from '%s'", shaderCachePath_.c_str());
 				}
+			} else {
+				// No cache of our own yet, but we may still know which shaders the game uses.
+				ShaderIdList list;
+				if (list.Load(shaderIdListPath_) && shaderManagerGL_->LoadShaders(list)) {
+					NOTICE_LOG(G3D, "Precompiling shaders from '%s'", shaderIdListPath_.c_str());
+				}
 			}
 		} else {
 			INFO_LOG(G3D, "Shader cache disabled. Not loading.");
@@ -139,6 +147,10 @@ GPU_GLES::~GPU_GLES() {
 	if (shaderCachePath_.Valid() && draw_) {
 		if (g_Config.bShaderCache) {
 			shaderManagerGL_->SaveCache(shaderCachePath_, &drawEngine_);
+
+			ShaderIdList list;
+			shaderManagerGL_->GetShaderIdList(&list);
+			list.Save(shaderIdListPath_);
 		} else {
 			INFO_LOG(G3D, "Shader cache disabled. Not saving.");
 		}
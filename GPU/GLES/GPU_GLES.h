@@ -80,4 +80,5 @@ class GPU_GLES : public GPUCommon {
 	ShaderManagerGLES *shaderManagerGL_;
 
 	Path shaderCachePath_;
+	Path shaderIdListPath_;
 };
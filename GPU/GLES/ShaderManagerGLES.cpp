@@ -46,6 +46,7 @@
 #include "GPU/Math3D.h"
 #include "GPU/GPUState.h"
 #include "GPU/ge_constants.h"
+#include "GPU/Common/ShaderIdList.h"
 #include "GPU/Common/ShaderUniforms.h"
 #include "GPU/GLES/ShaderManagerGLES.h"
 #include "GPU/GLES/DrawEngineGLES.h"
@@ -1072,6 +1073,11 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 			}
 
 			Shader *vs = CompileVertexShader(id);
+			if (!vs) {
+				// Lists from other devices can have shaders we can't generate here, just skip those.
+				WARN_LOG(G3D, "Failed to generate a vertex shader loading from cache, skipping it.");
+				continue;
+			}
 			if (vs->Failed()) {
 				// Give up on using the cache, just bail. We can't safely create the fallback shaders here
 				// without trying to deduce the vertType from the VSID.
@@ -1094,7 +1100,12 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 
 		const FShaderID &id = pending.frag[i];
 		if (!fsCache_.Get(id)) {
-			fsCache_.Insert(id, CompileFragmentShader(id));
+			Shader *fs = CompileFragmentShader(id);
+			if (!fs) {
+				WARN_LOG(G3D, "Failed to generate a fragment shader loading from cache, skipping it.");
+				continue;
+			}
+			fsCache_.Insert(id, fs);
 		} else {
 			WARN_LOG(G3D, "Duplicate fragment shader found in GL shader cache, ignoring");
 		}
@@ -1130,6 +1141,31 @@ void ShaderManagerGLES::CancelPrecompile() {
 	diskCachePending_.Clear();
 }
 
+bool ShaderManagerGLES::LoadShaders(const ShaderIdList &list) {
+	// Like the cache, the IDs mean different shaders with other flags.
+	if (list.useFlags != gstate_c.GetUseFlags()) {
+		WARN_LOG(G3D, "Shader ID list useFlags mismatch, %08x, expected %08x", list.useFlags, gstate_c.GetUseFlags());
+		return false;
+	}
+
+	diskCachePending_.Clear();
+	diskCachePending_.start = time_now_d();
+	// There are no geometry shaders here, and programs will be linked as they're used.
+	diskCachePending_.vert = list.vert;
+	diskCachePending_.frag = list.frag;
+	return true;
+}
+
+void ShaderManagerGLES::GetShaderIdList(ShaderIdList *list) {
+	list->useFlags = gstate_c.GetUseFlags();
+	vsCache_.Iterate([&](const VShaderID &id, Shader *shader) {
+		list->vert.push_back(id);
+	});
+	fsCache_.Iterate([&](const FShaderID &id, Shader *shader) {
+		list->frag.push_back(id);
+	});
+}
+
 void ShaderManagerGLES::SaveCache(const Path &filename, DrawEngineGLES *drawEngine) {
 	if (!diskCacheDirty_) {
 		return;
@@ -160,6 +160,8 @@ class Shader {
 	uint64_t uniformMask_;
 };
 
+struct ShaderIdList;
+
 class ShaderManagerGLES : public ShaderManagerCommon {
 public:
 	ShaderManagerGLES(Draw::DrawContext *draw);
@@ -191,6 +193,11 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 	void CancelPrecompile();
 	void SaveCache(const Path &filename, DrawEngineGLES *drawEngine);
 
+	// Queues the listed shaders for ContinuePrecompile(), without linking them into programs.
+	// Returns false if the list was made with different useFlags.
+	bool LoadShaders(const ShaderIdList &list);
+	void GetShaderIdList(ShaderIdList *list);
+
 private:
 	void Clear();
 	Shader *CompileFragmentShader(FShaderID id);
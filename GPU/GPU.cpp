@@ -23,6 +23,7 @@
 
 #include "GPU/GPU.h"
 #include "GPU/GPUInterface.h"
+#include "GPU/Debugger/Record.h"
 
 #if PPSSPP_API(ANY_GL)
 #include "GPU/GLES/GPU_GLES.h"
@@ -125,6 +126,8 @@ bool GPU_Init(GraphicsContext *ctx, Draw::DrawContext *draw) {
 void GPU_Shutdown() {
 	// Reduce the risk for weird races with the Windows GE debugger.
 	gpuDebug = nullptr;
+	// Joins the recording writer thread, if we're shutting down mid-recording.
+	GPURecord::Shutdown();
 
 	// Wait for IsReady, since it might be running on a thread.
 	if (gpu) {
@@ -79,7 +79,10 @@ struct GPUStatistics {
 		numCachedVertsDrawn = 0;
 		numUncachedVertsDrawn = 0;
 		numTrackedVertexArrays = 0;
+		numVertexDecodes = 0;
+		numMergedDrawCalls = 0;
 		numTextureInvalidations = 0;
+		numTextureInvalidationChecks = 0;
 		numTextureInvalidationsByFramebuffer = 0;
 		numTexturesHashed = 0;
 		numTextureSwitches = 0;
@@ -87,6 +90,8 @@ struct GPUStatistics {
 		numShaderSwitches = 0;
 		numFlushes = 0;
 		numTexturesDecoded = 0;
+		numTextureDataBytesDecoded = 0;
+		numPixelsShaded = 0;
 		numFramebufferEvaluations = 0;
 		numReadbacks = 0;
 		numUploads = 0;
@@ -98,6 +103,7 @@ struct GPUStatistics {
 		numCopiesForShaderBlend = 0;
 		numCopiesForSelfTex = 0;
 		msProcessingDisplayLists = 0;
+		msDrawingTiles = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 	}
@@ -110,13 +116,19 @@ struct GPUStatistics {
 	int numCachedVertsDrawn;
 	int numUncachedVertsDrawn;
 	int numTrackedVertexArrays;
+	int numVertexDecodes;
+	// Draw calls decoded together with an earlier one, rather than separately.
+	int numMergedDrawCalls;
 	int numTextureInvalidations;
+	int numTextureInvalidationChecks;
 	int numTextureInvalidationsByFramebuffer;
 	int numTexturesHashed;
 	int numTextureDataBytesHashed;
 	int numTextureSwitches;
 	int numShaderSwitches;
 	int numTexturesDecoded;
+	int numTextureDataBytesDecoded;
+	int64_t numPixelsShaded;
 	int numFramebufferEvaluations;
 	int numReadbacks;
 	int numUploads;
@@ -128,6 +140,8 @@ struct GPUStatistics {
 	int numCopiesForShaderBlend;
 	int numCopiesForSelfTex;
 	double msProcessingDisplayLists;
+	// Summed across all software renderer threads, so can exceed the frame time.
+	double msDrawingTiles;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 
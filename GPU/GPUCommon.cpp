@@ -3460,13 +3460,14 @@ void GPUCommon::UpdateUVScaleOffset() {
 
 size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 	float vertexAverageCycles = gpuStats.numVertsSubmitted > 0 ? (float)gpuStats.vertexGPUCycles / (float)gpuStats.numVertsSubmitted : 0.0f;
-	return snprintf(buffer, size,
+	size_t len = snprintf(buffer, size,
 		"DL processing time: %0.2f ms\n"
 		"Draw calls: %d, flushes %d, clears %d (cached: %d)\n"
 		"Num Tracked Vertex Arrays: %d\n"
+		"Vertex decodes: %d (merged draws: %d)\n"
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
-		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
+		"Textures: %d, dec: %d, invalidated: %d (checked %d), hashed: %d kB\n"
 		"readbacks %d, uploads %d, depal %d\n"
 		"Copies: depth %d, color %d, reint %d, blend %d, selftex %d\n"
 		"GPU cycles executed: %d (%f per vertex)\n",
@@ -3476,6 +3477,8 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numClears,
 		gpuStats.numCachedDrawCalls,
 		gpuStats.numTrackedVertexArrays,
+		gpuStats.numVertexDecodes,
+		gpuStats.numMergedDrawCalls,
 		gpuStats.numVertsSubmitted,
 		gpuStats.numCachedVertsDrawn,
 		gpuStats.numUncachedVertsDrawn,
@@ -3484,6 +3487,7 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		(int)textureCache_->NumLoadedTextures(),
 		gpuStats.numTexturesDecoded,
 		gpuStats.numTextureInvalidations,
+		gpuStats.numTextureInvalidationChecks,
 		gpuStats.numTextureDataBytesHashed / 1024,
 		gpuStats.numReadbacks,
 		gpuStats.numUploads,
@@ -3496,6 +3500,17 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.vertexGPUCycles + gpuStats.otherGPUCycles,
 		vertexAverageCycles
 	);
+
+	// Only software transform uses this, hardware transform has its own vertex cache.
+	if (g_Config.bVertexCache && !g_Config.bHardwareTransform && len + 1 < size) {
+		drawEngineCommon_->GetDecodedVertexCache().GetStats(buffer + len, size - len);
+		len += strlen(buffer + len);
+		if (len + 1 < size) {
+			buffer[len++] = '\n';
+			buffer[len] = '\0';
+		}
+	}
+	return len;
 }
 
 u32 GPUCommon::CheckGPUFeatures() const {
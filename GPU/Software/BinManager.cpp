@@ -17,10 +17,12 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstring>
 #include <mutex>
 #include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Common/TimeUtil.h"
+#include "Core/Config.h"
 #include "Core/System.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Software/BinManager.h"
@@ -67,38 +69,56 @@ struct BinWaitable : public Waitable {
 	std::condition_variable cond_;
 };
 
-static inline void DrawBinItem(const BinItem &item, const RasterizerState &state) {
+static inline void DrawBinItem(const BinItem &item, const BinCoords &range, const RasterizerState &state) {
 	switch (item.type) {
 	case BinItemType::TRIANGLE:
-		DrawTriangle(item.v0, item.v1, item.v2, item.range, state);
+		DrawTriangle(item.v0, item.v1, item.v2, range, state);
 		break;
 
 	case BinItemType::CLEAR_RECT:
-		ClearRectangle(item.v0, item.v1, item.range, state);
+		ClearRectangle(item.v0, item.v1, range, state);
 		break;
 
 	case BinItemType::RECT:
-		DrawRectangle(item.v0, item.v1, item.range, state);
+		DrawRectangle(item.v0, item.v1, range, state);
 		break;
 
 	case BinItemType::SPRITE:
-		DrawSprite(item.v0, item.v1, item.range, state);
+		DrawSprite(item.v0, item.v1, range, state);
 		break;
 
 	case BinItemType::LINE:
-		DrawLine(item.v0, item.v1, item.range, state);
+		DrawLine(item.v0, item.v1, range, state);
 		break;
 
 	case BinItemType::POINT:
-		DrawPoint(item.v0, item.range, state);
+		DrawPoint(item.v0, range, state);
 		break;
 	}
+
+	// Clears fill the bounds exactly themselves.
+	if (state.pixelID.depthWrite && item.type != BinItemType::CLEAR_RECT && state.depthBounds && state.depthBounds->Enabled()) {
+		int zmin = item.v0.screenpos.z;
+		int zmax = item.v0.screenpos.z;
+		if (item.type != BinItemType::POINT) {
+			zmin = std::min(zmin, (int)item.v1.screenpos.z);
+			zmax = std::max(zmax, (int)item.v1.screenpos.z);
+		}
+		if (item.type == BinItemType::TRIANGLE) {
+			zmin = std::min(zmin, (int)item.v2.screenpos.z);
+			zmax = std::max(zmax, (int)item.v2.screenpos.z);
+		}
+		// Interpolation may round slightly past the vertices.
+		const DrawingCoords tl = TransformUnit::ScreenToDrawing(range.x1, range.y1);
+		const DrawingCoords br = TransformUnit::ScreenToDrawing(range.x2, range.y2);
+		state.depthBounds->Expand(tl.x, tl.y, br.x, br.y, zmin - 1, zmax + 1);
+	}
 }
 
 class DrawBinItemsTask : public Task {
 public:
-	DrawBinItemsTask(BinWaitable *notify, BinManager::BinItemQueue &items, std::atomic<bool> &status, const BinManager::BinStateQueue &states)
-		: notify_(notify), items_(items), status_(status), states_(states) {
+	DrawBinItemsTask(BinWaitable *notify, BinManager &binner, std::atomic<bool> &status)
+		: notify_(notify), binner_(binner), status_(status) {
 	}
 
 	TaskType Type() const override {
@@ -106,10 +126,13 @@ class DrawBinItemsTask : public Task {
 	}
 
 	void Run() override {
-		ProcessItems();
-		status_ = false;
-		// In case of any atomic issues, do another pass.
-		ProcessItems();
+		bool expected;
+		do {
+			ProcessTiles();
+			status_ = false;
+			// In case a tile was queued after we last looked, check again.
+			expected = false;
+		} while (binner_.readyHead_ != binner_.readyTail_ && status_.compare_exchange_strong(expected, true));
 		notify_->Drain();
 	}
 
@@ -117,23 +140,59 @@ class DrawBinItemsTask : public Task {
 		// Don't delete, this is statically allocated.
 	}
 
+	// Only call when nothing is drawing, adds and clears the times collected since last time.
+	void TakeTileTimes(double *tileTimes) {
+		for (const auto &it : tileTimes_)
+			tileTimes[it.first] += it.second;
+		tileTimes_.clear();
+	}
+
 private:
-	void ProcessItems() {
-		while (!items_.Empty()) {
-			const BinItem &item = items_.PeekNext();
-			DrawBinItem(item, states_[item.stateIndex]);
-			items_.SkipNext();
+	void ProcessTiles() {
+		int tile;
+		while ((tile = binner_.PopTile()) >= 0) {
+			if (coreCollectDebugStats) {
+				double st = time_now_d();
+				ProcessTile(tile);
+				tileTimes_.emplace_back((uint16_t)tile, time_now_d() - st);
+			} else {
+				ProcessTile(tile);
+			}
 		}
 	}
 
+	void ProcessTile(int tile) {
+		BinManager::BinTileQueue &items = binner_.tileQueues_[tile];
+		std::atomic<bool> &status = binner_.tileStatus_[tile];
+		const BinCoords tileRange = BinManager::TileRange(tile);
+
+		bool expected;
+		do {
+			while (!items.Empty()) {
+				const BinItem &item = binner_.queue_[items.PeekNext()];
+				DrawBinItem(item, tileRange.Intersect(item.range), binner_.states_[item.stateIndex]);
+				items.SkipNext();
+			}
+			status = false;
+			// If more was added before we cleared the flag, it wasn't queued again.
+			expected = false;
+		} while (!items.Empty() && status.compare_exchange_strong(expected, true));
+	}
+
 	BinWaitable *notify_;
-	BinManager::BinItemQueue &items_;
+	BinManager &binner_;
 	std::atomic<bool> &status_;
-	const BinManager::BinStateQueue &states_;
+	// Kept per task, since several tasks may draw the same tile during a frame.
+	std::vector<std::pair<uint16_t, double>> tileTimes_;
 };
 
 constexpr int BinManager::MAX_POSSIBLE_TASKS;
 
+int BinManager::MaxDrawTasks() {
+	// The thread manager may have more threads than we have task lists for.
+	return std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
+}
+
 BinManager::BinManager() {
 	queueRange_.x1 = 0x7FFFFFFF;
 	queueRange_.y1 = 0x7FFFFFFF;
@@ -143,12 +202,15 @@ BinManager::BinManager() {
 	waitable_ = new BinWaitable();
 	for (auto &s : taskStatus_)
 		s = false;
+	for (auto &s : tileStatus_)
+		s = false;
+	readyHead_ = 0;
+	readyTail_ = 0;
 
-	int maxInitTasks = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
+	int maxInitTasks = MaxDrawTasks();
 	for (int i = 0; i < maxInitTasks; ++i) {
-		taskQueues_[i].Setup();
 		for (DrawBinItemsTask *&task : taskLists_[i].tasks)
-			task = new DrawBinItemsTask(waitable_, taskQueues_[i], taskStatus_[i], states_);
+			task = new DrawBinItemsTask(waitable_, *this, taskStatus_[i]);
 	}
 	states_.Setup();
 	cluts_.Setup();
@@ -166,6 +228,14 @@ BinManager::~BinManager() {
 
 void BinManager::UpdateState() {
 	PROFILE_THIS_SCOPE("bin_state");
+	// If the depth buffer can't be tracked anymore, stop before anything else is drawn to it.
+	if (depthBounds_.Enabled() && HasDirty(SoftDirty::BINNER_RANGE) && !DepthBoundsUsable())
+		Flush("depthbounds");
+	// Cached textures are a snapshot, so look again if we might render to them, or on a new frame.
+	if (State().textureCached && (HasDirty(SoftDirty::BINNER_RANGE) || lastFlipstats_ != gpuStats.numFlips))
+		SetDirty(SoftDirty::SAMPLER_TEXLIST);
+
+	bool newState = false;
 	if (HasDirty(SoftDirty::PIXEL_ALL | SoftDirty::SAMPLER_ALL | SoftDirty::RAST_ALL)) {
 		if (states_.Full())
 			Flush("states");
@@ -174,7 +244,9 @@ void BinManager::UpdateState() {
 		// When new funcs are compiled, we need to flush if WX exclusive.
 		ComputeRasterizerState(&states_[stateIndex_], this);
 		states_[stateIndex_].samplerID.cached.clut = cluts_[clutIndex_].readable;
+		states_[stateIndex_].depthBounds = &depthBounds_;
 		creatingState_ = false;
+		newState = true;
 
 		ClearDirty(SoftDirty::PIXEL_ALL | SoftDirty::SAMPLER_ALL | SoftDirty::RAST_ALL);
 	}
@@ -215,15 +287,30 @@ void BinManager::UpdateState() {
 		}
 	}
 
+	if (newState && g_Config.bSoftwareTextureCache) {
+		// Only now are the pending writes complete, and we can't snapshot anything still being drawn.
+		if (state.enableTextures && !HasTextureWrite(state)) {
+			creatingState_ = true;
+			texCache_.Apply(&states_[stateIndex_], this, gpuStats.numFlips);
+			creatingState_ = false;
+
+			// Compiling may have flushed, which cleared the pending writes.
+			if (HasDirty(SoftDirty::BINNER_RANGE)) {
+				MarkPendingWrites(state);
+				ClearDirty(SoftDirty::BINNER_RANGE);
+			}
+		}
+	} else if (newState) {
+		texCache_.Clear();
+	}
+
 	if (HasDirty(SoftDirty::BINNER_OVERLAP)) {
 		// This is a good place to record any dependencies for block transfer overlap.
 		MarkPendingReads(state);
 
 		// Disallow threads when rendering to the target, even offset.
 		bool selfRender = HasTextureWrite(state);
-		int newMaxTasks = selfRender || FORCE_SINGLE_THREAD ? 1 : g_threadManager.GetNumLooperThreads();
-		if (newMaxTasks > MAX_POSSIBLE_TASKS)
-			newMaxTasks = MAX_POSSIBLE_TASKS;
+		int newMaxTasks = selfRender || FORCE_SINGLE_THREAD ? 1 : MaxDrawTasks();
 		// We don't want to overlap wrong, so flush any pending.
 		if (maxTasks_ != newMaxTasks) {
 			maxTasks_ = newMaxTasks;
@@ -245,7 +332,8 @@ void BinManager::UpdateState() {
 }
 
 bool BinManager::HasTextureWrite(const RasterizerState &state) {
-	if (!state.enableTextures)
+	// Cached textures are read from a copy, so writes can't affect them.
+	if (!state.enableTextures || state.textureCached)
 		return false;
 
 	const uint8_t textureBits = textureBitsPerPixel[state.samplerID.texfmt];
@@ -295,7 +383,7 @@ bool BinManager::IsExactSelfRender(const Rasterizer::RasterizerState &state, con
 }
 
 void BinManager::MarkPendingReads(const Rasterizer::RasterizerState &state) {
-	if (!state.enableTextures)
+	if (!state.enableTextures || state.textureCached)
 		return;
 
 	const uint8_t textureBits = textureBitsPerPixel[state.samplerID.texfmt];
@@ -331,6 +419,12 @@ void BinManager::MarkPendingWrites(const Rasterizer::RasterizerState &state) {
 	pendingWrites_[0].Expand(gstate.getFrameBufAddress() & mirrorMask, bpp, gstate.FrameBufStride(), scissorTL, scissorBR);
 	if (state.pixelID.depthWrite)
 		pendingWrites_[1].Expand(gstate.getDepthBufAddress() & mirrorMask, 2, gstate.DepthBufStride(), scissorTL, scissorBR);
+
+	// Anything we render to will need to be hashed again before it's used as a cached texture.
+	for (const auto &range : pendingWrites_) {
+		if (range.base != 0 && range.height != 0)
+			texCache_.Invalidate(range.base, range.strideBytes * (range.height - 1) + range.widthBytes);
+	}
 }
 
 inline void BinDirtyRange::Expand(uint32_t newBase, uint32_t bpp, uint32_t stride, const DrawingCoords &tl, const DrawingCoords &br) {
@@ -359,6 +453,64 @@ inline void BinDirtyRange::Expand(uint32_t newBase, uint32_t bpp, uint32_t strid
 	widthBytes = strideBytes;
 }
 
+void BinManager::InvalidateMemory(uint32_t addr, int size) {
+	bool invalidated = size > 0 ? texCache_.Invalidate(addr, (uint32_t)size) : texCache_.InvalidateAll();
+	// The current state might be using an old copy, so we'll need to look it up again.
+	if (invalidated && State().textureCached)
+		SetDirty(SoftDirty::SAMPLER_TEXLIST);
+
+	// Invalidating everything happens often and rarely means depth, so only trust specific ranges.
+	if (size > 0 && depthBounds_.Enabled() && depthBounds_.Overlaps(addr, (uint32_t)size)) {
+		clearDepthBounds_ = true;
+		Flush("depthbounds");
+	}
+}
+
+bool BinManager::DepthBoundsUsable() {
+	const uint32_t depthAddr = gstate.getDepthBufRawAddress();
+	const int depthStride = gstate.DepthBufStride();
+	if (depthStride == 0 || (depthStride & (DepthBounds::BLOCK_SIZE - 1)) != 0)
+		return false;
+
+	// Anything past the stride would be the next row, so we only track what the region can reach.
+	const int width = gstate.getRegionX2() + 1;
+	const int height = gstate.getRegionY2() + 1;
+	if (width > depthStride)
+		return false;
+	if (depthBounds_.Enabled() && !depthBounds_.Matches(depthAddr, depthStride, height))
+		return false;
+
+	// Drawing color into the depth buffer would make the bounds stale.
+	const uint32_t fbBpp = gstate.FrameBufFormat() == GE_FORMAT_8888 ? 4 : 2;
+	const uint32_t fbStart = gstate.getFrameBufAddress() & 0x001FFFFF;
+	const uint32_t fbEnd = fbStart + gstate.FrameBufStride() * fbBpp * height;
+	const uint32_t depthStart = depthAddr;
+	const uint32_t depthEnd = depthStart + depthStride * 2 * height;
+	return fbEnd <= depthStart || fbStart >= depthEnd;
+}
+
+void BinManager::ResetDepthBounds() {
+	const uint32_t depthAddr = gstate.getDepthBufRawAddress();
+	const int depthStride = gstate.DepthBufStride();
+	const int height = gstate.getRegionY2() + 1;
+
+	if (depthBounds_.Enabled()) {
+		bool stale = clearDepthBounds_ || depthBoundsFlips_ != gpuStats.numFlips;
+		if (stale || !depthBounds_.Matches(depthAddr, depthStride, height))
+			depthBounds_.Reset(false, 0, 0, 0);
+	}
+
+	// When enabled, this also checks it's still the same buffer.
+	if (!DepthBoundsUsable()) {
+		if (depthBounds_.Enabled())
+			depthBounds_.Reset(false, 0, 0, 0);
+	} else if (!depthBounds_.Enabled()) {
+		depthBounds_.Reset(true, depthAddr, depthStride, height);
+		depthBoundsFlips_ = gpuStats.numFlips;
+	}
+	clearDepthBounds_ = false;
+}
+
 void BinManager::UpdateClut(const void *src) {
 	PROFILE_THIS_SCOPE("bin_clut");
 	if (cluts_.Full())
@@ -460,35 +612,16 @@ void BinManager::Drain(bool flushing) {
 		int w2 = (queueRange_.x2 - queueRange_.x1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 		int h2 = (queueRange_.y2 - queueRange_.y1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 
-		// Always bin the entire possible range, but focus on the drawn area.
-		ScreenCoords tl(0, 0, 0);
-		ScreenCoords br(1024 * SCREEN_SCALE_FACTOR, 1024 * SCREEN_SCALE_FACTOR, 0);
-
 		if (pendingOverlap_ && maxTasks_ == 1 && flushing && queue_.Size() == 1 && !FORCE_SINGLE_THREAD) {
 			// If the drawing is 1:1, we can potentially use threads.  It's worth checking.
 			const auto &item = queue_.PeekNext();
 			const auto &state = states_[item.stateIndex];
 			if (IsExactSelfRender(state, item))
-				maxTasks_ = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
-		}
-
-		taskRanges_.clear();
-		if (h2 >= 18 && w2 >= h2 * 4) {
-			int bin_w = std::max(4, (w2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, queueRange_.x1 + bin_w - 1, br.y - 1 });
-			for (int x = queueRange_.x1 + bin_w; x <= queueRange_.x2; x += bin_w) {
-				int x2 = x + bin_w > queueRange_.x2 ? br.x : x + bin_w;
-				taskRanges_.push_back(BinCoords{ x, tl.y, x2 - 1, br.y - 1 });
-			}
-		} else if (h2 >= 18 && w2 >= 18) {
-			int bin_h = std::max(4, (h2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, br.x - 1, queueRange_.y1 + bin_h - 1 });
-			for (int y = queueRange_.y1 + bin_h; y <= queueRange_.y2; y += bin_h) {
-				int y2 = y + bin_h > queueRange_.y2 ? br.y : y + bin_h;
-				taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, y2 - 1 });
-			}
+				maxTasks_ = MaxDrawTasks();
 		}
 
+		// Tiny draws aren't worth waking up threads for.
+		useTiles_ = maxTasks_ > 1 && h2 >= 18 && w2 >= 18;
 		tasksSplit_ = true;
 	}
 
@@ -496,73 +629,146 @@ void BinManager::Drain(bool flushing) {
 	OptimizePendingStates(pendingStateIndex_, stateIndex_);
 	pendingStateIndex_ = stateIndex_;
 
-	if (taskRanges_.size() <= 1) {
+	if (!useTiles_) {
 		PROFILE_THIS_SCOPE("bin_drain_single");
+		// Tasks are all done if we got here, so anything binned is already drawn.
+		if (binnedCount_ != 0)
+			ReclaimBinned();
 		while (!queue_.Empty()) {
 			const BinItem &item = queue_.PeekNext();
-			DrawBinItem(item, states_[item.stateIndex]);
+			DrawBinItem(item, item.range, states_[item.stateIndex]);
 			queue_.SkipNext();
 		}
-	} else {
-		int max = flushing ? QUEUED_PRIMS : QUEUED_PRIMS / 2;
-		while (!queue_.Empty()) {
-			const BinItem &item = queue_.PeekNext();
-			for (int i = 0; i < (int)taskRanges_.size(); ++i) {
-				const BinCoords range = taskRanges_[i].Intersect(item.range);
-				if (range.Invalid())
-					continue;
-
-				if (taskQueues_[i].NearFull()) {
-					// This shouldn't often happen, but if it does, wait for space.
-					if (taskQueues_[i].Full())
-						waitable_->Wait();
-					// If we're not flushing and not near full, let's just continue later.
-					// Near full means we'd drain on next prim, so better to finish it now.
-					else if (!flushing && !queue_.NearFull())
-						max = 0;
+		return;
+	}
+
+	BinTiles();
+
+	// Wake up enough tasks for the tiles waiting, the rest will be picked up by running tasks.
+	int pending = (int)(readyTail_ - readyHead_);
+	int threads = 0;
+	for (int i = 0; i < maxTasks_ && threads < pending; ++i) {
+		threads++;
+		bool expected = false;
+		if (!taskStatus_[i].compare_exchange_strong(expected, true))
+			continue;
+
+		waitable_->Fill();
+		g_threadManager.EnqueueTaskOnThread(i, taskLists_[i].Next());
+		enqueues_++;
+	}
+	mostThreads_ = std::max(mostThreads_, threads);
+
+	// We're about to add more, so make sure there's room in the queue.
+	if (queue_.NearFull()) {
+		ReclaimBinned();
+		if (queue_.NearFull()) {
+			// This shouldn't often happen, but if it does, wait for space.
+			waitable_->Wait();
+			ReclaimBinned();
+		}
+	}
+}
+
+void BinManager::BinTiles() {
+	PROFILE_THIS_SCOPE("bin_tiles");
+	constexpr int tileScreenSize = TILE_SIZE * SCREEN_SCALE_FACTOR;
+
+	size_t binned = binnedCount_;
+	const size_t size = queue_.Size();
+	for (; binned < size; ++binned) {
+		const size_t index = (queue_.head_ + binned) % QUEUED_PRIMS;
+		const BinCoords &range = queue_[index].range;
+
+		int tx1 = std::max(range.x1 / tileScreenSize, 0);
+		int ty1 = std::max(range.y1 / tileScreenSize, 0);
+		int tx2 = std::min(range.x2 / tileScreenSize, TILES_X - 1);
+		int ty2 = std::min(range.y2 / tileScreenSize, TILES_X - 1);
+		for (int ty = ty1; ty <= ty2; ++ty) {
+			for (int tx = tx1; tx <= tx2; ++tx) {
+				int tile = ty * TILES_X + tx;
+				BinTileQueue &items = tileQueues_[tile];
+				if (!items.items_) {
+					items.Setup();
+					setupTiles_.push_back((uint16_t)tile);
 				}
 
-				BinItem &taskItem = taskQueues_[i].PeekPush();
-				taskItem = item;
-				taskItem.range = range;
-				taskQueues_[i].PushPeeked();
+				// Can't overflow, since a tile never holds more than the prim queue.
+				items.Push((uint16_t)index);
+				if (!tileStatus_[tile])
+					QueueTile(tile);
 			}
-			queue_.SkipNext();
-			if (--max <= 0)
-				break;
 		}
+	}
+	binnedCount_ = binned;
+}
 
-		int threads = 0;
-		for (int i = 0; i < (int)taskRanges_.size(); ++i) {
-			if (taskQueues_[i].Empty())
-				continue;
-			threads++;
-			if (taskStatus_[i])
-				continue;
-
-			waitable_->Fill();
-			taskStatus_[i] = true;
-			g_threadManager.EnqueueTaskOnThread(i, taskLists_[i].Next());
-			enqueues_++;
-		}
+void BinManager::QueueTile(int tile) {
+	bool expected = false;
+	if (!tileStatus_[tile].compare_exchange_strong(expected, true))
+		return;
 
-		mostThreads_ = std::max(mostThreads_, threads);
+	// Each tile is in here at most once, so it can't overflow.
+	uint32_t tail = readyTail_;
+	readyTiles_[tail % TILES] = (uint16_t)tile;
+	readyTail_ = tail + 1;
+}
+
+int BinManager::PopTile() {
+	uint32_t head = readyHead_;
+	while (head != readyTail_) {
+		// This might be stale if another task beat us, but then the exchange fails.
+		int tile = readyTiles_[head % TILES];
+		if (readyHead_.compare_exchange_weak(head, head + 1))
+			return tile;
+	}
+	return -1;
+}
+
+void BinManager::ReclaimBinned() {
+	// Anything older than the oldest prim any tile still needs has been drawn.
+	const size_t head = queue_.head_;
+	size_t drawn = binnedCount_;
+	for (uint16_t tile : setupTiles_) {
+		BinTileQueue &items = tileQueues_[tile];
+		if (items.Empty())
+			continue;
+		// If the task finished the tile meanwhile, this may be junk, but then any value is safe.
+		size_t age = (items.PeekNext() + QUEUED_PRIMS - head) % QUEUED_PRIMS;
+		drawn = std::min(drawn, age);
 	}
+
+	for (size_t i = 0; i < drawn; ++i)
+		queue_.SkipNext();
+	binnedCount_ -= drawn;
+}
+
+BinCoords BinManager::TileRange(int tile) {
+	constexpr int tileScreenSize = TILE_SIZE * SCREEN_SCALE_FACTOR;
+	BinCoords range;
+	range.x1 = (tile % TILES_X) * tileScreenSize;
+	range.y1 = (tile / TILES_X) * tileScreenSize;
+	range.x2 = range.x1 + tileScreenSize - 1;
+	range.y2 = range.y1 + tileScreenSize - 1;
+	return range;
 }
 
 void BinManager::Flush(const char *reason) {
-	if (queueRange_.x1 == 0x7FFFFFFF)
+	if (queueRange_.x1 == 0x7FFFFFFF) {
+		// Nothing is drawing, so this is a safe time to start tracking depth.
+		ResetDepthBounds();
 		return;
+	}
 
 	double st;
 	if (coreCollectDebugStats)
 		st = time_now_d();
 	Drain(true);
 	waitable_->Wait();
-	taskRanges_.clear();
 	tasksSplit_ = false;
 
 	queue_.Reset();
+	binnedCount_ = 0;
 	while (states_.Size() > 1)
 		states_.SkipNext();
 	while (cluts_.Size() > 1)
@@ -570,6 +776,8 @@ void BinManager::Flush(const char *reason) {
 
 	Rasterizer::FlushJit();
 	Sampler::FlushJit();
+	texCache_.FreeRetired();
+	ResetDepthBounds();
 
 	queueRange_.x1 = 0x7FFFFFFF;
 	queueRange_.y1 = 0x7FFFFFFF;
@@ -585,6 +793,20 @@ void BinManager::Flush(const char *reason) {
 	dirty_ |= SoftDirty::BINNER_RANGE | SoftDirty::BINNER_OVERLAP;
 
 	if (coreCollectDebugStats) {
+		// Nothing is drawing now, so it's safe to collect the tile times.
+		for (BinTaskList &list : taskLists_) {
+			for (DrawBinItemsTask *task : list.tasks) {
+				if (task)
+					task->TakeTileTimes(tileTimes_);
+			}
+		}
+		double tilesTotal = 0.0;
+		for (double t : tileTimes_)
+			tilesTotal += t;
+		gpuStats.msDrawingTiles += (tilesTotal - tileTimesReported_) * 1000.0;
+		tileTimesReported_ = tilesTotal;
+		gpuStats.numPixelsShaded += Rasterizer::TakePixelsShadedStat();
+
 		double et = time_now_d();
 		flushReasonTimes_[reason] += et - st;
 		if (et - st > slowestFlushTime_) {
@@ -689,17 +911,49 @@ void BinManager::GetStats(char *buffer, size_t bufsize) {
 		recentTotal += it.second;
 	}
 
+	// Tile times are summed across threads, so compare the slowest to the average.
+	int usedTiles = 0;
+	int slowestTile = 0;
+	double tilesTotal = 0.0;
+	for (int i = 0; i < TILES; ++i) {
+		if (tileTimes_[i] <= 0.0)
+			continue;
+		usedTiles++;
+		tilesTotal += tileTimes_[i];
+		if (tileTimes_[i] > tileTimes_[slowestTile])
+			slowestTile = i;
+	}
+	const BinCoords slowestRange = TileRange(slowestTile);
+
 	snprintf(buffer, bufsize,
 		"Slowest individual flush: %s (%0.4f)\n"
 		"Slowest frame flush: %s (%0.4f)\n"
 		"Slowest recent flush: %s (%0.4f)\n"
 		"Total flush time: %0.4f (%05.2f%%, last 2: %05.2f%%)\n"
-		"Thread enqueues: %d, count %d",
+		"Thread enqueues: %d, count %d\n"
+		"Tiles drawn: %d, total %0.4f, average %0.4f\n"
+		"Slowest tile: %d,%d (%0.4f)",
 		slowestFlushReason_, slowestFlushTime_,
 		slowestTotalReason, slowestTotalTime,
 		slowestRecentReason, slowestRecentTime,
 		allTotal, allTotal * (6000.0 / 1.001), recentTotal * (3000.0 / 1.001),
-		enqueues_, mostThreads_);
+		enqueues_, mostThreads_,
+		usedTiles, tilesTotal, usedTiles == 0 ? 0.0 : tilesTotal / usedTiles,
+		slowestRange.x1 / SCREEN_SCALE_FACTOR, slowestRange.y1 / SCREEN_SCALE_FACTOR, tileTimes_[slowestTile]);
+
+	if (g_Config.bSoftwareTextureCache) {
+		size_t len = strlen(buffer);
+		if (len + 1 < bufsize) {
+			buffer[len++] = '\n';
+			texCache_.GetStats(buffer + len, bufsize - len);
+		}
+	}
+
+	size_t len = strlen(buffer);
+	if (len + 1 < bufsize) {
+		buffer[len++] = '\n';
+		depthBounds_.GetStats(buffer + len, bufsize - len);
+	}
 }
 
 void BinManager::ResetStats() {
@@ -709,6 +963,11 @@ void BinManager::ResetStats() {
 	slowestFlushTime_ = 0.0;
 	enqueues_ = 0;
 	mostThreads_ = 0;
+	for (double &t : tileTimes_)
+		t = 0.0;
+	tileTimesReported_ = 0.0;
+	texCache_.ResetStats();
+	depthBounds_.ResetStats();
 }
 
 inline BinCoords BinCoords::Intersect(const BinCoords &range) const {
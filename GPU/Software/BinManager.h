@@ -19,7 +19,9 @@
 
 #include <atomic>
 #include <unordered_map>
+#include "GPU/Software/DepthBounds.h"
 #include "GPU/Software/Rasterizer.h"
+#include "GPU/Software/SoftTextureCache.h"
 
 struct BinWaitable;
 class DrawBinItemsTask;
@@ -204,6 +206,8 @@ class BinManager {
 	bool HasPendingWrite(uint32_t start, uint32_t stride, uint32_t w, uint32_t h);
 	// Assumes you've also checked for a write (writes are partial so are automatically reads.)
 	bool HasPendingRead(uint32_t start, uint32_t stride, uint32_t w, uint32_t h);
+	// Size zero or less means everything.
+	void InvalidateMemory(uint32_t addr, int size);
 
 	void GetStats(char *buffer, size_t bufsize);
 	void ResetStats();
@@ -232,12 +236,20 @@ class BinManager {
 	static constexpr int QUEUED_STATES = 4096;
 	// These are 1KB each, so half an MB.
 	static constexpr int QUEUED_CLUTS = 512;
-	// About 360 KB, but we have usually 16 or less of them, so 5 MB - 22 MB.
+	// About 360 KB.  Binned prims stay in here until every tile that references them is drawn.
 	static constexpr int QUEUED_PRIMS = 2048;
+	static_assert(QUEUED_PRIMS <= 65536, "Tile queues store 16-bit prim indexes");
+
+	// Tiles are square, in pixels.  The grid covers the whole 1024x1024 drawing space.
+	static constexpr int TILE_SIZE = 32;
+	static constexpr int TILES_X = 1024 / TILE_SIZE;
+	static constexpr int TILES = TILES_X * TILES_X;
 
 	typedef BinQueue<Rasterizer::RasterizerState, QUEUED_STATES> BinStateQueue;
 	typedef BinQueue<BinClut, QUEUED_CLUTS> BinClutQueue;
 	typedef BinQueue<BinItem, QUEUED_PRIMS> BinItemQueue;
+	// Indexes into the prim queue, 4 KB each and only allocated for tiles that get drawn to.
+	typedef BinQueue<uint16_t, QUEUED_PRIMS> BinTileQueue;
 
 private:
 	BinStateQueue states_;
@@ -248,15 +260,33 @@ class BinManager {
 	BinItemQueue queue_;
 	BinCoords queueRange_;
 	SoftDirty dirty_ = SoftDirty::NONE;
+	SoftTextureCache texCache_;
+	Rasterizer::DepthBounds depthBounds_;
+	bool clearDepthBounds_ = false;
+	int depthBoundsFlips_ = 0;
 
 	int maxTasks_ = 1;
 	bool tasksSplit_ = false;
-	std::vector<BinCoords> taskRanges_;
-	BinItemQueue taskQueues_[MAX_POSSIBLE_TASKS];
+	bool useTiles_ = false;
 	BinTaskList taskLists_[MAX_POSSIBLE_TASKS];
 	std::atomic<bool> taskStatus_[MAX_POSSIBLE_TASKS];
 	BinWaitable *waitable_ = nullptr;
 
+	// Number of prims at the front of queue_ already handed out to tiles.
+	size_t binnedCount_ = 0;
+	BinTileQueue tileQueues_[TILES];
+	// Set while a tile is waiting in readyTiles_ or being drawn, so only one task draws it.
+	std::atomic<bool> tileStatus_[TILES];
+	std::vector<uint16_t> setupTiles_;
+	// Tiles with work, pushed only by the emu thread and popped by any task.
+	std::atomic<uint16_t> readyTiles_[TILES];
+	std::atomic<uint32_t> readyHead_;
+	std::atomic<uint32_t> readyTail_;
+	// Summed from the draw tasks on each flush.
+	double tileTimes_[TILES]{};
+	// Portion of tileTimes_ already added to gpuStats.
+	double tileTimesReported_ = 0.0;
+
 	BinDirtyRange pendingWrites_[2]{};
 	std::unordered_map<uint32_t, BinDirtyRange> pendingReads_;
 
@@ -275,6 +305,8 @@ class BinManager {
 	void MarkPendingReads(const Rasterizer::RasterizerState &state);
 	void MarkPendingWrites(const Rasterizer::RasterizerState &state);
 	bool HasTextureWrite(const Rasterizer::RasterizerState &state);
+	bool DepthBoundsUsable();
+	void ResetDepthBounds();
 	bool IsExactSelfRender(const Rasterizer::RasterizerState &state, const BinItem &item);
 	void OptimizePendingStates(uint16_t first, uint16_t last);
 	BinCoords Scissor(BinCoords range);
@@ -282,6 +314,12 @@ class BinManager {
 	BinCoords Range(const VertexData &v0, const VertexData &v1);
 	BinCoords Range(const VertexData &v0);
 	void Expand(const BinCoords &range);
+	void BinTiles();
+	void QueueTile(int tile);
+	int PopTile();
+	void ReclaimBinned();
+	static BinCoords TileRange(int tile);
+	static int MaxDrawTasks();
 
 	friend class DrawBinItemsTask;
 };
@@ -0,0 +1,220 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "Core/MemMap.h"
+#include "GPU/Software/DepthBounds.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/Software/TransformUnit.h"
+
+namespace Rasterizer {
+
+static inline uint32_t NormalizeVRAM(uint32_t addr) {
+	return addr & 0x001FFFFF;
+}
+
+DepthBounds::DepthBounds() {
+	for (uint32_t &b : blocks_)
+		b = INVALID;
+	ResetStats();
+}
+
+void DepthBounds::Reset(bool enable, uint32_t addr, int stride, int height) {
+	for (uint32_t &b : blocks_)
+		b = INVALID;
+	enabled_ = enable;
+	addr_ = NormalizeVRAM(addr);
+	stride_ = stride;
+	height_ = height;
+}
+
+bool DepthBounds::Matches(uint32_t addr, int stride, int height) const {
+	return addr_ == NormalizeVRAM(addr) && stride_ == stride && height <= height_;
+}
+
+bool DepthBounds::Overlaps(uint32_t addr, uint32_t bytes) const {
+	if (!Memory::IsVRAMAddress(addr))
+		return false;
+	const uint32_t start = NormalizeVRAM(addr);
+	const uint32_t size = stride_ * 2 * height_;
+	return start < addr_ + size && start + bytes > addr_;
+}
+
+uint32_t DepthBounds::Compute(int bx, int by) {
+	int minZ = 0xFFFF;
+	int maxZ = 0;
+	for (int y = 0; y < BLOCK_SIZE; ++y) {
+		const u16 *row = depthbuf.Get16Ptr(bx * BLOCK_SIZE, by * BLOCK_SIZE + y, stride_);
+		for (int x = 0; x < BLOCK_SIZE; ++x) {
+			minZ = std::min(minZ, (int)row[x]);
+			maxZ = std::max(maxZ, (int)row[x]);
+		}
+	}
+	return (uint32_t)minZ | ((uint32_t)maxZ << 16);
+}
+
+bool DepthBounds::Reject(int bx, int by, GEComparison func, int zmin, int zmax) {
+	// Rows past the height might alias something else in VRAM, so we don't track them.
+	if ((by + 1) * BLOCK_SIZE > height_)
+		return false;
+
+	uint32_t &block = blocks_[by * BLOCKS_X + bx];
+	if (block == INVALID)
+		block = Compute(bx, by);
+
+	const int blockMin = block & 0xFFFF;
+	const int blockMax = block >> 16;
+	switch (func) {
+	case GE_COMP_NEVER:
+		return true;
+	case GE_COMP_EQUAL:
+		return zmax < blockMin || zmin > blockMax;
+	case GE_COMP_LESS:
+		return zmin >= blockMax;
+	case GE_COMP_LEQUAL:
+		return zmin > blockMax;
+	case GE_COMP_GREATER:
+		return zmax <= blockMin;
+	case GE_COMP_GEQUAL:
+		return zmax < blockMin;
+	default:
+		return false;
+	}
+}
+
+void DepthBounds::Expand(int x1, int y1, int x2, int y2, int zmin, int zmax) {
+	const int bx1 = std::max(x1, 0) / BLOCK_SIZE;
+	const int by1 = std::max(y1, 0) / BLOCK_SIZE;
+	const int bx2 = std::min(x2, 1023) / BLOCK_SIZE;
+	const int by2 = std::min(y2, 1023) / BLOCK_SIZE;
+	zmin = std::max(zmin, 0);
+	zmax = std::min(zmax, 0xFFFF);
+
+	for (int by = by1; by <= by2; ++by) {
+		for (int bx = bx1; bx <= bx2; ++bx) {
+			uint32_t &block = blocks_[by * BLOCKS_X + bx];
+			if (block == INVALID)
+				continue;
+			const int blockMin = std::min((int)(block & 0xFFFF), zmin);
+			const int blockMax = std::max((int)(block >> 16), zmax);
+			block = (uint32_t)blockMin | ((uint32_t)blockMax << 16);
+		}
+	}
+}
+
+void DepthBounds::Fill(int x1, int y1, int x2, int y2, int z) {
+	const int bx1 = std::max(x1, 0) / BLOCK_SIZE;
+	const int by1 = std::max(y1, 0) / BLOCK_SIZE;
+	const int bx2 = std::min(x2, 1023) / BLOCK_SIZE;
+	const int by2 = std::min(y2, 1023) / BLOCK_SIZE;
+	const uint32_t exact = (uint32_t)z | ((uint32_t)z << 16);
+
+	for (int by = by1; by <= by2; ++by) {
+		const bool fullY = by * BLOCK_SIZE >= y1 && (by + 1) * BLOCK_SIZE - 1 <= y2;
+		for (int bx = bx1; bx <= bx2; ++bx) {
+			const bool fullX = bx * BLOCK_SIZE >= x1 && (bx + 1) * BLOCK_SIZE - 1 <= x2;
+			uint32_t &block = blocks_[by * BLOCKS_X + bx];
+			if (fullX && fullY) {
+				block = exact;
+			} else if (block != INVALID) {
+				const int blockMin = std::min((int)(block & 0xFFFF), z);
+				const int blockMax = std::max((int)(block >> 16), z);
+				block = (uint32_t)blockMin | ((uint32_t)blockMax << 16);
+			}
+		}
+	}
+}
+
+void DepthBounds::AddStats(int tested, int rejected, int quads) {
+	testedBlocks_.fetch_add(tested, std::memory_order_relaxed);
+	rejectedBlocks_.fetch_add(rejected, std::memory_order_relaxed);
+	skippedQuads_.fetch_add(quads, std::memory_order_relaxed);
+}
+
+void DepthBounds::GetStats(char *buffer, size_t bufsize) {
+	const uint64_t tested = testedBlocks_.load(std::memory_order_relaxed);
+	const uint64_t rejected = rejectedBlocks_.load(std::memory_order_relaxed);
+	snprintf(buffer, bufsize,
+		"Depth blocks tested: %d, rejected %d (%0.1f%%), quads skipped %d",
+		(int)tested, (int)rejected, tested == 0 ? 0.0 : rejected * 100.0 / tested,
+		(int)skippedQuads_.load(std::memory_order_relaxed));
+}
+
+void DepthBounds::ResetStats() {
+	testedBlocks_ = 0;
+	rejectedBlocks_ = 0;
+	skippedQuads_ = 0;
+}
+
+void DepthPlane::Init(const VertexData &v0, const VertexData &v1, const VertexData &v2) {
+	const int z0i = v0.screenpos.z, z1i = v1.screenpos.z, z2i = v2.screenpos.z;
+	flat = z0i == z1i && z0i == z2i;
+	// Interpolation rounds, so allow a little either way.
+	minZ = flat ? z0i : std::max(std::min(std::min(z0i, z1i), z2i) - 1, 0);
+	maxZ = flat ? z0i : std::min(std::max(std::max(z0i, z1i), z2i) + 1, 0xFFFF);
+
+	x0 = v0.screenpos.x;
+	y0 = v0.screenpos.y;
+	z0 = (float)z0i;
+	dzdx = 0.0f;
+	dzdy = 0.0f;
+	if (flat)
+		return;
+
+	const int64_t dx1 = v1.screenpos.x - x0, dy1 = v1.screenpos.y - y0;
+	const int64_t dx2 = v2.screenpos.x - x0, dy2 = v2.screenpos.y - y0;
+	const int64_t dz1 = z1i - z0i, dz2 = z2i - z0i;
+	const int64_t det = dx1 * dy2 - dx2 * dy1;
+	if (det == 0) {
+		// Degenerate, we'll just use the full range.
+		flat = true;
+		return;
+	}
+
+	dzdx = (float)((double)(dz1 * dy2 - dz2 * dy1) / (double)det);
+	dzdy = (float)((double)(dx1 * dz2 - dx2 * dz1) / (double)det);
+}
+
+void DepthPlane::Range(int x1, int y1, int x2, int y2, int *zmin, int *zmax) const {
+	if (flat || (dzdx == 0.0f && dzdy == 0.0f) || x1 > x2 || y1 > y2) {
+		*zmin = minZ;
+		*zmax = maxZ;
+		return;
+	}
+
+	// Use the full extent of the pixels, wherever within them they get sampled.
+	const float sx1 = (float)(x1 * SCREEN_SCALE_FACTOR - x0);
+	const float sy1 = (float)(y1 * SCREEN_SCALE_FACTOR - y0);
+	const float sx2 = (float)((x2 + 1) * SCREEN_SCALE_FACTOR - x0);
+	const float sy2 = (float)((y2 + 1) * SCREEN_SCALE_FACTOR - y0);
+
+	// It's linear, so the extremes are at the corners.
+	const float zx1 = dzdx * sx1, zx2 = dzdx * sx2;
+	const float zy1 = dzdy * sy1, zy2 = dzdy * sy2;
+	const float lo = z0 + std::min(zx1, zx2) + std::min(zy1, zy2);
+	const float hi = z0 + std::max(zx1, zx2) + std::max(zy1, zy2);
+
+	*zmin = std::max((int)floorf(lo) - 1, minZ);
+	*zmax = std::min((int)ceilf(hi) + 1, maxZ);
+}
+
+}  // namespace Rasterizer
@@ -0,0 +1,96 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+
+#include <atomic>
+#include <cstdint>
+#include "GPU/ge_constants.h"
+
+struct VertexData;
+
+namespace Rasterizer {
+
+// Conservative min/max depth for each 8x8 block of the depth buffer, so triangles can skip whole
+// blocks that would fail the depth test before interpolating or texturing anything.
+//
+// Blocks are read from the depth buffer when first needed, and draws that write depth only ever
+// widen them, so they never reject anything that might pass.  Each block lies within a single
+// bin tile, and so is only touched by whichever thread is drawing that tile.
+class DepthBounds {
+public:
+	static constexpr int BLOCK_SIZE = 8;
+	static constexpr int BLOCKS_X = 1024 / BLOCK_SIZE;
+	static constexpr int BLOCKS = BLOCKS_X * BLOCKS_X;
+
+	DepthBounds();
+
+	// These must only be called while nothing is drawing.
+	void Reset(bool enable, uint32_t addr, int stride, int height);
+	bool Matches(uint32_t addr, int stride, int height) const;
+	bool Overlaps(uint32_t addr, uint32_t bytes) const;
+	bool Enabled() const {
+		return enabled_;
+	}
+
+	// Returns true if every pixel in block bx, by would fail func with a z between zmin and zmax.
+	bool Reject(int bx, int by, GEComparison func, int zmin, int zmax);
+	// Widens the blocks within these drawing coords (inclusive) to include depths zmin to zmax.
+	void Expand(int x1, int y1, int x2, int y2, int zmin, int zmax);
+	// Same, but blocks fully covered are set to exactly z.
+	void Fill(int x1, int y1, int x2, int y2, int z);
+
+	void AddStats(int tested, int rejected, int quads);
+	void GetStats(char *buffer, size_t bufsize);
+	void ResetStats();
+
+private:
+	// Packed as min | (max << 16), so an invalid min > max can't be mistaken for a real range.
+	static constexpr uint32_t INVALID = 0x0000FFFF;
+
+	uint32_t Compute(int bx, int by);
+
+	uint32_t blocks_[BLOCKS];
+	bool enabled_ = false;
+	uint32_t addr_ = 0;
+	int stride_ = 0;
+	int height_ = 0;
+
+	std::atomic<uint64_t> testedBlocks_;
+	std::atomic<uint64_t> rejectedBlocks_;
+	std::atomic<uint64_t> skippedQuads_;
+};
+
+// The depth of a triangle as a plane, to get a tighter range within each block.
+struct DepthPlane {
+	void Init(const VertexData &v0, const VertexData &v1, const VertexData &v2);
+	// Range of z sampled for pixels within the drawing coords (inclusive.)
+	void Range(int x1, int y1, int x2, int y2, int *zmin, int *zmax) const;
+
+	bool flat;
+	int minZ;
+	int maxZ;
+	float z0;
+	float dzdx;
+	float dzdy;
+	int x0;
+	int y0;
+};
+
+}  // namespace Rasterizer
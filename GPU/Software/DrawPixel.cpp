@@ -19,6 +19,7 @@
 #include <mutex>
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
+#include "Common/MemoryUtil.h"
 #include "Core/Config.h"
 #include "GPU/GPUState.h"
 #include "GPU/Software/BinManager.h"
@@ -47,6 +48,14 @@ void Shutdown() {
 	jitCache = nullptr;
 }
 
+std::vector<PixelFuncID> GetSeenJitIDs() {
+	return jitCache->SeenIDs();
+}
+
+void PrecompileJit(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel) {
+	jitCache->Precompile(ids, cancel);
+}
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (!jitCache->IsInSpace(ptr)) {
 		return false;
@@ -848,6 +857,34 @@ void PixelJitCache::Flush() {
 	compileQueue_.clear();
 }
 
+void PixelJitCache::Precompile(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return;
+
+	for (const PixelFuncID &id : ids) {
+		if (cancel)
+			break;
+
+		std::unique_lock<std::mutex> guard(jitCacheLock);
+		size_t key = std::hash<PixelFuncID>()(id);
+		if (cache_.Get(key))
+			continue;
+
+		// Other threads may be running code from this block, so we can't Clear() or change page protection.
+		// Instead, leave those to the next flush, which is still better than compiling mid-frame.
+		if (PlatformIsWXExclusive() || GetSpaceLeft() < 65536 * 2) {
+			compileQueue_.insert(id);
+			continue;
+		}
+		Compile(id);
+	}
+}
+
+std::vector<PixelFuncID> PixelJitCache::SeenIDs() {
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	return std::vector<PixelFuncID>(seen_.begin(), seen_.end());
+}
+
 SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id, BinManager *binner) {
 	if (!g_Config.bSoftwareRenderingJit)
 		return nullptr;
@@ -857,6 +894,8 @@ SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id, BinManager *binner) {
 		return lastSingle_.func;
 
 	std::unique_lock<std::mutex> guard(jitCacheLock);
+	// Recorded here rather than in Compile(), so precompiled funcs only count once they're used.
+	seen_.insert(id);
 	auto it = cache_.Get(key);
 	if (it != nullptr) {
 		lastSingle_.Set(key, it, clearGen_);
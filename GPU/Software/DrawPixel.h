@@ -19,6 +19,7 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -46,6 +47,10 @@ void Init();
 void FlushJit();
 void Shutdown();
 
+// IDs compiled so far, so they can be saved and precompiled next run.
+std::vector<PixelFuncID> GetSeenJitIDs();
+void PrecompileJit(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel);
+
 bool CheckDepthTestPassed(GEComparison func, int x, int y, int stride, u16 z);
 
 bool DescribeCodePtr(const u8 *ptr, std::string &name);
@@ -70,6 +75,10 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	void Clear() override;
 	void Flush();
 
+	// Compiles any missing funcs, locking per func so drawing isn't held up for long.
+	void Precompile(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel);
+	std::vector<PixelFuncID> SeenIDs();
+
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
 private:
@@ -128,6 +137,8 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	DenseHashMap<size_t, SingleFunc, nullptr> cache_;
 	std::unordered_map<PixelFuncID, const u8 *> addresses_;
 	std::unordered_set<PixelFuncID> compileQueue_;
+	// Unlike addresses_, this survives Clear().
+	std::unordered_set<PixelFuncID> seen_;
 	int clearGen_ = 0;
 	static thread_local LastCache lastSingle_;
 
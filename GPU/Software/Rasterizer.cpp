@@ -17,6 +17,7 @@
 
 #include "ppsspp_config.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 
 #include "Common/Common.h"
@@ -27,10 +28,12 @@
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/MemMap.h"
+#include "Core/System.h"
 #include "GPU/GPUState.h"
 
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Software/BinManager.h"
+#include "GPU/Software/DepthBounds.h"
 #include "GPU/Software/DrawPixel.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/Sampler.h"
@@ -40,10 +43,23 @@
 #if defined(_M_SSE)
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <immintrin.h>
 #endif
 
 namespace Rasterizer {
 
+// Drawn from all the binner threads, so only counted when collecting debug stats.
+static std::atomic<int64_t> pixelsShadedStat;
+
+void AddPixelsShadedStat(int64_t count) {
+	if (coreCollectDebugStats && count > 0)
+		pixelsShadedStat.fetch_add(count, std::memory_order_relaxed);
+}
+
+int64_t TakePixelsShadedStat() {
+	return pixelsShadedStat.exchange(0, std::memory_order_relaxed);
+}
+
 // Only OK on x64 where our stack is aligned
 #if defined(_M_SSE) && !PPSSPP_ARCH(X86)
 static inline __m128 InterpolateF(const __m128 &c0, const __m128 &c1, const __m128 &c2, int w0, int w1, int w2, float wsum) {
@@ -274,6 +290,11 @@ static bool CheckClutAlphaFull(RasterizerState *state) {
 	return onlyFull;
 }
 
+static inline bool HasClutAlphaFlags(const RasterizerState *state) {
+	// Cached textures were decoded ahead of time, so we know their alpha like with a CLUT.
+	return (state->samplerID.texfmt & 4) != 0 || state->textureCached;
+}
+
 static RasterizerStateFlags DetectStateOptimizations(RasterizerState *state) {
 	// Note: all optimizations must be undoable.
 	RasterizerStateFlags optimize = RasterizerStateFlags::NONE;
@@ -289,7 +310,7 @@ static RasterizerStateFlags DetectStateOptimizations(RasterizerState *state) {
 
 		bool alphaBlend = pixelID.alphaBlend || (state->flags & RasterizerStateFlags::OPTIMIZED_BLEND_OFF);
 		if (needTextureAlpha && alphaBlend && alphaFull) {
-			bool usesClut = (samplerID.texfmt & 4) != 0;
+			bool usesClut = HasClutAlphaFlags(state);
 			if (usesClut && CheckClutAlphaFull(state))
 				needTextureAlpha = false;
 		}
@@ -333,7 +354,7 @@ static RasterizerStateFlags DetectStateOptimizations(RasterizerState *state) {
 				dst = PixelBlendFactor::INVSRCALPHA;
 
 			if (alphaTestFunc == GE_COMP_ALWAYS && src == PixelBlendFactor::SRCALPHA && dst == PixelBlendFactor::INVSRCALPHA) {
-				bool usesClut = (samplerID.texfmt & 4) != 0;
+				bool usesClut = HasClutAlphaFlags(state);
 				bool couldHaveZeroTexAlpha = true;
 				if (usesClut && CheckClutAlphaFull(state))
 					couldHaveZeroTexAlpha = false;
@@ -366,7 +387,7 @@ static RasterizerStateFlags DetectStateOptimizations(RasterizerState *state) {
 				optimize |= RasterizerStateFlags::OPTIMIZED_TEXREPLACE;
 		}
 
-		bool usesClut = (samplerID.texfmt & 4) != 0;
+		bool usesClut = HasClutAlphaFlags(state);
 		if (usesClut && alphaFull && samplerID.useTextureAlpha) {
 			GEComparison alphaTestFunc = pixelID.AlphaTestFunc();
 			// We optimize > 0 to != 0, so this is especially common.
@@ -878,7 +899,56 @@ static inline Vec4<float> EdgeRecip(const Vec4<int> &w0, const Vec4<int> &w1, co
 #endif
 }
 
-template <bool clearMode, bool useSSE4>
+#if defined(_M_SSE) && !PPSSPP_ARCH(X86)
+// Results for a quad and the one after it, evaluated together.
+struct QuadPair {
+	Vec4<int> mask[2];
+	Vec4<float> wsumRecip[2];
+	Vec4<int> z[2];
+};
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline __m256i PairOfAVX2(__m128i w, __m128i step) {
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(w), _mm_add_epi32(w, step), 1);
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline void SOFTRAST_CALL QuadPairAVX2(const Vec4<int> &w0, const Vec4<int> &w1, const Vec4<int> &w2, const Vec4<int> &step0, const Vec4<int> &step1, const Vec4<int> &step2, const Vec4<int> &bias0, const Vec4<int> &bias1, const Vec4<int> &bias2, const Vec4<int> &scissor, const Vec4<int> &scissorStep, const VertexData &v0, const VertexData &v1, const VertexData &v2, bool flatZ, QuadPair *pair) {
+	// Low lanes are this quad, high lanes are the next one over.
+	const __m256i pw0 = PairOfAVX2(w0.ivec, step0.ivec);
+	const __m256i pw1 = PairOfAVX2(w1.ivec, step1.ivec);
+	const __m256i pw2 = PairOfAVX2(w2.ivec, step2.ivec);
+
+	// Same as MakeMask().
+	__m256i biased0 = _mm256_add_epi32(pw0, _mm256_broadcastsi128_si256(bias0.ivec));
+	__m256i biased1 = _mm256_add_epi32(pw1, _mm256_broadcastsi128_si256(bias1.ivec));
+	__m256i biased2 = _mm256_add_epi32(pw2, _mm256_broadcastsi128_si256(bias2.ivec));
+	__m256i mask = _mm256_or_si256(_mm256_or_si256(biased0, _mm256_or_si256(biased1, biased2)), PairOfAVX2(scissor.ivec, scissorStep.ivec));
+	_mm256_storeu_si256((__m256i *)pair->mask, mask);
+
+	// Same as EdgeRecip() and the scalar z, in the same order, so the results match exactly.
+	__m256i wsum = _mm256_add_epi32(pw0, _mm256_add_epi32(pw1, pw2));
+	__m256 recip = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_cvtepi32_ps(wsum));
+	_mm256_storeu_ps((float *)pair->wsumRecip, recip);
+
+	if (flatZ) {
+		pair->z[0] = Vec4<int>::AssignToAll(v2.screenpos.z);
+		pair->z[1] = pair->z[0];
+	} else {
+		__m256 z0 = _mm256_mul_ps(_mm256_cvtepi32_ps(pw0), _mm256_set1_ps((float)v0.screenpos.z));
+		__m256 z1 = _mm256_mul_ps(_mm256_cvtepi32_ps(pw1), _mm256_set1_ps((float)v1.screenpos.z));
+		__m256 z2 = _mm256_mul_ps(_mm256_cvtepi32_ps(pw2), _mm256_set1_ps((float)v2.screenpos.z));
+		__m256 zfloats = _mm256_add_ps(_mm256_add_ps(z0, z1), z2);
+		_mm256_storeu_si256((__m256i *)pair->z, _mm256_cvttps_epi32(_mm256_mul_ps(zfloats, recip)));
+	}
+}
+#endif
+
+template <bool clearMode, bool useSSE4, bool useAVX2>
 void DrawTriangleSlice(
 	const VertexData& v0, const VertexData& v1, const VertexData& v2,
 	int x1, int y1, int x2, int y2,
@@ -914,6 +984,28 @@ void DrawTriangleSlice(
 			return;
 	}
 
+	// Skip whole blocks of the depth buffer that this triangle can't pass the depth test in.
+	DepthBounds *depthBounds = !clearMode && pixelID.earlyZChecks ? state.depthBounds : nullptr;
+	DepthPlane depthPlane;
+	enum { BLOCK_UNKNOWN, BLOCK_KEEP, BLOCK_REJECT };
+	uint8_t blockStatus[DepthBounds::BLOCKS_X];
+	int blockStatusRow = -1;
+	int blocksTested = 0, blocksRejected = 0, quadsSkipped = 0;
+	int64_t pixelsShaded = 0;
+	if (depthBounds && depthBounds->Enabled()) {
+		depthPlane.Init(v0, v1, v2);
+		if (pixelID.applyDepthRange) {
+			depthPlane.minZ = std::max(depthPlane.minZ, (int)pixelID.cached.minz);
+			depthPlane.maxZ = std::min(depthPlane.maxZ, (int)pixelID.cached.maxz);
+			if (depthPlane.minZ > depthPlane.maxZ)
+				return;
+		}
+	} else {
+		depthBounds = nullptr;
+	}
+	const DrawingCoords primMin = TransformUnit::ScreenToDrawing(x1, y1);
+	const DrawingCoords primMax = TransformUnit::ScreenToDrawing(x2, y2);
+
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 	uint32_t bpp = pixelID.FBFormat() == GE_FORMAT_8888 ? 4 : 2;
 	std::string tag = StringFromFormat("DisplayListT_%08x", state.listPC);
@@ -952,6 +1044,10 @@ void DrawTriangleSlice(
 		int scissorYPlus1 = curY + SCREEN_SCALE_FACTOR > maxY ? -1 : 0;
 		Vec4<int> scissor_mask = Vec4<int>(0, rowMaxX - rowMinX - SCREEN_SCALE_FACTOR, scissorYPlus1, (rowMaxX - rowMinX - SCREEN_SCALE_FACTOR) | scissorYPlus1);
 		Vec4<int> scissor_step = Vec4<int>(0, -(SCREEN_SCALE_FACTOR * 2), 0, -(SCREEN_SCALE_FACTOR * 2));
+#if defined(_M_SSE) && !PPSSPP_ARCH(X86)
+		QuadPair pair;
+		int pairHalf = 0;
+#endif
 
 		for (int64_t curX = rowMinX; curX <= rowMaxX; curX += SCREEN_SCALE_FACTOR * 2,
 			w0 = e0.StepX(w0),
@@ -961,17 +1057,61 @@ void DrawTriangleSlice(
 			p.x = (p.x + 2) & 0x3FF) {
 
 			// If p is on or inside all edges, render pixel
-			Vec4<int> mask = MakeMask(w0, w1, w2, bias0, bias1, bias2, scissor_mask);
+			Vec4<int> mask;
+			Vec4<float> wsum_recip;
+			Vec4<int> z;
+#if defined(_M_SSE) && !PPSSPP_ARCH(X86)
+			if (useAVX2) {
+				// Every other quad, evaluate it and the next one together.
+				if (pairHalf == 0)
+					QuadPairAVX2(w0, w1, w2, e0.stepX, e1.stepX, e2.stepX, bias0, bias1, bias2, scissor_mask, scissor_step, v0, v1, v2, flatZ, &pair);
+				mask = pair.mask[pairHalf];
+				wsum_recip = pair.wsumRecip[pairHalf];
+				z = pair.z[pairHalf];
+				pairHalf ^= 1;
+			} else
+#endif
+			{
+				mask = MakeMask(w0, w1, w2, bias0, bias1, bias2, scissor_mask);
+			}
 			if (AnyMask<useSSE4>(mask)) {
-				Vec4<float> wsum_recip = EdgeRecip(w0, w1, w2);
+				if (depthBounds) {
+					// Quads are aligned to 2, so each is always within a single block.
+					const int bx = p.x / DepthBounds::BLOCK_SIZE;
+					const int by = p.y / DepthBounds::BLOCK_SIZE;
+					if (by != blockStatusRow) {
+						memset(blockStatus, BLOCK_UNKNOWN, sizeof(blockStatus));
+						blockStatusRow = by;
+					}
+					if (blockStatus[bx] == BLOCK_UNKNOWN) {
+						const int bx1 = std::max(bx * DepthBounds::BLOCK_SIZE, (int)primMin.x);
+						const int by1 = std::max(by * DepthBounds::BLOCK_SIZE, (int)primMin.y);
+						const int bx2 = std::min((bx + 1) * DepthBounds::BLOCK_SIZE - 1, (int)primMax.x);
+						const int by2 = std::min((by + 1) * DepthBounds::BLOCK_SIZE - 1, (int)primMax.y);
+						int zmin, zmax;
+						depthPlane.Range(bx1, by1, bx2, by2, &zmin, &zmax);
+						bool reject = zmin > zmax || depthBounds->Reject(bx, by, pixelID.DepthTestFunc(), zmin, zmax);
+						blockStatus[bx] = reject ? BLOCK_REJECT : BLOCK_KEEP;
+						blocksTested++;
+						if (reject)
+							blocksRejected++;
+					}
+					if (blockStatus[bx] == BLOCK_REJECT) {
+						quadsSkipped++;
+						continue;
+					}
+				}
 
-				Vec4<int> z;
-				if (flatZ) {
-					z = Vec4<int>::AssignToAll(v2.screenpos.z);
-				} else {
-					// Z is interpolated pretty much directly.
-					Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
-					z = (zfloats * wsum_recip).Cast<int>();
+				if (!useAVX2) {
+					wsum_recip = EdgeRecip(w0, w1, w2);
+
+					if (flatZ) {
+						z = Vec4<int>::AssignToAll(v2.screenpos.z);
+					} else {
+						// Z is interpolated pretty much directly.
+						Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
+						z = (zfloats * wsum_recip).Cast<int>();
+					}
 				}
 
 				if (pixelID.earlyZChecks) {
@@ -1075,6 +1215,7 @@ void DrawTriangleSlice(
 					subp.y = p.y + (i / 2);
 
 					state.drawPixel(subp.x, subp.y, z[i], fog[i], ToVec4IntArg(prim_color[i]), pixelID);
+					pixelsShaded++;
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED)
 					uint32_t row = gstate.getFrameBufAddress() + subp.y * pixelID.cached.framebufStride * bpp;
@@ -1089,6 +1230,10 @@ void DrawTriangleSlice(
 		}
 	}
 
+	if (depthBounds && coreCollectDebugStats)
+		depthBounds->AddStats(blocksTested, blocksRejected, quadsSkipped);
+	AddPixelsShadedStat(pixelsShaded);
+
 #if !defined(SOFTGPU_MEMORY_TAGGING_DETAILED) && defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 	for (int y = minY; y <= maxY; y += SCREEN_SCALE_FACTOR) {
 		DrawingCoords p = TransformUnit::ScreenToDrawing(minX, y);
@@ -1109,8 +1254,12 @@ void DrawTriangle(const VertexData &v0, const VertexData &v1, const VertexData &
 	PROFILE_THIS_SCOPE("draw_tri");
 
 	auto drawSlice = cpu_info.bSSE4_1 ?
-		(state.pixelID.clearMode ? &DrawTriangleSlice<true, true> : &DrawTriangleSlice<false, true>) :
-		(state.pixelID.clearMode ? &DrawTriangleSlice<true, false> : &DrawTriangleSlice<false, false>);
+		(state.pixelID.clearMode ? &DrawTriangleSlice<true, true, false> : &DrawTriangleSlice<false, true, false>) :
+		(state.pixelID.clearMode ? &DrawTriangleSlice<true, false, false> : &DrawTriangleSlice<false, false, false>);
+#if defined(_M_SSE) && !PPSSPP_ARCH(X86)
+	if (cpu_info.bAVX2 && cpu_info.bSSE4_1)
+		drawSlice = state.pixelID.clearMode ? &DrawTriangleSlice<true, true, true> : &DrawTriangleSlice<false, true, true>;
+#endif
 
 	drawSlice(v0, v1, v2, range.x1, range.y1, range.x2, range.y2, state);
 }
@@ -1210,6 +1359,8 @@ void DrawRectangle(const VertexData &v0, const VertexData &v1, const BinCoords &
 	std::string ztag = StringFromFormat("DisplayListRZ_%08x", state.listPC);
 #endif
 
+	int64_t pixelsShaded = 0;
+
 	for (int64_t curY = minY; curY < maxY; curY += SCREEN_SCALE_FACTOR * 2, rowST += sty) {
 		DrawingCoords p = TransformUnit::ScreenToDrawing(minX, curY);
 
@@ -1275,6 +1426,7 @@ void DrawRectangle(const VertexData &v0, const VertexData &v1, const BinCoords &
 				subp.y = p.y + (i / 2);
 
 				state.drawPixel(subp.x, subp.y, z[i], fog[i], ToVec4IntArg(prim_color[i]), state.pixelID);
+				pixelsShaded++;
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED)
 				uint32_t row = gstate.getFrameBufAddress() + subp.y * state.pixelID.cached.framebufStride * bpp;
@@ -1287,6 +1439,7 @@ void DrawRectangle(const VertexData &v0, const VertexData &v1, const BinCoords &
 			}
 		}
 	}
+	AddPixelsShadedStat(pixelsShaded);
 
 #if !defined(SOFTGPU_MEMORY_TAGGING_DETAILED) && defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 	for (int y = minY; y <= maxY; y += SCREEN_SCALE_FACTOR) {
@@ -1356,6 +1509,7 @@ void DrawPoint(const VertexData &v0, const BinCoords &range, const RasterizerSta
 
 	PROFILE_THIS_SCOPE("draw_px");
 	state.drawPixel(p.x, p.y, z, fog, ToVec4IntArg(prim_color), pixelID);
+	AddPixelsShadedStat(1);
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 	uint32_t bpp = pixelID.FBFormat() == GE_FORMAT_8888 ? 4 : 2;
@@ -1397,6 +1551,7 @@ void ClearRectangle(const VertexData &v0, const VertexData &v1, const BinCoords
 	const int w = pend.x - pprime.x + 1;
 	if (w <= 0)
 		return;
+	AddPixelsShadedStat((int64_t)w * (pend.y - pprime.y + 1));
 
 	if (pixelID.DepthClear()) {
 		const u16 z = v1.screenpos.z;
@@ -1417,6 +1572,8 @@ void ClearRectangle(const VertexData &v0, const VertexData &v1, const BinCoords
 				}
 			}
 		}
+		if (state.depthBounds && state.depthBounds->Enabled())
+			state.depthBounds->Fill(pprime.x, pprime.y, pend.x, pend.y, z);
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 		std::string tag = StringFromFormat("DisplayListXZ_%08x", state.listPC);
@@ -1603,6 +1760,8 @@ void DrawLine(const VertexData &v0, const VertexData &v1, const BinCoords &range
 	std::string ztag = StringFromFormat("DisplayListLZ_%08x", state.listPC);
 #endif
 
+	int64_t pixelsShaded = 0;
+
 	double x = a.x > b.x ? a.x - 1 : a.x;
 	double y = a.y > b.y ? a.y - 1 : a.y;
 	double z = a.z;
@@ -1695,6 +1854,7 @@ void DrawLine(const VertexData &v0, const VertexData &v1, const BinCoords &range
 
 			PROFILE_THIS_SCOPE("draw_px");
 			state.drawPixel(p.x, p.y, z, fog, ToVec4IntArg(prim_color), pixelID);
+			pixelsShaded++;
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 			uint32_t bpp = pixelID.FBFormat() == GE_FORMAT_8888 ? 4 : 2;
@@ -1712,6 +1872,7 @@ void DrawLine(const VertexData &v0, const VertexData &v1, const BinCoords &range
 		y += yinc;
 		z += zinc;
 	}
+	AddPixelsShadedStat(pixelsShaded);
 }
 
 bool GetCurrentTexture(GPUDebugBuffer &buffer, int level)
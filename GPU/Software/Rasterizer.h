@@ -34,6 +34,8 @@ class BinManager;
 
 namespace Rasterizer {
 
+class DepthBounds;
+
 enum class RasterizerStateFlags {
 	NONE = 0,
 	VERTEX_NON_FULL_WHITE = 0x0001,
@@ -77,6 +79,8 @@ struct RasterizerState {
 	float textureLodSlope;
 	RasterizerStateFlags flags = RasterizerStateFlags::NONE;
 	RasterizerStateFlags lastFlags = RasterizerStateFlags::INVALID;
+	// Null if depth blocks aren't tracked for the current depth buffer.
+	DepthBounds *depthBounds = nullptr;
 
 	struct {
 		uint8_t maxTexLevel : 3;
@@ -90,6 +94,8 @@ struct RasterizerState {
 		bool magFilt : 1;
 		bool antialiasLines : 1;
 		bool textureProj : 1;
+		// Set when texptr points at pre-decoded RGBA8888 data from SoftTextureCache.
+		bool textureCached : 1;
 	};
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
@@ -116,4 +122,8 @@ void ClearRectangle(const VertexData &v0, const VertexData &v1, const BinCoords
 
 bool GetCurrentTexture(GPUDebugBuffer &buffer, int level);
 
+// Pixels drawn by all threads, only counted when collecting debug stats.
+void AddPixelsShadedStat(int64_t count);
+int64_t TakePixelsShadedStat();
+
 }  // namespace Rasterizer
@@ -390,6 +390,7 @@ void DrawSprite(const VertexData &v0, const VertexData &v1, const BinCoords &ran
 			t_start += (scissorTL.y - pos0.y) * dt;
 			pos0.y = scissorTL.y;
 		}
+		AddPixelsShadedStat((int64_t)std::max(pos1.x - pos0.x, 0) * std::max(pos1.y - pos0.y, 0));
 
 		if (UseDrawSinglePixel(pixelID) && (samplerID.TexFunc() == GE_TEXFUNC_MODULATE || samplerID.TexFunc() == GE_TEXFUNC_REPLACE) && samplerID.useTextureAlpha) {
 			if (isWhite || samplerID.TexFunc() == GE_TEXFUNC_REPLACE) {
@@ -443,6 +444,7 @@ void DrawSprite(const VertexData &v0, const VertexData &v1, const BinCoords &ran
 		if (pos1.y > scissorBR.y) pos1.y = scissorBR.y + 1;
 		if (pos0.x < scissorTL.x) pos0.x = scissorTL.x;
 		if (pos0.y < scissorTL.y) pos0.y = scissorTL.y;
+		AddPixelsShadedStat((int64_t)std::max(pos1.x - pos0.x, 0) * std::max(pos1.y - pos0.y, 0));
 		if (UseDrawSinglePixel(pixelID)) {
 			if (pixelID.alphaBlend)
 				DrawSpriteNoTex<true>(pos0, pos1, v1.color0, state);
@@ -21,6 +21,7 @@
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/LogReporting.h"
+#include "Common/MemoryUtil.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "GPU/Common/TextureDecoder.h"
@@ -67,6 +68,14 @@ void Shutdown() {
 	jitCache = nullptr;
 }
 
+std::vector<SamplerID> GetSeenJitIDs() {
+	return jitCache->SeenIDs();
+}
+
+void PrecompileJit(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel) {
+	jitCache->Precompile(ids, cancel);
+}
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (!jitCache->IsInSpace(ptr)) {
 		return false;
@@ -170,8 +179,37 @@ void SamplerJitCache::Flush() {
 	compileQueue_.clear();
 }
 
+void SamplerJitCache::Precompile(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return;
+
+	for (const SamplerID &id : ids) {
+		if (cancel)
+			break;
+
+		std::unique_lock<std::mutex> guard(jitCacheLock);
+		size_t key = std::hash<SamplerID>()(id);
+		if (cache_.Get(key))
+			continue;
+
+		// Same as pixel funcs, draw threads may be using this block so we can't clear or reprotect it.
+		if (PlatformIsWXExclusive() || GetSpaceLeft() < 16384 * 2) {
+			compileQueue_.insert(id);
+			continue;
+		}
+		Compile(id);
+	}
+}
+
+std::vector<SamplerID> SamplerJitCache::SeenIDs() {
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	return std::vector<SamplerID>(seen_.begin(), seen_.end());
+}
+
 NearestFunc SamplerJitCache::GetByID(const SamplerID &id, size_t key, BinManager *binner) {
 	std::unique_lock<std::mutex> guard(jitCacheLock);
+	// Like pixel funcs, only count precompiled funcs once they're used.
+	seen_.insert(id);
 	auto it = cache_.Get(key);
 	if (it != nullptr)
 		return it;
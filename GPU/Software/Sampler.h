@@ -19,8 +19,10 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "Common/Data/Collections/Hashmaps.h"
 #include "GPU/Math3D.h"
 #include "GPU/Software/FuncId.h"
@@ -50,6 +52,10 @@ void Init();
 void FlushJit();
 void Shutdown();
 
+// IDs compiled so far, so they can be saved and precompiled next run.
+std::vector<SamplerID> GetSeenJitIDs();
+void PrecompileJit(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel);
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name);
 
 class SamplerJitCache : public Rasterizer::CodeBlock {
@@ -63,6 +69,10 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	void Clear() override;
 	void Flush();
 
+	// Compiles any missing funcs, locking per func so drawing isn't held up for long.
+	void Precompile(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel);
+	std::vector<SamplerID> SeenIDs();
+
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
 private:
@@ -147,6 +157,8 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	DenseHashMap<size_t, NearestFunc, nullptr> cache_;
 	std::unordered_map<SamplerID, const u8 *> addresses_;
 	std::unordered_set<SamplerID> compileQueue_;
+	// Unlike addresses_, this survives Clear().
+	std::unordered_set<SamplerID> seen_;
 	int clearGen_ = 0;
 	static thread_local LastCache lastFetch_;
 	static thread_local LastCache lastNearest_;
@@ -15,7 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <functional>
 #include <set>
+#include <unordered_set>
 #include "Common/System/Display.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
 
@@ -25,9 +27,15 @@
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/GraphicsContext.h"
 #include "Common/LogReporting.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/Waitable.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
+#include "Core/System.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/MemMap.h"
 #include "Core/MemMapHelpers.h"
@@ -432,6 +440,7 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 
 	Rasterizer::Init();
 	Sampler::Init();
+	LoadJitCache();
 	drawEngine_ = new SoftwareDrawEngine();
 	if (!drawEngine_)
 		return;
@@ -483,10 +492,185 @@ SoftGPU::~SoftGPU() {
 	delete presentation_;
 	delete drawEngine_;
 
+	// Stop any precompiling before saving, we don't want to wait for the whole list.
+	jitPrecompileCancel_ = true;
+	for (LimitedWaitable *waitable : jitPrecompileWaits_) {
+		waitable->Wait();
+		delete waitable;
+	}
+	jitPrecompileWaits_.clear();
+	SaveJitCache();
+
 	Sampler::Shutdown();
 	Rasterizer::Shutdown();
 }
 
+// Change the version if the meaning of PixelFuncID or SamplerID key bits change.
+static const uint32_t SOFTJIT_CACHE_MAGIC = 0x4A544653;  // SFTJ
+static const uint32_t SOFTJIT_CACHE_VERSION = 1;
+// The shared list is precompiled for every game in AOT mode, so keep it bounded.
+static const size_t SOFTJIT_COMMON_MAX_IDS = 2048;
+static const uint32_t SOFTJIT_FILE_MAX_IDS = 65536;
+
+struct SoftJitCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numPixelIDs;
+	uint32_t numSamplerIDs;
+};
+
+class SoftJitPrecompileTask : public Task {
+public:
+	SoftJitPrecompileTask(std::function<void()> func, LimitedWaitable *waitable) : func_(func), waitable_(waitable) {}
+
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	void Run() override {
+		func_();
+		waitable_->Notify();
+	}
+
+private:
+	std::function<void()> func_;
+	LimitedWaitable *waitable_;
+};
+
+static Path SoftJitCommonCachePath() {
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / "common.softjitcache";
+}
+
+// Appends any IDs not already present.  Returns false if the file was missing or unusable.
+static bool ReadSoftJitCache(const Path &filename, std::vector<PixelFuncID> &pixelIDs, std::vector<SamplerID> &samplerIDs) {
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return false;
+
+	SoftJitCacheHeader header{};
+	bool result = fread(&header, sizeof(header), 1, f) == 1;
+	result = result && header.magic == SOFTJIT_CACHE_MAGIC && header.version == SOFTJIT_CACHE_VERSION;
+	result = result && header.numPixelIDs <= SOFTJIT_FILE_MAX_IDS && header.numSamplerIDs <= SOFTJIT_FILE_MAX_IDS;
+
+	std::vector<uint64_t> pixelKeys(result ? header.numPixelIDs : 0);
+	std::vector<uint32_t> samplerKeys(result ? header.numSamplerIDs : 0);
+	if (result && !pixelKeys.empty())
+		result = fread(&pixelKeys[0], sizeof(uint64_t), pixelKeys.size(), f) == pixelKeys.size();
+	if (result && !samplerKeys.empty())
+		result = fread(&samplerKeys[0], sizeof(uint32_t), samplerKeys.size(), f) == samplerKeys.size();
+	fclose(f);
+
+	if (!result) {
+		WARN_LOG(G3D, "Incompatible software renderer jit cache %s, ignoring", filename.c_str());
+		return false;
+	}
+
+	std::unordered_set<PixelFuncID> knownPixelIDs(pixelIDs.begin(), pixelIDs.end());
+	for (uint64_t key : pixelKeys) {
+		PixelFuncID id;
+		memset(&id, 0, sizeof(id));
+		id.fullKey = key;
+		// Compiling an invalid ID would assert, so skip anything corrupt.
+		if (knownPixelIDs.count(id) || startsWith(DescribePixelFuncID(id), "INVALID"))
+			continue;
+		knownPixelIDs.insert(id);
+		pixelIDs.push_back(id);
+	}
+
+	std::unordered_set<SamplerID> knownSamplerIDs(samplerIDs.begin(), samplerIDs.end());
+	for (uint32_t key : samplerKeys) {
+		SamplerID id;
+		id.fullKey = key;
+		if (knownSamplerIDs.count(id) || startsWith(DescribeSamplerID(id), "INVALID"))
+			continue;
+		knownSamplerIDs.insert(id);
+		samplerIDs.push_back(id);
+	}
+	return true;
+}
+
+static void WriteSoftJitCache(const Path &filename, const std::vector<PixelFuncID> &pixelIDs, const std::vector<SamplerID> &samplerIDs) {
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return;
+
+	SoftJitCacheHeader header{ SOFTJIT_CACHE_MAGIC, SOFTJIT_CACHE_VERSION, (uint32_t)pixelIDs.size(), (uint32_t)samplerIDs.size() };
+	fwrite(&header, sizeof(header), 1, f);
+	for (const PixelFuncID &id : pixelIDs)
+		fwrite(&id.fullKey, sizeof(id.fullKey), 1, f);
+	for (const SamplerID &id : samplerIDs)
+		fwrite(&id.fullKey, sizeof(id.fullKey), 1, f);
+	fclose(f);
+}
+
+void SoftGPU::LoadJitCache() {
+	if (!g_Config.bSoftwareRenderingJit || !g_Config.bShaderCache)
+		return;
+
+	// The game's own IDs go first, so they're ready soonest.
+	std::vector<PixelFuncID> pixelIDs;
+	std::vector<SamplerID> samplerIDs;
+	std::string discID = g_paramSFO.GetDiscID();
+	if (!discID.empty()) {
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		jitCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".softjitcache");
+		ReadSoftJitCache(jitCachePath_, pixelIDs, samplerIDs);
+	}
+	if (g_Config.bSoftwareRenderingJitAOT)
+		ReadSoftJitCache(SoftJitCommonCachePath(), pixelIDs, samplerIDs);
+
+	INFO_LOG(G3D, "Precompiling %d pixel and %d sampler funcs", (int)pixelIDs.size(), (int)samplerIDs.size());
+
+	// The two caches have separate locks, so they can compile in parallel.
+	if (!pixelIDs.empty()) {
+		LimitedWaitable *waitable = new LimitedWaitable();
+		jitPrecompileWaits_.push_back(waitable);
+		g_threadManager.EnqueueTask(new SoftJitPrecompileTask([this, pixelIDs]() {
+			Rasterizer::PrecompileJit(pixelIDs, jitPrecompileCancel_);
+		}, waitable));
+	}
+	if (!samplerIDs.empty()) {
+		LimitedWaitable *waitable = new LimitedWaitable();
+		jitPrecompileWaits_.push_back(waitable);
+		g_threadManager.EnqueueTask(new SoftJitPrecompileTask([this, samplerIDs]() {
+			Sampler::PrecompileJit(samplerIDs, jitPrecompileCancel_);
+		}, waitable));
+	}
+}
+
+void SoftGPU::SaveJitCache() {
+	if (!g_Config.bSoftwareRenderingJit || !g_Config.bShaderCache)
+		return;
+
+	// Only what was actually drawn with, precompiled IDs that went unused are dropped.
+	std::vector<PixelFuncID> pixelIDs = Rasterizer::GetSeenJitIDs();
+	std::vector<SamplerID> samplerIDs = Sampler::GetSeenJitIDs();
+	if (pixelIDs.empty() && samplerIDs.empty())
+		return;
+
+	if (!jitCachePath_.empty())
+		WriteSoftJitCache(jitCachePath_, pixelIDs, samplerIDs);
+
+	// Also merge into the shared list used for AOT mode, which is first come first served.
+	std::vector<PixelFuncID> commonPixelIDs;
+	std::vector<SamplerID> commonSamplerIDs;
+	Path commonPath = SoftJitCommonCachePath();
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+	ReadSoftJitCache(commonPath, commonPixelIDs, commonSamplerIDs);
+
+	std::unordered_set<PixelFuncID> commonPixelSet(commonPixelIDs.begin(), commonPixelIDs.end());
+	for (const PixelFuncID &id : pixelIDs) {
+		if (commonPixelIDs.size() < SOFTJIT_COMMON_MAX_IDS && commonPixelSet.insert(id).second)
+			commonPixelIDs.push_back(id);
+	}
+	std::unordered_set<SamplerID> commonSamplerSet(commonSamplerIDs.begin(), commonSamplerIDs.end());
+	for (const SamplerID &id : samplerIDs) {
+		if (commonSamplerIDs.size() < SOFTJIT_COMMON_MAX_IDS && commonSamplerSet.insert(id).second)
+			commonSamplerIDs.push_back(id);
+	}
+	WriteSoftJitCache(commonPath, commonPixelIDs, commonSamplerIDs);
+}
+
 void SoftGPU::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
 	// Seems like this can point into RAM, but should be VRAM if not in RAM.
 	displayFramebuf_ = (framebuf & 0xFF000000) == 0 ? 0x44000000 | framebuf : framebuf;
@@ -816,6 +1000,7 @@ void SoftGPU::Execute_BlockTransferStart(u32 op, u32 diff) {
 	}
 
 	DoBlockTransfer(gstate_c.skipDrawReason);
+	drawEngine_->transformUnit.InvalidateMemory(dst, dstSize + width * bpp);
 
 	// Could theoretically dirty the framebuffer.
 	MarkDirty(dst, dstSize, SoftGPUVRAMDirty::DIRTY | SoftGPUVRAMDirty::REALLY_DIRTY);
@@ -850,6 +1035,8 @@ void SoftGPU::Execute_Prim(u32 op, u32 diff) {
 	drawEngine_->transformUnit.SetDirty(dirtyFlags_);
 	drawEngine_->transformUnit.SubmitPrimitive(verts, indices, prim, count, gstate.vertType, &bytesRead, drawEngine_);
 	dirtyFlags_ = drawEngine_->transformUnit.GetDirty();
+	gpuStats.numDrawCalls++;
+	gpuStats.numVertsSubmitted += count;
 
 	SoftGPUVRAMDirty mark = (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) != 0 ? SoftGPUVRAMDirty::DIRTY : SoftGPUVRAMDirty::DIRTY | SoftGPUVRAMDirty::REALLY_DIRTY;
 	MarkDirty(gstate.getFrameBufAddress(), gstate.FrameBufStride(), gstate.getRegionY2() + 1, gstate.FrameBufFormat(), mark);
@@ -903,6 +1090,8 @@ void SoftGPU::Execute_Bezier(u32 op, u32 diff) {
 	drawEngine_->transformUnit.SetDirty(dirtyFlags_);
 	drawEngineCommon_->SubmitCurve(control_points, indices, surface, gstate.vertType, &bytesRead, "bezier");
 	dirtyFlags_ = drawEngine_->transformUnit.GetDirty();
+	gpuStats.numDrawCalls++;
+	gpuStats.numVertsSubmitted += surface.num_points_u * surface.num_points_v;
 
 	SoftGPUVRAMDirty mark = (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) != 0 ? SoftGPUVRAMDirty::DIRTY : SoftGPUVRAMDirty::DIRTY | SoftGPUVRAMDirty::REALLY_DIRTY;
 	MarkDirty(gstate.getFrameBufAddress(), gstate.FrameBufStride(), gstate.getRegionY2() + 1, gstate.FrameBufFormat(), mark);
@@ -957,6 +1146,8 @@ void SoftGPU::Execute_Spline(u32 op, u32 diff) {
 	drawEngine_->transformUnit.SetDirty(dirtyFlags_);
 	drawEngineCommon_->SubmitCurve(control_points, indices, surface, gstate.vertType, &bytesRead, "spline");
 	dirtyFlags_ = drawEngine_->transformUnit.GetDirty();
+	gpuStats.numDrawCalls++;
+	gpuStats.numVertsSubmitted += surface.num_points_u * surface.num_points_v;
 
 	SoftGPUVRAMDirty mark = (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) != 0 ? SoftGPUVRAMDirty::DIRTY : SoftGPUVRAMDirty::DIRTY | SoftGPUVRAMDirty::REALLY_DIRTY;
 	MarkDirty(gstate.getFrameBufAddress(), gstate.FrameBufStride(), gstate.getRegionY2() + 1, gstate.FrameBufFormat(), mark);
@@ -1246,11 +1437,18 @@ u32 SoftGPU::DrawSync(int mode) {
 
 void SoftGPU::GetStats(char *buffer, size_t bufsize) {
 	drawEngine_->transformUnit.GetStats(buffer, bufsize);
+
+	size_t len = strlen(buffer);
+	if (g_Config.bVertexCache && len + 1 < bufsize) {
+		buffer[len++] = '\n';
+		drawEngine_->GetDecodedVertexCache().GetStats(buffer + len, bufsize - len);
+	}
 }
 
 void SoftGPU::InvalidateCache(u32 addr, int size, GPUInvalidationType type)
 {
-	// Nothing to invalidate.
+	// Only matters if we've kept any decoded textures.
+	drawEngine_->transformUnit.InvalidateMemory(addr, size);
 }
 
 void SoftGPU::PerformWriteFormattedFromMemory(u32 addr, int size, int width, GEBufferFormat format)
@@ -17,10 +17,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include "GPU/GPUCommon.h"
 #include "GPU/Common/GPUDebugInterface.h"
+#include "Common/File/Path.h"
 #include "Common/GPU/thin3d.h"
+#include "GPU/Software/FuncId.h"
+
+class LimitedWaitable;
 
 struct FormatBuffer {
 	FormatBuffer() { data = nullptr; }
@@ -217,6 +222,9 @@ class SoftGPU : public GPUCommon {
 	bool ClearDirty(uint32_t addr, uint32_t stride, uint32_t height, GEBufferFormat fmt, SoftGPUVRAMDirty value);
 	bool ClearDirty(uint32_t addr, uint32_t bytes, SoftGPUVRAMDirty value);
 
+	void LoadJitCache();
+	void SaveJitCache();
+
 	uint8_t vramDirty_[2048];
 	uint32_t lastDirtyAddr_ = 0;
 	uint32_t lastDirtySize_ = 0;
@@ -232,6 +240,10 @@ class SoftGPU : public GPUCommon {
 
 	Draw::Texture *fbTex = nullptr;
 	std::vector<u32> fbTexBuffer_;
+
+	Path jitCachePath_;
+	std::vector<LimitedWaitable *> jitPrecompileWaits_;
+	std::atomic<bool> jitPrecompileCancel_{};
 };
 
 // TODO: These shouldn't be global.
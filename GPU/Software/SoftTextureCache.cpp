@@ -0,0 +1,320 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "ext/xxhash.h"
+#include "Core/Config.h"
+#include "Core/ConfigValues.h"
+#include "Core/MemMap.h"
+#include "GPU/GPU.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "GPU/Software/Rasterizer.h"
+#include "GPU/Software/Sampler.h"
+#include "GPU/Software/SoftTextureCache.h"
+
+using namespace Rasterizer;
+
+// Decoded textures are 4 bytes per texel, so this is about 64 textures at 512x512.
+static constexpr size_t MAX_CACHE_BYTES = 64 * 1024 * 1024;
+// Sampling wraps and clamps at 512 texels, so larger sizes wouldn't decode the same.
+static constexpr int MAX_TEXTURE_SIZE = 512;
+
+static inline uint32_t NormalizeAddress(uint32_t addr) {
+	// Ignore mirrors, same as pending writes.
+	if (Memory::IsVRAMAddress(addr))
+		return addr & 0x041FFFFF;
+	return addr & 0x3FFFFFFF;
+}
+
+static inline int DecodedBufw(int w) {
+	// This is the standard bufw for 8888, which lets the sampler skip the bufw multiply.
+	return std::max(w, 4);
+}
+
+bool SoftTextureCache::Key::operator ==(const Key &other) const {
+	return memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+size_t SoftTextureCache::KeyHash::operator()(const Key &k) const {
+	return (size_t)XXH3_64bits(&k, sizeof(Key));
+}
+
+bool SoftTextureCache::Apply(RasterizerState *state, BinManager *binner, int frame) {
+	if (!state->enableTextures || state->textureCached)
+		return false;
+
+	const SamplerID &id = state->samplerID;
+	if (id.hasInvalidPtr)
+		return false;
+	// Already as cheap as it gets.
+	if (id.TexFmt() == GE_TFMT_8888 && !id.swizzle && id.useStandardBufw)
+		return false;
+	for (int i = 0; i <= state->maxTexLevel; ++i) {
+		if (id.cached.sizes[i].w > MAX_TEXTURE_SIZE || id.cached.sizes[i].h > MAX_TEXTURE_SIZE)
+			return false;
+	}
+
+	Entry *entries[8]{};
+	for (int i = 0; i <= state->maxTexLevel; ++i) {
+		entries[i] = Lookup(*state, i, binner, frame);
+		if (!entries[i])
+			return false;
+	}
+
+	SamplerID cachedID = id;
+	cachedID.texfmt = GE_TFMT_8888;
+	cachedID.clutfmt = 0;
+	cachedID.swizzle = false;
+	cachedID.useSharedClut = true;
+	cachedID.hasClutMask = false;
+	cachedID.hasClutShift = false;
+	cachedID.hasClutOffset = false;
+	cachedID.hasInvalidPtr = false;
+	cachedID.overReadSafe = true;
+	cachedID.useStandardBufw = true;
+	cachedID.cached.clutFormat = 0;
+
+	Sampler::LinearFunc linear = Sampler::GetLinearFunc(cachedID, binner);
+	Sampler::NearestFunc nearest = Sampler::GetNearestFunc(cachedID, binner);
+	if (!linear || !nearest)
+		return false;
+
+	// Since the definitions are the same, just force this setting using the func pointer.
+	if (g_Config.iTexFiltering == TEX_FILTER_FORCE_LINEAR) {
+		nearest = linear;
+	} else if (g_Config.iTexFiltering == TEX_FILTER_FORCE_NEAREST) {
+		linear = nearest;
+	}
+
+	state->samplerID = cachedID;
+	state->linear = linear;
+	state->nearest = nearest;
+
+	// We know every texel's alpha now, so this works like checking a CLUT.
+	bool alphaNonZero = true;
+	for (int i = 0; i <= state->maxTexLevel; ++i) {
+		state->texptr[i] = (const u8 *)entries[i]->data.get();
+		state->texbufw[i] = (uint16_t)DecodedBufw(cachedID.cached.sizes[i].w);
+		if (entries[i]->alphaNonFull)
+			state->flags |= RasterizerStateFlags::CLUT_ALPHA_NON_FULL;
+		alphaNonZero = alphaNonZero && entries[i]->alphaNonZero;
+	}
+	if (alphaNonZero)
+		state->flags |= RasterizerStateFlags::CLUT_ALPHA_NON_ZERO;
+	state->flags |= RasterizerStateFlags::CLUT_ALPHA_CHECKED;
+	state->textureCached = true;
+	return true;
+}
+
+SoftTextureCache::Entry *SoftTextureCache::Lookup(const RasterizerState &state, int level, BinManager *binner, int frame) {
+	const SamplerID &id = state.samplerID;
+	const GETextureFormat fmt = id.TexFmt();
+	const bool usesClut = (id.texfmt & 4) != 0;
+	const int w = id.cached.sizes[level].w;
+	const int h = id.cached.sizes[level].h;
+	const int bufw = state.texbufw[level];
+
+	// Swizzled and DXT textures are stored in blocks of rows, so include the whole last block.
+	int rows = h;
+	if (id.swizzle)
+		rows = (h + 7) & ~7;
+	else if (fmt >= GE_TFMT_DXT1)
+		rows = (h + 3) & ~3;
+	const uint32_t srcBytes = (bufw * textureBitsPerPixel[fmt] / 8) * rows;
+	if (!state.texptr[level] || srcBytes == 0 || !Memory::IsValidRange(state.texaddr[level], srcBytes))
+		return nullptr;
+
+	SamplerID keyID;
+	keyID.texfmt = id.texfmt;
+	keyID.swizzle = id.swizzle;
+	if (usesClut) {
+		keyID.clutfmt = id.clutfmt;
+		keyID.useSharedClut = id.useSharedClut;
+		keyID.hasClutMask = id.hasClutMask;
+		keyID.hasClutShift = id.hasClutShift;
+		keyID.hasClutOffset = id.hasClutOffset;
+	}
+
+	Key key{};
+	key.addr = NormalizeAddress(state.texaddr[level]);
+	key.bufw = (uint16_t)bufw;
+	key.w = (uint16_t)w;
+	key.h = (uint16_t)h;
+	// Only separate CLUTs per level decode differently by level.
+	key.level = usesClut && !id.useSharedClut ? (uint16_t)level : 0;
+	key.samplerKey = keyID.fullKey;
+	if (usesClut) {
+		key.clutFormat = id.cached.clutFormat;
+		key.clutHash = XXH3_64bits(id.cached.clut, 1024);
+	}
+
+	auto it = entries_.find(key);
+	if (it != entries_.end()) {
+		Entry &entry = it->second;
+		if (!entry.validated || entry.lastFrame != frame) {
+			uint64_t srcHash = XXH3_64bits(state.texptr[level], srcBytes);
+			if (srcHash != entry.srcHash) {
+				misses_++;
+				Retire(entry);
+				entry.srcHash = srcHash;
+				if (!Decode(entry, state, level, binner)) {
+					entries_.erase(it);
+					return nullptr;
+				}
+			} else {
+				hits_++;
+			}
+			entry.validated = true;
+		} else {
+			hits_++;
+		}
+		entry.lastFrame = frame;
+		return &entry;
+	}
+
+	misses_++;
+	Evict(frame);
+
+	Entry &entry = entries_[key];
+	entry.srcBytes = srcBytes;
+	entry.srcHash = XXH3_64bits(state.texptr[level], srcBytes);
+	if (!Decode(entry, state, level, binner)) {
+		entries_.erase(key);
+		return nullptr;
+	}
+	entry.validated = true;
+	entry.lastFrame = frame;
+	return &entry;
+}
+
+bool SoftTextureCache::Decode(Entry &entry, const RasterizerState &state, int level, BinManager *binner) {
+	const SamplerID &id = state.samplerID;
+	// This may need to compile, and if it fails we'll just skip the cache.
+	Sampler::FetchFunc fetch = Sampler::GetFetchFunc(id, binner);
+	if (!fetch)
+		return false;
+
+	const int w = id.cached.sizes[level].w;
+	const int h = id.cached.sizes[level].h;
+	const int bufw = DecodedBufw(w);
+	const u8 *src = state.texptr[level];
+	const int srcBufw = state.texbufw[level];
+
+	entry.data.reset(new uint32_t[bufw * h]());
+	entry.bytes = bufw * h * sizeof(uint32_t);
+	totalBytes_ += entry.bytes;
+	decodes_++;
+	gpuStats.numTexturesDecoded++;
+	gpuStats.numTextureDataBytesDecoded += (int)entry.bytes;
+
+	uint32_t alphaAnd = 0xFF;
+	uint32_t alphaMin = 0xFF;
+	uint32_t *row = entry.data.get();
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			uint32_t c = Vec4<int>(fetch(x, y, src, srcBufw, level, id)).ToRGBA();
+			uint32_t a = c >> 24;
+			alphaAnd &= a;
+			alphaMin = std::min(alphaMin, a);
+			row[x] = c;
+		}
+		row += bufw;
+	}
+
+	entry.alphaNonFull = alphaAnd != 0xFF;
+	entry.alphaNonZero = alphaMin != 0;
+	return true;
+}
+
+void SoftTextureCache::Retire(Entry &entry) {
+	if (!entry.data)
+		return;
+	totalBytes_ -= entry.bytes;
+	entry.bytes = 0;
+	retired_.push_back(std::move(entry.data));
+}
+
+void SoftTextureCache::Evict(int frame) {
+	while (totalBytes_ > MAX_CACHE_BYTES) {
+		// Never evict anything used this frame, since the current state may point at it.
+		auto oldest = entries_.end();
+		for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+			if (it->second.lastFrame == frame)
+				continue;
+			if (oldest == entries_.end() || it->second.lastFrame < oldest->second.lastFrame)
+				oldest = it;
+		}
+		if (oldest == entries_.end())
+			break;
+
+		Retire(oldest->second);
+		entries_.erase(oldest);
+		evictions_++;
+	}
+}
+
+bool SoftTextureCache::Invalidate(uint32_t addr, uint32_t bytes) {
+	if (entries_.empty())
+		return false;
+
+	const uint32_t start = NormalizeAddress(addr);
+	const uint32_t end = start + bytes;
+	bool found = false;
+	for (auto &it : entries_) {
+		const uint32_t entryStart = it.first.addr;
+		if (entryStart >= end || entryStart + it.second.srcBytes <= start)
+			continue;
+		it.second.validated = false;
+		found = true;
+	}
+	return found;
+}
+
+bool SoftTextureCache::InvalidateAll() {
+	for (auto &it : entries_)
+		it.second.validated = false;
+	return !entries_.empty();
+}
+
+void SoftTextureCache::Clear() {
+	for (auto &it : entries_)
+		Retire(it.second);
+	entries_.clear();
+}
+
+void SoftTextureCache::FreeRetired() {
+	retired_.clear();
+}
+
+void SoftTextureCache::GetStats(char *buffer, size_t bufsize) {
+	snprintf(buffer, bufsize,
+		"Texture cache: %d textures, %d KB\n"
+		"Texture cache hits: %d, misses %d, decodes %d, evictions %d",
+		(int)entries_.size(), (int)(totalBytes_ / 1024),
+		hits_, misses_, decodes_, evictions_);
+}
+
+void SoftTextureCache::ResetStats() {
+	hits_ = 0;
+	misses_ = 0;
+	decodes_ = 0;
+	evictions_ = 0;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Rasterizer {
+struct RasterizerState;
+}
+
+class BinManager;
+
+// Keeps textures decoded to plain RGBA8888, so the sampler can skip CLUT lookups, DXT block
+// decoding, and unswizzling on every texel.  Bilinear reads four texels per pixel, so this adds up.
+//
+// Entries are keyed by the texture address, format, size, and CLUT contents, and are checked
+// against a hash of the source data the first time they're used each frame, or after something
+// overlapping them was invalidated (dcache writebacks, block transfers, render targets, etc.)
+class SoftTextureCache {
+public:
+	// Points the state at decoded textures if possible, returns false if the state is unchanged.
+	// Must only be called when nothing pending will write to the texture.
+	bool Apply(Rasterizer::RasterizerState *state, BinManager *binner, int frame);
+
+	// Forces entries overlapping this range to be checked before their next use.
+	bool Invalidate(uint32_t addr, uint32_t bytes);
+	bool InvalidateAll();
+	// Drops all entries.  Their data is kept until FreeRetired(), since queued states may use it.
+	void Clear();
+
+	// Frees decoded data no longer used by any entry.  Only safe once nothing queued can sample it.
+	void FreeRetired();
+
+	void GetStats(char *buffer, size_t bufsize);
+	void ResetStats();
+
+private:
+	// Compared and hashed as raw bytes, so keep this free of implicit padding.
+	struct Key {
+		uint64_t clutHash;
+		uint32_t addr;
+		uint32_t samplerKey;
+		uint32_t clutFormat;
+		uint32_t pad;
+		uint16_t bufw;
+		uint16_t w;
+		uint16_t h;
+		uint16_t level;
+
+		bool operator ==(const Key &other) const;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &k) const;
+	};
+
+	struct Entry {
+		std::unique_ptr<uint32_t[]> data;
+		uint32_t bytes = 0;
+		uint32_t srcBytes = 0;
+		uint64_t srcHash = 0;
+		int lastFrame = -1;
+		bool validated = false;
+		bool alphaNonFull = false;
+		bool alphaNonZero = false;
+	};
+
+	Entry *Lookup(const Rasterizer::RasterizerState &state, int level, BinManager *binner, int frame);
+	bool Decode(Entry &entry, const Rasterizer::RasterizerState &state, int level, BinManager *binner);
+	void Retire(Entry &entry);
+	void Evict(int frame);
+
+	std::unordered_map<Key, Entry, KeyHash> entries_;
+	std::vector<std::unique_ptr<uint32_t[]>> retired_;
+	size_t totalBytes_ = 0;
+
+	int hits_ = 0;
+	int misses_ = 0;
+	int decodes_ = 0;
+	int evictions_ = 0;
+};
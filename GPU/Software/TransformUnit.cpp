@@ -17,12 +17,17 @@
 
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
 
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Config.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -341,28 +346,32 @@ void ComputeTransformState(TransformState *state, const VertexReader &vreader) {
 		state->roundToScreen = &ClipToScreenInternal<false, false>;
 }
 
-ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state) {
+ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state, bool updateLast) {
 	PROFILE_THIS_SCOPE("read_vert");
-	// If we ever thread this, we'll have to change this.
 	ClipVertexData vertex;
 
 	ModelCoords pos;
 	// VertexDecoder normally scales z, but we want it unscaled.
 	vreader.ReadPosThroughZ16(pos.AsArray());
 
+	// These carry over to later verts without UVs or normals.  Only updated on the emu thread.
 	static Vec3Packedf lastTC;
 	if (state.readUV) {
 		vreader.ReadUV(vertex.v.texturecoords.AsArray());
 		vertex.v.texturecoords.q() = 0.0f;
-		lastTC = vertex.v.texturecoords;
+		if (updateLast)
+			lastTC = vertex.v.texturecoords;
 	} else {
 		vertex.v.texturecoords = lastTC;
 	}
 
 	static Vec3f lastnormal;
-	if (vreader.hasNormal())
-		vreader.ReadNrm(lastnormal.AsArray());
 	Vec3f normal = lastnormal;
+	if (vreader.hasNormal()) {
+		vreader.ReadNrm(normal.AsArray());
+		if (updateLast)
+			lastnormal = normal;
+	}
 	if (state.negateNormals)
 		normal = -normal;
 
@@ -467,9 +476,66 @@ SoftDirty TransformUnit::GetDirty() {
 	return binner_->GetDirty();
 }
 
+// Below this, it's not worth waking up threads to transform verts.
+static constexpr int PARALLEL_TRANSFORM_MIN_VERTS = 512;
+static constexpr int PARALLEL_TRANSFORM_CHUNK = 128;
+
+// Runs a range of work in chunks, claimed by whichever thread gets to them first.
+// The submitting thread helps too, so threads stuck drawing bins can't stall it.
+class TransformChunksJob {
+public:
+	TransformChunksJob(const std::function<void(int, int)> &func, int count)
+		: func_(func), count_(count), numChunks_((count + PARALLEL_TRANSFORM_CHUNK - 1) / PARALLEL_TRANSFORM_CHUNK) {
+	}
+
+	void Work() {
+		int chunk;
+		while ((chunk = nextChunk_++) < numChunks_) {
+			int lower = chunk * PARALLEL_TRANSFORM_CHUNK;
+			func_(lower, std::min(lower + PARALLEL_TRANSFORM_CHUNK, count_));
+			doneChunks_++;
+		}
+	}
+
+	void Wait() {
+		// Only chunks already being worked on are left, so this is short.
+		while (doneChunks_ < numChunks_)
+			std::this_thread::yield();
+	}
+
+	int NumChunks() const {
+		return numChunks_;
+	}
+
+private:
+	std::function<void(int, int)> func_;
+	int count_;
+	int numChunks_;
+	std::atomic<int> nextChunk_{ 0 };
+	std::atomic<int> doneChunks_{ 0 };
+};
+
+class TransformChunksTask : public Task {
+public:
+	TransformChunksTask(const std::shared_ptr<TransformChunksJob> &job) : job_(job) {
+	}
+
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	void Run() override {
+		// If the emu thread already finished, this just drops the reference.
+		job_->Work();
+	}
+
+private:
+	std::shared_ptr<TransformChunksJob> job_;
+};
+
 class SoftwareVertexReader {
 public:
-	SoftwareVertexReader(u8 *base, VertexDecoder &vdecoder, u32 vertex_type, int vertex_count, const void *vertices, const void *indices, const TransformState &transformState, TransformUnit &transform)
+	SoftwareVertexReader(u8 *base, VertexDecoder &vdecoder, DecodedVertexCache &decodedCache, u32 vertex_type, int vertex_count, const void *vertices, const void *indices, const TransformState &transformState, TransformUnit &transform)
 	: vreader_(base, vdecoder.GetDecVtxFmt(), vertex_type), conv_(vertex_type, indices), transformState_(transformState), transform_(transform) {
 		useIndices_ = indices != nullptr;
 		lowerBound_ = 0;
@@ -477,12 +543,26 @@ class SoftwareVertexReader {
 
 		if (useIndices_)
 			GetIndexBounds(indices, vertex_count, vertex_type, &lowerBound_, &upperBound_);
-		if (vertex_count != 0)
-			vdecoder.DecodeVerts(base, vertices, lowerBound_, upperBound_);
+		if (vertex_count != 0) {
+			// If we've decoded these before, just read them from there.
+			const u8 *decoded = decodedCache.Decode(&vdecoder, vertices, lowerBound_, upperBound_, base);
+			if (decoded != base)
+				vreader_ = VertexReader(decoded, vdecoder.GetDecVtxFmt(), vertex_type);
+		}
 
 		// If we're only using a subset of verts, it's better to decode with random access (usually.)
 		// However, if we're reusing a lot of verts, we should read and cache them.
 		useCache_ = useIndices_ && vertex_count > (upperBound_ - lowerBound_ + 1);
+		// Large draws are transformed up front on threads, then assembled and clipped in order.
+		// Throughmode verts are too cheap to bother.  Like the cache, skip sparse indexed draws,
+		// since every vert in the index range gets transformed.
+		const int rangeVerts = upperBound_ - lowerBound_ + 1;
+		useThreads_ = !vreader_.isThrough() && rangeVerts >= PARALLEL_TRANSFORM_MIN_VERTS && vertex_count >= rangeVerts && g_threadManager.GetNumLooperThreads() > 1;
+		if (useThreads_) {
+			// To keep carried over UVs/normals right, we'll re-read the last vert the serial path would have.
+			lastRead_ = useIndices_ && !useCache_ ? conv_(vertex_count - 1) - lowerBound_ : upperBound_ - lowerBound_;
+			useCache_ = true;
+		}
 		if (useCache_ && cached_.size() < upperBound_ - lowerBound_ + 1)
 			cached_.resize(std::max(128, upperBound_ - lowerBound_ + 1));
 	}
@@ -499,6 +579,11 @@ class SoftwareVertexReader {
 		if (!useCache_)
 			return;
 
+		if (useThreads_) {
+			UpdateCacheThreaded();
+			return;
+		}
+
 		for (int i = 0; i < upperBound_ - lowerBound_ + 1; ++i) {
 			vreader_.Goto(i);
 			cached_[i] = transform_.ReadVertex(vreader_, transformState_);
@@ -511,6 +596,8 @@ class SoftwareVertexReader {
 				return cached_[conv_(vtx) - lowerBound_];
 			}
 			vreader_.Goto(conv_(vtx) - lowerBound_);
+		} else if (useCache_) {
+			return cached_[vtx];
 		} else {
 			vreader_.Goto(vtx);
 		}
@@ -519,6 +606,27 @@ class SoftwareVertexReader {
 	};
 
 protected:
+	void UpdateCacheThreaded() {
+		PROFILE_THIS_SCOPE("read_vert_mt");
+		auto readRange = [this](int lower, int upper) {
+			VertexReader vreader = vreader_;
+			for (int i = lower; i < upper; ++i) {
+				vreader.Goto(i);
+				cached_[i] = transform_.ReadVertex(vreader, transformState_, false);
+			}
+		};
+
+		auto job = std::make_shared<TransformChunksJob>(readRange, upperBound_ - lowerBound_ + 1);
+		int helpers = std::min(job->NumChunks() - 1, g_threadManager.GetNumLooperThreads() - 1);
+		for (int i = 0; i < helpers; ++i)
+			g_threadManager.EnqueueTask(new TransformChunksTask(job));
+		job->Work();
+		job->Wait();
+
+		vreader_.Goto(lastRead_);
+		transform_.ReadVertex(vreader_, transformState_);
+	}
+
 	VertexReader vreader_;
 	const IndexConverter conv_;
 	const TransformState &transformState_;
@@ -528,6 +636,8 @@ class SoftwareVertexReader {
 	static std::vector<ClipVertexData> cached_;
 	bool useIndices_ = false;
 	bool useCache_ = false;
+	bool useThreads_ = false;
+	int lastRead_ = 0;
 };
 
 // Static to reduce allocations mid-frame.
@@ -550,7 +660,7 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 		return;
 
 	static TransformState transformState;
-	SoftwareVertexReader vreader(decoded_, vdecoder, vertex_type, vertex_count, vertices, indices, transformState, *this);
+	SoftwareVertexReader vreader(decoded_, vdecoder, drawEngine->GetDecodedVertexCache(), vertex_type, vertex_count, vertices, indices, transformState, *this);
 
 	if (prim_type != GE_PRIM_KEEP_PREVIOUS) {
 		data_index_ = 0;
@@ -904,6 +1014,10 @@ void TransformUnit::NotifyClutUpdate(const void *src) {
 	binner_->UpdateClut(src);
 }
 
+void TransformUnit::InvalidateMemory(uint32_t addr, int size) {
+	binner_->InvalidateMemory(addr, size);
+}
+
 // TODO: This probably is not the best interface.
 // Also, we should try to merge this into the similar function in DrawEngineCommon.
 bool TransformUnit::GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices) {
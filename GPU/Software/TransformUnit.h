@@ -144,6 +144,7 @@ class TransformUnit {
 	void Flush(const char *reason);
 	void FlushIfOverlap(const char *reason, bool modifying, uint32_t addr, uint32_t stride, uint32_t w, uint32_t h);
 	void NotifyClutUpdate(const void *src);
+	void InvalidateMemory(uint32_t addr, int size);
 
 	void GetStats(char *buffer, size_t bufsize);
 
@@ -151,7 +152,8 @@ class TransformUnit {
 	SoftDirty GetDirty();
 
 private:
-	ClipVertexData ReadVertex(const VertexReader &vreader, const TransformState &state);
+	// Pass updateLast = false when reading off the emu thread.
+	ClipVertexData ReadVertex(const VertexReader &vreader, const TransformState &state, bool updateLast = true);
 	void SendTriangle(CullType cullType, const ClipVertexData *verts, int provoking = 2);
 
 	u8 *decoded_ = nullptr;
@@ -37,6 +37,7 @@
 #include "GPU/ge_constants.h"
 #include "GPU/GeDisasm.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Common/ShaderIdList.h"
 #include "GPU/Vulkan/ShaderManagerVulkan.h"
 #include "GPU/Vulkan/GPU_Vulkan.h"
 #include "GPU/Vulkan/FramebufferManagerVulkan.h"
@@ -94,6 +95,7 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkshadercache");
+		shaderIdListPath_ = ShaderIdListPath(discID);
 		shaderCacheLoaded_ = false;
 
 		std::thread th([&] {
@@ -123,8 +125,15 @@ void GPU_Vulkan::LoadCache(const Path &filename) {
 	PSP_SetLoading("Loading shader cache...");
 	// Actually precompiled by IsReady() since we're single-threaded.
 	FILE *f = File::OpenCFile(filename, "rb");
-	if (!f)
+	if (!f) {
+		// No pipeline cache yet, but we may still know which shaders the game uses.
+		ShaderIdList list;
+		if (list.Load(shaderIdListPath_)) {
+			int failCount = shaderManagerVulkan_->LoadShaders(list);
+			NOTICE_LOG(G3D, "Precompiled %d shaders from '%s' (failed %d)", (int)(list.vert.size() + list.frag.size() + list.geom.size()), shaderIdListPath_.c_str(), failCount);
+		}
 		return;
+	}
 
 	// First compile shaders to SPIR-V, then load the pipeline cache and recreate the pipelines.
 	// It's when recreating the pipelines that the pipeline cache is useful - in the ideal case,
@@ -179,6 +188,10 @@ void GPU_Vulkan::SaveCache(const Path &filename) {
 	pipelineManager_->SavePipelineCache(f, false, shaderManagerVulkan_, draw_);
 	INFO_LOG(G3D, "Saved Vulkan pipeline cache");
 	fclose(f);
+
+	ShaderIdList list;
+	shaderManagerVulkan_->GetShaderIdList(&list);
+	list.Save(shaderIdListPath_);
 }
 
 GPU_Vulkan::~GPU_Vulkan() {
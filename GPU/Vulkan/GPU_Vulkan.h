@@ -100,5 +100,6 @@ class GPU_Vulkan : public GPUCommon {
 	FrameData frameData_[VulkanContext::MAX_INFLIGHT_FRAMES]{};
 
 	Path shaderCachePath_;
+	Path shaderIdListPath_;
 	std::atomic<bool> shaderCacheLoaded_{};
 };
@@ -40,6 +40,7 @@
 #include "GPU/Common/FragmentShaderGenerator.h"
 #include "GPU/Common/VertexShaderGenerator.h"
 #include "GPU/Common/GeometryShaderGenerator.h"
+#include "GPU/Common/ShaderIdList.h"
 #include "GPU/Vulkan/ShaderManagerVulkan.h"
 #include "GPU/Vulkan/DrawEngineVulkan.h"
 #include "GPU/Vulkan/FramebufferManagerVulkan.h"
@@ -550,37 +551,62 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 	bool success = fread(&header, sizeof(header), 1, f) == 1;
 	// We don't need to validate magic/version again, done in LoadCacheFlags().
 
-	if (header.useFlags != gstate_c.GetUseFlags()) {
+	ShaderIdList list;
+	list.useFlags = header.useFlags;
+	for (int i = 0; i < header.numVertexShaders; i++) {
+		VShaderID id;
+		if (fread(&id, sizeof(id), 1, f) != 1) {
+			ERROR_LOG(G3D, "Vulkan shader cache truncated (in VertexShaders)");
+			return false;
+		}
+		list.vert.push_back(id);
+	}
+	for (int i = 0; i < header.numFragmentShaders; i++) {
+		FShaderID id;
+		if (fread(&id, sizeof(id), 1, f) != 1) {
+			ERROR_LOG(G3D, "Vulkan shader cache truncated (in FragmentShaders)");
+			return false;
+		}
+		list.frag.push_back(id);
+	}
+	for (int i = 0; i < header.numGeometryShaders; i++) {
+		GShaderID id;
+		if (fread(&id, sizeof(id), 1, f) != 1) {
+			ERROR_LOG(G3D, "Vulkan shader cache truncated (in GeometryShaders)");
+			return false;
+		}
+		list.geom.push_back(id);
+	}
+
+	int failCount = LoadShaders(list);
+	NOTICE_LOG(G3D, "ShaderCache: Loaded %d vertex, %d fragment shaders and %d geometry shaders (failed %d)", header.numVertexShaders, header.numFragmentShaders, header.numGeometryShaders, failCount);
+	return true;
+}
+
+int ShaderManagerVulkan::LoadShaders(const ShaderIdList &list) {
+	if (list.useFlags != gstate_c.GetUseFlags()) {
 		// This can simply be a result of sawExactEqualDepth_ having been flipped to true in the previous run.
 		// Let's just keep going.
-		WARN_LOG(G3D, "Shader cache useFlags mismatch, %08x, expected %08x", header.useFlags, gstate_c.GetUseFlags());
+		WARN_LOG(G3D, "Shader cache useFlags mismatch, %08x, expected %08x", list.useFlags, gstate_c.GetUseFlags());
 	} else {
 		// We're compiling shaders now, so they haven't changed anymore.
 		gstate_c.useFlagsChanged = false;
 	}
 
-	int failCount = 0;
+	// Generating the source is about as slow as compiling it, so do both on the worker threads.
+	ShaderIdListSources sources;
+	GenerateShaderIdListSources(list, compat_, draw_->GetBugs(), &sources);
+	if (sources.failed != 0) {
+		// We just ignore these and carry on.
+		WARN_LOG(G3D, "Failed to generate %d shaders during cache load", sources.failed);
+	}
 
 	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
-	for (int i = 0; i < header.numVertexShaders; i++) {
-		VShaderID id;
-		if (fread(&id, sizeof(id), 1, f) != 1) {
-			ERROR_LOG(G3D, "Vulkan shader cache truncated (in VertexShaders)");
-			return false;
-		}
-		bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
-		std::string genErrorString;
-		uint32_t attributeMask = 0;
-		uint64_t uniformMask = 0;
-		VertexShaderFlags flags;
-		if (!GenerateVertexShader(id, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &flags, &genErrorString)) {
-			WARN_LOG(G3D, "Failed to generate vertex shader during cache load");
-			// We just ignore this one and carry on.
-			failCount++;
+	for (size_t i = 0; i < list.vert.size(); i++) {
+		if (sources.vert[i].empty())
 			continue;
-		}
-		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
-		VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform);
+		const VShaderID &id = list.vert[i];
+		VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, sources.vertFlags[i], sources.vert[i].c_str(), id.Bit(VS_BIT_USE_HW_TRANSFORM));
 		// Remove first, just to be safe (we are loading on a background thread.)
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanVertexShader *old = vsCache_.Get(id);
@@ -590,25 +616,12 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		}
 		vsCache_.Insert(id, vs);
 	}
-	uint32_t vendorID = vulkan->GetPhysicalDeviceProperties().properties.vendorID;
 
-	for (int i = 0; i < header.numFragmentShaders; i++) {
-		FShaderID id;
-		if (fread(&id, sizeof(id), 1, f) != 1) {
-			ERROR_LOG(G3D, "Vulkan shader cache truncated (in FragmentShaders)");
-			return false;
-		}
-		std::string genErrorString;
-		uint64_t uniformMask = 0;
-		FragmentShaderFlags flags;
-		if (!GenerateFragmentShader(id, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &flags, &genErrorString)) {
-			WARN_LOG(G3D, "Failed to generate fragment shader during cache load");
-			// We just ignore this one and carry on.
-			failCount++;
+	for (size_t i = 0; i < list.frag.size(); i++) {
+		if (sources.frag[i].empty())
 			continue;
-		}
-		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
-		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_);
+		const FShaderID &id = list.frag[i];
+		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, sources.fragFlags[i], sources.frag[i].c_str());
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanFragmentShader *old = fsCache_.Get(id);
 		if (old) {
@@ -618,21 +631,11 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		fsCache_.Insert(id, fs);
 	}
 
-	for (int i = 0; i < header.numGeometryShaders; i++) {
-		GShaderID id;
-		if (fread(&id, sizeof(id), 1, f) != 1) {
-			ERROR_LOG(G3D, "Vulkan shader cache truncated (in GeometryShaders)");
-			return false;
-		}
-		std::string genErrorString;
-		if (!GenerateGeometryShader(id, codeBuffer_, compat_, draw_->GetBugs(), &genErrorString)) {
-			WARN_LOG(G3D, "Failed to generate geometry shader during cache load");
-			// We just ignore this one and carry on.
-			failCount++;
+	for (size_t i = 0; i < list.geom.size(); i++) {
+		if (sources.geom[i].empty())
 			continue;
-		}
-		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
-		VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_);
+		const GShaderID &id = list.geom[i];
+		VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, sources.geom[i].c_str());
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanGeometryShader *old = gsCache_.Get(id);
 		if (old) {
@@ -642,8 +645,21 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		gsCache_.Insert(id, gs);
 	}
 
-	NOTICE_LOG(G3D, "ShaderCache: Loaded %d vertex, %d fragment shaders and %d geometry shaders (failed %d)", header.numVertexShaders, header.numFragmentShaders, header.numGeometryShaders, failCount);
-	return true;
+	return sources.failed;
+}
+
+void ShaderManagerVulkan::GetShaderIdList(ShaderIdList *list) {
+	list->useFlags = gstate_c.GetUseFlags();
+	std::lock_guard<std::mutex> guard(cacheLock_);
+	vsCache_.Iterate([&](const VShaderID &id, VulkanVertexShader *vs) {
+		list->vert.push_back(id);
+	});
+	fsCache_.Iterate([&](const FShaderID &id, VulkanFragmentShader *fs) {
+		list->frag.push_back(id);
+	});
+	gsCache_.Iterate([&](const GShaderID &id, VulkanGeometryShader *gs) {
+		list->geom.push_back(id);
+	});
 }
 
 void ShaderManagerVulkan::SaveCache(FILE *f, DrawEngineVulkan *drawEngine) {
@@ -109,6 +109,8 @@ class VulkanGeometryShader {
 	GShaderID id_;
 };
 
+struct ShaderIdList;
+
 class ShaderManagerVulkan : public ShaderManagerCommon {
 public:
 	ShaderManagerVulkan(Draw::DrawContext *draw);
@@ -160,6 +162,10 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	bool LoadCache(FILE *f);
 	void SaveCache(FILE *f, DrawEngineVulkan *drawEngine);
 
+	// Generates the listed shaders on the worker threads and starts compiling them, returning how many failed.
+	int LoadShaders(const ShaderIdList &list);
+	void GetShaderIdList(ShaderIdList *list);
+
 private:
 	void Clear();
 
@@ -730,6 +730,16 @@ void TextureCacheVulkan::LoadVulkanTextureLevel(TexCacheEntry &entry, uint8_t *w
 		texDecFlags |= TexDecodeFlags::TO_CLUT8;
 	}
 
+	ScaledTextureKey scaledKey{};
+	const bool useScaledCache = scaleFactor > 1 && scaledCache_.IsOpen() && GetScaledTextureKey(entry, level, scaleFactor, texDecFlags, &scaledKey);
+	if (useScaledCache) {
+		CheckAlphaResult cachedAlpha;
+		if (scaledCache_.Find(scaledKey, writePtr, rowPitch, w * scaleFactor, h * scaleFactor, &cachedAlpha)) {
+			entry.SetAlphaStatus(cachedAlpha, level);
+			return;
+		}
+	}
+
 	if (scaleFactor > 1) {
 		tmpTexBufRearrange_.resize(std::max(bufw, w) * h);
 		pixelData = tmpTexBufRearrange_.data();
@@ -747,7 +757,9 @@ void TextureCacheVulkan::LoadVulkanTextureLevel(TexCacheEntry &entry, uint8_t *w
 		u32 fmt = dstFmt;
 		// CPU scaling reads from the destination buffer so we want cached RAM.
 		uint8_t *rearrange = (uint8_t *)AllocateAlignedMemory(w * scaleFactor * h * scaleFactor * 4, 16);
+		double scaleStart = time_now_d();
 		scaler_.ScaleAlways((u32 *)rearrange, pixelData, w, h, scaleFactor);
+		double scaleTime = time_now_d() - scaleStart;
 		pixelData = (u32 *)writePtr;
 
 		// We always end up at 8888.  Other parts assume this.
@@ -763,6 +775,9 @@ void TextureCacheVulkan::LoadVulkanTextureLevel(TexCacheEntry &entry, uint8_t *w
 		} else {
 			memcpy(writePtr, rearrange, w * h * 4);
 		}
+		if (useScaledCache) {
+			scaledCache_.Store(scaledKey, rearrange, w * 4, w, h, alphaResult, scaleTime);
+		}
 		FreeAlignedMemory(rearrange);
 	}
 }
@@ -0,0 +1,215 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+// ShaderTool
+//
+// Checks the shader ID lists (.shaderids) that the backends save next to their shader caches.
+// Every listed shader is generated for each GLSL variant and compiled to SPIR-V with glslang,
+// and the lists can be merged into one containing only the shaders that worked.  Put the result
+// in a fresh install's cache directory, and the backends will compile those shaders at startup
+// rather than on first draw.
+
+#include "ppsspp_config.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/File/Path.h"
+#include "Common/GPU/Shader.h"
+#include "Common/GPU/thin3d.h"
+#include "Common/GPU/Vulkan/VulkanContext.h"
+#include "Common/StringUtils.h"
+#include "Common/System/System.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/ShaderIdList.h"
+
+std::string System_GetProperty(SystemProperty prop) { return ""; }
+std::vector<std::string> System_GetPropertyStringVec(SystemProperty prop) { return std::vector<std::string>(); }
+int System_GetPropertyInt(SystemProperty prop) {
+	return -1;
+}
+float System_GetPropertyFloat(SystemProperty prop) {
+	return -1;
+}
+bool System_GetPropertyBool(SystemProperty prop) {
+	return false;
+}
+
+struct LanguageToCheck {
+	ShaderLanguage lang;
+	GLSLVariant variant;
+	const char *name;
+};
+
+static const LanguageToCheck languages[] = {
+	{ ShaderLanguage::GLSL_VULKAN, GLSLVariant::VULKAN, "GLSL_VULKAN" },
+	{ ShaderLanguage::GLSL_3xx, GLSLVariant::GLES300, "GLSL_3xx" },
+	{ ShaderLanguage::GLSL_1xx, GLSLVariant::GL140, "GLSL_1xx" },
+};
+
+// Per shader, over all languages.
+struct ShaderStatus {
+	std::vector<int> generated;
+	std::vector<char> compileFailed;
+
+	void Init(size_t count) {
+		generated.assign(count, 0);
+		compileFailed.assign(count, 0);
+	}
+	bool Keep(size_t i) const {
+		// Not every variant can be generated in every language, but an error compiling one is a bug.
+		return generated[i] != 0 && !compileFailed[i];
+	}
+};
+
+static int CompileAll(const std::vector<std::string> &codes, VkShaderStageFlagBits stage, const LanguageToCheck &language, ShaderStatus *status, bool verbose) {
+	std::vector<std::string> errors(codes.size());
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		std::vector<uint32_t> spirv;
+		for (int i = lower; i < upper; ++i) {
+			if (codes[i].empty())
+				continue;
+			status->generated[i]++;
+			if (!GLSLtoSPV(stage, codes[i].c_str(), language.variant, spirv, &errors[i])) {
+				status->compileFailed[i] = 1;
+				if (errors[i].empty())
+					errors[i] = "Unknown error";
+			} else {
+				errors[i].clear();
+			}
+		}
+	}, 0, (int)codes.size(), 4);
+
+	int failed = 0;
+	for (size_t i = 0; i < codes.size(); ++i) {
+		if (errors[i].empty())
+			continue;
+		failed++;
+		printf("Error compiling %s shader for %s:\n%s\n", stage == VK_SHADER_STAGE_VERTEX_BIT ? "vertex" : (stage == VK_SHADER_STAGE_FRAGMENT_BIT ? "fragment" : "geometry"), language.name, errors[i].c_str());
+		if (verbose)
+			printf("%s\n", LineNumberString(codes[i]).c_str());
+	}
+	return failed;
+}
+
+template <typename T>
+static void KeepValid(std::vector<T> &ids, const ShaderStatus &status) {
+	std::vector<T> valid;
+	for (size_t i = 0; i < ids.size(); ++i) {
+		if (status.Keep(i))
+			valid.push_back(ids[i]);
+	}
+	ids = valid;
+}
+
+static void PrintUsage() {
+	fprintf(stderr, "Usage: PPSSPPShaderTool [-v] [-o output.shaderids] input.shaderids...\n\n");
+	fprintf(stderr, "Generates and compiles every shader in the lists, and optionally merges\n");
+	fprintf(stderr, "the ones that work into a single list.\n\n");
+	fprintf(stderr, "  -o FILE   write the merged, checked list to FILE\n");
+	fprintf(stderr, "  -v        print the source of shaders that fail to compile\n");
+}
+
+int main(int argc, const char *argv[]) {
+	Path outputPath;
+	std::vector<Path> inputPaths;
+	bool verbose = false;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			outputPath = Path(argv[++i]);
+		} else if (!strcmp(argv[i], "-v")) {
+			verbose = true;
+		} else if (argv[i][0] == '-') {
+			PrintUsage();
+			return 1;
+		} else {
+			inputPaths.push_back(Path(argv[i]));
+		}
+	}
+	if (inputPaths.empty()) {
+		PrintUsage();
+		return 1;
+	}
+
+	ShaderIdList list;
+	int merged = 0;
+	for (const Path &path : inputPaths) {
+		ShaderIdList input;
+		if (!input.Load(path)) {
+			fprintf(stderr, "Could not read shader ID list '%s'\n", path.c_str());
+			return 1;
+		}
+		// The same IDs mean different shaders with other useFlags, so only merge lists that agree.
+		if (merged != 0 && input.useFlags != list.useFlags) {
+			fprintf(stderr, "Skipping '%s', useFlags %08x don't match %08x\n", path.c_str(), input.useFlags, list.useFlags);
+			continue;
+		}
+		if (merged == 0)
+			list.useFlags = input.useFlags;
+		list.Merge(input);
+		merged++;
+	}
+	printf("%d vertex, %d fragment and %d geometry shaders in %d lists\n", (int)list.vert.size(), (int)list.frag.size(), (int)list.geom.size(), merged);
+
+	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	init_glslang();
+
+	ShaderStatus vertStatus, fragStatus, geomStatus;
+	vertStatus.Init(list.vert.size());
+	fragStatus.Init(list.frag.size());
+	geomStatus.Init(list.geom.size());
+
+	Draw::Bugs bugs;
+	int compileFailed = 0;
+	for (const LanguageToCheck &language : languages) {
+		ShaderLanguageDesc compat(language.lang);
+		ShaderIdListSources sources;
+
+		double start = time_now_d();
+		GenerateShaderIdListSources(list, compat, bugs, &sources);
+		double generated = time_now_d();
+
+		int failed = CompileAll(sources.vert, VK_SHADER_STAGE_VERTEX_BIT, language, &vertStatus, verbose);
+		failed += CompileAll(sources.frag, VK_SHADER_STAGE_FRAGMENT_BIT, language, &fragStatus, verbose);
+		failed += CompileAll(sources.geom, VK_SHADER_STAGE_GEOMETRY_BIT, language, &geomStatus, verbose);
+		double compiled = time_now_d();
+
+		printf("%s: %d not generated, %d failed to compile (generated in %0.1f ms, compiled in %0.1f ms)\n", language.name, sources.failed, failed, (generated - start) * 1000.0, (compiled - generated) * 1000.0);
+		compileFailed += failed;
+	}
+
+	finalize_glslang();
+
+	if (!outputPath.empty()) {
+		KeepValid(list.vert, vertStatus);
+		KeepValid(list.frag, fragStatus);
+		KeepValid(list.geom, geomStatus);
+		if (!list.Save(outputPath)) {
+			fprintf(stderr, "Could not write '%s'\n", outputPath.c_str());
+			return 1;
+		}
+		printf("Wrote %d vertex, %d fragment and %d geometry shaders to '%s'\n", (int)list.vert.size(), (int)list.frag.size(), (int)list.geom.size(), outputPath.c_str());
+	}
+
+	g_threadManager.Teardown();
+	return compileFailed == 0 ? 0 : 2;
+}
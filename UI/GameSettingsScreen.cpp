@@ -516,6 +516,11 @@ void GameSettingsScreen::CreateViews() {
 		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling();
 	});
 
+	CheckBox *scalingDiskCache = graphicsSettings->Add(new CheckBox(&g_Config.bTexScalingDiskCache, gr->T("Cache upscaled textures on disk")));
+	scalingDiskCache->SetEnabledFunc([]() {
+		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling() && g_Config.iTexScalingLevel != 1;
+	});
+
 	ChoiceWithValueDisplay *textureShaderChoice = graphicsSettings->Add(new ChoiceWithValueDisplay(&g_Config.sTextureShaderName, gr->T("Texture Shader"), &TextureTranslateName));
 	textureShaderChoice->OnClick.Handle(this, &GameSettingsScreen::OnTextureShader);
 	textureShaderChoice->SetEnabledFunc([]() {
@@ -1010,6 +1015,7 @@ void GameSettingsScreen::CreateViews() {
 		systemSettings->Add(new CheckBox(&g_Config.bBypassOSKWithKeyboard, sy->T("Use system native keyboard")));
 
 	systemSettings->Add(new CheckBox(&g_Config.bCacheFullIsoInRam, sy->T("Cache ISO in RAM", "Cache full ISO in RAM")))->SetEnabled(!PSP_IsInited());
+	systemSettings->Add(new CheckBox(&g_Config.bDecryptedCache, sy->T("Cache decrypted game data on disk")))->SetEnabled(!PSP_IsInited());
 
 	systemSettings->Add(new ItemHeader(sy->T("Cheats", "Cheats")));
 	CheckBox *enableCheats = systemSettings->Add(new CheckBox(&g_Config.bEnableCheats, sy->T("Enable Cheats")));
@@ -1772,6 +1778,11 @@ void DeveloperToolsScreen::CreateViews() {
 		}
 		return true;
 	});
+	Choice *buildTexturePack = list->Add(new Choice(dev->T("Build textures.pack file for current game")));
+	buildTexturePack->OnClick.Handle(this, &DeveloperToolsScreen::OnBuildTexturePack);
+	buildTexturePack->SetEnabledFunc([] {
+		return PSP_IsInited();
+	});
 
 	Draw::DrawContext *draw = screenManager()->getDrawContext();
 
@@ -1888,6 +1899,11 @@ UI::EventReturn DeveloperToolsScreen::OnOpenTexturesIniFile(UI::EventParams &e)
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DeveloperToolsScreen::OnBuildTexturePack(UI::EventParams &e) {
+	TextureReplacer::BuildPackInBackground(g_paramSFO.GetDiscID());
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DeveloperToolsScreen::OnLogConfig(UI::EventParams &e) {
 	screenManager()->push(new LogConfigScreen());
 	return UI::EVENT_DONE;
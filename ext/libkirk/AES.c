@@ -1233,6 +1233,16 @@ rijndaelDecrypt(const u32 rk[/*4*(Nr + 1)*/], int Nr, const u8 ct[16],
 	PUTU32(pt + 12, s3);
 }
 
+/* round keys as bytes in order, which is what AES instructions take */
+static void
+rijndael_keys_to_bytes(const u32 *rk, int rounds, u8 *out)
+{
+	int i;
+
+	for (i = 0; i < (rounds + 1) * 4; i++)
+		PUTU32(out + i * 4, rk[i]);
+}
+
 /* setup key context for encryption only */
 int
 rijndael_set_key_enc_only(rijndael_ctx *ctx, const u8 *key, int bits)
@@ -1242,6 +1252,7 @@ rijndael_set_key_enc_only(rijndael_ctx *ctx, const u8 *key, int bits)
 	rounds = rijndaelKeySetupEnc(ctx->ek, key, bits);
 	if (rounds == 0)
 		return -1;
+	rijndael_keys_to_bytes(ctx->ek, rounds, ctx->ek_bytes);
 
 	ctx->Nr = rounds;
 	ctx->enc_only = 1;
@@ -1260,6 +1271,8 @@ rijndael_set_key(rijndael_ctx *ctx, const u8 *key, int bits)
 		return -1;
 	if (rijndaelKeySetupDec(ctx->dk, key, bits) != rounds)
 		return -1;
+	rijndael_keys_to_bytes(ctx->ek, rounds, ctx->ek_bytes);
+	rijndael_keys_to_bytes(ctx->dk, rounds, ctx->dk_bytes);
 
 	ctx->Nr = rounds;
 	ctx->enc_only = 0;
@@ -1284,13 +1297,33 @@ int AES_set_key(AES_ctx *ctx, const u8 *key, int bits)
 	return rijndael_set_key((rijndael_ctx *)ctx, key, bits);
 }
 
+static AES_cbc_func cbc_encrypt_backend = NULL;
+static AES_cbc_func cbc_decrypt_backend = NULL;
+
+void AES_set_cbc_backend(AES_cbc_func encrypt, AES_cbc_func decrypt)
+{
+	cbc_encrypt_backend = encrypt;
+	cbc_decrypt_backend = decrypt;
+}
+
 void AES_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst)
 {
+	/* A single block with a zero IV is the same in CBC mode. */
+	if (cbc_decrypt_backend && !ctx->enc_only)
+	{
+		cbc_decrypt_backend(ctx, src, dst, 16);
+		return;
+	}
 	rijndaelDecrypt(ctx->dk, ctx->Nr, src, dst);
 }
 
 void AES_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst)
 {
+	if (cbc_encrypt_backend)
+	{
+		cbc_encrypt_backend(ctx, src, dst, 16);
+		return;
+	}
 	rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
 }
 
@@ -1309,6 +1342,11 @@ void AES_cbc_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size)
 	u8 block_buff[16];
 	
 	int i;
+	if (cbc_encrypt_backend && size > 0 && (size & 15) == 0)
+	{
+		cbc_encrypt_backend(ctx, src, dst, size);
+		return;
+	}
 	for(i = 0; i < size; i+=16)
 	{
 		//step 1: copy block to dst
@@ -1330,6 +1368,11 @@ void AES_cbc_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size)
 	u8 block_buff[16];
 	u8 block_buff_previous[16];
 	int i;
+	if (cbc_decrypt_backend && !ctx->enc_only && size > 0 && (size & 15) == 0)
+	{
+		cbc_decrypt_backend(ctx, src, dst, size);
+		return;
+	}
 	
 	memcpy(block_buff, src, 16);
 	memcpy(block_buff_previous, src, 16);
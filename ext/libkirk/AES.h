@@ -22,6 +22,8 @@ typedef struct
 	int	Nr;			/* key-length-dependent number of rounds */
 	u32	ek[4*(AES_MAXROUNDS + 1)];	/* encrypt key schedule */
 	u32	dk[4*(AES_MAXROUNDS + 1)];	/* decrypt key schedule */
+	u8	ek_bytes[16*(AES_MAXROUNDS + 1)];	/* ek in byte order, for AES_set_cbc_backend */
+	u8	dk_bytes[16*(AES_MAXROUNDS + 1)];	/* dk in byte order, for AES_set_cbc_backend */
 } rijndael_ctx;
 
 typedef struct 
@@ -30,6 +32,8 @@ typedef struct
 	int	Nr;			/* key-length-dependent number of rounds */
 	u32	ek[4*(AES_MAXROUNDS + 1)];	/* encrypt key schedule */
 	u32	dk[4*(AES_MAXROUNDS + 1)];	/* decrypt key schedule */
+	u8	ek_bytes[16*(AES_MAXROUNDS + 1)];	/* ek in byte order, for AES_set_cbc_backend */
+	u8	dk_bytes[16*(AES_MAXROUNDS + 1)];	/* dk in byte order, for AES_set_cbc_backend */
 } AES_ctx;
 
 int rijndael_set_key(rijndael_ctx *, const u8 *, int);
@@ -44,6 +48,13 @@ void AES_cbc_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size);
 void AES_cbc_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size);
 void AES_CMAC(AES_ctx *ctx, unsigned char *input, int length, unsigned char *mac);
 
+/* Optional accelerated CBC (zero IV) implementation, e.g. using AES-NI.
+   Installed by the host after checking CPU features, NULL to use the table based code.
+   Only called with sizes that are a non-zero multiple of 16.  src may equal dst.
+   The round keys are in ctx->ek_bytes/dk_bytes, filled in when the key is set. */
+typedef void (*AES_cbc_func)(const AES_ctx *ctx, const u8 *src, u8 *dst, int size);
+void AES_set_cbc_backend(AES_cbc_func encrypt, AES_cbc_func decrypt);
+
 int	rijndaelKeySetupEnc(unsigned int [], const unsigned char [], int);
 int	rijndaelKeySetupDec(unsigned int [], const unsigned char [], int);
 void rijndaelEncrypt(const unsigned int [], int, const unsigned char [],
@@ -5,9 +5,12 @@
 // > --root pspautotests/tests/../ --compare --timeout=5 --graphics=software pspautotests/tests/cpu/cpu_alu/cpu_alu.prx
 
 #include "ppsspp_config.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
+#include <vector>
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
 #endif
@@ -23,6 +26,7 @@
 #include <csignal>
 #endif
 #include "Common/CPUDetect.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/VFS/AssetReader.h"
 #include "Common/File/FileUtil.h"
@@ -38,7 +42,9 @@
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
 #include "Core/SaveState.h"
+#include "GPU/GPU.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Debugger/Playback.h"
 #include "Log.h"
 #include "LogManager.h"
 
@@ -135,6 +141,7 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  --screenshot=FILE     compare against a screenshot\n");
 	fprintf(stderr, "  --max-mse=NUMBER      maximum allowed MSE error for screenshot\n");
 	fprintf(stderr, "  --timeout=SECONDS     abort test it if takes longer than SECONDS\n");
+	fprintf(stderr, "  --gedump-frame=N      only replay frame N of a multi-frame .ppdmp\n");
 
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
@@ -142,6 +149,8 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --bench-threads=MAX   bench with 1, 2, 4... up to MAX worker threads\n");
+	fprintf(stderr, "  --gedump-bench[=RUNS] replay .ppdmp files RUNS times (default 5), output JSON stats\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -263,6 +272,111 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 	return passed;
 }
 
+static double BenchAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt) {
+	double st = time_now_d();
+	double deadline = st + opt.timeout;
+	double runs = 0.0;
+	for (int i = 0; i < 100; ++i) {
+		RunAutoTest(headlessHost, coreParameter, opt);
+		runs++;
+
+		if (time_now_d() > deadline)
+			break;
+	}
+	double et = time_now_d();
+	return (et - st) / runs;
+}
+
+struct GEDumpBenchFrame {
+	double seconds;
+	int drawCalls;
+	int vertices;
+	int64_t pixelsShaded;
+	int textureBytesDecoded;
+	double msDrawingTiles;
+};
+
+static double Percentile(const std::vector<double> &sorted, double p) {
+	if (sorted.empty())
+		return 0.0;
+	// Nearest rank.
+	size_t rank = (size_t)ceil(p * sorted.size());
+	return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+static bool BenchGEDump(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt, int runs, json::JsonWriter &writer) {
+	std::vector<GEDumpBenchFrame> frames;
+	bool measuring = false;
+	GPURecord::SetReplayFrameCallback([&](int frame, double seconds) {
+		if (!measuring)
+			return;
+		GEDumpBenchFrame f;
+		f.seconds = seconds;
+		f.drawCalls = gpuStats.numDrawCalls;
+		f.vertices = gpuStats.numVertsSubmitted;
+		f.pixelsShaded = gpuStats.numPixelsShaded;
+		f.textureBytesDecoded = gpuStats.numTextureDataBytesDecoded;
+		f.msDrawingTiles = gpuStats.msDrawingTiles;
+		frames.push_back(f);
+	});
+	// Pixel and tile counts are only tracked with stats on.
+	Core_ForceDebugStats(true);
+
+	// The first run compiles and caches everything, so don't count it.
+	bool success = RunAutoTest(headlessHost, coreParameter, opt);
+	measuring = true;
+	for (int i = 0; i < runs && success; ++i)
+		success = RunAutoTest(headlessHost, coreParameter, opt);
+
+	Core_ForceDebugStats(false);
+	GPURecord::SetReplayFrameCallback(nullptr);
+
+	std::vector<double> frameMs;
+	double drawCalls = 0.0, vertices = 0.0, pixelsShaded = 0.0, textureBytesDecoded = 0.0, msDrawingTiles = 0.0;
+	for (const GEDumpBenchFrame &f : frames) {
+		frameMs.push_back(f.seconds * 1000.0);
+		drawCalls += f.drawCalls;
+		vertices += f.vertices;
+		pixelsShaded += (double)f.pixelsShaded;
+		textureBytesDecoded += f.textureBytesDecoded;
+		msDrawingTiles += f.msDrawingTiles;
+	}
+	std::sort(frameMs.begin(), frameMs.end());
+	double totalMs = 0.0;
+	for (double ms : frameMs)
+		totalMs += ms;
+	const double count = std::max((double)frames.size(), 1.0);
+	const int threads = g_threadManager.GetNumLooperThreads();
+
+	writer.pushDict();
+	writer.writeString("name", GetTestName(coreParameter.fileToStart));
+	writer.writeBool("success", success && !frames.empty());
+	writer.writeInt("runs", runs);
+	writer.writeInt("frames", (int)frames.size());
+	writer.pushDict("frameMs");
+	writer.writeFloat("mean", totalMs / count);
+	writer.writeFloat("p50", Percentile(frameMs, 0.50));
+	writer.writeFloat("p90", Percentile(frameMs, 0.90));
+	writer.writeFloat("p99", Percentile(frameMs, 0.99));
+	writer.writeFloat("max", frameMs.empty() ? 0.0 : frameMs.back());
+	writer.pop();
+	writer.pushDict("perFrame");
+	writer.writeFloat("drawCalls", drawCalls / count);
+	writer.writeFloat("vertices", vertices / count);
+	writer.writeFloat("pixelsShaded", pixelsShaded / count);
+	writer.writeFloat("textureBytesDecoded", textureBytesDecoded / count);
+	writer.pop();
+	writer.pushDict("binManager");
+	writer.writeInt("threads", threads);
+	writer.writeFloat("tileMsPerFrame", msDrawingTiles / count);
+	// How busy the drawing threads were, on average, while frames were replaying.
+	writer.writeFloat("utilization", totalMs > 0.0 ? msDrawingTiles / (totalMs * std::max(threads, 1)) : 0.0);
+	writer.pop();
+	writer.pop();
+
+	return success && !frames.empty();
+}
+
 int main(int argc, const char* argv[])
 {
 	PROFILE_INIT();
@@ -286,6 +400,8 @@ int main(int argc, const char* argv[])
 	GPUCore gpuCore = GPUCORE_SOFTWARE;
 	CPUCore cpuCore = CPUCore::JIT;
 	int debuggerPort = -1;
+	int benchThreads = 0;
+	int gedumpBenchRuns = 0;
 
 	std::vector<std::string> testFilenames;
 	const char *mountIso = nullptr;
@@ -318,6 +434,10 @@ int main(int argc, const char* argv[])
 			testOptions.compare = true;
 		else if (!strcmp(argv[i], "--bench"))
 			testOptions.bench = true;
+		else if (!strncmp(argv[i], "--bench-threads=", strlen("--bench-threads=")) && strlen(argv[i]) > strlen("--bench-threads=")) {
+			testOptions.bench = true;
+			benchThreads = (int)strtoul(argv[i] + strlen("--bench-threads="), NULL, 10);
+		}
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
 			testOptions.verbose = true;
 		else if (!strncmp(argv[i], "--graphics=", strlen("--graphics=")) && strlen(argv[i]) > strlen("--graphics="))
@@ -348,6 +468,15 @@ int main(int argc, const char* argv[])
 			screenshotFilename = argv[i] + strlen("--screenshot=");
 		else if (!strncmp(argv[i], "--timeout=", strlen("--timeout=")) && strlen(argv[i]) > strlen("--timeout="))
 			testOptions.timeout = strtod(argv[i] + strlen("--timeout="), nullptr);
+		else if (!strcmp(argv[i], "--gedump-bench")) {
+			testOptions.bench = true;
+			gedumpBenchRuns = 5;
+		} else if (!strncmp(argv[i], "--gedump-bench=", strlen("--gedump-bench=")) && strlen(argv[i]) > strlen("--gedump-bench=")) {
+			testOptions.bench = true;
+			gedumpBenchRuns = std::max((int)strtoul(argv[i] + strlen("--gedump-bench="), NULL, 10), 1);
+		}
+		else if (!strncmp(argv[i], "--gedump-frame=", strlen("--gedump-frame=")) && strlen(argv[i]) > strlen("--gedump-frame="))
+			GPURecord::SetReplayFrameRange((int)strtoul(argv[i] + strlen("--gedump-frame="), NULL, 10), 1);
 		else if (!strncmp(argv[i], "--max-mse=", strlen("--max-mse=")) && strlen(argv[i]) > strlen("--max-mse="))
 			testOptions.maxScreenshotError = strtod(argv[i] + strlen("--max-mse="), nullptr);
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
@@ -504,6 +633,30 @@ int main(int argc, const char* argv[])
 
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
+	if (gedumpBenchRuns > 0) {
+		// Keep the output clean for parsing.
+		AutoTestOptions benchOptions = testOptions;
+		benchOptions.compare = false;
+		coreParameter.printfEmuLog = false;
+
+		json::JsonWriter writer(json::JsonWriter::PRETTY);
+		writer.begin();
+		writer.writeBool("softwareRenderer", coreParameter.gpuCore == GPUCORE_SOFTWARE);
+		writer.pushArray("dumps");
+		bool allSucceeded = true;
+		for (const std::string &filename : testFilenames) {
+			coreParameter.fileToStart = Path(filename);
+			if (!BenchGEDump(headlessHost, coreParameter, benchOptions, gedumpBenchRuns, writer))
+				allSucceeded = false;
+		}
+		writer.pop();
+		writer.end();
+		printf("%s", writer.str().c_str());
+		if (!allSucceeded)
+			failedTests.push_back("gedump-bench");
+		testFilenames.clear();
+	}
+
 	for (size_t i = 0; i < testFilenames.size(); ++i)
 	{
 		coreParameter.fileToStart = Path(testFilenames[i]);
@@ -511,20 +664,19 @@ int main(int argc, const char* argv[])
 			printf("%s:\n", coreParameter.fileToStart.c_str());
 		bool passed = RunAutoTest(headlessHost, coreParameter, testOptions);
 		if (testOptions.bench) {
-			double st = time_now_d();
-			double deadline = st + testOptions.timeout;
-			double runs = 0.0;
-			for (int i = 0; i < 100; ++i) {
-				RunAutoTest(headlessHost, coreParameter, testOptions);
-				runs++;
-
-				if (time_now_d() > deadline)
-					break;
-			}
-			double et = time_now_d();
-
 			std::string testName = GetTestName(coreParameter.fileToStart);
-			printf("  %s - %f seconds average\n", testName.c_str(), (et - st) / runs);
+			if (benchThreads > 0) {
+				// Mainly useful with GE dumps on the software renderer, to see how drawing scales.
+				for (int threads = 1; threads <= benchThreads; threads *= 2) {
+					g_threadManager.Init(threads, 1);
+					double seconds = BenchAutoTest(headlessHost, coreParameter, testOptions);
+					printf("  %s - %d threads - %f seconds average\n", testName.c_str(), g_threadManager.GetNumLooperThreads(), seconds);
+				}
+				g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+			} else {
+				double seconds = BenchAutoTest(headlessHost, coreParameter, testOptions);
+				printf("  %s - %f seconds average\n", testName.c_str(), seconds);
+			}
 		}
 		if (testOptions.compare) {
 			std::string testName = GetTestName(coreParameter.fileToStart);
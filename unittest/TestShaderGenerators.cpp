@@ -1,10 +1,14 @@
 #include "ppsspp_config.h"
 #include <algorithm>
 
+#include "Common/CPUDetect.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
 
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/ShaderCommon.h"
+#include "GPU/Common/ShaderIdList.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "Common/Data/Random/Rng.h"
 
@@ -617,6 +621,101 @@ bool TestGeometryShaders() {
 	return true;
 }
 
+// Random IDs adjusted the same way as above, about as many as a big game uses.
+static ShaderIdList MakeRandomShaderIdList() {
+	GMRng rng;
+	ShaderIdList list;
+	while (list.vert.size() < 200) {
+		VShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBits(VS_BIT_WEIGHT_FMTSCALE, 2, 0);
+		if (id.Bit(VS_BIT_IS_THROUGH)) {
+			id.SetBit(VS_BIT_USE_HW_TRANSFORM, 0);
+		}
+		if (!id.Bit(VS_BIT_USE_HW_TRANSFORM)) {
+			id.SetBit(VS_BIT_ENABLE_BONES, 0);
+		}
+		if (!id.Bit(VS_BIT_VERTEX_RANGE_CULLING)) {
+			list.vert.push_back(id);
+		}
+	}
+	while (list.frag.size() < 200) {
+		FShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBit(FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL, false);
+		if (static_cast<ReplaceAlphaType>(id.Bits(FS_BIT_STENCIL_TO_ALPHA, 2)) != ReplaceAlphaType::REPLACE_ALPHA_DUALSOURCE) {
+			list.frag.push_back(id);
+		}
+	}
+	return list;
+}
+
+// One at a time on this thread, like compiling on first draw does.
+static void GenerateShaderIdListSerially(const ShaderIdList &list, const Draw::Bugs &bugs, std::vector<std::string> *vert, std::vector<std::string> *frag) {
+	char *buffer = new char[65536];
+	std::string errorString;
+	vert->resize(list.vert.size());
+	frag->resize(list.frag.size());
+	for (size_t i = 0; i < list.vert.size(); i++) {
+		(*vert)[i] = GenerateVShader(list.vert[i], buffer, ShaderLanguage::GLSL_VULKAN, bugs, &errorString) ? buffer : "";
+	}
+	for (size_t i = 0; i < list.frag.size(); i++) {
+		(*frag)[i] = GenerateFShader(list.frag[i], buffer, ShaderLanguage::GLSL_VULKAN, bugs, &errorString) ? buffer : "";
+	}
+	delete[] buffer;
+}
+
+bool TestShaderIdListGeneration() {
+	if (!g_threadManager.IsInitialized())
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+
+	const ShaderIdList list = MakeRandomShaderIdList();
+	Draw::Bugs bugs;
+	ShaderLanguageDesc compat(ShaderLanguage::GLSL_VULKAN);
+
+	std::vector<std::string> vert, frag;
+	GenerateShaderIdListSerially(list, bugs, &vert, &frag);
+	ShaderIdListSources sources;
+	GenerateShaderIdListSources(list, compat, bugs, &sources);
+
+	if (sources.vert != vert || sources.frag != frag) {
+		printf("Shader ID list generated different shaders than one at a time\n");
+		return false;
+	}
+	return true;
+}
+
+bool BenchShaderIdListGeneration() {
+	if (!g_threadManager.IsInitialized())
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+
+	const ShaderIdList list = MakeRandomShaderIdList();
+	Draw::Bugs bugs;
+	ShaderLanguageDesc compat(ShaderLanguage::GLSL_VULKAN);
+
+	std::vector<std::string> vert, frag;
+	double st = time_now_d();
+	int runs = 0;
+	do {
+		GenerateShaderIdListSerially(list, bugs, &vert, &frag);
+		runs++;
+	} while (time_now_d() - st < 0.25);
+	const double serialTime = (time_now_d() - st) / runs;
+
+	ShaderIdListSources sources;
+	st = time_now_d();
+	runs = 0;
+	do {
+		GenerateShaderIdListSources(list, compat, bugs, &sources);
+		runs++;
+	} while (time_now_d() - st < 0.25);
+	const double parallelTime = (time_now_d() - st) / runs;
+
+	printf("Generated %d shaders in %0.2f ms one at a time, %0.2f ms from a shader ID list (%d failed)\n", (int)(vert.size() + frag.size()), serialTime * 1000.0, parallelTime * 1000.0, sources.failed);
+	return true;
+}
 
 bool TestShaderGenerators() {
 #if PPSSPP_PLATFORM(WINDOWS)
@@ -651,5 +750,9 @@ bool TestShaderGenerators() {
 		return false;
 	}
 
+	if (!TestShaderIdListGeneration()) {
+		return false;
+	}
+
 	return true;
 } 
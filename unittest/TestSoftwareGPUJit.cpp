@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "Common/Data/Random/Rng.h"
+#include "Common/MemoryUtil.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "GPU/Software/BinManager.h"
@@ -161,6 +162,44 @@ static bool TestPixelJit() {
 	return successes == count && !HitAnyAsserts();
 }
 
+static bool TestPrecompileJit() {
+	using namespace Rasterizer;
+	PixelJitCache *cache = new PixelJitCache();
+	std::atomic<bool> cancel{};
+
+	GMRng rng;
+	std::vector<PixelFuncID> ids;
+	while (ids.size() < 32) {
+		PixelFuncID id;
+		memset(&id, 0, sizeof(id));
+		id.fullKey = (uint64_t)rng.R32() | ((uint64_t)rng.R32() << 32);
+		if (!startsWith(DescribePixelFuncID(id), "INVALID"))
+			ids.push_back(id);
+	}
+
+	cache->Precompile(ids, cancel);
+
+	// With W^X, these are queued for the next flush instead.
+	if (PlatformIsWXExclusive()) {
+		delete cache;
+		return !HitAnyAsserts();
+	}
+
+	// Precompiled funcs only count as seen once they're used.
+	bool success = cache->SeenIDs().empty();
+	// Without a binner, these can only come from the precompile.
+	for (const PixelFuncID &id : ids) {
+		if (cache->GetSingle(id, nullptr) == nullptr) {
+			printf("Pixel func not precompiled: %s\n", DescribePixelFuncID(id).c_str());
+			success = false;
+		}
+	}
+	success = success && cache->SeenIDs().size() == ids.size();
+
+	delete cache;
+	return success && !HitAnyAsserts();
+}
+
 bool TestSoftwareGPUJit() {
 	g_Config.bSoftwareRenderingJit = true;
 	ResetHitAnyAsserts();
@@ -173,5 +212,9 @@ bool TestSoftwareGPUJit() {
 		return false;
 	}
 
+	if (!TestPrecompileJit()) {
+		return false;
+	}
+
 	return true;
 }
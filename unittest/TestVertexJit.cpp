@@ -15,14 +15,20 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <math.h>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/MemoryUtil.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
+#include "GPU/Common/DecodedVertexCache.h"
+#include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/ge_constants.h"
+#include "GPU/GPU.h"
 #include "GPU/GPUState.h"
 #include "unittest/TestVertexJit.h"
 #include "unittest/UnitTest.h"
@@ -639,6 +645,399 @@ static bool TestVertexFloatSkin() {
 	return !dec.HasFailed();
 }
 
+// The typical software transform format.
+struct CacheTestVert {
+	u32_le color;
+	float_le pos[3];
+};
+static const u32 CACHE_TEST_VTYPE = GE_VTYPE_POS_FLOAT | GE_VTYPE_COL_8888;
+
+static std::vector<CacheTestVert> MakeCacheTestVerts(int count) {
+	std::vector<CacheTestVert> verts(count);
+	for (int i = 0; i < count; ++i) {
+		verts[i].color = 0xFF000000 | i;
+		verts[i].pos[0] = (float)i;
+		verts[i].pos[1] = (float)-i;
+		verts[i].pos[2] = 0.5f;
+	}
+	return verts;
+}
+
+static bool TestDecodedVertexCache() {
+	static const int NUM_VERTS = 100;
+	std::vector<CacheTestVert> verts = MakeCacheTestVerts(NUM_VERTS);
+
+	const bool oldVertexCache = g_Config.bVertexCache;
+	g_Config.bVertexCache = true;
+	gstate_c.uv.uScale = 1.0f;
+	gstate_c.uv.vScale = 1.0f;
+
+	g_Config.bVertexDecoderJit = true;
+	g_Config.iCpuCore = (int)CPUCore::JIT;
+	VertexDecoderJitCache jitCache;
+	VertexDecoderOptions options{};
+	VertexDecoder dec;
+	dec.SetVertexType(CACHE_TEST_VTYPE, options, &jitCache);
+	const int stride = dec.GetDecVtxFmt().stride;
+	std::vector<u8> expected(NUM_VERTS * stride);
+	std::vector<u8> dest(NUM_VERTS * stride);
+	dec.DecodeVerts(&expected[0], &verts[0], 0, NUM_VERTS - 1);
+
+	DecodedVertexCache cache;
+	bool pass = true;
+	const u8 *decoded = nullptr;
+	for (int i = 0; i < 3; ++i) {
+		memset(&dest[0], 0, dest.size());
+		gstate_c.vertexFullAlpha = true;
+		decoded = cache.Decode(&dec, &verts[0], 0, NUM_VERTS - 1, &dest[0]);
+		// Only kept once it's been seen twice.
+		if ((decoded != &dest[0]) != (i == 2)) {
+			printf("DecodedVertexCache: unexpected %s on draw %d\n", decoded == &dest[0] ? "miss" : "hit", i);
+			pass = false;
+		}
+		if (memcmp(decoded, &expected[0], expected.size()) != 0) {
+			printf("DecodedVertexCache: wrong data on draw %d\n", i);
+			pass = false;
+		}
+		if (!gstate_c.vertexFullAlpha) {
+			printf("DecodedVertexCache: lost full alpha on draw %d\n", i);
+			pass = false;
+		}
+	}
+
+	// A change should be noticed, and not cached again.
+	verts[0].color = 0x7F000000;
+	dec.DecodeVerts(&expected[0], &verts[0], 0, NUM_VERTS - 1);
+	for (int i = 0; i < 2; ++i) {
+		gstate_c.vertexFullAlpha = true;
+		decoded = cache.Decode(&dec, &verts[0], 0, NUM_VERTS - 1, &dest[0]);
+		if (decoded != &dest[0] || memcmp(decoded, &expected[0], expected.size()) != 0) {
+			printf("DecodedVertexCache: changed data was not redecoded\n");
+			pass = false;
+		}
+		if (gstate_c.vertexFullAlpha) {
+			printf("DecodedVertexCache: full alpha should be cleared\n");
+			pass = false;
+		}
+	}
+
+	// Morph weights aren't part of the key, so these are never kept.
+	VertexDecoder morphDec;
+	morphDec.SetVertexType(GE_VTYPE_POS_FLOAT | (1 << GE_VTYPE_MORPHCOUNT_SHIFT), options);
+	if (DecodedVertexCache::CanCache(morphDec.VertexType())) {
+		printf("DecodedVertexCache: morph should not be cached\n");
+		pass = false;
+	}
+
+	g_Config.bVertexCache = oldVertexCache;
+	return pass;
+}
+
+bool BenchDecodedVertexCache() {
+	static const int NUM_VERTS = 100;
+	std::vector<CacheTestVert> verts = MakeCacheTestVerts(NUM_VERTS);
+
+	const bool oldVertexCache = g_Config.bVertexCache;
+	g_Config.bVertexCache = true;
+	gstate_c.uv.uScale = 1.0f;
+	gstate_c.uv.vScale = 1.0f;
+
+	g_Config.bVertexDecoderJit = true;
+	g_Config.iCpuCore = (int)CPUCore::JIT;
+	VertexDecoderJitCache jitCache;
+	VertexDecoderOptions options{};
+	VertexDecoder dec;
+	dec.SetVertexType(CACHE_TEST_VTYPE, options, &jitCache);
+	std::vector<u8> dest(NUM_VERTS * dec.GetDecVtxFmt().stride);
+
+	// Compare to a plain decode.
+	double st = time_now_d();
+	int decodes = 0;
+	do {
+		for (int j = 0; j < 1000; ++j)
+			dec.DecodeVerts(&dest[0], &verts[0], 0, NUM_VERTS - 1);
+		decodes += 1000;
+	} while (time_now_d() - st < 0.25);
+	const double decodeRate = decodes / (time_now_d() - st);
+
+	// Full hashes back off over frames, so pretend these are spread over a few.
+	const int oldFlips = gpuStats.numFlips;
+	DecodedVertexCache benchCache;
+	st = time_now_d();
+	int lookups = 0;
+	do {
+		for (int j = 0; j < 1000; ++j)
+			benchCache.DecodeInto(&dec, &verts[0], 0, NUM_VERTS - 1, &dest[0]);
+		lookups += 1000;
+		gpuStats.numFlips++;
+	} while (time_now_d() - st < 0.25);
+	const double cacheRate = lookups / (time_now_d() - st);
+	printf("Decoded vertex cache was %fx the speed of decoding %d verts.\n", cacheRate / decodeRate, NUM_VERTS);
+
+	gpuStats.numFlips = oldFlips;
+	g_Config.bVertexCache = oldVertexCache;
+	return true;
+}
+
+static bool TestGetIndexBounds() {
+	bool pass = true;
+	std::vector<u8> inds8(67);
+	std::vector<u16_le> inds16(67);
+	uint32_t seed = 1;
+	for (int count : { 1, 7, 8, 15, 16, 17, 33, 67 }) {
+		for (int i = 0; i < count; ++i) {
+			seed = seed * 1103515245 + 12345;
+			inds8[i] = (u8)(seed >> 16);
+			// Use the top bit too, it matters for the signed compares.
+			inds16[i] = (u16)((seed >> 8) | 0x100);
+		}
+
+		u16 lower, upper;
+		GetIndexBounds(&inds8[0], count, GE_VTYPE_IDX_8BIT, &lower, &upper);
+		if (lower != *std::min_element(inds8.begin(), inds8.begin() + count) || upper != *std::max_element(inds8.begin(), inds8.begin() + count)) {
+			printf("GetIndexBounds: wrong 8-bit bounds %d-%d for %d indices\n", lower, upper, count);
+			pass = false;
+		}
+		GetIndexBounds(&inds16[0], count, GE_VTYPE_IDX_16BIT, &lower, &upper);
+		if (lower != *std::min_element(inds16.begin(), inds16.begin() + count) || upper != *std::max_element(inds16.begin(), inds16.begin() + count)) {
+			printf("GetIndexBounds: wrong 16-bit bounds %d-%d for %d indices\n", lower, upper, count);
+			pass = false;
+		}
+	}
+	return pass;
+}
+
+// Just enough of a draw engine to run the deferred decode, keeping what a backend would draw.
+class MergeTestDrawEngine : public DrawEngineCommon {
+public:
+	MergeTestDrawEngine() {
+		decoded = (u8 *)AllocateMemoryPages(DECODED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
+		decIndex = (u16 *)AllocateMemoryPages(DECODED_INDEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
+		indexGen.Setup(decIndex);
+	}
+	~MergeTestDrawEngine() {
+		FreeMemoryPages(decoded, DECODED_VERTEX_BUFFER_SIZE);
+		FreeMemoryPages(decIndex, DECODED_INDEX_BUFFER_SIZE);
+	}
+
+	void DispatchFlush() override {
+		Flush();
+	}
+
+	void Submit(const void *verts, const void *inds, int vertexCount, u32 vertType, int cullMode) {
+		int bytesRead = 0;
+		SubmitPrim(verts, inds, GE_PRIM_TRIANGLES, vertexCount, GetVertTypeID(vertType, gstate.getUVGenMode(), false), cullMode, &bytesRead);
+	}
+
+	void Flush() {
+		if (numDrawCalls == 0)
+			return;
+		DecodeVerts(decoded);
+		outVerts.assign(decoded, decoded + decodedVerts_ * dec_->GetDecVtxFmt().stride);
+		outInds.assign(decIndex, decIndex + indexGen.VertexCount());
+
+		indexGen.Reset();
+		decodedVerts_ = 0;
+		numDrawCalls = 0;
+		vertexCountInDrawCalls_ = 0;
+		decodeCounter_ = 0;
+	}
+
+	std::vector<u8> outVerts;
+	std::vector<u16> outInds;
+};
+
+struct MergeTestVert {
+	u16_le uv[2];
+	u32_le color;
+	float_le pos[3];
+};
+static const u32 MERGE_TEST_VTYPE = GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_FLOAT;
+
+static std::vector<MergeTestVert> MakeMergeTestVerts(int count) {
+	std::vector<MergeTestVert> verts(count);
+	for (int i = 0; i < count; ++i) {
+		verts[i].uv[0] = (u16)(i * 3);
+		verts[i].uv[1] = (u16)(i * 5);
+		verts[i].color = 0xFF000000 | i;
+		verts[i].pos[0] = (float)i;
+		verts[i].pos[1] = (float)-i;
+		verts[i].pos[2] = 0.5f;
+	}
+	return verts;
+}
+
+static bool TestMergedDecode() {
+	static const int NUM_VERTS = 64;
+	std::vector<MergeTestVert> verts = MakeMergeTestVerts(NUM_VERTS);
+
+	const u32 vertType = MERGE_TEST_VTYPE;
+	const bool oldJit = g_Config.bVertexDecoderJit;
+	// Compare against the same decoder steps, the jit is covered by the other tests.
+	g_Config.bVertexDecoderJit = false;
+	gstate.cullfaceEnable = 1;
+	gstate.cullmode = 0;
+	const UVScale baseUV{ 1.0f, 1.0f, 0.0f, 0.0f };
+	gstate_c.uv = baseUV;
+
+	MergeTestDrawEngine engine;
+	engine.Init();
+
+	VertexDecoderOptions options{};
+	VertexDecoder refDec;
+	refDec.SetVertexType(vertType, options);
+	const int stride = refDec.GetDecVtxFmt().stride;
+	// What decoding each draw by itself, with its own UV scale, would give.
+	std::vector<u8> expectedVerts;
+	auto expectVerts = [&](int lower, int upper, const UVScale &uv) {
+		const UVScale oldUV = gstate_c.uv;
+		gstate_c.uv = uv;
+		size_t pos = expectedVerts.size();
+		expectedVerts.resize(pos + (upper - lower + 1) * stride);
+		refDec.DecodeVerts(&expectedVerts[pos], &verts[0], lower, upper);
+		gstate_c.uv = oldUV;
+	};
+
+	bool pass = true;
+	auto check = [&](const char *name, const std::vector<u16> &expectedInds, int decodes, int merged) {
+		engine.Flush();
+		if (engine.outVerts != expectedVerts) {
+			printf("MergedDecode %s: decoded verts differ\n", name);
+			pass = false;
+		}
+		if (engine.outInds != expectedInds) {
+			printf("MergedDecode %s: indices differ\n", name);
+			pass = false;
+		}
+		if (gpuStats.numVertexDecodes != decodes || gpuStats.numMergedDrawCalls != merged) {
+			printf("MergedDecode %s: %d decodes merging %d draws, expected %d merging %d\n", name, gpuStats.numVertexDecodes, gpuStats.numMergedDrawCalls, decodes, merged);
+			pass = false;
+		}
+		expectedVerts.clear();
+		gpuStats.numVertexDecodes = 0;
+		gpuStats.numMergedDrawCalls = 0;
+	};
+	auto listInds = [](std::vector<u16> &inds, int first, int count, bool clockwise) {
+		for (int i = first; i < first + count; i += 3) {
+			inds.push_back(i);
+			inds.push_back(clockwise ? i + 1 : i + 2);
+			inds.push_back(clockwise ? i + 2 : i + 1);
+		}
+	};
+	gpuStats.numVertexDecodes = 0;
+	gpuStats.numMergedDrawCalls = 0;
+
+	// Non-indexed draws that follow each other in memory are decoded at once.
+	std::vector<u16> inds;
+	for (int j = 0; j < 3; ++j)
+		engine.Submit(&verts[j * 6], nullptr, 6, vertType, 0);
+	expectVerts(0, 17, baseUV);
+	listInds(inds, 0, 18, true);
+	check("adjacent", inds, 1, 2);
+
+	// A different cull mode still merges, but that draw's winding is flipped.
+	inds.clear();
+	for (int j = 0; j < 3; ++j)
+		engine.Submit(&verts[j * 6], nullptr, 6, vertType, j == 1 ? 1 : 0);
+	expectVerts(0, 17, baseUV);
+	listInds(inds, 0, 6, true);
+	listInds(inds, 6, 6, false);
+	listInds(inds, 12, 6, true);
+	check("cull", inds, 1, 2);
+
+	// The decoder applies the UV scale, so a change has to split the decode.
+	const UVScale scaledUV{ 2.0f, 0.5f, 0.25f, 0.0f };
+	for (int j = 0; j < 3; ++j) {
+		gstate_c.uv = j == 1 ? scaledUV : baseUV;
+		engine.Submit(&verts[j * 6], nullptr, 6, vertType, 0);
+		expectVerts(j * 6, j * 6 + 5, gstate_c.uv);
+	}
+	gstate_c.uv = baseUV;
+	inds.clear();
+	listInds(inds, 0, 18, true);
+	check("uvscale", inds, 3, 0);
+
+	// Draws that aren't adjacent in memory can't be merged.
+	engine.Submit(&verts[0], nullptr, 6, vertType, 0);
+	engine.Submit(&verts[12], nullptr, 6, vertType, 0);
+	expectVerts(0, 5, baseUV);
+	expectVerts(12, 17, baseUV);
+	inds.clear();
+	listInds(inds, 0, 12, true);
+	check("gap", inds, 2, 0);
+
+	// Indexed draws sharing verts decode their combined range once, and are rebased to it.
+	// The second is flipped, to go through both the rebase and the counter-clockwise paths.
+	std::vector<u16_le> inds16(48);
+	std::vector<u8> inds8(24);
+	for (int i = 0; i < 48; ++i)
+		inds16[i] = (u16)(20 + (i * 7) % 11);
+	for (int i = 0; i < 24; ++i)
+		inds8[i] = (u8)(25 + (i * 5) % 13);
+	engine.Submit(&verts[0], &inds16[0], 24, vertType | GE_VTYPE_IDX_16BIT, 0);
+	engine.Submit(&verts[0], &inds16[24], 24, vertType | GE_VTYPE_IDX_16BIT, 1);
+	expectVerts(20, 30, baseUV);
+	inds.clear();
+	for (int i = 0; i < 48; i += 3) {
+		bool clockwise = i < 24;
+		inds.push_back(inds16[i] - 20);
+		inds.push_back(inds16[clockwise ? i + 1 : i + 2] - 20);
+		inds.push_back(inds16[clockwise ? i + 2 : i + 1] - 20);
+	}
+	check("indexed16", inds, 1, 1);
+
+	engine.Submit(&verts[0], &inds8[0], 12, vertType | GE_VTYPE_IDX_8BIT, 0);
+	engine.Submit(&verts[0], &inds8[12], 12, vertType | GE_VTYPE_IDX_8BIT, 0);
+	expectVerts(25, 37, baseUV);
+	inds.clear();
+	for (int i = 0; i < 24; ++i)
+		inds.push_back(inds8[i] - 25);
+	check("indexed8", inds, 1, 1);
+
+	gstate.cullfaceEnable = 0;
+	g_Config.bVertexDecoderJit = oldJit;
+	return pass;
+}
+
+bool BenchMergedDecode() {
+	// Lots of small draws, like sprites or text.  Each flush decodes them all.
+	static const int NUM_DRAWS = 64;
+	static const int DRAW_VERTS = 6;
+	std::vector<MergeTestVert> verts = MakeMergeTestVerts(NUM_DRAWS * DRAW_VERTS * 2);
+
+	const bool oldJit = g_Config.bVertexDecoderJit;
+	g_Config.bVertexDecoderJit = true;
+	g_Config.iCpuCore = (int)CPUCore::JIT;
+	gstate.cullfaceEnable = 0;
+	gstate_c.uv = UVScale{ 1.0f, 1.0f, 0.0f, 0.0f };
+
+	MergeTestDrawEngine engine;
+	engine.Init();
+
+	// Leaving a gap between the draws keeps them from merging, so the same draws are decoded per call.
+	auto timeFlushes = [&](int spacing) {
+		double st = time_now_d();
+		int flushes = 0;
+		do {
+			for (int j = 0; j < 100; ++j) {
+				for (int d = 0; d < NUM_DRAWS; ++d)
+					engine.Submit(&verts[d * spacing], nullptr, DRAW_VERTS, MERGE_TEST_VTYPE, 0);
+				engine.Flush();
+			}
+			flushes += 100;
+		} while (time_now_d() - st < 0.25);
+		return flushes / (time_now_d() - st);
+	};
+	const double separateRate = timeFlushes(DRAW_VERTS * 2);
+	const double mergedRate = timeFlushes(DRAW_VERTS);
+	printf("Merged decode was %fx the speed of decoding %d draws of %d verts separately.\n", mergedRate / separateRate, NUM_DRAWS, DRAW_VERTS);
+
+	gpuStats.numVertexDecodes = 0;
+	gpuStats.numMergedDrawCalls = 0;
+	g_Config.bVertexDecoderJit = oldJit;
+	return true;
+}
+
 // TODO: Morph (col, pos, nrm), weights (no skin), morph + weights?
 
 typedef bool (*VertexTestFunc)();
@@ -660,6 +1059,10 @@ static VertexTestFunc vertdecTestFuncs[] = {
 	&TestVertex8Skin,
 	&TestVertex16Skin,
 	&TestVertexFloatSkin,
+
+	&TestDecodedVertexCache,
+	&TestGetIndexBounds,
+	&TestMergedDecode,
 };
 
 bool TestVertexJit() {
@@ -29,12 +29,14 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
 #include <vector>
 #include <string>
 #include <sstream>
+#include <thread>
 
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
@@ -46,24 +48,37 @@
 #include "Common/Data/Text/WrapText.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/File/Path.h"
+#include "Common/File/PathCaseCache.h"
+#include "Common/File/FileUtil.h"
 #include "Common/Input/InputState.h"
 #include "Common/Math/math_util.h"
 #include "Common/Render/DrawBuffer.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
+#include "Common/Thread/ThreadManager.h"
 
 #include "Common/ArmEmitter.h"
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HW/KirkAES.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/ReplacementPack.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/TextureScalerCommon.h"
+
+#include "ext/xbrz/xbrz.h"
 
 #include "android/jni/AndroidContentURI.h"
 
+extern "C" {
+#include "ext/libkirk/AES.h"
+}
+
 #include "unittest/JitHarness.h"
 #include "unittest/TestVertexJit.h"
 #include "unittest/UnitTest.h"
@@ -547,6 +562,418 @@ bool TestQuickTexHash() {
 	return true;
 }
 
+template <typename Block>
+static void FillDXTBlocks(std::vector<Block> &blocks, uint32_t seed) {
+	uint8_t *p = (uint8_t *)blocks.data();
+	for (size_t i = 0; i < blocks.size() * sizeof(Block); ++i) {
+		seed = seed * 1664525 + 1013904223;
+		p[i] = (uint8_t)(seed >> 24);
+	}
+	// Make sure both color modes, equal colors and the extremes are covered.
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		DXT1Block *color = (DXT1Block *)&blocks[i];
+		if ((i % 5) == 1)
+			std::swap(color->color1, color->color2);
+		else if ((i % 5) == 2)
+			color->color2 = (u16)color->color1;
+		else if ((i % 5) == 3)
+			color->color1 = (i & 8) ? 0xFFFF : 0x0000;
+	}
+}
+
+template <typename Block, typename F1, typename F2>
+static bool CompareDXTBlocks(const char *name, const std::vector<Block> &blocks, F1 single, F2 batch) {
+	int count = (int)blocks.size();
+	// Pad the pitch, to catch any writes past the blocks.
+	int pitch = count * 4 + 3;
+	std::vector<u32> expected(pitch * 4, 0xDEADBEEF), actual(pitch * 4, 0xDEADBEEF);
+	for (int i = 0; i < count; ++i)
+		single(expected.data() + i * 4, &blocks[i], pitch);
+	batch(actual.data(), blocks.data(), count, pitch);
+	for (size_t i = 0; i < expected.size(); ++i) {
+		if (expected[i] != actual[i]) {
+			printf("%s: pixel %d, %d: %08x != expected %08x\n", name, (int)(i % pitch), (int)(i / pitch), actual[i], expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename Block, typename F>
+static double TimeDXTBlocks(const std::vector<Block> &blocks, F func) {
+	int count = (int)blocks.size();
+	std::vector<u32> dst(count * 16);
+	int64_t pixels = 0;
+	double st = time_now_d();
+	do {
+		func(dst.data(), blocks.data(), count, count * 4);
+		pixels += count * 16;
+	} while (time_now_d() - st < 0.1);
+	return pixels / (time_now_d() - st) / 1000000.0;
+}
+
+bool TestDXTDecoder() {
+	u32 alphaScalar = 1, alphaBatch = 1;
+	auto dxt1Single = [&](u32 *dst, const DXT1Block *src, int pitch) {
+		DecodeDXT1Block(dst, src, pitch, 4, 4, &alphaScalar);
+	};
+	auto dxt1Batch = [&](u32 *dst, const DXT1Block *src, int count, int pitch) {
+		DecodeDXT1Blocks(dst, src, count, pitch, &alphaBatch);
+	};
+	auto dxt3Single = [](u32 *dst, const DXT3Block *src, int pitch) {
+		DecodeDXT3Block(dst, src, pitch, 4, 4);
+	};
+	auto dxt5Single = [](u32 *dst, const DXT5Block *src, int pitch) {
+		DecodeDXT5Block(dst, src, pitch, 4, 4);
+	};
+
+	// An odd count so the non-batched tail is covered too.
+	std::vector<DXT1Block> dxt1(1027);
+	std::vector<DXT3Block> dxt3(1027);
+	std::vector<DXT5Block> dxt5(1027);
+	for (uint32_t seed = 1; seed <= 8; ++seed) {
+		FillDXTBlocks(dxt1, seed);
+		FillDXTBlocks(dxt3, seed);
+		FillDXTBlocks(dxt5, seed);
+		alphaScalar = 1;
+		alphaBatch = 1;
+		if (!CompareDXTBlocks("DXT1", dxt1, dxt1Single, dxt1Batch))
+			return false;
+		EXPECT_EQ_INT(alphaBatch, alphaScalar);
+		if (!CompareDXTBlocks("DXT3", dxt3, dxt3Single, &DecodeDXT3Blocks))
+			return false;
+		if (!CompareDXTBlocks("DXT5", dxt5, dxt5Single, &DecodeDXT5Blocks))
+			return false;
+	}
+
+	// Now without any transparent pixels, which should keep the alpha flag set.
+	for (DXT1Block &block : dxt1) {
+		if (block.color1 <= block.color2)
+			std::swap(block.color1, block.color2);
+		if (block.color1 == block.color2 && block.color2 == 0)
+			block.color1 = 1;
+		else if (block.color1 == block.color2)
+			block.color2 = block.color2 - 1;
+	}
+	alphaScalar = 1;
+	alphaBatch = 1;
+	if (!CompareDXTBlocks("DXT1 opaque", dxt1, dxt1Single, dxt1Batch))
+		return false;
+	EXPECT_EQ_INT(alphaScalar, 1);
+	EXPECT_EQ_INT(alphaBatch, 1);
+	return true;
+}
+
+bool BenchDXTDecoder() {
+	u32 alpha = 1;
+	auto dxt1Blockwise = [&](u32 *dst, const DXT1Block *src, int count, int pitch) {
+		for (int i = 0; i < count; ++i)
+			DecodeDXT1Block(dst + i * 4, src + i, pitch, 4, 4, &alpha);
+	};
+	auto dxt1Batch = [&](u32 *dst, const DXT1Block *src, int count, int pitch) {
+		DecodeDXT1Blocks(dst, src, count, pitch, &alpha);
+	};
+	auto dxt5Blockwise = [](u32 *dst, const DXT5Block *src, int count, int pitch) {
+		for (int i = 0; i < count; ++i)
+			DecodeDXT5Block(dst + i * 4, src + i, pitch, 4, 4);
+	};
+
+	std::vector<DXT1Block> dxt1(1027);
+	std::vector<DXT5Block> dxt5(1027);
+	FillDXTBlocks(dxt1, 1);
+	FillDXTBlocks(dxt5, 1);
+	printf("DXT decode Mpixels/s: DXT1 %0.1f -> %0.1f, DXT5 %0.1f -> %0.1f\n",
+		TimeDXTBlocks(dxt1, dxt1Blockwise), TimeDXTBlocks(dxt1, dxt1Batch),
+		TimeDXTBlocks(dxt5, dxt5Blockwise), TimeDXTBlocks(dxt5, &DecodeDXT5Blocks));
+	return true;
+}
+
+template <typename ClutT>
+static bool CheckDeIndexTexture4(const ClutT *clut, const u8 *indexed, int length) {
+	std::vector<ClutT> expected(length + 1, 0xBEEF), actual(length + 1, 0xBEEF);
+	ClutT expectedAlpha = (ClutT)-1;
+	for (int i = 0; i < length; ++i) {
+		expected[i] = clut[(indexed[i / 2] >> ((i & 1) * 4)) & 0xF];
+		expectedAlpha &= expected[i];
+	}
+
+	u32 alphaSum = 0xFFFFFFFF;
+	DeIndexTexture4(actual.data(), indexed, length, clut, &alphaSum);
+	if (expected != actual) {
+		printf("DeIndexTexture4: mismatch at length %d (%d bytes per color)\n", length, (int)sizeof(ClutT));
+		return false;
+	}
+	EXPECT_EQ_HEX(alphaSum, (u32)expectedAlpha);
+	return true;
+}
+
+bool TestCLUT4Decoder() {
+	// Simple indexing, no shift, mask or offset.
+	const u32 oldClutFormat = gstate.clutformat;
+	gstate.clutformat = 0xC500FF00;
+
+	u8 indexed[128];
+	u16 clut16[16];
+	u32 clut32[16];
+	uint32_t seed = 1;
+	auto next = [&]() {
+		seed = seed * 1664525 + 1013904223;
+		return seed >> 8;
+	};
+	bool decodePass = true;
+	for (int pass = 0; pass < 4; ++pass) {
+		for (u8 &index : indexed)
+			index = (u8)next();
+		for (int i = 0; i < 16; ++i) {
+			// Every other pass, keep alpha full to check that it's reported.
+			clut16[i] = (u16)next() | ((pass & 1) ? 0xF000 : 0);
+			clut32[i] = next() | ((pass & 1) ? 0xFF000000 : (next() << 24));
+		}
+		for (int length : { 1, 2, 31, 32, 33, 64, 95, 256 }) {
+			if (!CheckDeIndexTexture4(clut16, indexed, length) || !CheckDeIndexTexture4(clut32, indexed, length))
+				decodePass = false;
+		}
+	}
+	gstate.clutformat = oldClutFormat;
+	if (!decodePass)
+		return false;
+
+	for (int width : { 1, 2, 31, 32, 33, 64, 255 }) {
+		u8 expanded[256];
+		memset(expanded, 0xFF, sizeof(expanded));
+		Expand4To8Bits(expanded, indexed, width);
+		for (int i = 0; i < width; ++i) {
+			if (expanded[i] != ((indexed[i / 2] >> ((i & 1) * 4)) & 0xF)) {
+				printf("Expand4To8Bits: mismatch at %d of %d\n", i, width);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void FillScalerTexture(std::vector<u32> &pixels, int width, int height, uint32_t seed) {
+	// Smooth gradients with some noise and hard edges, so that all parts of the scalers get used.
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			seed = seed * 1664525 + 1013904223;
+			u32 color = 0xFF000000 | ((x * 7) & 0xFF) | (((y * 5) & 0xFF) << 8) | ((((x + y) * 3) & 0xF0) << 16);
+			if ((seed >> 28) == 0)
+				color ^= seed;
+			else if (((x / 5) ^ (y / 3)) & 1)
+				color = 0xFF2040C0;
+			pixels[y * width + x] = color;
+		}
+	}
+}
+
+// Straightforward full image version of the hybrid scaler, with one pass per step like it used to be.
+static u32 MixScalerPixels(u32 p0, u32 p1, int f0, int f1) {
+	u32 result = 0;
+	for (int c = 0; c < 32; c += 8)
+		result |= ((((p0 >> c) & 0xFF) * f0 + ((p1 >> c) & 0xFF) * f1) / 255) << c;
+	return result;
+}
+
+static void ReferenceBilinear(const u32 *src, u32 *out, int w, int h, int factor) {
+	static const u8 factors[4][3][2] = {
+		{ { 44, 211 }, { 0, 0 }, { 0, 0 } },
+		{ { 64, 191 }, { 0, 255 }, { 0, 0 } },
+		{ { 77, 178 }, { 26, 229 }, { 0, 0 } },
+		{ { 102, 153 }, { 51, 204 }, { 0, 255 } },
+	};
+	const int outw = w * factor;
+	// Both directions mix the center with its left/upper neighbor for the first half, clamped at the edges.
+	auto scale = [&](u32 before, u32 center, u32 after, int i) {
+		if (i < factor / 2 + factor % 2)
+			return MixScalerPixels(before, center, factors[factor - 2][i][0], factors[factor - 2][i][1]);
+		return MixScalerPixels(after, center, factors[factor - 2][factor - 1 - i][0], factors[factor - 2][factor - 1 - i][1]);
+	};
+	std::vector<u32> horiz(outw * h);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			const u32 *row = src + y * w;
+			for (int i = 0; i < factor; ++i)
+				horiz[y * outw + x * factor + i] = scale(row[std::max(x - 1, 0)], row[x], row[std::min(x + 1, w - 1)], i);
+		}
+	}
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < outw; ++x) {
+			const u32 upper = horiz[std::max(y - 1, 0) * outw + x];
+			const u32 lower = horiz[std::min(y + 1, h - 1) * outw + x];
+			for (int i = 0; i < factor; ++i)
+				out[(y * factor + i) * outw + x] = scale(upper, horiz[y * outw + x], lower, i);
+		}
+	}
+}
+
+static void ReferenceHybrid(const u32 *src, u32 *out, int w, int h, int factor) {
+	auto distance = [](u32 a, u32 b) {
+		int sum = 0;
+		for (int c = 0; c < 32; c += 8)
+			sum += abs((int)((a >> c) & 0xFF) - (int)((b >> c) & 0xFF));
+		return sum;
+	};
+	std::vector<u32> mask(w * h), box(w * h);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			u32 dist = 0;
+			for (int yoff = -1; yoff <= 1; ++yoff) {
+				if (y + yoff < 0 || y + yoff >= h) {
+					dist += 1200;
+					continue;
+				}
+				for (int xoff = -1; xoff <= 1; ++xoff) {
+					if (yoff == 0 && xoff == 0)
+						continue;
+					if (x + xoff < 0 || x + xoff >= w)
+						dist += 400;
+					else
+						dist += distance(src[(y + yoff) * w + x + xoff], src[y * w + x]);
+				}
+			}
+			mask[y * w + x] = dist;
+		}
+	}
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			u32 sum = 0;
+			for (int yoff = -1; yoff <= 1; ++yoff) {
+				for (int xoff = -1; xoff <= 1; ++xoff)
+					sum += mask[std::max(std::min(y + yoff, h - 1), 0) * w + std::max(std::min(x + xoff, w - 1), 0)];
+			}
+			box[y * w + x] = sum;
+		}
+	}
+
+	const int outPixels = w * h * factor * factor;
+	std::vector<u32> scaledMask(outPixels), smooth(outPixels), sharp(outPixels);
+	ReferenceBilinear(box.data(), scaledMask.data(), w, h, factor);
+	ReferenceBilinear(src, smooth.data(), w, h, factor);
+	xbrz::ScalerCfg cfg;
+	xbrz::scale(factor, src, sharp.data(), w, h, xbrz::ColorFormat::ARGB, cfg, 0, h);
+
+	for (int i = 0; i < outPixels; ++i) {
+		const int f1 = std::min(scaledMask[i], 8192U) * 255 / 8192;
+		out[i] = MixScalerPixels(smooth[i], sharp[i], 255 - f1, f1);
+		if ((sharp[i] >> 24) == 0)
+			out[i] &= 0x00FFFFFF;
+	}
+}
+
+static double TimeTextureScaler(TextureScalerCommon &scaler, const std::vector<u32> &src, int width, int height, int factor) {
+	std::vector<u32> input = src;
+	std::vector<u32> out(width * height * factor * factor);
+	int64_t pixels = 0;
+	double st = time_now_d();
+	do {
+		int w = width, h = height;
+		scaler.ScaleInto(out.data(), input.data(), w, h, factor);
+		pixels += w * h;
+	} while (time_now_d() - st < 0.1);
+	return pixels / (time_now_d() - st) / 1000000.0;
+}
+
+static bool CheckTextureScaler() {
+
+	TextureScalerCommon scaler;
+	for (int type : { TextureScalerCommon::XBRZ, TextureScalerCommon::HYBRID, TextureScalerCommon::BICUBIC, TextureScalerCommon::HYBRID_BICUBIC }) {
+		g_Config.iTexScalingType = type;
+		for (int factor = 2; factor <= 5; ++factor) {
+			// Odd sizes, and one large enough to be split into several bands.
+			for (int size : { 1, 3, 17, 130 }) {
+				// A flat texture has to stay flat, including the edges, and nothing may be written past the end.
+				std::vector<u32> flat(size * size, 0xFF336699);
+				std::vector<u32> out(size * size * factor * factor + 1, 0xDEADBEEF);
+				int w = size, h = size;
+				scaler.ScaleInto(out.data(), flat.data(), w, h, factor);
+				EXPECT_EQ_INT(w, size * factor);
+				EXPECT_EQ_INT(h, size * factor);
+				for (int i = 0; i < w * h; ++i) {
+					if (out[i] != 0xFF336699) {
+						printf("Scaler type %d %dx: pixel %d of %dx%d is %08x\n", type, factor, i, w, h, out[i]);
+						return false;
+					}
+				}
+				EXPECT_EQ_HEX(out[w * h], 0xDEADBEEF);
+			}
+		}
+	}
+
+	// Scaling two textures at once must give the same results as one at a time.
+	g_Config.iTexScalingType = TextureScalerCommon::HYBRID;
+	const int width = 96, height = 80, factor = 3;
+	std::vector<u32> src[2], expected[2], actual[2];
+	for (int i = 0; i < 2; ++i) {
+		src[i].resize(width * height);
+		FillScalerTexture(src[i], width, height, i + 1);
+		expected[i].resize(width * height * factor * factor);
+		actual[i].resize(width * height * factor * factor);
+		int w = width, h = height;
+		scaler.ScaleInto(expected[i].data(), src[i].data(), w, h, factor);
+	}
+	std::thread other([&] {
+		int w = width, h = height;
+		scaler.ScaleInto(actual[1].data(), src[1].data(), w, h, factor);
+	});
+	int w = width, h = height;
+	scaler.ScaleInto(actual[0].data(), src[0].data(), w, h, factor);
+	other.join();
+	EXPECT_TRUE(expected[0] == actual[0]);
+	EXPECT_TRUE(expected[1] == actual[1]);
+
+	// The banded SIMD hybrid scaler has to match the full image scalar steps exactly.
+	// This size is large enough for several bands at each factor.
+	const int refWidth = 67, refHeight = 150;
+	std::vector<u32> refSrc(refWidth * refHeight);
+	FillScalerTexture(refSrc, refWidth, refHeight, 3);
+	for (int factor = 2; factor <= 5; ++factor) {
+		std::vector<u32> refExpected(refWidth * refHeight * factor * factor), refActual(refWidth * refHeight * factor * factor);
+		ReferenceHybrid(refSrc.data(), refExpected.data(), refWidth, refHeight, factor);
+		int w = refWidth, h = refHeight;
+		scaler.ScaleInto(refActual.data(), refSrc.data(), w, h, factor);
+		for (int i = 0; i < w * h; ++i) {
+			if (refActual[i] != refExpected[i]) {
+				printf("Hybrid %dx: pixel %d,%d is %08x, expected %08x\n", factor, i % w, i / w, refActual[i], refExpected[i]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool TestTextureScaler() {
+	if (!g_threadManager.IsInitialized())
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	const int oldScalingType = g_Config.iTexScalingType;
+	const bool oldDeposterize = g_Config.bTexDeposterize;
+	g_Config.bTexDeposterize = false;
+
+	bool pass = CheckTextureScaler();
+
+	g_Config.iTexScalingType = oldScalingType;
+	g_Config.bTexDeposterize = oldDeposterize;
+	return pass;
+}
+
+bool BenchTextureScaler() {
+	if (!g_threadManager.IsInitialized())
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	g_Config.bTexDeposterize = false;
+
+	TextureScalerCommon scaler;
+	std::vector<u32> bench(256 * 256);
+	FillScalerTexture(bench, 256, 256, 1);
+	for (int type : { TextureScalerCommon::XBRZ, TextureScalerCommon::HYBRID }) {
+		g_Config.iTexScalingType = type;
+		printf("%s scaling output Mpixels/s:", type == TextureScalerCommon::XBRZ ? "xBRZ" : "Hybrid");
+		for (int factor = 2; factor <= 5; ++factor)
+			printf(" %dx %0.1f", factor, TimeTextureScaler(scaler, bench, 256, 256, factor));
+		printf("\n");
+	}
+	return true;
+}
+
 bool TestCLZ() {
 	static const uint32_t input[] = {
 		0xFFFFFFFF,
@@ -570,6 +997,125 @@ bool TestCLZ() {
 	return true;
 }
 
+static bool CheckKirkAESVectors(const char *name) {
+	// FIPS-197 appendix C.1.
+	static const u8 fipsKey[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	static const u8 fipsPlain[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+	static const u8 fipsCipher[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+	// SP 800-38A F.2.1, CBC-AES128.  KIRK always uses a zero IV, so the IV is pre-applied to the first block.
+	static const u8 cbcKey[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+	static const u8 cbcPlain[80] = {
+		0x6b ^ 0x00, 0xc1 ^ 0x01, 0xbe ^ 0x02, 0xe2 ^ 0x03, 0x2e ^ 0x04, 0x40 ^ 0x05, 0x9f ^ 0x06, 0x96 ^ 0x07,
+		0xe9 ^ 0x08, 0x3d ^ 0x09, 0x7e ^ 0x0a, 0x11 ^ 0x0b, 0x73 ^ 0x0c, 0x93 ^ 0x0d, 0x17 ^ 0x0e, 0x2a ^ 0x0f,
+		0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+		0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+		0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+		// Not part of the vectors, makes sure the 4-block batches and the tail agree.
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	};
+	static const u8 cbcCipher[64] = {
+		0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+		0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+		0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+		0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+	};
+
+	AES_ctx ctx;
+	u8 out[80];
+	AES_set_key(&ctx, fipsKey, 128);
+	AES_encrypt(&ctx, fipsPlain, out);
+	if (memcmp(out, fipsCipher, 16) != 0) {
+		printf("%s: FIPS-197 encrypt failed\n", name);
+		return false;
+	}
+	AES_decrypt(&ctx, fipsCipher, out);
+	if (memcmp(out, fipsPlain, 16) != 0) {
+		printf("%s: FIPS-197 decrypt failed\n", name);
+		return false;
+	}
+
+	AES_set_key(&ctx, cbcKey, 128);
+	AES_cbc_encrypt(&ctx, cbcPlain, out, 80);
+	if (memcmp(out, cbcCipher, 64) != 0) {
+		printf("%s: CBC encrypt failed\n", name);
+		return false;
+	}
+	// In place, like KIRK does it.
+	AES_cbc_decrypt(&ctx, out, out, 80);
+	if (memcmp(out, cbcPlain, 80) != 0) {
+		printf("%s: CBC decrypt failed\n", name);
+		return false;
+	}
+	return true;
+}
+
+static double TimeKirkAES(u8 *buf, int size, bool decrypt) {
+	static const u8 key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+	AES_ctx ctx;
+	AES_set_key(&ctx, key, 128);
+
+	int64_t total = 0;
+	double st = time_now_d();
+	do {
+		if (decrypt)
+			AES_cbc_decrypt(&ctx, buf, buf, size);
+		else
+			AES_cbc_encrypt(&ctx, buf, buf, size);
+		total += size;
+	} while (time_now_d() - st < 0.25);
+	return total / (time_now_d() - st) / (1024.0 * 1024.0);
+}
+
+static bool TestKirkAES() {
+	KirkAES_SetHardware(false);
+	if (!CheckKirkAESVectors("Software AES"))
+		return false;
+
+	if (!KirkAES_SetHardware(true)) {
+		printf("Hardware AES not available, only tested software AES.\n");
+		return true;
+	}
+	bool pass = CheckKirkAESVectors("Hardware AES");
+
+	// Compare against the software path on a larger, odd-sized (in blocks) buffer.
+	const int size = 0x10000 + 0x30;
+	std::vector<u8> src(size), hw(size), sw(size);
+	for (int i = 0; i < size; ++i)
+		src[i] = (u8)(i * 7 + (i >> 8));
+	static const u8 key[16] = { 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe, 0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01 };
+	AES_ctx ctx;
+	AES_set_key(&ctx, key, 128);
+	AES_cbc_decrypt(&ctx, src.data(), hw.data(), size);
+	KirkAES_SetHardware(false);
+	AES_cbc_decrypt(&ctx, src.data(), sw.data(), size);
+	if (hw != sw) {
+		printf("Hardware AES: CBC decrypt mismatch vs software\n");
+		pass = false;
+	}
+	KirkAES_SetHardware(true);
+	return pass;
+}
+
+static bool BenchKirkAES() {
+	const int size = 0x10000 + 0x30;
+	std::vector<u8> buf(size);
+	for (int i = 0; i < size; ++i)
+		buf[i] = (u8)(i * 7 + (i >> 8));
+
+	KirkAES_SetHardware(false);
+	double swEnc = TimeKirkAES(buf.data(), size, false);
+	double swDec = TimeKirkAES(buf.data(), size, true);
+	if (!KirkAES_SetHardware(true)) {
+		printf("KIRK AES-CBC MB/s: software enc %0.1f dec %0.1f, no hardware AES\n", swEnc, swDec);
+		return true;
+	}
+	double hwEnc = TimeKirkAES(buf.data(), size, false);
+	double hwDec = TimeKirkAES(buf.data(), size, true);
+	printf("KIRK AES-CBC MB/s: software enc %0.1f dec %0.1f, hardware enc %0.1f dec %0.1f\n", swEnc, swDec, hwEnc, hwDec);
+	return true;
+}
+
 static bool TestMemMap() {
 	Memory::g_MemorySize = Memory::RAM_DOUBLE_SIZE;
 
@@ -667,6 +1213,215 @@ static bool TestPath() {
 	return true;
 }
 
+#if HOST_IS_CASE_SENSITIVE
+// Creates a synthetic tree of upper case names to look up with the wrong case.
+static Path MakePathCaseTestTree(int dirs, int filesPerDir) {
+	const char *tmpDir = getenv("TMPDIR");
+	Path root = Path(tmpDir && tmpDir[0] ? tmpDir : "/tmp") / StringFromFormat("ppsspp_pathcase_%d", rand());
+	for (int d = 0; d < dirs; ++d) {
+		Path dir = root / StringFromFormat("Dir%02d", d);
+		File::CreateFullPath(dir);
+		for (int f = 0; f < filesPerDir; ++f) {
+			File::CreateEmptyFile(dir / StringFromFormat("File%05d.DAT", f));
+		}
+	}
+	return root;
+}
+
+static std::vector<std::string> PathCaseTestNames(int dirs, int filesPerDir, int count) {
+	std::vector<std::string> names;
+	for (int i = 0; i < count; ++i) {
+		names.push_back(StringFromFormat("dir%02d/file%05d.dat", (i * 7) % dirs, (i * 7919) % filesPerDir));
+	}
+	return names;
+}
+
+static bool TestPathCaseCache() {
+	const int DIRS = 10;
+	const int FILES_PER_DIR = 50;
+	Path root = MakePathCaseTestTree(DIRS, FILES_PER_DIR);
+	EXPECT_TRUE(File::IsDirectory(root / "Dir09"));
+
+	const int LOOKUPS = 200;
+	std::vector<std::string> names = PathCaseTestNames(DIRS, FILES_PER_DIR, LOOKUPS);
+
+	bool pass = true;
+	std::vector<std::string> expected;
+	for (const auto &name : names) {
+		std::string fixed = name;
+		if (!FixPathCase(root, fixed, FPC_FILE_MUST_EXIST)) {
+			printf("TestPathCaseCache: failed to fix %s\n", name.c_str());
+			pass = false;
+		}
+		expected.push_back(fixed);
+	}
+
+	// The first round fills the cache, the second should only hit it.
+	PathCaseCache cache;
+	for (int round = 0; round < 2; ++round) {
+		for (int i = 0; i < LOOKUPS; ++i) {
+			std::string fixed = names[i];
+			if (!FixPathCase(root, fixed, FPC_FILE_MUST_EXIST, &cache) || fixed != expected[i]) {
+				printf("TestPathCaseCache: cached mismatch %s != %s\n", fixed.c_str(), expected[i].c_str());
+				pass = false;
+				break;
+			}
+		}
+	}
+	PathCaseCache::Stats stats = cache.GetStats();
+	if (stats.hits < (uint64_t)LOOKUPS) {
+		printf("TestPathCaseCache: only %d cache hits for %d repeated lookups\n", (int)stats.hits, LOOKUPS);
+		pass = false;
+	}
+
+	// Our own writes must be visible immediately, even within the same mtime second.
+	File::CreateEmptyFile(root / "Dir00" / "NewFile.BIN");
+	cache.Invalidate((root / "Dir00" / "NewFile.BIN").ToString());
+	std::string newName = "dir00/newfile.bin";
+	EXPECT_TRUE(FixPathCase(root, newName, FPC_FILE_MUST_EXIST, &cache));
+	EXPECT_EQ_STR(newName, std::string("Dir00/NewFile.BIN"));
+
+	std::string missing = "dir00/missing.bin";
+	EXPECT_FALSE(FixPathCase(root, missing, FPC_FILE_MUST_EXIST, &cache));
+
+	File::DeleteDirRecursively(root);
+	return pass;
+}
+
+static bool BenchPathCaseCache() {
+	// Large directories are where the cache matters.
+	const int DIRS = 10;
+	const int FILES_PER_DIR = 5000;
+	Path root = MakePathCaseTestTree(DIRS, FILES_PER_DIR);
+
+	const int LOOKUPS = 200;
+	std::vector<std::string> names = PathCaseTestNames(DIRS, FILES_PER_DIR, LOOKUPS);
+
+	double st = time_now_d();
+	for (const auto &name : names) {
+		std::string fixed = name;
+		FixPathCase(root, fixed, FPC_FILE_MUST_EXIST);
+	}
+	double uncached = time_now_d() - st;
+
+	// The first round fills the cache, the second is timed.
+	PathCaseCache cache;
+	for (int round = 0; round < 2; ++round) {
+		st = time_now_d();
+		for (const auto &name : names) {
+			std::string fixed = name;
+			FixPathCase(root, fixed, FPC_FILE_MUST_EXIST, &cache);
+		}
+	}
+	double cached = time_now_d() - st;
+	PathCaseCache::Stats stats = cache.GetStats();
+	printf("PathCaseCache: %d lookups, uncached %0.3f ms, cached %0.3f ms (%d hits, %d rescans)\n", LOOKUPS, uncached * 1000.0, cached * 1000.0, (int)stats.hits, (int)stats.rescans);
+
+	File::DeleteDirRecursively(root);
+	return true;
+}
+#endif
+
+static const int PACK_TEST_IMAGES = 2000;
+static const char *const PACK_TEST_INI = "[options]\nversion = 1\n";
+
+static std::string PackTestImageName(int i) {
+	return StringFromFormat("Dir%02d/%016llx%08x.png", i % 10, (unsigned long long)i * 0x123456789ULL, i);
+}
+
+static u32 PackTestImagePixel(int i, int p) {
+	return (u32)(i * 0x01030507 + p * 0x9E3779B9);
+}
+
+static Path PackTestFilename() {
+	const char *tmpDir = getenv("TMPDIR");
+	return Path(tmpDir && tmpDir[0] ? tmpDir : "/tmp") / StringFromFormat("ppsspp_pack_%d.pack", rand());
+}
+
+static bool WriteTestReplacementPack(const Path &filename) {
+	ReplacementPackWriter writer;
+	EXPECT_TRUE(writer.Begin(filename));
+	const std::string ini = PACK_TEST_INI;
+	EXPECT_TRUE(writer.AddRaw("textures.ini", ini.data(), ini.size()));
+	std::vector<u32> pixels;
+	for (int i = 0; i < PACK_TEST_IMAGES; ++i) {
+		int w = 1 + (i % 7), h = 1 + (i % 5);
+		pixels.resize(w * h);
+		for (int p = 0; p < w * h; ++p)
+			pixels[p] = PackTestImagePixel(i, p);
+		EXPECT_TRUE(writer.AddImage(PackTestImageName(i), pixels.data(), w, h, (u8)CHECKALPHA_ANY));
+	}
+	EXPECT_TRUE(writer.Finish());
+	return true;
+}
+
+static bool TestReplacementPack() {
+	Path filename = PackTestFilename();
+	if (!WriteTestReplacementPack(filename))
+		return false;
+
+	ReplacementPack pack;
+	EXPECT_TRUE(pack.Open(filename));
+	std::string loadedIni;
+	EXPECT_TRUE(pack.ReadString("Textures.INI", &loadedIni));
+	EXPECT_EQ_STR(loadedIni, std::string(PACK_TEST_INI));
+	EXPECT_EQ_INT(pack.Find("missing.png"), -1);
+
+	std::vector<u32> pixels;
+	for (int i = 0; i < PACK_TEST_IMAGES; ++i) {
+		// Should match regardless of case and slashes, like in textures.zip.
+		std::string name = ReplaceAll(PackTestImageName(i), "/", "\\");
+		const ReplacementPack::Entry *entry = pack.GetEntry(pack.Find(i & 1 ? name : ReplacementPack::NormalizeName(name)));
+		EXPECT_TRUE(entry != nullptr);
+		EXPECT_EQ_INT((int)entry->w, 1 + (i % 7));
+		EXPECT_EQ_INT((int)entry->h, 1 + (i % 5));
+		pixels.resize(entry->w * entry->h);
+		EXPECT_TRUE(pack.Read(entry, pixels.data()));
+		for (int p = 0; p < (int)pixels.size(); ++p)
+			EXPECT_EQ_HEX(pixels[p], PackTestImagePixel(i, p));
+	}
+	pack.Close();
+
+	// A truncated pack has to be rejected, rather than read out of bounds.
+	std::string data;
+	EXPECT_TRUE(File::ReadFileToString(false, filename, data));
+	data.resize(data.size() - 8);
+	EXPECT_TRUE(File::WriteStringToFile(false, data, filename));
+	EXPECT_FALSE(pack.Open(filename));
+
+	File::Delete(filename);
+	return true;
+}
+
+static bool BenchReplacementPack() {
+	Path filename = PackTestFilename();
+	if (!WriteTestReplacementPack(filename))
+		return false;
+
+	ReplacementPack pack;
+	EXPECT_TRUE(pack.Open(filename));
+	std::vector<std::string> names;
+	for (int i = 0; i < PACK_TEST_IMAGES; ++i)
+		names.push_back(ReplaceAll(PackTestImageName(i), "/", "\\"));
+
+	std::vector<u32> pixels;
+	int64_t images = 0;
+	double st = time_now_d();
+	do {
+		for (const std::string &name : names) {
+			const ReplacementPack::Entry *entry = pack.GetEntry(pack.Find(name));
+			pixels.resize(entry->w * entry->h);
+			pack.Read(entry, pixels.data());
+		}
+		images += PACK_TEST_IMAGES;
+	} while (time_now_d() - st < 0.25);
+	printf("Texture pack: found and read %0.1f images/ms\n", images / ((time_now_d() - st) * 1000.0));
+	pack.Close();
+
+	File::Delete(filename);
+	return true;
+}
+
 static bool TestAndroidContentURI() {
 	static const char *treeURIString = "content://com.android.externalstorage.documents/tree/primary%3APSP%20ISO";
 	static const char *directoryURIString = "content://com.android.externalstorage.documents/tree/primary%3APSP%20ISO/document/primary%3APSP%20ISO";
@@ -802,6 +1557,7 @@ struct TestItem {
 };
 
 #define TEST_ITEM(name) { #name, &Test ##name, }
+#define BENCH_ITEM(name) { #name, &Bench ##name, }
 
 bool TestArmEmitter();
 bool TestArm64Emitter();
@@ -811,6 +1567,9 @@ bool TestShaderGenerators();
 bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
 bool TestThreadManager();
+bool BenchDecodedVertexCache();
+bool BenchMergedDecode();
+bool BenchShaderIdListGeneration();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -836,11 +1595,19 @@ TestItem availableTests[] = {
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(DXTDecoder),
+	TEST_ITEM(CLUT4Decoder),
+	TEST_ITEM(TextureScaler),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
+	TEST_ITEM(KirkAES),
 	TEST_ITEM(ShaderGenerators),
 	TEST_ITEM(SoftwareGPUJit),
 	TEST_ITEM(Path),
+#if HOST_IS_CASE_SENSITIVE
+	TEST_ITEM(PathCaseCache),
+#endif
+	TEST_ITEM(ReplacementPack),
 	TEST_ITEM(AndroidContentURI),
 	TEST_ITEM(ThreadManager),
 	TEST_ITEM(WrapText),
@@ -848,6 +1615,41 @@ TestItem availableTests[] = {
 	TEST_ITEM(SmallDataConvert),
 };
 
+// Timing only, so they're not part of "all" and only run with "bench [name]".
+TestItem availableBenchmarks[] = {
+	BENCH_ITEM(DXTDecoder),
+	BENCH_ITEM(TextureScaler),
+	BENCH_ITEM(KirkAES),
+#if HOST_IS_CASE_SENSITIVE
+	BENCH_ITEM(PathCaseCache),
+#endif
+	BENCH_ITEM(ReplacementPack),
+	BENCH_ITEM(DecodedVertexCache),
+	BENCH_ITEM(MergedDecode),
+	BENCH_ITEM(ShaderIdListGeneration),
+};
+
+static int RunBenchmarks(const char *name) {
+	bool found = false;
+	for (auto f : availableBenchmarks) {
+		if (name && strcasecmp(name, f.name))
+			continue;
+		found = true;
+		if (!f.func()) {
+			printf("%s: FAILED\n", f.name);
+			return 2;
+		}
+	}
+	if (!found) {
+		fprintf(stderr, "Available benchmarks:\n");
+		for (auto f : availableBenchmarks) {
+			fprintf(stderr, "  * %s\n", f.name);
+		}
+		return 1;
+	}
+	return 0;
+}
+
 int main(int argc, const char *argv[]) {
 	cpu_info.bNEON = true;
 	cpu_info.bVFP = true;
@@ -858,6 +1660,9 @@ int main(int argc, const char *argv[]) {
 	bool allTests = false;
 	TestFunc testFunc = nullptr;
 	if (argc >= 2) {
+		if (!strcasecmp(argv[1], "bench")) {
+			return RunBenchmarks(argc >= 3 ? argv[2] : nullptr);
+		}
 		if (!strcasecmp(argv[1], "all")) {
 			allTests = true;
 		}
@@ -888,6 +1693,7 @@ int main(int argc, const char *argv[]) {
 		}
 	} else if (testFunc == nullptr) {
 		fprintf(stderr, "You may select a test to run by passing an argument.\n");
+		fprintf(stderr, "Pass \"bench\", optionally followed by a name, to run the benchmarks.\n");
 		fprintf(stderr, "\n");
 		fprintf(stderr, "Available tests:\n");
 		for (auto f : availableTests) {